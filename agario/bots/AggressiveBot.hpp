@@ -30,12 +30,12 @@ namespace agario {
         auto &largest_cell = this->largest_cell();
 
         // check if there are any wimpy players nearby
-        for (auto &pair : state.players) {
-          auto &player = *pair.second;
+        for (auto &near : this->players_near(state, AGGRESSIVE_RADIUS)) {
+          auto &player = *near.first;
           if (player == *this) continue; // skip self
 
           // is it nearby?
-          auto distance = this->location().distance_to(player.location());
+          auto distance = near.second;
           if (distance <= AGGRESSIVE_RADIUS) {
 
             // can I eat it?
@@ -51,6 +51,11 @@ namespace agario {
         this->chase_pellet(state);
       }
 
+      void take_actions(agario::Player<renderable> *const *bots, std::size_t count,
+                        const agario::GameState<renderable> &state) override {
+        this->template take_actions_as<AggressiveBot>(bots, count, state);
+      }
+
     private:
       agario::pid targeting;
     };
@@ -28,12 +28,12 @@ namespace agario {
       void take_action(const GameState &state) override {
 
         // check if there are any big players nearby
-        for (auto &pair : state.players) {
-          Player &other_player = *pair.second;
+        for (auto &near : this->players_near(state, SHY_RADIUS)) {
+          const Player &other_player = *near.first;
           if (other_player == *this) continue; // skip self
 
           // is it nearby?
-          auto distance = this->location().distance_to(other_player.location());
+          auto distance = near.second;
 
           // it is scary?
           if (distance < SHY_RADIUS && other_player.mass() > mass()) {
@@ -46,12 +46,12 @@ namespace agario {
         auto &largest_cell = this->largest_cell();
 
         // check if there are any wimpy players nearby
-        for (auto &pair : state.players) {
-          auto &player = *pair.second;
+        for (auto &near : this->players_near(state, AGGRESSIVE_RADIUS)) {
+          auto &player = *near.first;
           if (player == *this) continue; // skip self
 
           // is it nearby?
-          auto distance = this->location().distance_to(player.location());
+          auto distance = near.second;
           if (distance <= AGGRESSIVE_RADIUS) {
 
             // can I eat it?
@@ -67,6 +67,11 @@ namespace agario {
         this->chase_pellet(state);
       }
 
+      void take_actions(agario::Player<renderable> *const *bots, std::size_t count,
+                        const agario::GameState<renderable> &state) override {
+        this->template take_actions_as<AggressiveShyBot>(bots, count, state);
+      }
+
     private:
       agario::pid targeting;
     };
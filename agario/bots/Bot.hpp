@@ -3,6 +3,11 @@
 #include <agario/engine/GameState.hpp>
 #include <agario/core/Player.hpp>
 
+#include <algorithm>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
 #define NO_PLAYER (-1)
 
 
@@ -28,6 +33,21 @@ namespace agario {
 
     protected:
 
+      /**
+       * Decides each of a batch of bots of type `B` (as for take_actions) with
+       * non-virtual calls to `B::take_action`. Subclasses of `B` which don't
+       * override take_actions themselves are decided with virtual calls instead.
+       */
+      template<typename B>
+      void take_actions_as(Player *const *bots, std::size_t count, const GameState &state) {
+        if (typeid(*this) != typeid(B)) {
+          Player::take_actions(bots, count, state);
+          return;
+        }
+        for (std::size_t i = 0; i < count; i++)
+          static_cast<B *>(bots[i])->B::take_action(state);
+      }
+
       void chase_pellet(const GameState &state) {
         this->action = agario::action::none;
         this->target = this->nearest_pellet(state);
@@ -38,10 +58,9 @@ namespace agario {
         agario::pid target = bot::no_player;
         agario::mass target_mass = 0;
 
-        for (auto &pair : state.players) {
-          auto &player = *pair.second;
-          auto proximity = this->location().distance_to(player.location());
-          if (proximity < radius) {
+        for (auto &near : this->players_near(state, radius)) {
+          auto &player = *near.first;
+          if (near.second < radius) {
             auto mass = this->edible_mass(player, largest_cell);
             if (target == bot::no_player || mass > target_mass) {
               target = player.pid();
@@ -52,6 +71,26 @@ namespace agario {
         return target;
       }
 
+      /**
+       * The players (including this one) within `radius` of this bot, along with
+       * their distances, in order of pid (i.e. the order of `state.players`).
+       * The list is reused by the next call, so that deciding doesn't allocate.
+       */
+      const std::vector<std::pair<const Player *, agario::distance>> &
+      players_near (const GameState &state, agario::distance radius) const {
+        _near.clear();
+        state.index().for_each_within(SpatialIndex::players, this->location(), radius,
+                                      [&](const SpatialIndex::Entry &entry, agario::distance dist) {
+          auto it = state.players.find(static_cast<agario::pid>(entry.id));
+          if (it != state.players.end())
+            _near.emplace_back(it->second.get(), dist);
+        });
+        std::sort(_near.begin(), _near.end(), [](const auto &a, const auto &b) {
+          return a.first->pid() < b.first->pid();
+        });
+        return _near;
+      }
+
       /* weighted average of the cells that we can eat from this player */
       void target_player (const Player &player, const Cell &largest_cell) {
         agario::mass mass = 0;
@@ -91,30 +130,30 @@ namespace agario {
       agario::Location nearest_pellet (const GameState &state) const {
         distance min_distance = agario::distance::max();
         agario::Location target;
-        for (auto &pellet : state.pellets) {
-          distance dist = pellet.location().distance_to(this->location());
-          if (dist < min_distance) {
-            target = pellet.location();
-            min_distance = dist;
-          }
+        SpatialIndex::Entry pellet;
+        if (state.index().nearest(SpatialIndex::pellets, this->location(), pellet)) {
+          target = pellet.location;
+          min_distance = target.distance_to(this->location());
         }
+
+        // procedurally generated pellets are searched region by region
+        agario::Location procedural;
+        if (state.pellet_field.nearest(this->location(), procedural) &&
+            procedural.distance_to(this->location()) < min_distance)
+          target = procedural;
         return target;
       }
 
       /* location of the nearest food */
       agario::Location nearest_food (const GameState &state) const {
-        distance min_distance = agario::distance::max();
-        agario::Location target;
-        for (auto &food : state.foods) {
-          distance dist = food.location().distance_to(this->location());
-          if (dist < min_distance) {
-            target = food.location();
-            min_distance = dist;
-          }
-        }
-        return target;
+        SpatialIndex::Entry food;
+        if (state.index().nearest(SpatialIndex::foods, this->location(), food))
+          return food.location;
+        return agario::Location();
       }
 
+    private:
+      mutable std::vector<std::pair<const Player *, agario::distance>> _near; // returned by players_near
     };
   }
 }
\ No newline at end of file
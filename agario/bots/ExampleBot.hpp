@@ -47,6 +47,11 @@ namespace agario {
         this->target = this->location(); // go towards where I already am
       }
 
+      void take_actions(agario::Player<renderable> *const *bots, std::size_t count,
+                        const agario::GameState<renderable> &state) override {
+        this->template take_actions_as<ExampleBot>(bots, count, state);
+      }
+
     };
   }
 }
\ No newline at end of file
@@ -21,6 +21,11 @@ namespace agario {
         this->target = this->nearest_pellet(state);
       }
 
+      void take_actions(agario::Player<renderable> *const *bots, std::size_t count,
+                        const agario::GameState<renderable> &state) override {
+        this->template take_actions_as<HungryBot>(bots, count, state);
+      }
+
     };
 
 
@@ -24,12 +24,12 @@ namespace agario {
         this->action = agario::action::none; // no splitting or anything
 
         // check if there are any big players nearby
-        for (auto &pair : state.players) {
-          Player &other_player = *pair.second;
+        for (auto &near : this->players_near(state, SHY_RADIUS)) {
+          const Player &other_player = *near.first;
           if (other_player == *this) continue; // skip self
 
           // is it nearby?
-          auto distance = this->location().distance_to(other_player.location());
+          auto distance = near.second;
 
           // it is scary?
           if (distance < SHY_RADIUS && other_player.mass() > mass()) {
@@ -43,6 +43,11 @@ namespace agario {
         this->target = this->nearest_pellet(state);
       }
 
+      void take_actions(agario::Player<renderable> *const *bots, std::size_t count,
+                        const agario::GameState<renderable> &state) override {
+        this->template take_actions_as<HungryShyBot>(bots, count, state);
+      }
+
     };
 
   }
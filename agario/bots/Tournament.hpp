@@ -0,0 +1,346 @@
+#pragma once
+
+#include <agario/engine/Engine.hpp>
+#include <utils/thread-pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Tournaments between kinds of bots (see bot-compare): many games, each
+ * between the same numbers of bots of each kind, played in parallel on a
+ * ThreadPool. Each thread accumulates statistics of the games it plays, and
+ * these are merged once all games are done, so the only thing the threads
+ * share is the (optional) stream that each game's result is written to as it
+ * finishes. Nothing is kept per game, so memory use doesn't grow with the
+ * number of games.
+ */
+namespace agario {
+  namespace bot {
+
+    /* count, mean, variance and range of a series of values (by Welford's algorithm) */
+    class ScoreStats {
+    public:
+      void add(double x) {
+        _count++;
+        auto delta = x - _mean;
+        _mean += delta / _count;
+        _m2 += delta * (x - _mean);
+        _min = std::min(_min, x);
+        _max = std::max(_max, x);
+      }
+
+      /* combines these with the statistics of another series, as if all were added here */
+      void merge(const ScoreStats &other) {
+        if (other._count == 0) return;
+        if (_count == 0) {
+          *this = other;
+          return;
+        }
+        auto count = _count + other._count;
+        auto delta = other._mean - _mean;
+        _mean += delta * other._count / count;
+        _m2 += other._m2 + delta * delta * _count * other._count / count;
+        _count = count;
+        _min = std::min(_min, other._min);
+        _max = std::max(_max, other._max);
+      }
+
+      [[nodiscard]] std::size_t count() const { return _count; }
+      [[nodiscard]] double mean() const { return _mean; }
+      [[nodiscard]] double min() const { return _count == 0 ? 0 : _min; }
+      [[nodiscard]] double max() const { return _count == 0 ? 0 : _max; }
+
+      /* sample variance */
+      [[nodiscard]] double variance() const { return _count < 2 ? 0 : _m2 / (_count - 1); }
+      [[nodiscard]] double stddev() const { return std::sqrt(variance()); }
+
+      /* the half-width of the confidence interval of the mean, `z` standard errors either side (95% by default) */
+      [[nodiscard]] double confidence(double z = 1.96) const {
+        return _count < 2 ? 0 : z * stddev() / std::sqrt(static_cast<double>(_count));
+      }
+
+    private:
+      std::size_t _count = 0;
+      double _mean = 0, _m2 = 0;
+      double _min = std::numeric_limits<double>::max();
+      double _max = std::numeric_limits<double>::lowest();
+    };
+
+    /* the outcome of a single game */
+    struct GameResult {
+      int game = 0;
+      unsigned seed = 0;
+      agario::tick ticks = 0;
+      double seconds = 0; // to play the game
+
+      // bot name => final mass of each bot of that name
+      std::map<std::string, std::vector<agario::mass>> scores;
+    };
+
+    /* statistics for each kind of bot over a number of games */
+    class TournamentStats {
+    public:
+      struct BotStats {
+        // of each game's average, best and worst score of the bots of this kind
+        ScoreStats average, maximum, minimum;
+      };
+
+      void add(const GameResult &result) {
+        _games++;
+        _ticks += result.ticks;
+        for (auto &pair : result.scores) {
+          ScoreStats game;
+          for (auto score : pair.second)
+            game.add(score);
+
+          auto &stats = _bots[pair.first];
+          stats.average.add(game.mean());
+          stats.maximum.add(game.max());
+          stats.minimum.add(game.min());
+        }
+      }
+
+      void merge(const TournamentStats &other) {
+        _games += other._games;
+        _ticks += other._ticks;
+        for (auto &pair : other._bots) {
+          auto &stats = _bots[pair.first];
+          stats.average.merge(pair.second.average);
+          stats.maximum.merge(pair.second.maximum);
+          stats.minimum.merge(pair.second.minimum);
+        }
+        engine_stats += other.engine_stats;
+      }
+
+      [[nodiscard]] int games() const { return _games; }
+      [[nodiscard]] std::uint64_t ticks() const { return _ticks; }
+      [[nodiscard]] const std::map<std::string, BotStats> &bots() const { return _bots; }
+
+      // the engine's tick profile, accumulated over all games (if compiled with ENGINE_PROFILING)
+      agario::TickStats engine_stats;
+
+    private:
+      int _games = 0;
+      std::uint64_t _ticks = 0;
+      std::map<std::string, BotStats> _bots;
+    };
+
+    /* the table of bots, from highest to lowest average score, with 95% confidence intervals */
+    inline std::ostream &operator<<(std::ostream &os, const TournamentStats &stats) {
+      std::vector<std::string> names;
+      std::size_t longest = 4;
+      for (auto &pair : stats.bots()) {
+        names.push_back(pair.first);
+        longest = std::max(longest, pair.first.size());
+      }
+      std::sort(names.begin(), names.end(), [&](const std::string &n1, const std::string &n2) {
+        return stats.bots().at(n1).average.mean() > stats.bots().at(n2).average.mean();
+      });
+
+      os << std::setw(longest) << "Name" << std::setw(8) << "Avg." << std::setw(8) << "95% CI"
+         << std::setw(8) << "Max." << std::setw(8) << "Min." << std::endl;
+      os << std::setfill('=') << std::setw(longest + 32) << "" << std::setfill(' ') << std::endl;
+      for (auto &name : names) {
+        auto &bot = stats.bots().at(name);
+        os << std::setw(longest) << name
+           << std::setw(8) << static_cast<int>(bot.average.mean())
+           << std::setw(3) << "±" << std::setw(5) << static_cast<int>(std::ceil(bot.average.confidence()))
+           << std::setw(8) << static_cast<int>(bot.maximum.mean())
+           << std::setw(8) << static_cast<int>(bot.minimum.mean()) << std::endl;
+      }
+      return os;
+    }
+
+    /* writes the result of each game as it finishes, as CSV (one row per bot) or JSON lines (one per game) */
+    class ResultWriter {
+    public:
+      enum format { csv, json };
+
+      ResultWriter(std::ostream &os, format f) : os(os), _format(f) {
+        if (_format == csv)
+          os << "game,seed,ticks,seconds,bot,index,score" << std::endl;
+      }
+
+      /* may be called from any thread */
+      void write(const GameResult &result) {
+        std::lock_guard<std::mutex> lg(m);
+        if (_format == csv) {
+          for (auto &pair : result.scores)
+            for (std::size_t i = 0; i < pair.second.size(); i++)
+              os << result.game << ',' << result.seed << ',' << result.ticks << ','
+                 << result.seconds << ',' << pair.first << ',' << i << ',' << pair.second[i] << '\n';
+        } else {
+          os << "{\"game\":" << result.game << ",\"seed\":" << result.seed << ",\"ticks\":" << result.ticks
+             << ",\"seconds\":" << result.seconds << ",\"scores\":{";
+          bool first = true;
+          for (auto &pair : result.scores) {
+            os << (first ? "" : ",") << '"' << escaped(pair.first) << "\":[";
+            for (std::size_t i = 0; i < pair.second.size(); i++)
+              os << (i == 0 ? "" : ",") << pair.second[i];
+            os << ']';
+            first = false;
+          }
+          os << "}}\n";
+        }
+        os.flush();
+      }
+
+    private:
+      std::ostream &os;
+      format _format;
+      std::mutex m;
+
+      static std::string escaped(const std::string &s) {
+        std::string e;
+        for (char c : s) {
+          if (c == '"' || c == '\\') e += '\\';
+          e += c;
+        }
+        return e;
+      }
+    };
+
+    struct TournamentConfig {
+      int num_games = 10;
+      int bots_per_kind = 7;
+      float duration = 3;       // of each game, in minutes of game time
+      int tick_freq = 30;       // ticks per second of game time
+      unsigned seed = 0;        // of the first game (the rest follow on), or 0 for a random one
+      double progress_seconds = 5; // between progress reports, if reporting progress
+    };
+
+    /**
+     * A tournament between kinds of bots, each given as a template
+     * (e.g. Tournament<false, HungryBot, AggressiveBot>)
+     */
+    template<bool renderable, template<bool> class ...Bots>
+    class Tournament {
+    public:
+      explicit Tournament(const TournamentConfig &config) : config(config), _seed(config.seed) {
+        if (_seed == 0) _seed = std::random_device()();
+      }
+
+      /* the seed of the first game, from which all of the games can be replayed */
+      [[nodiscard]] unsigned seed() const { return _seed; }
+
+      [[nodiscard]] agario::tick ticks_per_game() const {
+        return static_cast<agario::tick>(60 * config.duration * config.tick_freq);
+      }
+
+      /* plays a single game of the tournament */
+      GameResult play(int game, agario::TickStats *engine_stats = nullptr) const {
+        auto start = std::chrono::steady_clock::now();
+        GameResult result;
+        result.game = game;
+        result.seed = _seed + game;
+
+        agario::Engine<renderable> engine;
+        engine.seed(result.seed);
+        engine.reset();
+        add_bots<Bots...>(engine);
+
+        agario::time_delta dt(1.0 / config.tick_freq);
+        for (agario::tick t = 0; t < ticks_per_game(); t++)
+          engine.tick(dt);
+
+        for (auto &pair : engine.players())
+          result.scores[pair.second->name()].push_back(pair.second->mass());
+        result.ticks = engine.ticks();
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (engine_stats != nullptr) *engine_stats += engine.stats();
+        return result;
+      }
+
+      /**
+       * Plays every game on `pool`, one task per game
+       * @param writer if given, is written each game's result as it finishes
+       * @param progress if given, is written the number of games done and the
+       * throughput every `progress_seconds`
+       * @return the statistics of all the games
+       */
+      TournamentStats run(ThreadPool &pool, ResultWriter *writer = nullptr, std::ostream *progress = nullptr) {
+        // one accumulator per thread (the last for the thread calling run), apart to avoid false sharing
+        struct alignas(64) Accumulator { TournamentStats stats; };
+        std::vector<Accumulator> accumulators(pool.size() + 1);
+
+        auto start = std::chrono::steady_clock::now();
+        std::atomic<int> games_done(0);
+        std::atomic<std::uint64_t> ticks_done(0);
+        std::atomic<double> next_report(config.progress_seconds);
+        std::mutex progress_mutex;
+
+        for (int game = 0; game < config.num_games; game++) {
+          pool.schedule([&, game]() {
+            auto &stats = accumulators[pool.thread_index()].stats;
+            auto result = play(game, &stats.engine_stats);
+            stats.add(result);
+            if (writer != nullptr) writer->write(result);
+
+            auto done = ++games_done;
+            ticks_done += result.ticks;
+            if (progress != nullptr) {
+              auto elapsed = seconds_since(start);
+              auto due = next_report.load();
+              if ((elapsed >= due && next_report.compare_exchange_strong(due, elapsed + config.progress_seconds))
+                  || done == config.num_games) {
+                std::lock_guard<std::mutex> lg(progress_mutex);
+                *progress << done << "/" << config.num_games << " games, "
+                          << throughput(done, ticks_done, elapsed) << std::endl;
+              }
+            }
+          });
+        }
+        pool.wait();
+        _seconds = seconds_since(start);
+
+        TournamentStats stats;
+        for (auto &accumulator : accumulators)
+          stats.merge(accumulator.stats);
+        return stats;
+      }
+
+      /* wall-clock time taken by the last run */
+      [[nodiscard]] double seconds() const { return _seconds; }
+
+      static std::string throughput(int games, std::uint64_t ticks, double seconds) {
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(2) << games / seconds << " games/s, "
+           << std::setprecision(0) << ticks / seconds << " ticks/s";
+        return ss.str();
+      }
+
+    private:
+      TournamentConfig config;
+      unsigned _seed;
+      double _seconds = 0;
+
+      static double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      }
+
+      template<template<bool> class ...Us>
+      void add_bots(agario::Engine<renderable> &engine) const {
+        (add_kind<Us>(engine), ...);
+      }
+
+      template<template<bool> class U>
+      void add_kind(agario::Engine<renderable> &engine) const {
+        for (int i = 0; i < config.bots_per_kind; i++)
+          engine.template add_player<U<renderable>>();
+      }
+    };
+
+  }
+}
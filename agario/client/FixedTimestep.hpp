@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cmath>
+#include <stdexcept>
+
+#include "agario/core/types.hpp"
+
+namespace agario {
+
+  /* the most steps simulated for one frame, beyond which the game slows down rather than catching up */
+  constexpr int default_max_steps = 5;
+
+  /**
+   * Divides elapsed wall-clock time into steps of simulation of a fixed
+   * length, so that the game plays out the same at any frame rate. Time left
+   * over (less than a step) is carried on to the next frame, and `alpha` is
+   * how far that leftover time is through the next step, for interpolating
+   * between the last two simulated states.
+   */
+  class FixedTimestep {
+  public:
+    explicit FixedTimestep(const agario::time_delta &step, int max_steps = default_max_steps) :
+      _step(step), max_steps(max_steps), accumulated(0) {
+      if (step.count() <= 0)
+        throw std::invalid_argument("Time step must be positive");
+      if (max_steps < 1)
+        throw std::invalid_argument("Must allow at least one step per frame");
+    }
+
+    /**
+     * Adds the time elapsed since the last call
+     * @return the number of steps to simulate
+     */
+    int advance(const agario::time_delta &elapsed) {
+      accumulated += elapsed;
+      auto steps = static_cast<int>(std::floor(accumulated / _step));
+      if (steps > max_steps) {
+        // too far behind to catch up, so the time which can't be simulated is dropped
+        steps = max_steps;
+        accumulated = _step * max_steps;
+      }
+      accumulated -= _step * steps;
+      return steps;
+    }
+
+    /* the fraction of a step of time that's accumulated (from 0 up to 1) */
+    [[nodiscard]] float alpha() const {
+      return static_cast<float>(accumulated / _step);
+    }
+
+    [[nodiscard]] const agario::time_delta &step() const { return _step; }
+
+  private:
+    const agario::time_delta _step;
+    const int max_steps;
+    agario::time_delta accumulated;
+  };
+
+}
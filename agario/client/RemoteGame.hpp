@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "agario/client/SnapshotState.hpp"
+#include "agario/engine/Engine.hpp"
+#include "agario/server/ServerConnection.hpp"
+
+namespace agario {
+
+  /* the number of unacknowledged inputs kept for replaying on top of snapshots */
+  constexpr std::size_t input_history = 256;
+
+  /* how far (in seconds) behind the server remote entities are shown, so that
+   * there is (usually) a snapshot on either side of them to interpolate between */
+  constexpr double default_interpolation_delay = 0.1;
+
+  /**
+   * A game played on a remote Server, for clients which update at display
+   * rate however often snapshots arrive.
+   *
+   * The local player's cells are predicted: each frame's input is sent to
+   * the server, kept in a ring buffer, and applied straight away to a local
+   * engine which holds only the local player, so that they move by the same
+   * engine code as on the server. When a snapshot arrives, the player's cells
+   * are reset to the server's and the inputs which the server hadn't yet
+   * applied are replayed on top of them (reconciliation). Eating, being eaten
+   * and everything else that depends on other entities is left to the server.
+   *
+   * Everything else is shown `interpolation_delay` behind the latest snapshot,
+   * interpolated between the two snapshots either side of that time.
+   */
+  template<bool renderable>
+  class RemoteGame {
+  public:
+    using Player = agario::Player<renderable>;
+    using GameState = agario::GameState<renderable>;
+    using Snapshot = server::Snapshot;
+
+    RemoteGame(const std::string &host, int port, const std::string &name,
+               double interpolation_delay = default_interpolation_delay) :
+      _connection(host, port), name(name), interpolation_delay(interpolation_delay),
+      display(DEFAULT_ARENA_WIDTH, DEFAULT_ARENA_HEIGHT) {
+      _connection.join(name);
+    }
+
+    /**
+     * Waits up to `timeout_ms` for the server to welcome us and send the first snapshot
+     * @return whether it did
+     */
+    bool wait_for_snapshot(int timeout_ms = 1000) {
+      while (!_connection.joined() || _connection.tick() == server::no_base)
+        if (!_connection.receive(timeout_ms)) return false;
+      start();
+      received(_connection.snapshot());
+      reconcile();
+      return true;
+    }
+
+    /**
+     * Advances the game by `dt` of wall-clock time: takes in any snapshots
+     * which have arrived, then sends the player's input and predicts its effect
+     */
+    void update(const Location &target, agario::action action, const agario::time_delta &dt) {
+      if (engine == nullptr && !wait_for_snapshot(0)) return;
+
+      bool updated = false;
+      while (_connection.receive(0)) {
+        received(_connection.snapshot());
+        updated = true;
+      }
+      if (updated) reconcile();
+
+      latest_input = _connection.send_input(target.x, target.y, action);
+      inputs[latest_input % input_history] = Input { target, action, dt };
+      apply(inputs[latest_input % input_history]);
+
+      server_time += dt.count() * _connection.welcome().tick_rate;
+    }
+
+    /* the local player, as predicted */
+    Player &player() { return engine->player(local_pid); }
+
+    /* the pid of the local player on the server */
+    [[nodiscard]] agario::pid pid() const { return _connection.welcome().pid; }
+
+    /**
+     * The entities other than the local player's cells, interpolated to
+     * `interpolation_delay` behind the latest snapshot
+     */
+    Snapshot remote_entities() const {
+      Snapshot entities;
+      if (snapshots.empty()) return entities;
+
+      auto time = render_time();
+      auto after = std::find_if(snapshots.begin(), snapshots.end(),
+                                [&](const TimedSnapshot &s) { return s.tick > time; });
+      if (after == snapshots.begin() || after == snapshots.end()) {
+        // nothing to interpolate between, so show the nearest snapshot as it was
+        auto &nearest = after == snapshots.end() ? snapshots.back() : snapshots.front();
+        for (auto &entity : nearest.snapshot)
+          if (!own(entity)) entities.push_back(entity);
+        return entities;
+      }
+
+      auto before = std::prev(after);
+      auto alpha = static_cast<float>((time - before->tick) / (after->tick - before->tick));
+      entities = server::interpolate(before->snapshot, after->snapshot, alpha);
+      entities.erase(std::remove_if(entities.begin(), entities.end(),
+                                    [&](const server::EntityState &entity) { return own(entity); }),
+                     entities.end());
+      return entities;
+    }
+
+    /* the game state to render: the remote entities along with the predicted local player */
+    GameState &state() {
+      display.game_state().players.erase(pid()); // the prediction engine's player, whose cells aren't to be cleared
+      auto &shown = display.show(remote_entities(), _connection.players());
+      if (engine != nullptr)
+        shown.players[pid()] = engine->game_state().players.at(local_pid);
+      return shown;
+    }
+
+    /* how far the local player was from where it was predicted to be, at the last snapshot */
+    [[nodiscard]] float prediction_error() const { return _prediction_error; }
+
+    /* the number of inputs sent which the server hadn't applied as of the latest snapshot */
+    [[nodiscard]] std::size_t pending_inputs() const {
+      return latest_input - _connection.last_input();
+    }
+
+    server::ServerConnection &connection() { return _connection; }
+
+    RemoteGame(const RemoteGame &) = delete;
+    RemoteGame &operator=(const RemoteGame &) = delete;
+
+  private:
+    struct Input {
+      Location target;
+      agario::action action;
+      agario::time_delta dt;
+    };
+
+    struct TimedSnapshot {
+      std::uint32_t tick;
+      Snapshot snapshot;
+    };
+
+    server::ServerConnection _connection;
+    std::string name;
+    const double interpolation_delay;
+
+    // prediction of the local player, who is the only player in `engine`
+    std::unique_ptr<agario::Engine<renderable>> engine;
+    agario::pid local_pid = 0;
+    std::array<Input, input_history> inputs {}; // by sequence number, modulo the size
+    std::uint32_t latest_input = 0;
+    float _prediction_error = 0;
+
+    // interpolation of everything else
+    std::deque<TimedSnapshot> snapshots;
+    double server_time = 0; // estimate of the server's current tick
+    SnapshotState<renderable> display;
+
+    /* creates the prediction engine, now that the arena's size is known */
+    void start() {
+      auto &welcome = _connection.welcome();
+      engine = std::make_unique<agario::Engine<renderable>>(agario::distance(welcome.arena_width),
+                                                            agario::distance(welcome.arena_height), 0, 0, false);
+      local_pid = engine->template add_player<Player>(name);
+      display.game_state().arena_width = welcome.arena_width;
+      display.game_state().arena_height = welcome.arena_height;
+      server_time = _connection.tick();
+    }
+
+    [[nodiscard]] double render_time() const {
+      return server_time - interpolation_delay * _connection.welcome().tick_rate;
+    }
+
+    [[nodiscard]] bool own(const server::EntityState &entity) const {
+      return entity.kind == server::cell && server::cell_owner(entity) == pid();
+    }
+
+    void received(const Snapshot &snapshot) {
+      auto tick = _connection.tick();
+      snapshots.push_back(TimedSnapshot { tick, snapshot });
+
+      // keep the clock close to the server's without jumping on every snapshot
+      auto drift = tick - server_time;
+      if (std::abs(drift) > _connection.welcome().tick_rate) server_time = tick;
+      else server_time += 0.1 * drift;
+
+      // only one snapshot from before the render time is needed to interpolate from
+      auto time = render_time();
+      while (snapshots.size() > 2 && snapshots[1].tick <= time)
+        snapshots.pop_front();
+    }
+
+    void apply(const Input &input) {
+      auto &player = engine->player(local_pid);
+      player.target = input.target;
+      player.action = input.action;
+      engine->tick(input.dt);
+      engine->game_state().foods.clear(); // food is the server's to simulate
+    }
+
+    /* resets the local player's cells to the server's and replays the inputs it has yet to apply */
+    void reconcile() {
+      auto &player = engine->player(local_pid);
+      bool was_alive = !player.dead();
+      auto predicted = was_alive ? player.location() : Location(0, 0);
+
+      // the server's cells, in order of index (cells keep the velocities predicted for them)
+      std::vector<typename Player::Cell> cells;
+      for (auto &entity : _connection.snapshot()) {
+        if (!own(entity)) continue;
+        auto index = static_cast<std::size_t>(entity.id & 0xffffffffu);
+        if (index < player.cells.size()) {
+          // moved rather than copied: renderable cells own GL objects (and the old cells are killed below)
+          auto cell = std::move(player.cells[index]);
+          cell.x = entity.x;
+          cell.y = entity.y;
+          cell.set_mass(entity.mass);
+          cells.push_back(std::move(cell));
+        } else {
+          cells.emplace_back(Location(entity.x, entity.y), entity.mass);
+        }
+      }
+      player.kill();
+      player.add_cells(cells);
+
+      // inputs which have fallen out of the history are lost to the prediction
+      auto oldest = latest_input >= input_history ? latest_input - input_history + 1 : 1;
+      auto first = std::max<std::uint32_t>(_connection.last_input() + 1, oldest);
+      for (auto sequence = first; sequence <= latest_input; sequence++)
+        apply(inputs[sequence % input_history]);
+
+      if (was_alive && !player.dead()) {
+        auto location = player.location();
+        _prediction_error = std::hypot(static_cast<float>(location.x - predicted.x),
+                                       static_cast<float>(location.y - predicted.y));
+      }
+    }
+  };
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <iterator>
+#include <map>
+#include <memory>
+
+#include "agario/engine/GameState.hpp"
+#include "agario/server/protocol.hpp"
+#include "agario/server/snapshot.hpp"
+
+namespace agario {
+
+  /**
+   * A game state to render, built from the entities of a Snapshot (as
+   * captured, or interpolated between two captures). Players are kept from
+   * one snapshot to the next, and pellets and food are colored by their ids,
+   * so that nothing changes color from frame to frame.
+   */
+  template<bool renderable>
+  class SnapshotState {
+  public:
+    using Player = agario::Player<renderable>;
+    using GameState = agario::GameState<renderable>;
+    using Roster = std::map<agario::pid, server::PlayerInfo>;
+
+    SnapshotState(agario::distance arena_width, agario::distance arena_height) :
+      state(arena_width, arena_height) {}
+
+    /**
+     * Replaces the state's entities with `entities`, leaving out players
+     * without any cells among them
+     * @param roster the names and colors of the players
+     */
+    GameState &show(const server::Snapshot &entities, const Roster &roster) {
+      state.pellets.clear();
+      state.foods.clear();
+      state.viruses.clear();
+      for (auto &pair : state.players)
+        pair.second->cells.clear();
+
+      for (auto &entity : entities) {
+        Location location(entity.x, entity.y);
+        switch (entity.kind) {
+          case server::pellet:
+            state.pellets.emplace_back(std::move(location));
+            set_color(state.pellets.back(), entity);
+            break;
+          case server::food:
+            state.foods.emplace_back(std::move(location), Velocity());
+            set_color(state.foods.back(), entity);
+            break;
+          case server::virus: state.viruses.emplace_back(std::move(location)); break;
+          case server::cell: player(server::cell_owner(entity), roster).add_cell(location, entity.mass); break;
+        }
+      }
+
+      for (auto it = state.players.begin(); it != state.players.end();)
+        it = it->second->dead() ? state.players.erase(it) : std::next(it);
+      return state;
+    }
+
+    GameState &game_state() { return state; }
+
+  private:
+    GameState state;
+
+    Player &player(agario::pid pid, const Roster &roster) {
+      auto &player = state.players[pid];
+      if (player == nullptr) {
+        auto it = roster.find(pid);
+        player = it == roster.end() ? std::make_shared<Player>(pid, "unnamed")
+                                    : std::make_shared<Player>(pid, it->second.name, it->second.color);
+      }
+      return *player;
+    }
+
+    template<typename B>
+    static void set_color(B &ball, const server::EntityState &entity) {
+      if constexpr (renderable) {
+        auto hash = entity.id * 0x9e3779b97f4a7c15u;
+        ball.set_color(static_cast<agario::color>((hash >> 32u) % agario::color::last));
+      }
+    }
+  };
+
+}
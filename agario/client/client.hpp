@@ -5,10 +5,20 @@
 
 #include <agario/core/renderables.hpp>
 #include <agario/engine/Engine.hpp>
+#include <agario/client/FixedTimestep.hpp>
+#include <agario/client/RemoteGame.hpp>
+#include <agario/client/SnapshotState.hpp>
+#include <agario/server/snapshot.hpp>
 
 #include <agario/bots/bots.hpp>
 
+#include "utils/triple-buffer.h"
+
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <thread>
 
 #include <string>
 #include <ctime>
@@ -17,6 +27,7 @@
 #define WINDOW_NAME "AgarIO"
 #define DEFAULT_SCREEN_WIDTH 640
 #define DEFAULT_SCREEN_HEIGHT 480
+#define DEFAULT_TICK_RATE 60
 
 #define RENDERABLE true
 
@@ -33,18 +44,64 @@ namespace agario {
     Client() :
       server(), port(),
       engine(DEFAULT_ARENA_WIDTH, DEFAULT_ARENA_HEIGHT),
-      renderer(nullptr) {
+      renderer(nullptr), tick_rate(DEFAULT_TICK_RATE), simulation_thread(false),
+      display(DEFAULT_ARENA_WIDTH, DEFAULT_ARENA_HEIGHT), frames(0) {
       engine.initialize_game();
     }
 
     Client(std::string server, int port) :
-      server(std::move(server)), port(port), renderer(nullptr) {}
+      server(std::move(server)), port(port), renderer(nullptr), tick_rate(DEFAULT_TICK_RATE), simulation_thread(false),
+      display(DEFAULT_ARENA_WIDTH, DEFAULT_ARENA_HEIGHT), frames(0) {}
+
+    /* sets how many times a second the single-player game is ticked, whatever the frame rate */
+    void set_tick_rate(int rate) {
+      if (rate <= 0)
+        throw std::invalid_argument("Tick rate must be positive");
+      tick_rate = rate;
+    }
 
-    void connect() {
+    /* whether to tick the single-player game on its own thread, apart from rendering */
+    void set_simulation_thread(bool separate) { simulation_thread = separate; }
+
+    /* joins the game on the server as a player named `name` */
+    void connect(const std::string &name) {
       std::cout << "Connecting to: " << server << ":" << port << "..." << std::endl;
-      // todo: set arena_height and width form server (among other things)
-      std::cout << "remote server connection not implemented yet." << std::endl;
+      remote = std::make_unique<RemoteGame<RENDERABLE>>(server, port, name);
+      if (!remote->wait_for_snapshot(5000))
+        throw agario::server::NetworkException("No response from " + server + ":" + std::to_string(port));
 
+      auto &welcome = remote->connection().welcome();
+      std::cout << "Joined as pid " << welcome.pid << " in a " << welcome.arena_width
+                << " x " << welcome.arena_height << " arena" << std::endl;
+      window = std::make_shared<Window>(WINDOW_NAME, DEFAULT_SCREEN_WIDTH, DEFAULT_SCREEN_HEIGHT);
+      renderer = std::make_unique<agario::Renderer>(window, agario::distance(welcome.arena_width),
+                                                    agario::distance(welcome.arena_height));
+    }
+
+    /**
+     * Plays on the server (after `connect`) at display rate, predicting the
+     * player's own cells and interpolating everything else (see RemoteGame)
+     */
+    void network_loop() {
+      auto before = std::chrono::system_clock::now();
+      agario::Location target(0, 0);
+      while (!window->should_close()) {
+        auto now = std::chrono::system_clock::now();
+        agario::time_delta dt = now - before;
+        before = now;
+
+        // between dying and the server respawning us there's nothing to aim or to center the view on
+        auto action = agario::action::none;
+        if (!remote->player().dead())
+          target = read_input(remote->player(), action);
+        remote->update(target, action, dt);
+
+        if (!remote->player().dead())
+          renderer->render_screen(remote->player(), remote->state());
+        glfwPollEvents();
+        window->swap_buffers();
+      }
+      window->destroy();
     }
 
     template<typename... Args>
@@ -82,16 +139,18 @@ namespace agario {
 
       auto beginning = std::chrono::system_clock::now();
       auto ticks_before = engine.ticks();
+      frames = 0;
 
-      game_loop();
+      if (simulation_thread) threaded_game_loop();
+      else game_loop();
 
       auto now = std::chrono::system_clock::now();
       std::chrono::duration<double> total_time = now - beginning;
 
       std::cout << "Game time: " << total_time.count() << " sec." << std::endl;
 
-      float fps = (engine.ticks() - ticks_before) / total_time.count();
-      std::cout << "Average FPS: " << fps << std::endl;
+      std::cout << "Average FPS: " << frames / total_time.count() << std::endl;
+      std::cout << "Ticks per second: " << (engine.ticks() - ticks_before) / total_time.count() << std::endl;
 
       std::cout << "Leader-board:" << std::endl;
       std::cout << engine.game_state() << std::endl;
@@ -99,30 +158,85 @@ namespace agario {
       window->destroy();
     }
 
+    /**
+     * Ticks the game `tick_rate` times a second of wall-clock time, however
+     * often frames are rendered, and renders each frame between the last two
+     * ticks, as far between them as the frame is between their times
+     */
     void game_loop() {
-      auto before = std::chrono::system_clock::now();
-      while (!window->should_close()) {
+      FixedTimestep timestep(time_delta(1.0 / tick_rate));
+      aspect_ratio = window->aspect_ratio();
+      roster = players_roster();
+      auto previous = capture_view(), current = previous;
 
-        auto now = std::chrono::system_clock::now();
-        auto dt = now - before;
+      auto before = std::chrono::steady_clock::now();
+      while (!window->should_close()) {
+        auto now = std::chrono::steady_clock::now();
+        agario::time_delta dt = now - before;
         before = now;
 
-        auto &player = engine.player(player_pid);
-
-        if (player.dead()) {
-          std::cout << "Player \"" << player.name() << "\" (pid ";
-          std::cout << player.pid() << ") died." << std::endl;
-          engine.respawn(player_pid);
+        for (int steps = timestep.advance(dt); steps > 0; steps--) {
+          simulate(timestep.step());
+          previous = std::move(current);
+          current = capture_view();
         }
 
-        process_input();
-        renderer->render_screen(player, engine.game_state());
+        render_frame(server::interpolate(previous, current, timestep.alpha()));
+      }
+    }
 
-        glfwPollEvents();
-        window->swap_buffers();
+    /**
+     * Like game_loop, except that the game is ticked on a thread of its own,
+     * which hands each tick's state to this (the rendering) thread through a
+     * triple buffer. Frames are rendered a tick behind the latest state, so
+     * that there are (usually) two ticks' states to interpolate between.
+     */
+    void threaded_game_loop() {
+      using clock = std::chrono::steady_clock;
+      aspect_ratio = window->aspect_ratio();
+      roster = players_roster();
+
+      TripleBuffer<TimedView> views;
+      views.back() = { clock::now(), capture_view() };
+      views.publish();
+
+      std::atomic<bool> running(true);
+      std::thread simulation([&] {
+        auto step = time_delta(1.0 / tick_rate);
+        auto period = std::chrono::duration_cast<clock::duration>(step);
+        auto next = clock::now();
+        while (running) {
+          simulate(step);
+          views.back() = { clock::now(), capture_view() };
+          views.publish();
+
+          next += period;
+          auto now = clock::now();
+          if (next < now) next = now; // don't try to catch up after falling behind
+          std::this_thread::sleep_until(next);
+        }
+      });
+
+      views.update();
+      auto previous = std::move(views.front()), current = previous;
+      auto period = std::chrono::duration_cast<clock::duration>(time_delta(1.0 / tick_rate));
+      while (!window->should_close()) {
+        if (views.update()) {
+          previous = std::move(current);
+          current = std::move(views.front());
+        }
 
-        engine.tick(dt);
+        auto time = clock::now() - period;
+        float alpha = 1;
+        if (current.time > previous.time) {
+          time_delta between = current.time - previous.time, since = time - previous.time;
+          alpha = std::clamp(static_cast<float>(since / between), 0.0f, 1.0f);
+        }
+        render_frame(server::interpolate(previous.entities, current.entities, alpha));
       }
+
+      running = false;
+      simulation.join();
     }
 
   private:
@@ -137,29 +251,107 @@ namespace agario {
     std::unique_ptr<agario::Renderer> renderer;
     std::shared_ptr<Window> window;
 
+    std::unique_ptr<RemoteGame<RENDERABLE>> remote; // when playing on a server
+
+    int tick_rate;
+    bool simulation_thread;
+
+    // single-player frames are rendered from snapshots of what the player can see
+    struct TimedView {
+      std::chrono::steady_clock::time_point time;
+      server::Snapshot entities;
+    };
+    SnapshotState<RENDERABLE>::Roster roster;
+    SnapshotState<RENDERABLE> display;
+    std::size_t frames;
+
+    // the latest input, read by the rendering thread and applied by the simulating one
+    std::mutex input_mutex;
+    agario::Location input_target = agario::Location(0, 0);
+    agario::action input_action = agario::action::none; // kept from the frame it was pressed in until a tick
+    std::atomic<float> aspect_ratio = 1; // of the window, which may be resized while simulating
+
     template <typename T>
     void add_bot(int num_bots) {
       for (int i = 0; i < num_bots; i++)
         engine.add_player<T>();
     }
 
-    void process_input() {
-      GLFWwindow *win = window->pointer();
+    /* the names and colors of the players in the single-player game */
+    SnapshotState<RENDERABLE>::Roster players_roster() const {
+      SnapshotState<RENDERABLE>::Roster players;
+      for (auto &pair : engine.game_state().players)
+        players[pair.first] = server::PlayerInfo { pair.first, pair.second->color(), pair.second->name() };
+      return players;
+    }
+
+    /* the entities in (or near) the player's view */
+    server::Snapshot capture_view() {
       auto &player = engine.player(player_pid);
+      if (player.dead()) return {};
+
+      // half as far again as the camera sees, so that balls whose centers are out of view aren't missing
+      auto extent = view_half_height(agario::camera_z(player.mass())) * std::max(1.0f, aspect_ratio.load());
+      return server::capture(engine.game_state(), player.location(), 3 * extent);
+    }
+
+    /* ticks the game by `dt` with the latest input, respawning the player if it died */
+    void simulate(const agario::time_delta &dt) {
+      auto &player = engine.player(player_pid);
+
+      if (player.dead()) {
+        std::cout << "Player \"" << player.name() << "\" (pid ";
+        std::cout << player.pid() << ") died." << std::endl;
+        engine.respawn(player_pid);
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(input_mutex);
+        player.target = input_target;
+        player.action = input_action;
+        input_action = agario::action::none; // performed by this tick
+      }
+      engine.tick(dt);
+    }
+
+    /* renders the entities, reading the player's input relative to where they're shown */
+    void render_frame(const server::Snapshot &entities) {
+      aspect_ratio = window->aspect_ratio();
+      auto &state = display.show(entities, roster);
+      auto it = state.players.find(player_pid);
+      if (it != state.players.end()) {
+        auto action = agario::action::none;
+        auto target = read_input(*it->second, action);
+        {
+          std::lock_guard<std::mutex> lock(input_mutex);
+          input_target = target;
+          if (action != agario::action::none) input_action = action; // even if released before the next tick
+        }
+        renderer->render_screen(*it->second, state);
+      }
+
+      glfwPollEvents();
+      window->swap_buffers();
+      frames++;
+    }
+
+    /* the target under the cursor, setting `action` from the keys pressed */
+    agario::Location read_input(Player &player, agario::action &action) {
+      GLFWwindow *win = window->pointer();
 
       double xpos, ypos;
       glfwGetCursorPos(win, &xpos, &ypos);
-      player.target = renderer->to_target(player, xpos, ypos);
-      player.action = agario::action::none;
+      auto target = renderer->to_target(player, xpos, ypos);
 
       if (glfwGetKey(win, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(win, true);
 
       if (glfwGetKey(win, GLFW_KEY_SPACE) == GLFW_PRESS)
-        player.action = agario::action::split;
+        action = agario::action::split;
 
       if (glfwGetKey(win, GLFW_KEY_W) == GLFW_PRESS)
-        player.action = agario::action::feed;
+        action = agario::action::feed;
+      return target;
     }
 
   };
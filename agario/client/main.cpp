@@ -14,8 +14,10 @@ cxxopts::Options options() {
     options.add_options()
       ("s,singleplayer", "singleplayer mode", cxxopts::value<bool>()->default_value("false"))
       ("server", "Server", cxxopts::value<std::string>()->default_value("localhost"))
-      ("port", "Port", cxxopts::value<int>()->default_value("80"))
+      ("port", "Port", cxxopts::value<int>()->default_value("8080"))
       ("name", "Player Name", cxxopts::value<std::string>()->default_value("unnamed"))
+      ("tick-rate", "Single-player ticks per second", cxxopts::value<int>()->default_value("60"))
+      ("sim-thread", "Tick the single-player game on its own thread", cxxopts::value<bool>()->default_value("false"))
       ("help", "Print help");
 
 
@@ -33,32 +35,35 @@ int main(int argc, char *argv[]) {
   auto opts = options();
   auto args = opts.parse(argc, argv);
 
-//  bool singleplayer = args["singleplayer"].as<bool>();
+  bool singleplayer = args["singleplayer"].as<bool>() || args.count("server") == 0;
   std::string name = args["name"].as<std::string>();
 
+  if (singleplayer) {
+    std::cout << "Single-player mode." << std::endl;
 
-//  if (singleplayer) {
-  std::cout << "Single-player mode." << std::endl;
+    agario::Client client;
+    client.set_tick_rate(args["tick-rate"].as<int>());
+    client.set_simulation_thread(args["sim-thread"].as<bool>());
+    agario::pid pid = client.add_player(name);
 
-  agario::Client client;
-  agario::pid pid = client.add_player(name);
+    client.set_player(pid);
+    client.add_bots();
 
-  client.set_player(pid);
-  client.add_bots();
+    client.play();
 
-  client.play();
+  } else {
+    std::string server = args["server"].as<std::string>();
+    int port = args["port"].as<int>();
 
-//  } else {
-//    std::string server = args["server"].as<std::string>();
-//    int port = args["port"].as<int>();
-//
-//    std::cout << "Server: " << server << std::endl;
-//    std::cout << "Port: " << port << std::endl;
-//
-//    agario::Client client(server, port);
-//    client.connect();
-//    client.game_loop();
-//  }
+    agario::Client client(server, port);
+    try {
+      client.connect(name);
+    } catch (agario::server::NetworkException &e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+    }
+    client.network_loop();
+  }
 
   return 0;
 }
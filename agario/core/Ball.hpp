@@ -25,13 +25,13 @@ namespace agario {
     distance width() const { return 2 * radius(); }
 
     bool collides_with(const Ball &other) const {
-      auto sqr_rads = pow(std::max(radius(), other.radius()), 2);
-      return sqr_rads >= sqr_distance_to(other);
+      auto rad = std::max(radius(), other.radius());
+      return rad * rad >= sqr_distance_to(other);
     }
 
     bool touches(const Ball& other) const {
-      auto sqr_rads = pow(radius() + other.radius(), 2);
-      return sqr_rads >= sqr_distance_to(other);
+      auto rads = radius() + other.radius();
+      return rads * rads >= sqr_distance_to(other);
     }
 
     bool can_eat(const Ball &other) const {
@@ -67,7 +67,7 @@ namespace agario {
     template<typename Loc, typename Vel>
     MovingBall(Loc &&loc, Vel &&vel) : Ball(loc), velocity(vel) {}
 
-    float speed() const { return velocity.speed(); }
+    distance speed() const { return velocity.speed(); }
 
     void accelerate(float accel, float dt) {
       velocity.accelerate(accel, dt);
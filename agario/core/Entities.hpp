@@ -60,16 +60,7 @@ namespace agario {
   template<bool r, unsigned NumSides>
   struct oVirus : virtual public RenderableMovingBall<NumSides> {
     void _create_vertices() override {
-      auto num_verts = RenderableMovingBall<NumSides>::NVertices;
-      this->circle.verts[0] = 0;
-      this->circle.verts[1] = 0;
-      this->circle.verts[2] = 0;
-      for (unsigned i = 1; i < num_verts; i++) {
-        auto radius = 1 + sin(30 * M_PI * i / NumSides) / 15;
-        this->circle.verts[i * 3] = radius * cos(i * 2 * M_PI / NumSides);
-        this->circle.verts[i * 3 + 1] = radius * sin(i * 2 * M_PI / NumSides);
-        this->circle.verts[i * 3 + 2] = 0;
-      }
+      virus_vertices(this->circle);
     }
   };
 
@@ -111,9 +102,8 @@ namespace agario {
     // gotta redeclare all the constructors because of virtual inheritance...
     template<typename Loc, typename Vel>
     Cell(Loc &&loc, Vel &&vel, agario::mass mass) : Ball(loc), Super(loc, vel),
-                                                    _mass(mass), _can_recombine(false) {
+                                                    _recombine_timer(0), _mass(mass) {
       set_mass(mass);
-      _recombine_timer = std::chrono::steady_clock::now();
     }
 
     template<typename Loc>
@@ -140,24 +130,22 @@ namespace agario {
 
     void reduce_mass_by_factor(float factor) { set_mass(mass() / factor); }
 
-    bool can_recombine() {
-      if (_can_recombine) return true;
-      _can_recombine = std::chrono::steady_clock::now() >= _recombine_timer;
-      return _can_recombine;
-    }
+    bool can_recombine() const { return _recombine_timer <= 0; }
+
+    void reset_recombine_timer() { _recombine_timer = RECOMBINE_TIMER_SEC; }
 
-    void reset_recombine_timer() {
-      _recombine_timer = std::chrono::steady_clock::now() +
-                         std::chrono::seconds(RECOMBINE_TIMER_SEC);
-      _can_recombine = false;
+    /* counts down the game time (not wall-clock time, so that games are
+     * reproducible) remaining until the cell may recombine */
+    void decrement_recombine_timer(float dt) {
+      if (_recombine_timer > 0)
+        _recombine_timer -= dt;
     }
 
     agario::Velocity splitting_velocity;
-    agario::real_time _recombine_timer;
+    float _recombine_timer; // seconds of game time
 
   private:
     agario::mass _mass;
-    bool _can_recombine;
   };
 
 }
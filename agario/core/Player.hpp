@@ -120,6 +120,17 @@ namespace agario {
       static_cast<void>(state);
     }
 
+    /**
+     * Calls take_action on each of the `count` players at `players`, which all
+     * have the same type as this one. Bots override this to make the calls
+     * non-virtual (see Bot::take_actions_as), so that the engine decides a
+     * whole group of bots of the same type in one tight loop.
+     */
+    virtual void take_actions(Player *const *players, std::size_t count, const GameState<renderable> &state) {
+      for (std::size_t i = 0; i < count; i++)
+        players[i]->take_action(state);
+    }
+
     template <bool r = renderable>
     typename std::enable_if<r, void>::type
     add_cells(std::vector<Cell> &new_cells) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdexcept>
+
 namespace agario {
   enum color { red, orange, yellow, green, blue, purple, last };
 
@@ -11,6 +13,20 @@ namespace agario {
   float yellow_color[] = {1.0, 1.0, 0.0};
   float black_color[] = {0.0, 0.0, 0.0};
 
+  /* the red, green and blue components of a color */
+  inline const float *color_values(agario::color c) {
+    switch (c) {
+      case agario::color::red: return red_color;
+      case agario::color::blue: return blue_color;
+      case agario::color::green: return green_color;
+      case agario::color::orange: return orange_color;
+      case agario::color::purple: return purple_color;
+      case agario::color::yellow: return yellow_color;
+      default:
+        throw std::invalid_argument("Not a color");
+    }
+  }
+
   agario::color random_color() {
     return static_cast<enum color>(rand() % agario::color::last);
   }
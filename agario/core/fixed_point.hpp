@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include "agario/core/num_wrapper.hpp"
+
+#define FIXED_POINT_FRACTION_BITS 20
+
+namespace agario {
+
+  /**
+   * Tag type which, when used as the underlying type of a numWrapper,
+   * selects the fixed-point numWrapper specialization below. Values
+   * are stored in a 64 bit integer scaled by 2^FracBits, so that all
+   * of the arithmetic on them is integer arithmetic which produces
+   * bit-identical results regardless of compiler, platform or
+   * floating point optimization flags (i.e. -Ofast)
+   */
+  template<unsigned FracBits>
+  struct fixed_point {
+    static_assert(FracBits > 0 && FracBits < 32, "Unsupported number of fraction bits");
+    static constexpr unsigned fraction_bits = FracBits;
+  };
+
+}
+
+/**
+ * Fixed-point specialization of numWrapper. Converts implicitly to and from
+ * the built-in arithmetic types so that it can be used as a drop-in replacement
+ * for the floating point numWrapper, but all operations between two fixed-point
+ * numbers (or between a fixed-point number and an arithmetic constant) are
+ * carried out in exact integer arithmetic.
+ */
+template<unsigned FracBits, int type_distinguisher>
+class numWrapper<agario::fixed_point<FracBits>, type_distinguisher> {
+public:
+  typedef std::int64_t raw_type;
+  typedef float value_type;
+
+  static constexpr raw_type one = raw_type(1) << FracBits;
+
+private:
+  raw_type value;
+
+  typedef __int128 wide_type;
+
+  template<typename U>
+  using if_arithmetic = typename std::enable_if<std::is_arithmetic<U>::value, int>::type;
+
+  template<typename U>
+  using if_integral = typename std::enable_if<std::is_integral<U>::value, int>::type;
+
+  template<typename U>
+  using if_floating = typename std::enable_if<std::is_floating_point<U>::value, int>::type;
+
+  template<int other>
+  using if_other = typename std::enable_if<other != type_distinguisher, int>::type;
+
+  template<int other>
+  using Other = numWrapper<agario::fixed_point<FracBits>, other>;
+
+  static constexpr raw_type multiply(raw_type a, raw_type b) {
+    // round to nearest
+    return static_cast<raw_type>((wide_type(a) * b + (one >> 1)) >> FracBits);
+  }
+
+  static constexpr raw_type divide(raw_type a, raw_type b) {
+    // saturate rather than trap on division by zero (like inf for floats)
+    if (b == 0)
+      return a == 0 ? 0 : (a > 0 ? max_raw : -max_raw);
+    return static_cast<raw_type>((wide_type(a) << FracBits) / b);
+  }
+
+  static constexpr raw_type max_raw = std::numeric_limits<raw_type>::max();
+
+public:
+  constexpr numWrapper() : value(0) {}
+
+  template<typename U, if_integral<U> = 0>
+  constexpr numWrapper(U v) : value(static_cast<raw_type>(v) * one) {}
+
+  template<typename U, if_floating<U> = 0>
+  numWrapper(U v) : value(static_cast<raw_type>(std::llround(v * one))) {}
+
+  /* conversion between fixed-point numbers with a different meaning (e.g. distance to angle) */
+  template<int other, if_other<other> = 0>
+  constexpr explicit numWrapper(const Other<other> &v) : value(v.raw()) {}
+
+  /* construct directly from the underlying scaled integer */
+  static constexpr numWrapper from_raw(raw_type raw) {
+    numWrapper n;
+    n.value = raw;
+    return n;
+  }
+
+  /* construct a compile-time constant */
+  static constexpr numWrapper constant(double v) {
+    return from_raw(static_cast<raw_type>(v * one + (v < 0 ? -0.5 : 0.5)));
+  }
+
+  constexpr raw_type raw() const { return value; }
+
+  operator float() const { return static_cast<float>(value) / one; }
+
+  static constexpr numWrapper max() { return from_raw(max_raw); }
+
+  //modifiers
+  numWrapper &operator+=(numWrapper v) {
+    value += v.value;
+    return *this;
+  }
+
+  numWrapper &operator-=(numWrapper v) {
+    value -= v.value;
+    return *this;
+  }
+
+  numWrapper &operator*=(numWrapper v) {
+    value = multiply(value, v.value);
+    return *this;
+  }
+
+  numWrapper &operator/=(numWrapper v) {
+    value = divide(value, v.value);
+    return *this;
+  }
+
+  numWrapper &operator++() {
+    value += one;
+    return *this;
+  }
+
+  numWrapper &operator--() {
+    value -= one;
+    return *this;
+  }
+
+  numWrapper operator++(int) {
+    numWrapper before = *this;
+    value += one;
+    return before;
+  }
+
+  numWrapper operator--(int) {
+    numWrapper before = *this;
+    value -= one;
+    return before;
+  }
+
+  //accessors
+  constexpr numWrapper operator+() const { return *this; }
+
+  constexpr numWrapper operator-() const { return from_raw(-value); }
+
+  //friends
+  // arithmetic with built-in types is constrained to arithmetic types so that
+  // it can't be ambiguous with the same operators on other fixed-point numWrappers
+  friend numWrapper operator+(numWrapper iw, numWrapper v) { return iw += v; }
+
+  template<typename U, if_arithmetic<U> = 0>
+  friend numWrapper operator+(numWrapper iw, U v) { return iw += v; }
+
+  template<typename U, if_arithmetic<U> = 0>
+  friend numWrapper operator+(U v, numWrapper iw) { return numWrapper(v) += iw; }
+
+  friend numWrapper operator-(numWrapper iw, numWrapper v) { return iw -= v; }
+
+  template<typename U, if_arithmetic<U> = 0>
+  friend numWrapper operator-(numWrapper iw, U v) { return iw -= v; }
+
+  template<typename U, if_arithmetic<U> = 0>
+  friend numWrapper operator-(U v, numWrapper iw) { return numWrapper(v) -= iw; }
+
+  friend numWrapper operator*(numWrapper iw, numWrapper v) { return iw *= v; }
+
+  template<typename U, if_arithmetic<U> = 0>
+  friend numWrapper operator*(numWrapper iw, U v) { return iw *= v; }
+
+  template<typename U, if_arithmetic<U> = 0>
+  friend numWrapper operator*(U v, numWrapper iw) { return numWrapper(v) *= iw; }
+
+  friend numWrapper operator/(numWrapper iw, numWrapper v) { return iw /= v; }
+
+  template<typename U, if_arithmetic<U> = 0>
+  friend numWrapper operator/(numWrapper iw, U v) { return iw /= v; }
+
+  template<typename U, if_arithmetic<U> = 0>
+  friend numWrapper operator/(U v, numWrapper iw) { return numWrapper(v) /= iw; }
+
+  // scaling by a fixed-point number with a different meaning keeps the meaning of the left operand
+  template<int other, if_other<other> = 0>
+  friend numWrapper operator*(numWrapper iw, Other<other> v) { return iw *= numWrapper(v); }
+
+  template<int other, if_other<other> = 0>
+  friend numWrapper operator/(numWrapper iw, Other<other> v) { return iw /= numWrapper(v); }
+
+  // comparisons, which would otherwise be done (lossily) in floating point
+  friend bool operator==(numWrapper a, numWrapper b) { return a.value == b.value; }
+  friend bool operator!=(numWrapper a, numWrapper b) { return a.value != b.value; }
+  friend bool operator<(numWrapper a, numWrapper b) { return a.value < b.value; }
+  friend bool operator>(numWrapper a, numWrapper b) { return a.value > b.value; }
+  friend bool operator<=(numWrapper a, numWrapper b) { return a.value <= b.value; }
+  friend bool operator>=(numWrapper a, numWrapper b) { return a.value >= b.value; }
+
+  template<typename U, if_arithmetic<U> = 0>
+  friend bool operator==(numWrapper a, U b) { return a == numWrapper(b); }
+  template<typename U, if_arithmetic<U> = 0>
+  friend bool operator==(U a, numWrapper b) { return numWrapper(a) == b; }
+  template<typename U, if_arithmetic<U> = 0>
+  friend bool operator!=(numWrapper a, U b) { return a != numWrapper(b); }
+  template<typename U, if_arithmetic<U> = 0>
+  friend bool operator!=(U a, numWrapper b) { return numWrapper(a) != b; }
+  template<typename U, if_arithmetic<U> = 0>
+  friend bool operator<(numWrapper a, U b) { return a < numWrapper(b); }
+  template<typename U, if_arithmetic<U> = 0>
+  friend bool operator<(U a, numWrapper b) { return numWrapper(a) < b; }
+  template<typename U, if_arithmetic<U> = 0>
+  friend bool operator>(numWrapper a, U b) { return a > numWrapper(b); }
+  template<typename U, if_arithmetic<U> = 0>
+  friend bool operator>(U a, numWrapper b) { return numWrapper(a) > b; }
+  template<typename U, if_arithmetic<U> = 0>
+  friend bool operator<=(numWrapper a, U b) { return a <= numWrapper(b); }
+  template<typename U, if_arithmetic<U> = 0>
+  friend bool operator<=(U a, numWrapper b) { return numWrapper(a) <= b; }
+  template<typename U, if_arithmetic<U> = 0>
+  friend bool operator>=(numWrapper a, U b) { return a >= numWrapper(b); }
+  template<typename U, if_arithmetic<U> = 0>
+  friend bool operator>=(U a, numWrapper b) { return numWrapper(a) >= b; }
+};
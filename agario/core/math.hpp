@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "agario/core/num_wrapper.hpp"
+#include "agario/core/fixed_point.hpp"
+
+/**
+ * Math functions on the game's numeric types (agario::distance, agario::angle).
+ * For the default floating point types these just forward to the standard
+ * library. For the fixed-point types (deterministic build) they are computed
+ * with integer arithmetic only, so that the results don't depend on the libm
+ * implementation, compiler or optimization flags.
+ *
+ * The trigonometric functions return the underlying floating point type for
+ * floating point arguments (as the std:: functions would) and a fixed-point
+ * number of the same type as their argument for fixed-point arguments.
+ */
+namespace agario::math {
+
+  /* ================ floating point ================ */
+
+  template<typename T, int id>
+  numWrapper<T, id> abs(numWrapper<T, id> x) { return std::abs(static_cast<T>(x)); }
+
+  template<typename T, int id>
+  numWrapper<T, id> sqrt(numWrapper<T, id> x) { return std::sqrt(static_cast<T>(x)); }
+
+  template<typename T, int id, typename U>
+  numWrapper<T, id> pow(numWrapper<T, id> x, U y) {
+    return std::pow(static_cast<T>(x), static_cast<T>(y));
+  }
+
+  template<typename T, int id>
+  T sin(numWrapper<T, id> x) { return std::sin(static_cast<T>(x)); }
+
+  template<typename T, int id>
+  T cos(numWrapper<T, id> x) { return std::cos(static_cast<T>(x)); }
+
+  template<typename T, int id>
+  T atan(numWrapper<T, id> x) { return std::atan(static_cast<T>(x)); }
+
+  /* ================ fixed point ================ */
+
+  template<unsigned F, int id>
+  using fixed = numWrapper<agario::fixed_point<F>, id>;
+
+  namespace detail {
+
+    /* floor(sqrt(n)), exact for all n */
+    inline std::uint64_t isqrt(unsigned __int128 n) {
+      // the (correctly rounded) floating point square root is only used as a first
+      // guess, which is then corrected so that the result is exact on any platform
+      auto root = static_cast<std::uint64_t>(std::sqrt(static_cast<double>(n)));
+      while (static_cast<unsigned __int128>(root) * root > n)
+        root--;
+      while (static_cast<unsigned __int128>(root + 1) * (root + 1) <= n)
+        root++;
+      return root;
+    }
+
+    /* sin(x) for x in [-pi/2, pi/2] (Taylor series, error < 4e-6) */
+    template<unsigned F, int id>
+    fixed<F, id> sin_reduced(fixed<F, id> x) {
+      using W = fixed<F, id>;
+      auto x2 = x * x;
+      auto poly = W::constant(1.0 / 362880);
+      poly = W::constant(-1.0 / 5040) + x2 * poly;
+      poly = W::constant(1.0 / 120) + x2 * poly;
+      poly = W::constant(-1.0 / 6) + x2 * poly;
+      poly = W(1) + x2 * poly;
+      return x * poly;
+    }
+
+    /* atan(x) for x in [-1, 1] (Abramowitz & Stegun 4.4.49, error < 1e-5) */
+    template<unsigned F, int id>
+    fixed<F, id> atan_reduced(fixed<F, id> x) {
+      using W = fixed<F, id>;
+      auto x2 = x * x;
+      auto poly = W::constant(0.0208351);
+      poly = W::constant(-0.0851330) + x2 * poly;
+      poly = W::constant(0.1801410) + x2 * poly;
+      poly = W::constant(-0.3302995) + x2 * poly;
+      poly = W::constant(0.9998660) + x2 * poly;
+      return x * poly;
+    }
+
+    /* base-2 logarithm of a positive number, computed bit by bit */
+    template<unsigned F, int id>
+    fixed<F, id> log2(fixed<F, id> x) {
+      using W = fixed<F, id>;
+      using raw_type = typename W::raw_type;
+      constexpr raw_type one = W::one;
+
+      auto raw = x.raw();
+      if (raw <= 0) return -W::max();
+
+      // integer part: position of the most significant bit
+      int msb = 63 - __builtin_clzll(static_cast<unsigned long long>(raw));
+      raw_type result = static_cast<raw_type>(msb - static_cast<int>(F)) * one;
+
+      // normalize into [1, 2)
+      raw_type y = msb >= static_cast<int>(F) ? raw >> (msb - F) : raw << (F - msb);
+
+      // fractional part: square and check for overflow past 2, one bit at a time
+      for (raw_type bit = one >> 1; bit > 0; bit >>= 1) {
+        y = static_cast<raw_type>((static_cast<__int128>(y) * y) >> F);
+        if (y >= 2 * one) {
+          y >>= 1;
+          result += bit;
+        }
+      }
+      return W::from_raw(result);
+    }
+
+    /* 2 to the power of x */
+    template<unsigned F, int id>
+    fixed<F, id> exp2(fixed<F, id> x) {
+      using W = fixed<F, id>;
+      using raw_type = typename W::raw_type;
+
+      raw_type n = x.raw() >> F; // floor
+      auto f = W::from_raw(x.raw() - n * W::one); // [0, 1)
+
+      if (n >= 62 - static_cast<raw_type>(F)) return W::max();
+      if (n < -static_cast<raw_type>(F) - 1) return W(0);
+
+      // 2^f = e^(f ln 2) (Taylor series, error < 2e-7)
+      constexpr double ln2 = 0.69314718055994530942;
+      auto poly = W::constant(ln2 * ln2 * ln2 * ln2 * ln2 * ln2 * ln2 * ln2 / 40320);
+      poly = W::constant(ln2 * ln2 * ln2 * ln2 * ln2 * ln2 * ln2 / 5040) + f * poly;
+      poly = W::constant(ln2 * ln2 * ln2 * ln2 * ln2 * ln2 / 720) + f * poly;
+      poly = W::constant(ln2 * ln2 * ln2 * ln2 * ln2 / 120) + f * poly;
+      poly = W::constant(ln2 * ln2 * ln2 * ln2 / 24) + f * poly;
+      poly = W::constant(ln2 * ln2 * ln2 / 6) + f * poly;
+      poly = W::constant(ln2 * ln2 / 2) + f * poly;
+      poly = W::constant(ln2) + f * poly;
+      poly = W(1) + f * poly;
+
+      auto raw = poly.raw();
+      return W::from_raw(n >= 0 ? raw << n : raw >> -n);
+    }
+
+  } // namespace detail
+
+  template<unsigned F, int id>
+  fixed<F, id> abs(fixed<F, id> x) {
+    return x.raw() < 0 ? -x : x;
+  }
+
+  template<unsigned F, int id>
+  fixed<F, id> sqrt(fixed<F, id> x) {
+    using W = fixed<F, id>;
+    if (x.raw() <= 0) return W(0);
+    auto scaled = static_cast<unsigned __int128>(x.raw()) << F;
+    return W::from_raw(static_cast<typename W::raw_type>(detail::isqrt(scaled)));
+  }
+
+  template<unsigned F, int id, typename U>
+  fixed<F, id> pow(fixed<F, id> x, U y) {
+    using W = fixed<F, id>;
+    if (x.raw() <= 0) return W(0);
+    return detail::exp2(W(y) * detail::log2(x));
+  }
+
+  template<unsigned F, int id>
+  fixed<F, id> sin(fixed<F, id> x) {
+    using W = fixed<F, id>;
+    constexpr auto pi = W::constant(M_PI);
+    constexpr auto half_pi = W::constant(M_PI / 2);
+    constexpr auto two_pi = W::constant(2 * M_PI);
+
+    // reduce to [-pi, pi]
+    auto reduced = W::from_raw(x.raw() % two_pi.raw());
+    if (reduced > pi) reduced -= two_pi;
+    else if (reduced < -pi) reduced += two_pi;
+
+    // reduce to [-pi/2, pi/2] using sin(pi - x) = sin(x)
+    if (reduced > half_pi) reduced = pi - reduced;
+    else if (reduced < -half_pi) reduced = -pi - reduced;
+
+    return detail::sin_reduced(reduced);
+  }
+
+  template<unsigned F, int id>
+  fixed<F, id> cos(fixed<F, id> x) {
+    return math::sin(x + fixed<F, id>::constant(M_PI / 2));
+  }
+
+  template<unsigned F, int id>
+  fixed<F, id> atan(fixed<F, id> x) {
+    using W = fixed<F, id>;
+    constexpr auto half_pi = W::constant(M_PI / 2);
+
+    // atan(x) = +/- pi/2 - atan(1/x) for |x| > 1
+    if (x > 1) return half_pi - detail::atan_reduced(W(1) / x);
+    if (x < -1) return -half_pi - detail::atan_reduced(W(1) / x);
+    return detail::atan_reduced(x);
+  }
+
+}
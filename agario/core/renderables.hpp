@@ -10,6 +10,10 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
 #include <agario/core/Ball.hpp>
 #include <agario/rendering/shader.hpp>
 
@@ -30,33 +34,38 @@ namespace agario {
     GLuint vbo; // vertex buffer object (gpu memory)
 
     void set_color(agario::color c) {
-      GLfloat *color_array;
-      switch (c) {
-        case agario::color::red:
-          color_array = red_color;
-          break;
-        case agario::color::blue:
-          color_array = blue_color;
-          break;
-        case agario::color::green:
-          color_array = green_color;
-          break;
-        case agario::color::orange:
-          color_array = orange_color;
-          break;
-        case agario::color::purple:
-          color_array = purple_color;
-          break;
-        case agario::color::yellow:
-          color_array = yellow_color;
-          break;
-        default:
-          throw RenderingException("Not a color");
-      }
+      auto color_array = color_values(c);
       std::copy(color_array, color_array + COLOR_LEN, color);
     }
   };
 
+  /* fills a circle's vertices with a triangle fan around the unit circle */
+  template<unsigned NSides>
+  void circle_vertices(Circle<NSides> &circle) {
+    circle.verts[0] = 0;
+    circle.verts[1] = 0;
+    circle.verts[2] = 0;
+    for (unsigned i = 1; i < NSides + 2; i++) {
+      circle.verts[i * 3] = cos(i * 2 * M_PI / NSides);
+      circle.verts[i * 3 + 1] = sin(i * 2 * M_PI / NSides);
+      circle.verts[i * 3 + 2] = 0;
+    }
+  }
+
+  /* like circle_vertices, with the wavy border of a virus */
+  template<unsigned NSides>
+  void virus_vertices(Circle<NSides> &circle) {
+    circle.verts[0] = 0;
+    circle.verts[1] = 0;
+    circle.verts[2] = 0;
+    for (unsigned i = 1; i < NSides + 2; i++) {
+      auto radius = 1 + sin(30 * M_PI * i / NSides) / 15;
+      circle.verts[i * 3] = radius * cos(i * 2 * M_PI / NSides);
+      circle.verts[i * 3 + 1] = radius * sin(i * 2 * M_PI / NSides);
+      circle.verts[i * 3 + 2] = 0;
+    }
+  }
+
   template<unsigned NSides>
   class RenderableBall : virtual public Ball {
   public:
@@ -159,14 +168,7 @@ namespace agario {
     }
 
     virtual void _create_vertices() {
-      circle.verts[0] = 0;
-      circle.verts[1] = 0;
-      circle.verts[2] = 0;
-      for (unsigned i = 1; i < NVertices; i++) {
-        circle.verts[i * 3] = cos(i * 2 * M_PI / NSides);
-        circle.verts[i * 3 + 1] = sin(i * 2 * M_PI / NSides);
-        circle.verts[i * 3 + 2] = 0;
-      }
+      circle_vertices(circle);
     }
   };
 
@@ -212,6 +214,120 @@ namespace agario {
 
   };
 
+  /**
+   * Draws any number of balls of one kind with a single instanced draw call.
+   * The batch owns one unit mesh (on the GPU), and each frame the balls'
+   * positions, radii and colors are collected with `add` and streamed to an
+   * instance buffer by `draw`, so that the balls themselves need no GL objects.
+   * Must be drawn with the instanced shader (shaders/instanced_vertex.glsl).
+   */
+  template<unsigned NSides>
+  class BallBatch {
+  public:
+    struct Instance {
+      GLfloat x, y, radius;
+      GLfloat color[COLOR_LEN];
+    };
+
+    /* @param wavy whether to give the mesh the wavy border of a virus */
+    explicit BallBatch(bool wavy = false) : wavy(wavy), capacity(0), uploaded(0), _initialized(false) {}
+
+    BallBatch(const BallBatch &) = delete;
+    BallBatch &operator=(const BallBatch &) = delete;
+
+    void clear() { instances.clear(); }
+
+    [[nodiscard]] std::size_t size() const { return instances.size(); }
+
+    void add(GLfloat x, GLfloat y, GLfloat radius, agario::color c) {
+      auto color_array = color_values(c);
+      instances.push_back({ x, y, radius, { color_array[0], color_array[1], color_array[2] }});
+    }
+
+    template<typename B>
+    void add(const B &ball) {
+      add(static_cast<GLfloat>(ball.x), static_cast<GLfloat>(ball.y), static_cast<GLfloat>(ball.radius()), ball.color);
+    }
+
+    /* draws every ball added since the last clear */
+    void draw() {
+      upload();
+      draw_uploaded();
+    }
+
+    /* streams the balls added since the last clear to the instance buffer */
+    void upload() {
+      uploaded = instances.size();
+      if (instances.empty()) return;
+      if (!_initialized) _initialize();
+
+      glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+      // orphan last frame's storage (growing it if needed), so as not to wait for the GPU to finish with it
+      capacity = std::max(capacity, instances.capacity());
+      glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+      glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+    }
+
+    /* draws the balls last uploaded, as many times as needed (e.g. once for each of several views) */
+    void draw_uploaded() {
+      if (uploaded == 0) return;
+      glBindVertexArray(mesh.vao);
+      glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, NVertices, static_cast<GLsizei>(uploaded));
+      glBindVertexArray(0);
+    }
+
+    ~BallBatch() {
+      if (_initialized) {
+        glDeleteVertexArrays(1, &mesh.vao);
+        glDeleteBuffers(1, &mesh.vbo);
+        glDeleteBuffers(1, &instance_vbo);
+      }
+    }
+
+  private:
+    static constexpr unsigned NVertices = NSides + 2;
+
+    bool wavy;
+    std::vector<Instance> instances;
+    std::size_t capacity; // of the instance buffer, in instances
+    std::size_t uploaded; // instances in the instance buffer
+
+    Circle<NSides> mesh;
+    GLuint instance_vbo;
+    bool _initialized;
+
+    void _initialize() {
+      if (wavy) virus_vertices(mesh);
+      else circle_vertices(mesh);
+
+      glGenVertexArrays(1, &mesh.vao);
+      glGenBuffers(1, &mesh.vbo);
+      glGenBuffers(1, &instance_vbo);
+
+      glBindVertexArray(mesh.vao);
+      glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+      glBufferData(GL_ARRAY_BUFFER, sizeof(mesh.verts), mesh.verts, GL_STATIC_DRAW);
+
+      // Position attribute
+      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+      glEnableVertexAttribArray(0);
+
+      // per-instance position/radius and color attributes
+      glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                            reinterpret_cast<void *>(offsetof(Instance, x)));
+      glEnableVertexAttribArray(1);
+      glVertexAttribDivisor(1, 1);
+      glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                            reinterpret_cast<void *>(offsetof(Instance, color)));
+      glEnableVertexAttribArray(2);
+      glVertexAttribDivisor(2, 1);
+
+      glBindVertexArray(0);
+      _initialized = true;
+    }
+  };
+
   template<unsigned NLines>
   class Grid {
   public:
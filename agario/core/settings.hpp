@@ -27,5 +27,15 @@
 #define DEFAULT_ARENA_HEIGHT 500
 
 #define DEFAULT_NUM_PELLETS 1024
+
+// eaten pellets are respawned over about this many ticks, and
+// at most PELLET_RESPAWN_LIMIT in a tick unless that's too few to
+#define PELLET_RESPAWN_SPREAD 8
+#define PELLET_RESPAWN_LIMIT 32
+
 #define DEFAULT_NUM_VIRUSES 25
-#define PLAYER_CELL_LIMIT 25
\ No newline at end of file
+#define PLAYER_CELL_LIMIT 25
+
+// procedurally generated pellets (see PelletField)
+#define PELLETS_PER_REGION 32
+#define PELLET_RESPAWN_TICKS 60
@@ -5,6 +5,8 @@
 #include <chrono>
 
 #include "agario/core/num_wrapper.hpp"
+#include "agario/core/fixed_point.hpp"
+#include "agario/core/math.hpp"
 
 namespace agario {
 
@@ -41,11 +43,22 @@ namespace agario {
    * functions. These two types are distinguished
    * by the enum _type_id so that they can have semantically
    * different meanings. Overhead of the numWrapper
-   * class (hopefully) gets compiled away
+   * class (hopefully) gets compiled away.
+   *
+   * Compiling with DETERMINISTIC defined swaps the underlying
+   * floating point type for a fixed-point type (see fixed_point.hpp)
+   * so that games play out identically on any machine, compiler,
+   * or set of optimization flags.
    */
+#ifdef DETERMINISTIC
+  using real = agario::fixed_point<FIXED_POINT_FRACTION_BITS>;
+#else
+  using real = float;
+#endif
+
   enum _type_id { _distance, _angle };
-  using distance = numWrapper<float, _distance>;
-  using angle    = numWrapper<float, _angle>;
+  using distance = numWrapper<real, _distance>;
+  using angle    = numWrapper<real, _angle>;
 
   typedef unsigned int mass;
   typedef unsigned int score;
@@ -81,13 +94,11 @@ namespace agario {
     }
 
     T norm_sqr() const {
-      auto dx = std::abs(x);
-      auto dy = std::abs(y);
-      return dx * dx + dy * dy;
+      return x * x + y * y;
     }
 
     T norm() const {
-      return std::sqrt(norm_sqr());
+      return math::sqrt(norm_sqr());
     }
 
     void normalize() {
@@ -156,7 +167,7 @@ namespace agario {
     Velocity(agario::Location dir) : Velocity(dir.x, dir.y) {}
 
     Velocity(agario::angle angle, agario::distance speed) :
-      dx(speed * std::cos(angle)), dy(speed * std::sin(angle)) {}
+      dx(speed * math::cos(angle)), dy(speed * math::sin(angle)) {}
 
     void set_speed(float new_speed) {
       // sets the speed without changing direction
@@ -165,7 +176,7 @@ namespace agario {
     }
 
     agario::angle direction() const {
-      auto angle = std::atan(dx / dy);
+      auto angle = math::atan(dx / dy);
       if (dx < 0) {
         if (dy > 0) angle += M_PI;
         else angle -= M_PI;
@@ -210,23 +221,23 @@ namespace agario {
       auto y_ratio = dy / magnitude();
 
       auto ddx = x_ratio * decel;
-      if (std::abs(ddx * dt) <= std::abs(dx))
+      if (math::abs(ddx * dt) <= math::abs(dx))
         dx -= ddx * dt;
       else
         dx = 0;
 
       auto ddy = y_ratio * decel;
-      if (std::abs(ddy * dt) <= std::abs(dy))
+      if (math::abs(ddy * dt) <= math::abs(dy))
         dy -= ddy * dt;
       else
         dy = 0;
     }
 
-    float magnitude() const {
-      return sqrt(dx * dx + dy * dy);
+    agario::distance magnitude() const {
+      return math::sqrt(dx * dx + dy * dy);
     }
 
-    float speed() const { return magnitude(); }
+    agario::distance speed() const { return magnitude(); }
 
     Velocity &operator+=(const Velocity &rhs) {
       dx += rhs.dx;
@@ -5,13 +5,13 @@
 
 namespace agario {
 
-  agario::distance radius_conversion(mass mass) {
+  inline agario::distance radius_conversion(mass mass) {
     auto area = mass / MASS_AREA_RADIO;
     return (distance) std::sqrt(area / M_PI);
   }
 
-  agario::mass mass_conversion(distance radius) {
-    auto area = M_PI * std::pow(radius, 2);
+  inline agario::mass mass_conversion(distance radius) {
+    auto area = M_PI * (radius * radius);
     return static_cast<agario::mass>(std::round(MASS_AREA_RADIO * area));
   }
 
@@ -20,6 +20,11 @@ namespace agario {
     return std::max<T>(std::min<T>(x, high), low);
   }
 
+  /* the width (and height) of the region of the arena that a player of `mass` sees */
+  inline float view_size(agario::mass mass) {
+    return clamp<float>(2 * mass, 100, 300);
+  }
+
   template <typename T> T div_round_up(T num, T denom) {
     return static_cast<T>((num + denom - 1) / denom);
   }
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "agario/core/types.hpp"
+#include "agario/core/utils.hpp"
+
+namespace agario {
+
+  /**
+   * The arena divided into a fixed grid of columns by rows tiles, into which
+   * entries (ids, such as the ordinals of cells) are sorted by location.
+   * Each tile's entries are contiguous, in the order that they were added,
+   * and queries visit only the tiles which overlap the area searched, so the
+   * entries of one tile can find those just across its border (its halo).
+   */
+  class ArenaTiles {
+  public:
+    struct Entry {
+      Location location;
+      std::uint32_t id;
+    };
+
+    void configure(agario::distance width, agario::distance height, int cols, int rows) {
+      _cols = std::max(1, cols);
+      _rows = std::max(1, rows);
+      _tile_width = width / _cols;
+      _tile_height = height / _rows;
+    }
+
+    [[nodiscard]] int cols() const { return _cols; }
+    [[nodiscard]] int rows() const { return _rows; }
+    [[nodiscard]] std::size_t num_tiles() const { return static_cast<std::size_t>(_cols) * _rows; }
+
+    void clear() { _staged.clear(); }
+    void add(const Location &location, std::uint32_t id) { _staged.push_back(Entry { location, id }); }
+
+    /* counting sort of the entries added since `clear` into their tiles, keeping their order within each */
+    void sort() {
+      _starts.assign(num_tiles() + 1, 0);
+      _tiles.resize(_staged.size());
+      for (std::size_t i = 0; i < _staged.size(); i++) {
+        _tiles[i] = tile(_staged[i].location);
+        _starts[_tiles[i] + 1]++;
+      }
+      for (std::size_t t = 1; t < _starts.size(); t++)
+        _starts[t] += _starts[t - 1];
+
+      _entries.resize(_staged.size());
+      auto next = _starts;
+      for (std::size_t i = 0; i < _staged.size(); i++)
+        _entries[next[_tiles[i]]++] = _staged[i];
+    }
+
+    [[nodiscard]] const Entry *begin(std::size_t tile) const { return _entries.data() + _starts[tile]; }
+    [[nodiscard]] const Entry *end(std::size_t tile) const { return _entries.data() + _starts[tile + 1]; }
+
+    /* calls `f` with each entry inside the box [lower, upper] */
+    template<typename F>
+    void for_each_in_box(const Location &lower, const Location &upper, F &&f) const {
+      if (_entries.empty()) return;
+      int col_min = col(lower.x), col_max = col(upper.x);
+      int row_min = row(lower.y), row_max = row(upper.y);
+      for (int r = row_min; r <= row_max; r++) {
+        auto first = _starts[r * _cols + col_min];
+        auto last = _starts[r * _cols + col_max + 1];
+        for (auto i = first; i < last; i++) {
+          auto &entry = _entries[i];
+          if (lower.x <= entry.location.x && entry.location.x <= upper.x &&
+              lower.y <= entry.location.y && entry.location.y <= upper.y)
+            f(entry);
+        }
+      }
+    }
+
+  private:
+    int _cols = 1, _rows = 1;
+    agario::distance _tile_width = 1, _tile_height = 1;
+
+    std::vector<Entry> _staged;          // entries in the order added, before sorting
+    std::vector<Entry> _entries;         // sorted by tile
+    std::vector<std::uint32_t> _starts;  // of each tile's entries, with the total at the end
+    std::vector<std::uint32_t> _tiles;   // the tile of each staged entry
+
+    std::size_t tile(const Location &location) const { return row(location.y) * _cols + col(location.x); }
+    int col(agario::distance x) const { return index(x / _tile_width, _cols); }
+    int row(agario::distance y) const { return index(y / _tile_height, _rows); }
+
+    static int index(agario::distance coordinate, int count) {
+      return static_cast<int>(clamp<float>(std::floor(static_cast<float>(coordinate)), 0, count - 1));
+    }
+  };
+
+  /* how the players' interactions were settled by tiled ticks (see Engine::set_arena_tiles), accumulated over ticks */
+  struct TileStats {
+    std::uint64_t settled_in_tiles = 0; // players fed, and players collided, by the tiles (in parallel)
+    std::uint64_t settled_serially = 0; // by the serial pass, or every pair, when groups grew too far
+
+    /* the fraction of the players' interactions that were settled in parallel */
+    [[nodiscard]] double parallel_fraction() const {
+      auto total = settled_in_tiles + settled_serially;
+      return total == 0 ? 0 : static_cast<double>(settled_in_tiles) / total;
+    }
+  };
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include "agario/core/types.hpp"
+
+namespace agario {
+
+  /**
+   * When bots decide (see Engine::set_bot_schedule). By default every bot
+   * decides on every `period`th tick, all of them on the same tick. When
+   * staggered, each bot decides on its own tick of the period (by pid), so
+   * that about as many decide on every tick. With a `distant_period`, bots
+   * that are out of the view of every agent (every plain player, which isn't
+   * a bot), or that have nothing near them, only decide that often.
+   */
+  struct BotSchedule {
+    int period = 10;                    // ticks between a bot's decisions
+    bool staggered = false;             // spread decisions over the ticks of each period
+    int distant_period = 0;             // a multiple of `period`, or 0 for every bot to decide every period
+    agario::distance view_margin = 50;  // how far beyond an agent's view a bot still counts as in view
+    agario::distance idle_radius = 0;   // a bot with nothing this near it is idle (or with 0, never)
+  };
+
+  /* how often bots have decided, accumulated over game ticks */
+  struct BotDecisionStats {
+    std::uint64_t ticks = 0;
+    std::uint64_t bot_ticks = 0;      // the sum over ticks of the number of living bots
+    std::uint64_t decisions = 0;
+    std::uint64_t deferred = 0;       // decisions put off because the bot was out of view or idle
+    std::uint64_t peak_decisions = 0; // the most decisions made on any one tick
+
+    /* decisions per bot per tick (1 / the mean ticks between a bot's decisions) */
+    [[nodiscard]] double rate() const {
+      return bot_ticks == 0 ? 0 : static_cast<double>(decisions) / bot_ticks;
+    }
+
+    /* decisions per tick */
+    [[nodiscard]] double per_tick() const {
+      return ticks == 0 ? 0 : static_cast<double>(decisions) / ticks;
+    }
+  };
+
+}
@@ -1,16 +1,30 @@
 #pragma once
 
 #include <vector>
+#include <cmath>
 #include <cstdlib>
+#include <functional>
+#include <typeindex>
+#include <typeinfo>
 #include <chrono>
 #include <algorithm>
+#include <iterator>
 #include <sstream>
+#include <random>
+#include <istream>
+#include <ostream>
 
 #include "agario/core/Player.hpp"
 #include "agario/core/settings.hpp"
 #include "agario/core/types.hpp"
 #include "agario/core/Entities.hpp"
+#include "agario/engine/ArenaTiles.hpp"
+#include "agario/engine/BotSchedule.hpp"
 #include "agario/engine/GameState.hpp"
+#include "agario/engine/TickStats.hpp"
+#include "agario/engine/binary.hpp"
+#include "utils/thread-pool.h"
+#include "utils/trace.h"
 
 namespace agario {
 
@@ -18,6 +32,18 @@ namespace agario {
     using runtime_error::runtime_error;
   };
 
+  /**
+   * Is notified around each game tick, and whenever players are added, respawned
+   * or the game is reset in between ticks (e.g. ReplayRecorder, see Replay.hpp)
+   */
+  class EngineObserver {
+  public:
+    virtual void before_tick() {}
+    virtual void after_tick(const agario::time_delta &/* elapsed_seconds */) {}
+    virtual void state_changed() {}
+    virtual ~EngineObserver() = default;
+  };
+
   template<bool renderable>
   class Engine {
   public:
@@ -28,15 +54,19 @@ namespace agario {
     using Virus = Virus<renderable>;
     using GameState = GameState<renderable>;
 
+    /* calls the given function with each of 0 ... n - 1, returning once all calls have */
+    using ParallelFor = SpatialIndex::ParallelFor;
+
     Engine(distance arena_width, distance arena_height,
            int num_pellets = DEFAULT_NUM_PELLETS,
            int num_viruses = DEFAULT_NUM_VIRUSES,
-           bool pellet_regen = true) :
-      state(arena_width, arena_height),
+           bool pellet_regen = true,
+           bool procedural_pellets = false) :
+      state(arena_width, arena_height), next_pid(0),
       _num_pellets(num_pellets), _num_virus(num_viruses),
-      _pellet_regen(pellet_regen),
-      next_pid(0) {
-      std::srand(std::chrono::system_clock::now().time_since_epoch().count());
+      _pellet_regen(pellet_regen), _procedural_pellets(procedural_pellets),
+      _pellet_respawn_backlog(0), _observer(nullptr) {
+      seed(std::chrono::system_clock::now().time_since_epoch().count());
     }
     Engine() : Engine(DEFAULT_ARENA_WIDTH, DEFAULT_ARENA_HEIGHT) {}
 
@@ -51,11 +81,23 @@ namespace agario {
     agario::distance arena_width() const { return state.arena_width; }
     agario::distance arena_height() const { return state.arena_height; }
     int player_count() const { return state.players.size(); }
-    int pellet_count() const { return state.pellets.size(); }
+    const agario::PelletField &pellet_field() const { return state.pellet_field; }
+    int pellet_count() const { return state.pellet_count(); }
     int virus_count() const { return state.viruses.size(); }
     int food_count() const { return state.foods.size(); }
     bool pellet_regen() const { return _pellet_regen; };
 
+    /* the number of pellets and viruses that the arena is (re)filled with */
+    int num_pellets() const { return _num_pellets; }
+    int num_viruses() const { return _num_virus; }
+
+    /* timing and collision test counts, recorded if compiled with ENGINE_PROFILING */
+    const TickStats &stats() const { return _stats; }
+    void reset_stats() { _stats = TickStats(); }
+
+    /* whether pellets are procedurally generated (see PelletField) rather than stored */
+    bool procedural_pellets() const { return _procedural_pellets; }
+
     template<typename P>
     agario::pid add_player(const std::string &name = std::string()) {
       auto pid = next_pid++;
@@ -69,9 +111,17 @@ namespace agario {
 
       auto p = state.players.insert(std::make_pair(pid, player));
       _respawn(*player);
+      if (_observer) _observer->state_changed();
       return pid;
     }
 
+    /* removes the player `pid` (and its cells) from the game */
+    void remove_player(agario::pid pid) {
+      if (state.players.erase(pid) == 0)
+        throw EngineException("Player ID: " + std::to_string(pid) + " does not exist.");
+      if (_observer) _observer->state_changed();
+    }
+
     Player &player(agario::pid pid) {
       return const_cast<Player &>(get_player(pid));
     }
@@ -87,15 +137,25 @@ namespace agario {
 
     void reset() {
       state.clear();
+      _pellet_respawn_backlog = 0;
       initialize_game();
+      if (_observer) _observer->state_changed();
     }
 
     void initialize_game() {
-      add_pellets(_num_pellets);
+      if (_procedural_pellets)
+        state.pellet_field.configure(arena_width(), arena_height(), _num_pellets, rng());
+      else {
+        state.pellets.reserve(_num_pellets);
+        add_pellets(_num_pellets);
+      }
       add_viruses(_num_virus);
     }
 
-    void respawn(agario::pid pid) { _respawn(player(pid)); }
+    void respawn(agario::pid pid) {
+      _respawn(player(pid));
+      if (_observer) _observer->state_changed();
+    }
 
     agario::Location random_location() {
       auto x = random<agario::distance>(arena_width());
@@ -110,24 +170,240 @@ namespace agario {
      * since the previous game tick.
      */
     void tick(const agario::time_delta &elapsed_seconds) {
-      for (auto &pair : state.players) {
-        auto &player = *pair.second;
-        if (!player.dead())
-          tick_player(player, elapsed_seconds);
+      PROFILE_TICK(_stats);
+      TRACE_SCOPE("tick");
+      if (_observer) _observer->before_tick();
+
+      {
+        TRACE_SCOPE("players");
+        count_bots();
+        _decided = false;
+        if (_bot_schedule.staggered || ticks() % _bot_schedule.period == 0)
+          decide();
+        if (_tiled) {
+          tick_players_tiled(elapsed_seconds);
+        } else {
+          for (auto &pair : state.players) {
+            auto &player = *pair.second;
+            if (!player.dead())
+              tick_player(player, elapsed_seconds);
+          }
+        }
       }
 
-      check_player_collisions();
+      if (_tiled)
+        check_player_collisions_tiled();
+      else
+        check_player_collisions();
 
       move_foods(elapsed_seconds);
 
-      if (_pellet_regen) {
-        add_pellets(_num_pellets - state.pellets.size());
+      {
+        PROFILE_PHASE(_stats, regeneration);
+        TRACE_SCOPE("regeneration");
+        if (_pellet_regen) {
+          if (_procedural_pellets)
+            state.pellet_field.regenerate(state.ticks);
+          else
+            respawn_pellets();
+        }
+        add_viruses(_num_virus - state.viruses.size());
       }
-      add_viruses(_num_virus - state.viruses.size());
       state.ticks++;
+
+#ifdef ENGINE_PROFILING
+      record_entity_counts();
+#endif
+      if (_observer) _observer->after_tick(elapsed_seconds);
+    }
+
+    /* seeds the engine's random number generator, which determines
+     * where all entities are (re)spawned */
+    void seed(unsigned s) { rng.seed(s); }
+
+    /**
+     * Makes bots decide in parallel, by calling `parallel_for(n, f)`, which must
+     * call f(0) ... f(n - 1) (in any order, on any threads) and return once they
+     * all have, with batches of at most `batch_size` bots. Decisions only read
+     * the game state, so the game plays out the same as when they are serial.
+     * Pass nullptr to go back to deciding on the ticking thread.
+     */
+    void set_parallel_decisions(ParallelFor parallel_for, std::size_t batch_size = 16) {
+      _parallel_for = std::move(parallel_for);
+      _decision_batch_size = std::max<std::size_t>(1, batch_size);
     }
 
-    void seed(unsigned s) { std::srand(s); }
+    /* makes bots decide in parallel on `pool` (see set_parallel_decisions), or serially again with nullptr */
+    void set_thread_pool(ThreadPool *pool, std::size_t batch_size = 16) {
+      if (pool == nullptr) {
+        set_parallel_decisions(nullptr);
+        return;
+      }
+      set_parallel_decisions([pool](std::size_t n, const std::function<void(std::size_t)> &f) {
+        pool->parallel_for(n, f, 1);
+      }, batch_size);
+    }
+
+    /**
+     * Splits the arena into `columns` by `rows` tiles which settle the players'
+     * interactions in parallel (on the threads given to set_parallel_decisions or
+     * set_thread_pool, if any). Each tick, players whose cells might reach the
+     * same pellets, food or viruses (or, later, each other) are grouped, and each
+     * group is owned by the lowest numbered tile that holds one of its cells, so
+     * a tile settles everything within it and across its border (its halo) that
+     * only its groups reach. What they eat is then removed from the arena by a
+     * serial pass in order of pid, and so is left in exactly the order that a
+     * serial tick would leave it, so that the game plays out identically however
+     * many tiles there are. (The few groups whose outcome depends on that order,
+     * such as cells which might pop one of several viruses, are settled by the
+     * serial pass itself.) Pass zeros to tick serially again.
+     */
+    void set_arena_tiles(int columns, int rows) {
+      if (columns < 0 || rows < 0)
+        throw EngineException("The arena can't have a negative number of tiles");
+      _tiled = columns > 0 && rows > 0;
+      _tiles.configure(arena_width(), arena_height(), columns, rows);
+    }
+
+    /* whether ticks are settled by tiles of the arena (see set_arena_tiles) */
+    bool tiled() const { return _tiled; }
+
+    /* how many players tiled ticks settled in tiles rather than serially */
+    const TileStats &tile_stats() const { return _tile_stats; }
+    void reset_tile_stats() { _tile_stats = TileStats(); }
+
+    /**
+     * Sets when bots decide (see BotSchedule), which is every 10 ticks, all
+     * on the same tick, unless set otherwise
+     */
+    void set_bot_schedule(const BotSchedule &schedule) {
+      if (schedule.period < 1)
+        throw EngineException("The decision period must be at least 1 tick (got " + std::to_string(schedule.period) + ")");
+      if (schedule.distant_period != 0 &&
+          (schedule.distant_period < schedule.period || schedule.distant_period % schedule.period != 0))
+        throw EngineException("The distant period must be a multiple of the period (" +
+                              std::to_string(schedule.period) + ")");
+      _bot_schedule = schedule;
+    }
+
+    const BotSchedule &bot_schedule() const { return _bot_schedule; }
+
+    /* how often bots have decided since the engine was created, or the stats were last reset */
+    const BotDecisionStats &decision_stats() const { return _decision_stats; }
+    void reset_decision_stats() { _decision_stats = BotDecisionStats(); }
+
+    /* sets (or clears, with nullptr) the observer notified of each tick and state change */
+    void set_observer(EngineObserver *observer) { _observer = observer; }
+
+    /**
+     * Writes the complete state of the game, including the random number generator,
+     * such that after `load_state` the game plays out identically (given the same
+     * player actions). Bots are loaded back as plain players (without their behavior).
+     */
+    void save_state(std::ostream &os) const {
+      binary::write(os, state.ticks);
+      std::stringstream rng_state;
+      rng_state << rng;
+      binary::write_string(os, rng_state.str());
+      binary::write(os, next_pid);
+      binary::write(os, _pellet_respawn_backlog);
+
+      binary::write<std::uint32_t>(os, state.players.size());
+      for (auto &pair : state.players) {
+        auto &player = *pair.second;
+        binary::write(os, player.pid());
+        binary::write_string(os, player.name());
+        binary::write(os, player.color());
+        binary::write(os, player.action);
+        binary::write(os, player.target.x);
+        binary::write(os, player.target.y);
+        binary::write(os, player.split_cooldown);
+        binary::write(os, player.feed_cooldown);
+
+        binary::write<std::uint32_t>(os, player.cells.size());
+        for (auto &cell : player.cells) {
+          write_moving_ball(os, cell);
+          binary::write(os, cell.splitting_velocity.dx);
+          binary::write(os, cell.splitting_velocity.dy);
+          binary::write(os, cell.mass());
+          binary::write(os, cell._recombine_timer);
+        }
+      }
+
+      binary::write<std::uint32_t>(os, state.pellets.size());
+      for (auto &pellet : state.pellets) {
+        binary::write(os, pellet.x);
+        binary::write(os, pellet.y);
+      }
+
+      binary::write<std::uint32_t>(os, state.foods.size());
+      for (auto &food : state.foods)
+        write_moving_ball(os, food);
+
+      binary::write<std::uint32_t>(os, state.viruses.size());
+      for (auto &virus : state.viruses)
+        write_moving_ball(os, virus);
+
+      state.pellet_field.save(os);
+    }
+
+    /**
+     * Replaces the game with one written by `save_state` (from an
+     * engine with the same configuration)
+     * @throws binary::FormatException if `is` ends prematurely
+     */
+    void load_state(std::istream &is) {
+      state.clear();
+      state.ticks = binary::read<agario::tick>(is);
+      std::stringstream rng_state(binary::read_string(is));
+      rng_state >> rng;
+      next_pid = binary::read<agario::pid>(is);
+      _pellet_respawn_backlog = binary::read<int>(is);
+
+      auto num_players = binary::read<std::uint32_t>(is);
+      for (std::uint32_t p = 0; p < num_players; p++) {
+        auto pid = binary::read<agario::pid>(is);
+        auto name = binary::read_string(is);
+        auto color = binary::read<agario::color>(is);
+        auto player = std::make_shared<Player>(pid, name, color);
+        player->action = binary::read<agario::action>(is);
+        player->target.x = binary::read<agario::distance>(is);
+        player->target.y = binary::read<agario::distance>(is);
+        player->split_cooldown = binary::read<agario::tick>(is);
+        player->feed_cooldown = binary::read<agario::tick>(is);
+
+        auto num_cells = binary::read<std::uint32_t>(is);
+        for (std::uint32_t c = 0; c < num_cells; c++) {
+          auto loc = read_location(is);
+          auto vel = read_velocity(is);
+          auto splitting_velocity = read_velocity(is);
+          auto mass = binary::read<agario::mass>(is);
+          player->add_cell(loc, vel, mass);
+          player->cells.back().splitting_velocity = splitting_velocity;
+          player->cells.back()._recombine_timer = binary::read<float>(is);
+        }
+        state.players.emplace(pid, player);
+      }
+
+      auto num_pellets = binary::read<std::uint32_t>(is);
+      state.pellets.reserve(std::max<int>(num_pellets, _num_pellets));
+      for (std::uint32_t p = 0; p < num_pellets; p++)
+        state.pellets.emplace_back(read_location(is));
+
+      auto num_foods = binary::read<std::uint32_t>(is);
+      for (std::uint32_t f = 0; f < num_foods; f++) {
+        auto loc = read_location(is);
+        state.foods.emplace_back(loc, read_velocity(is));
+      }
+
+      auto num_viruses = binary::read<std::uint32_t>(is);
+      for (std::uint32_t v = 0; v < num_viruses; v++) {
+        auto loc = read_location(is);
+        state.viruses.emplace_back(loc, read_velocity(is));
+      }
+
+      state.pellet_field.load(is);
+    }
 
     Engine(const Engine &) = delete; // no copy constructor
     Engine &operator=(const Engine &) = delete; // no copy assignments
@@ -140,6 +416,87 @@ namespace agario {
 
     agario::pid next_pid;
     int _num_pellets, _num_virus, _pellet_regen;
+    bool _procedural_pellets;
+    int _pellet_respawn_backlog; // eaten pellets which are yet to be respawned
+
+    TickStats _stats;
+    EngineObserver *_observer;
+
+    // bots due for a decision, grouped by their type (reused from tick to tick)
+    std::vector<std::pair<std::type_index, std::vector<Player *>>> _decisions;
+    ParallelFor _parallel_for;
+    std::size_t _decision_batch_size = 16;
+
+    BotSchedule _bot_schedule;
+    BotDecisionStats _decision_stats;
+    bool _decided = false; // whether bots decided this tick (and so the state has just been indexed)
+    std::vector<std::pair<Location, agario::distance>> _agent_views; // the center and half width of each
+
+    // the state of tiled ticks (see set_arena_tiles), reused from tick to tick
+    struct CellRef { std::uint32_t player, cell; }; // an index into _living, and into that player's cells
+    static constexpr std::uint32_t none = ~std::uint32_t(0);
+    bool _tiled = false;
+    ArenaTiles _tiles;                  // the ordinal of each cell, in the tiles which settle their interactions
+    ArenaTiles _cell_grid;              // the same, in a finer grid for finding cells near one another
+    TileStats _tile_stats;
+    std::vector<Player *> _living;      // in order of pid
+    std::vector<CellRef> _cells;        // by ordinal: the cells of each living player in turn
+    std::vector<std::uint32_t> _first_cell; // by index into _living, the ordinal of the player's first cell
+    std::vector<agario::distance> _reach;   // by ordinal, as far as the cell could reach (or be reached) this phase
+    std::vector<std::uint32_t> _group;      // by index into _living, a union-find forest of the players that may interact
+    std::vector<std::uint32_t> _owner;      // by group (root), the lowest tile holding one of its cells
+    std::vector<agario::mass> _group_mass;  // by group (root), the total mass of its players
+    std::vector<agario::mass> _player_mass; // by index into _living
+    std::vector<char> _grown;               // by ordinal, whether the cell's reach has grown since it searched
+    std::vector<char> _inline;              // by group (root), whether it's settled serially (see tick_players_tiled)
+    std::vector<std::vector<std::uint32_t>> _tile_players; // the players settled by each tile, in order of pid
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> _tile_pairs; // players that may interact
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> _pairs;
+
+    // what a tile's players eat, which is committed to the shared state afterwards, in order of pid
+    std::vector<std::vector<std::uint32_t>> _pellet_candidates, _food_candidates, _virus_candidates; // by ordinal
+    std::vector<std::vector<std::uint32_t>> _pellets_taken;  // by ordinal: pellet ids, or PelletField slot keys
+    std::vector<std::uint32_t> _virus_taken;                 // by ordinal, the id of the virus it collided with
+    std::vector<std::vector<Food>> _emitted;                 // by index into _living
+    std::vector<std::vector<char>> _emitted_eaten;           // by index into _living
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> _tile_emitted; // (player, food) by tile
+    std::vector<char> _pellet_taken, _slot_taken, _virus_claimed;
+
+    // where the shared vectors' elements are, as they're removed from in the order a serial tick would
+    std::vector<std::uint32_t> _pellet_position; // by a pellet's index at the start of the tick, where it is now
+    std::vector<std::uint32_t> _pellet_at;       // the inverse: which pellet is at each index
+    std::vector<std::uint32_t> _virus_position, _virus_at; // the same for viruses
+    std::vector<char> _pellet_eaten, _food_eaten;
+    std::vector<std::uint32_t> _eaten;  // the indices of the pellets being eaten by a cell
+    std::size_t _foods_indexed = 0;     // the food there was when candidates were found (any more was emitted since)
+
+    // rounds of merging groups of players that may collide before the collisions are checked serially
+    static constexpr int collision_rounds = 8;
+
+    // added to each search's extent, for the rounding of distances
+    static constexpr float search_margin = 1;
+
+    // each engine has its own generator (rather than using std::rand) so that
+    // engines on different threads don't interfere with each other, and since
+    // std::mt19937's output sequence is the same on every platform
+    std::mt19937 rng;
+
+    static void write_moving_ball(std::ostream &os, const MovingBall &ball) {
+      binary::write(os, ball.x);
+      binary::write(os, ball.y);
+      binary::write(os, ball.velocity.dx);
+      binary::write(os, ball.velocity.dy);
+    }
+
+    static Location read_location(std::istream &is) {
+      auto x = binary::read<agario::distance>(is);
+      return Location(x, binary::read<agario::distance>(is));
+    }
+
+    static Velocity read_velocity(std::istream &is) {
+      auto dx = binary::read<agario::distance>(is);
+      return Velocity(dx, binary::read<agario::distance>(is));
+    }
 
     /**
      * Resets a player to the starting position
@@ -155,39 +512,183 @@ namespace agario {
         state.pellets.emplace_back(random_location());
     }
 
+    /* respawns eaten pellets, at most PELLET_RESPAWN_LIMIT per tick so that
+     * bursts of eating are regenerated over the following ticks, or if more
+     * are waiting, a PELLET_RESPAWN_SPREAD'th of them, so that however fast
+     * pellets are eaten, the number waiting stays bounded */
+    void respawn_pellets() {
+      auto n = std::min(_pellet_respawn_backlog, respawn_budget(_pellet_respawn_backlog));
+      add_pellets(n);
+      _pellet_respawn_backlog -= n;
+    }
+
+    /* the most eaten pellets respawned in one tick, with `backlog` waiting */
+    static int respawn_budget(int backlog) {
+      return std::max(PELLET_RESPAWN_LIMIT, div_round_up(backlog, PELLET_RESPAWN_SPREAD));
+    }
+
     void add_viruses(int n) {
       for (int v = 0; v < n; v++)
         state.viruses.emplace_back(random_location());
     }
 
+    /**
+     * The decision phase: every bot chooses its target and action, from where
+     * everything was at the start of the tick. Bots are grouped by type so that
+     * each group is decided by one (non-virtual) loop (see Player::take_actions),
+     * and the groups are split into batches to decide in parallel, if enabled.
+     */
+    void decide() {
+      PROFILE_PHASE(_stats, bot_actions);
+      TRACE_SCOPE("bot actions");
+      state.invalidate_index(); // rebuilt when first queried (by `idle`, or below if any bot is due)
+      find_agent_views();
+
+      std::uint64_t num_deciding = 0;
+      for (auto &group : _decisions) group.second.clear();
+      for (auto &pair : state.players) {
+        auto &player = *pair.second;
+        if (player.dead() || typeid(player) == typeid(Player)) continue; // plain players don't decide
+        if (!due(player)) continue;
+        num_deciding++;
+        std::type_index type(typeid(player));
+        auto it = std::find_if(_decisions.begin(), _decisions.end(),
+                               [&](const auto &group) { return group.first == type; });
+        if (it == _decisions.end())
+          it = _decisions.emplace(_decisions.end(), type, std::vector<Player *>());
+        it->second.push_back(&player);
+      }
+      _decision_stats.decisions += num_deciding;
+      _decision_stats.peak_decisions = std::max(_decision_stats.peak_decisions, num_deciding);
+      if (num_deciding == 0) return;
+
+      spatial_index(); // before the bots query it, perhaps in parallel
+      _decided = true;
+
+      if (!_parallel_for) {
+        for (auto &group : _decisions)
+          if (!group.second.empty())
+            group.second.front()->take_actions(group.second.data(), group.second.size(), state);
+        return;
+      }
+
+      // (group, first bot) of each batch
+      std::vector<std::pair<std::size_t, std::size_t>> batches;
+      for (std::size_t g = 0; g < _decisions.size(); g++)
+        for (std::size_t first = 0; first < _decisions[g].second.size(); first += _decision_batch_size)
+          batches.emplace_back(g, first);
+
+      _parallel_for(batches.size(), [&](std::size_t b) {
+        auto &bots = _decisions[batches[b].first].second;
+        auto first = batches[b].second;
+        auto count = std::min(_decision_batch_size, bots.size() - first);
+        bots[first]->take_actions(bots.data() + first, count, state);
+      });
+    }
+
+    /* whether `bot` decides this tick (see BotSchedule) */
+    bool due(const Player &bot) {
+      auto &schedule = _bot_schedule;
+      auto tick = ticks() + (schedule.staggered ? bot.pid() : 0);
+      if (tick % schedule.period != 0) return false;
+      if (schedule.distant_period == 0 || tick % schedule.distant_period == 0) return true;
+      if (in_view(bot) && !idle(bot)) return true;
+      _decision_stats.deferred++;
+      return false;
+    }
+
+    /* whether `bot` is within (or near) the view of an agent, as every bot is when there are none */
+    bool in_view(const Player &bot) const {
+      if (_agent_views.empty()) return true;
+      auto location = bot.location();
+      for (auto &view : _agent_views) {
+        auto reach = view.second + _bot_schedule.view_margin;
+        if (math::abs(location.x - view.first.x) <= reach && math::abs(location.y - view.first.y) <= reach)
+          return true;
+      }
+      return false;
+    }
+
+    /* whether there's nothing (but the bot itself) within the idle radius of `bot` */
+    bool idle(const Player &bot) const {
+      auto radius = _bot_schedule.idle_radius;
+      if (radius <= 0) return false;
+      Location lower = bot.location() - Location(radius, radius);
+      Location upper = bot.location() + Location(radius, radius);
+
+      bool found = false;
+      auto &index = state.index();
+      for (auto kind : { SpatialIndex::pellets, SpatialIndex::foods, SpatialIndex::viruses, SpatialIndex::players })
+        index.for_each_in_box(kind, lower, upper, [&](const SpatialIndex::Entry &entry) {
+          found = found || kind != SpatialIndex::players || entry.id != bot.pid();
+        });
+      if (_procedural_pellets)
+        state.pellet_field.for_each(lower, upper, [&](const Location &) { found = true; });
+      return !found;
+    }
+
+    /* the views of the agents (living plain players), for deciding which bots are in view */
+    void find_agent_views() {
+      _agent_views.clear();
+      if (_bot_schedule.distant_period == 0) return;
+      for (auto &pair : state.players) {
+        auto &player = *pair.second;
+        if (!player.dead() && typeid(player) == typeid(Player))
+          _agent_views.emplace_back(player.location(), view_size(player.mass()) / 2);
+      }
+    }
+
+    /* counts the tick lived by each living bot, for the decision stats */
+    void count_bots() {
+      _decision_stats.ticks++;
+      for (auto &pair : state.players)
+        if (!pair.second->dead() && typeid(*pair.second) != typeid(Player))
+          _decision_stats.bot_ticks++;
+    }
+
     /**
      * "ticks" the given player, which involves moving the player's cells and checking
      * for collisions between the player and all other entities in the arena
-     * Also performs any player actions (i.e. splitting or feeling) decrements
-     * the cooldown timers on the player actions
+     * Also performs the player's actions (i.e. splitting or feeding, as decided
+     * beforehand) and decrements the cooldown timers on the player actions
      * @param player the player to tick
      * @param elapsed_seconds the amount of (game) time since the last game tick
      */
     void tick_player(Player &player, const agario::time_delta &elapsed_seconds) {
-
-      if (ticks() % 10 == 0)
-        player.take_action(state);
-
       move_player(player, elapsed_seconds);
+      feed_player(player, state.foods, [&](Cell &cell, std::size_t) {
+        eat_pellets(cell);
+        eat_food(cell);
+      }, [&](Cell &cell, std::size_t, std::vector<Cell> &created_cells, int create_limit) {
+        check_virus_collisions(cell, created_cells, create_limit);
+      });
+    }
 
+    /**
+     * The rest of tick_player, once the player has moved: each of its cells
+     * eats (by calling `eat` with the cell and its index) and collides with
+     * viruses (calling `collide` likewise, with where to put the cells created
+     * and how many may be), before the player's actions are performed (emitting
+     * food into `foods`) and cells recombine
+     */
+    template<typename Eat, typename Collide>
+    void feed_player(Player &player, std::vector<Food> &foods, Eat &&eat, Collide &&collide) {
       std::vector<Cell> created_cells; // list of new cells that will be created
       int create_limit = PLAYER_CELL_LIMIT - player.cells.size();
 
-      for (Cell &cell : player.cells) {
-        eat_pellets(cell);
-        eat_food(cell);
-        check_virus_collisions(cell, created_cells, create_limit);
+      for (std::size_t i = 0; i < player.cells.size(); i++) {
+        Cell &cell = player.cells[i];
+        eat(cell, i);
+        collide(cell, i, created_cells, create_limit);
       }
 
       create_limit -= created_cells.size();
 
-      maybe_emit_food(player);
-      maybe_split(player, created_cells, create_limit);
+      {
+        PROFILE_PHASE(_stats, split_feed);
+        maybe_emit_food(player, foods);
+        maybe_split(player, created_cells, create_limit);
+      }
 
       // add any cells that were created
       player.add_cells(created_cells);
@@ -203,9 +704,12 @@ namespace agario {
      * @param elapsed_seconds time since the last game tick
      */
     void move_player(Player &player, const agario::time_delta &elapsed_seconds) {
+      PROFILE_PHASE(_stats, movement);
       auto dt = elapsed_seconds.count();
 
       for (auto &cell : player.cells) {
+        cell.decrement_recombine_timer(dt);
+
         cell.velocity.dx = 3 * (player.target.x - cell.x);
         cell.velocity.dy = 3 * (player.target.y - cell.y);
 
@@ -224,6 +728,8 @@ namespace agario {
     }
 
     void move_foods(const agario::time_delta &elapsed_seconds) {
+      PROFILE_PHASE(_stats, food_movement);
+      TRACE_SCOPE("food movement");
       auto dt = elapsed_seconds.count();
 
       for (auto &food : state.foods) {
@@ -259,6 +765,7 @@ namespace agario {
           if (it->can_recombine() && it2->can_recombine())
             continue;
 
+          PROFILE_COUNT(_stats.cell_tests, 1);
           Cell &cell_a = *it;
           Cell &cell_b = *it2;
           if (cell_a.touches(cell_b))
@@ -278,13 +785,13 @@ namespace agario {
       auto dx = cell_b.x - cell_a.x;
       auto dy = cell_b.y - cell_a.y;
 
-      auto dist = sqrt(dx * dx + dy * dy);
+      auto dist = math::sqrt(dx * dx + dy * dy);
       auto target_dist = cell_a.radius() + cell_b.radius();
 
       if (dist > target_dist) return; // aren't overlapping
 
-      auto x_ratio = dx / (std::abs(dx) + std::abs(dy));
-      auto y_ratio = dy / (std::abs(dx) + std::abs(dy));
+      auto x_ratio = dx / (math::abs(dx) + math::abs(dy));
+      auto y_ratio = dy / (math::abs(dx) + math::abs(dy));
 
       cell_b.x += (target_dist - dist) * x_ratio / 2;
       cell_b.y += (target_dist - dist) * y_ratio / 2;
@@ -300,20 +807,40 @@ namespace agario {
      * @param cell the cell which is doing the eating
      */
     void eat_pellets(Cell &cell) {
-      auto prev_size = pellet_count();
+      PROFILE_PHASE(_stats, pellet_eating);
+
+      if (_procedural_pellets) {
+        // only the regions within reach of the cell are searched
+        Location reach(cell.radius(), cell.radius());
+        auto num_eaten = state.pellet_field.eat(
+          cell.location() - reach, cell.location() + reach,
+          [&](const Location &loc) {
+            PROFILE_COUNT(_stats.pellet_tests, 1);
+            agario::Pellet<false> pellet(loc);
+            return cell.can_eat(pellet) && cell.collides_with(pellet);
+          }, ticks());
+        cell.increment_mass(num_eaten * PELLET_MASS);
+        return;
+      }
 
-      state.pellets.erase(
-        std::remove_if(state.pellets.begin(), state.pellets.end(),
-                       [&](const Pellet &pellet) {
-                         return cell.can_eat(pellet) && cell.collides_with(pellet);
-                       }),
-        state.pellets.end());
-      auto num_eaten = prev_size - pellet_count();
+      PROFILE_COUNT(_stats.pellet_tests, state.pellets.size());
+      int num_eaten = 0;
+      for (std::size_t i = 0; i < state.pellets.size();) {
+        Pellet &pellet = state.pellets[i];
+        if (cell.can_eat(pellet) && cell.collides_with(pellet)) {
+          std::swap(pellet, state.pellets.back()); // O(1) removal
+          state.pellets.pop_back();
+          num_eaten++;
+        } else i++;
+      }
+      _pellet_respawn_backlog += num_eaten;
       cell.increment_mass(num_eaten * PELLET_MASS);
     }
 
     void eat_food(Cell &cell) {
+      PROFILE_PHASE(_stats, food_eating);
       if (cell.mass() < FOOD_MASS) return;
+      PROFILE_COUNT(_stats.food_tests, state.foods.size());
       auto prev_size = food_count();
 
       state.foods.erase(
@@ -326,7 +853,510 @@ namespace agario {
       cell.increment_mass(num_eaten * FOOD_MASS);
     }
 
-    void emit_foods(Player &player) {
+    /**
+     * The players' part of a tiled tick (see set_arena_tiles), which leaves the
+     * game as calling tick_player on each living player would. Moving depends on
+     * nothing but the player moving, so every player moves first (in parallel).
+     * Then each tile finds what its cells might reach (in parallel), the players
+     * whose reaches overlap are grouped (see group_feeding), and each tile feeds
+     * the players of its groups in order of pid (in parallel), noting what they
+     * eat rather than removing it, since no other group can reach it. Last, the
+     * serial pass removes what each player ate, in order of pid, as tick_player
+     * would have, and feeds the players of any group settled inline.
+     */
+    void tick_players_tiled(const agario::time_delta &elapsed_seconds) {
+      find_living();
+      parallel_for(_living.size(), [&](std::size_t p) { move_player(*_living[p], elapsed_seconds); });
+
+      // indexed (on this thread) as it is before anything is eaten, as it still is if bots decided this tick
+      if (!_decided) state.invalidate_index();
+      auto &index = spatial_index();
+      index_cells();
+
+      // the most food that could be emitted this tick (by players due to feed), which later players might eat
+      int emittable = 0;
+      for (auto *player : _living)
+        if (player->action == agario::action::feed && player->feed_cooldown <= 1)
+          emittable += static_cast<int>(player->cells.size());
+
+      _pellet_candidates.resize(_cells.size());
+      _food_candidates.resize(_cells.size());
+      _virus_candidates.resize(_cells.size());
+      _reach.resize(_cells.size());
+      parallel_for(_tiles.num_tiles(), [&](std::size_t tile) {
+        for (auto entry = _tiles.begin(tile); entry != _tiles.end(tile); ++entry)
+          find_food(index, entry->id, emittable);
+      });
+      group_feeding();
+      start_eating();
+
+      parallel_for(_tiles.num_tiles(), [&](std::size_t tile) {
+        _tile_emitted[tile].clear();
+        for (auto p : _tile_players[tile])
+          feed_in_tile(tile, p);
+      });
+
+      for (std::uint32_t p = 0; p < _living.size(); p++) {
+        if (_inline[find_group(p)]) {
+          feed_inline(p);
+          _tile_stats.settled_serially++;
+        } else {
+          commit_feeding(p);
+          _tile_stats.settled_in_tiles++;
+        }
+      }
+
+      // eaten food is only removed now, leaving the rest in the order that eat_food would
+      _food_eaten.resize(state.foods.size(), false);
+      std::size_t i = 0;
+      state.foods.erase(
+        std::remove_if(state.foods.begin(), state.foods.end(), [&](const Food &) { return _food_eaten[i++]; }),
+        state.foods.end());
+    }
+
+    /**
+     * Finds the pellets, food and viruses that the cell numbered `ordinal` might
+     * reach this tick, and how far that is. Its radius can't change before it
+     * eats, and it eats food after pellets, and collides with viruses after that,
+     * so each is searched for as far as it could reach having eaten everything
+     * found before (and, for viruses, any of the food emitted this tick).
+     */
+    void find_food(const SpatialIndex &index, std::uint32_t ordinal, int emittable) {
+      auto &cell = cell_at(ordinal);
+      auto &pellets = _pellet_candidates[ordinal];
+      auto &foods = _food_candidates[ordinal];
+      auto &viruses = _virus_candidates[ordinal];
+      pellets.clear();
+      foods.clear();
+      viruses.clear();
+
+      int num_pellets = 0;
+      auto reach = extent(cell.radius());
+      if (_procedural_pellets) {
+        state.pellet_field.for_each(cell.location() - reach, cell.location() + reach,
+                                    [&](const Location &) { num_pellets++; });
+      } else {
+        index.for_each_in_box(SpatialIndex::pellets, cell.location() - reach, cell.location() + reach,
+                              [&](const SpatialIndex::Entry &entry) { pellets.push_back(entry.id); });
+        num_pellets = static_cast<int>(pellets.size());
+      }
+
+      auto mass = cell.mass() + num_pellets * PELLET_MASS;
+      reach = extent(radius_conversion(mass));
+      index.for_each_in_box(SpatialIndex::foods, cell.location() - reach, cell.location() + reach,
+                            [&](const SpatialIndex::Entry &entry) { foods.push_back(entry.id); });
+
+      mass += (static_cast<int>(foods.size()) + emittable) * FOOD_MASS;
+      _reach[ordinal] = radius_conversion(mass);
+      reach = extent(_reach[ordinal]);
+      index.for_each_in_box(SpatialIndex::viruses, cell.location() - reach, cell.location() + reach,
+                            [&](const SpatialIndex::Entry &entry) { viruses.push_back(entry.id); });
+    }
+
+    /**
+     * Groups the players whose cells' reaches (see find_food) overlap, so that
+     * no two groups might eat the same pellet, food or virus, or food that the
+     * other emits. A group is settled inline, by the serial pass, if any of its
+     * cells might collide with more than one virus, since which it collides with
+     * depends on the order of the viruses, which only that pass knows.
+     */
+    void group_feeding() {
+      start_grouping();
+      for (std::uint32_t ordinal = 0; ordinal < _cells.size(); ordinal++)
+        if (_virus_candidates[ordinal].size() > 1)
+          _inline[_cells[ordinal].player] = true;
+
+      _grown.clear();
+      find_pairs(true);
+      for (auto &pairs : _tile_pairs)
+        for (auto &pair : pairs)
+          unite(pair.first, pair.second);
+      assign_groups();
+    }
+
+    /* readies the state that the tiles note what they eat in, and that the serial pass removes it with */
+    void start_eating() {
+      if (_procedural_pellets) {
+        // (all clear, since the serial pass clears what it commits)
+        _slot_taken.resize(static_cast<std::size_t>(state.pellet_field.num_regions()) * PelletField::max_slots, false);
+      } else {
+        // (split between the tiles, as there are many)
+        auto n = state.pellets.size();
+        _pellet_position.resize(n);
+        _pellet_at.resize(n);
+        _pellet_eaten.resize(n);
+        _pellet_taken.resize(n);
+        auto num_chunks = _tiles.num_tiles();
+        parallel_for(num_chunks, [&](std::size_t c) {
+          for (auto i = static_cast<std::uint32_t>(c * n / num_chunks); i < (c + 1) * n / num_chunks; i++) {
+            _pellet_position[i] = _pellet_at[i] = i;
+            _pellet_eaten[i] = _pellet_taken[i] = false;
+          }
+        });
+      }
+
+      _virus_position.resize(state.viruses.size());
+      _virus_at.resize(state.viruses.size());
+      for (std::uint32_t i = 0; i < state.viruses.size(); i++)
+        _virus_position[i] = _virus_at[i] = i;
+      _virus_claimed.assign(state.viruses.size(), false);
+
+      _food_eaten.assign(state.foods.size(), false);
+      _foods_indexed = state.foods.size();
+
+      _pellets_taken.resize(_cells.size());
+      _virus_taken.assign(_cells.size(), none);
+      _emitted.resize(_living.size());
+      _emitted_eaten.resize(_living.size());
+      _tile_emitted.resize(_tiles.num_tiles());
+    }
+
+    /* feeds the living player `p` in `tile`, noting what it eats (for commit_feeding) */
+    void feed_in_tile(std::size_t tile, std::uint32_t p) {
+      auto first = _first_cell[p];
+      auto &emitted = _emitted[p];
+      emitted.clear();
+      feed_player(*_living[p], emitted, [&](Cell &cell, std::size_t i) {
+        take_pellets(cell, first + i);
+        take_food(tile, cell, first + i);
+      }, [&](Cell &cell, std::size_t i, std::vector<Cell> &created_cells, int create_limit) {
+        take_virus(cell, first + i, created_cells, create_limit);
+      });
+
+      _emitted_eaten[p].assign(emitted.size(), false);
+      for (std::uint32_t f = 0; f < emitted.size(); f++)
+        _tile_emitted[tile].emplace_back(p, f);
+    }
+
+    /* eat_pellets, noting the pellets eaten by the cell numbered `ordinal` rather than removing them */
+    void take_pellets(Cell &cell, std::uint32_t ordinal) {
+      PROFILE_PHASE(_stats, pellet_eating);
+      auto &taken = _pellets_taken[ordinal];
+      taken.clear();
+
+      if (_procedural_pellets) {
+        Location reach(cell.radius(), cell.radius());
+        state.pellet_field.for_each_slot(cell.location() - reach, cell.location() + reach,
+                                         [&](std::uint32_t key, const Location &loc) {
+          PROFILE_COUNT(_stats.pellet_tests, 1);
+          agario::Pellet<false> pellet(loc);
+          if (!_slot_taken[key] && cell.can_eat(pellet) && cell.collides_with(pellet)) {
+            _slot_taken[key] = true;
+            taken.push_back(key);
+          }
+        });
+      } else {
+        PROFILE_COUNT(_stats.pellet_tests, _pellet_candidates[ordinal].size());
+        for (auto id : _pellet_candidates[ordinal]) {
+          auto &pellet = state.pellets[id]; // (none are removed until the serial pass)
+          if (!_pellet_taken[id] && cell.can_eat(pellet) && cell.collides_with(pellet)) {
+            _pellet_taken[id] = true;
+            taken.push_back(id);
+          }
+        }
+      }
+      cell.increment_mass(static_cast<int>(taken.size()) * PELLET_MASS);
+    }
+
+    /* eat_food, testing only the candidates of the cell numbered `ordinal`, and the food emitted in `tile` */
+    void take_food(std::size_t tile, Cell &cell, std::uint32_t ordinal) {
+      PROFILE_PHASE(_stats, food_eating);
+      if (cell.mass() < FOOD_MASS) return;
+      PROFILE_COUNT(_stats.food_tests, _food_candidates[ordinal].size() + _tile_emitted[tile].size());
+
+      int num_eaten = 0;
+      auto maybe_eat = [&](const Food &food, char &eaten) {
+        if (!eaten && cell.can_eat(food) && cell.collides_with(food)) {
+          eaten = true;
+          num_eaten++;
+        }
+      };
+      for (auto i : _food_candidates[ordinal])
+        maybe_eat(state.foods[i], _food_eaten[i]);
+
+      // any food emitted by earlier players (those of other tiles are out of reach)
+      for (auto &food : _tile_emitted[tile])
+        maybe_eat(_emitted[food.first][food.second], _emitted_eaten[food.first][food.second]);
+      cell.increment_mass(num_eaten * FOOD_MASS);
+    }
+
+    /* check_virus_collisions, noting the virus (if any) that the cell numbered `ordinal` collides with */
+    void take_virus(Cell &cell, std::uint32_t ordinal, std::vector<Cell> &created_cells, int create_limit) {
+      PROFILE_PHASE(_stats, virus_collisions);
+      for (auto id : _virus_candidates[ordinal]) { // (at most one, or it'd be fed inline)
+        auto &virus = state.viruses[id];
+        PROFILE_COUNT(_stats.virus_tests, 1);
+        if (!_virus_claimed[id] && cell.can_eat(virus) && cell.collides_with(virus)) {
+          disrupt(cell, virus, created_cells, create_limit);
+          _virus_claimed[id] = true;
+          _virus_taken[ordinal] = id;
+          return;
+        }
+      }
+    }
+
+    /* removes what the living player `p` ate in its tile, and adds the food it emitted, as tick_player would */
+    void commit_feeding(std::uint32_t p) {
+      auto last = p + 1 < _living.size() ? _first_cell[p + 1] : static_cast<std::uint32_t>(_cells.size());
+      for (auto ordinal = _first_cell[p]; ordinal < last; ordinal++) {
+        auto &taken = _pellets_taken[ordinal];
+        if (_procedural_pellets) {
+          for (auto key : taken) {
+            state.pellet_field.eat_slot(key, ticks());
+            _slot_taken[key] = false;
+          }
+        } else {
+          for (auto id : taken) _pellet_eaten[id] = true;
+          remove_pellets(taken);
+        }
+        if (_virus_taken[ordinal] != none)
+          remove_virus(_virus_taken[ordinal]);
+      }
+
+      auto &emitted = _emitted[p];
+      _food_eaten.resize(state.foods.size(), false);
+      state.foods.insert(state.foods.end(), std::make_move_iterator(emitted.begin()), std::make_move_iterator(emitted.end()));
+      _food_eaten.insert(_food_eaten.end(), _emitted_eaten[p].begin(), _emitted_eaten[p].end());
+    }
+
+    /* tick_player's feeding of the living player `p`, in the serial pass (see group_feeding) */
+    void feed_inline(std::uint32_t p) {
+      auto first = _first_cell[p];
+      feed_player(*_living[p], state.foods, [&](Cell &cell, std::size_t i) {
+        if (_procedural_pellets)
+          eat_pellets(cell); // which only searches the regions within reach anyway
+        else
+          eat_pellets(cell, _pellet_candidates[first + i]);
+        eat_food(cell, _food_candidates[first + i]);
+      }, [&](Cell &cell, std::size_t i, std::vector<Cell> &created_cells, int create_limit) {
+        // the first in the viruses' current order, as check_virus_collisions' scan would find
+        PROFILE_PHASE(_stats, virus_collisions);
+        auto first_hit = none;
+        for (auto id : _virus_candidates[first + i]) {
+          auto &virus = state.viruses[_virus_position[id]];
+          PROFILE_COUNT(_stats.virus_tests, 1);
+          if (!_virus_claimed[id] && cell.can_eat(virus) && cell.collides_with(virus) &&
+              (first_hit == none || _virus_position[id] < _virus_position[first_hit]))
+            first_hit = id;
+        }
+        if (first_hit == none) return;
+        disrupt(cell, state.viruses[_virus_position[first_hit]], created_cells, create_limit);
+        _virus_claimed[first_hit] = true;
+        remove_virus(first_hit);
+      });
+    }
+
+    /* eat_pellets, testing only the `candidates` (by their indices at the start of the tick) */
+    void eat_pellets(Cell &cell, const std::vector<std::uint32_t> &candidates) {
+      PROFILE_PHASE(_stats, pellet_eating);
+      PROFILE_COUNT(_stats.pellet_tests, candidates.size());
+
+      _eaten.clear();
+      for (auto id : candidates) {
+        if (_pellet_eaten[id]) continue;
+        auto &pellet = state.pellets[_pellet_position[id]];
+        if (cell.can_eat(pellet) && cell.collides_with(pellet)) {
+          _pellet_eaten[id] = true;
+          _eaten.push_back(id);
+        }
+      }
+
+      auto num_eaten = static_cast<int>(_eaten.size());
+      remove_pellets(_eaten);
+      cell.increment_mass(num_eaten * PELLET_MASS);
+    }
+
+    /**
+     * Removes the pellets `eaten` by a cell (by their indices at the start of
+     * the tick, and already marked as eaten) as eat_pellets' scan would: from
+     * the first, with the last pellet swapped into each place, and removed from
+     * there too if it was also eaten. Leaves `eaten` holding their indices.
+     */
+    void remove_pellets(std::vector<std::uint32_t> &eaten) {
+      for (auto &id : eaten) id = _pellet_position[id];
+      std::sort(eaten.begin(), eaten.end());
+      for (auto i : eaten) {
+        // (an eaten pellet which was last has already been swapped into an earlier place, and removed)
+        while (i < state.pellets.size() && _pellet_eaten[_pellet_at[i]]) {
+          auto last = state.pellets.size() - 1;
+          std::swap(state.pellets[i], state.pellets[last]);
+          state.pellets.pop_back();
+          _pellet_at[i] = _pellet_at[last];
+          _pellet_position[_pellet_at[i]] = i;
+        }
+      }
+      _pellet_respawn_backlog += static_cast<int>(eaten.size());
+    }
+
+    /* removes the virus `id` (by its index at the start of the tick) as check_virus_collisions would */
+    void remove_virus(std::uint32_t id) {
+      auto i = _virus_position[id];
+      auto last = state.viruses.size() - 1;
+      std::swap(state.viruses[i], state.viruses[last]);
+      state.viruses.pop_back();
+      _virus_at[i] = _virus_at[last];
+      _virus_position[_virus_at[i]] = i;
+    }
+
+    /* eat_food, testing only the `candidates` (by index) and any food emitted since they were found */
+    void eat_food(Cell &cell, const std::vector<std::uint32_t> &candidates) {
+      PROFILE_PHASE(_stats, food_eating);
+      if (cell.mass() < FOOD_MASS) return;
+      PROFILE_COUNT(_stats.food_tests, candidates.size() + state.foods.size() - _foods_indexed);
+
+      _food_eaten.resize(state.foods.size(), false);
+      int num_eaten = 0;
+      auto maybe_eat = [&](std::size_t i) {
+        if (!_food_eaten[i] && cell.can_eat(state.foods[i]) && cell.collides_with(state.foods[i])) {
+          _food_eaten[i] = true;
+          num_eaten++;
+        }
+      };
+      for (auto i : candidates) maybe_eat(i);
+      for (auto i = _foods_indexed; i < state.foods.size(); i++) maybe_eat(i);
+      cell.increment_mass(num_eaten * FOOD_MASS);
+    }
+
+    void find_living() {
+      _living.clear();
+      for (auto &pair : state.players)
+        if (!pair.second->dead())
+          _living.push_back(pair.second.get());
+    }
+
+    /* numbers the cells of the living players in turn, and sorts them into tiles by location */
+    void index_cells() {
+      _cells.clear();
+      _first_cell.resize(_living.size());
+      for (std::uint32_t p = 0; p < _living.size(); p++) {
+        _first_cell[p] = static_cast<std::uint32_t>(_cells.size());
+        for (std::uint32_t c = 0; c < _living[p]->cells.size(); c++)
+          _cells.push_back(CellRef { p, c });
+      }
+
+      // the finer grid has a few cells in each of its tiles
+      auto side = std::sqrt(static_cast<float>(arena_width()) * static_cast<float>(arena_height())
+                            * 4 / std::max<std::size_t>(1, _cells.size()));
+      _cell_grid.configure(arena_width(), arena_height(),
+                           clamp(static_cast<int>(std::lround(arena_width() / side)), 1, 256),
+                           clamp(static_cast<int>(std::lround(arena_height() / side)), 1, 256));
+
+      _tiles.clear();
+      _cell_grid.clear();
+      for (std::uint32_t ordinal = 0; ordinal < _cells.size(); ordinal++) {
+        auto location = cell_at(ordinal).location();
+        _tiles.add(location, ordinal);
+        _cell_grid.add(location, ordinal);
+      }
+      _tiles.sort();
+      _cell_grid.sort();
+    }
+
+    /* puts each living player in a group of its own */
+    void start_grouping() {
+      _group.resize(_living.size());
+      for (std::uint32_t p = 0; p < _living.size(); p++)
+        _group[p] = p;
+      _group_mass.assign(_living.size(), 0);
+      _inline.assign(_living.size(), false);
+    }
+
+    /* the group of the living player `p`, named by its first player */
+    std::uint32_t find_group(std::uint32_t p) {
+      while (_group[p] != p)
+        p = _group[p] = _group[_group[p]];
+      return p;
+    }
+
+    /* merges the groups of the living players `p` and `q`, returning whether they were apart */
+    bool unite(std::uint32_t p, std::uint32_t q) {
+      p = find_group(p);
+      q = find_group(q);
+      if (p == q) return false;
+      if (q < p) std::swap(p, q);
+      _group[q] = p;
+      _group_mass[p] += _group_mass[q];
+      _inline[p] = _inline[p] || _inline[q];
+      return true;
+    }
+
+    /**
+     * Each tile finds (in parallel) the pairs of players with cells in it that
+     * might reach one another: within the larger of the cells' reaches, or if
+     * `overlapping`, whose reaches overlap. Each pair is found from the cell
+     * that reaches further, so only the cells which have `_grown` since the
+     * last search need search again (or all, if it's empty).
+     */
+    void find_pairs(bool overlapping) {
+      _tile_pairs.resize(_tiles.num_tiles());
+      parallel_for(_tiles.num_tiles(), [&](std::size_t tile) {
+        auto &pairs = _tile_pairs[tile];
+        pairs.clear();
+        for (auto entry = _tiles.begin(tile); entry != _tiles.end(tile); ++entry) {
+          auto ordinal = entry->id;
+          if (!_grown.empty() && !_grown[ordinal]) continue;
+          auto p = _cells[ordinal].player;
+          auto reach = overlapping ? extent(_reach[ordinal] + _reach[ordinal] + search_margin) : extent(_reach[ordinal]);
+          _cell_grid.for_each_in_box(entry->location - reach, entry->location + reach, [&](const ArenaTiles::Entry &other) {
+            auto q = _cells[other.id].player;
+            if (q == p || _reach[other.id] > _reach[ordinal]) return;
+            auto span = _reach[ordinal] + _reach[other.id] + 2 * search_margin;
+            if (overlapping && (math::abs(other.location.x - entry->location.x) > span ||
+                                math::abs(other.location.y - entry->location.y) > span))
+              return;
+            pairs.emplace_back(std::min(p, q), std::max(p, q));
+          });
+        }
+      });
+    }
+
+    /* gives each group to the lowest numbered tile holding one of its cells, and each tile the players it settles */
+    void assign_groups() {
+      _owner.assign(_living.size(), none);
+      for (std::size_t tile = 0; tile < _tiles.num_tiles(); tile++)
+        for (auto entry = _tiles.begin(tile); entry != _tiles.end(tile); ++entry) {
+          auto group = find_group(_cells[entry->id].player);
+          if (_owner[group] == none) _owner[group] = static_cast<std::uint32_t>(tile);
+        }
+
+      _tile_players.resize(_tiles.num_tiles());
+      for (auto &players : _tile_players) players.clear();
+      for (std::uint32_t p = 0; p < _living.size(); p++) {
+        auto group = find_group(p);
+        if (!_inline[group]) _tile_players[_owner[group]].push_back(p);
+      }
+    }
+
+    Cell &cell_at(std::uint32_t ordinal) {
+      auto &ref = _cells[ordinal];
+      return _living[ref.player]->cells[ref.cell];
+    }
+
+    static Location extent(agario::distance radius) {
+      return Location(radius + search_margin, radius + search_margin);
+    }
+
+    /* the state's index, built in parallel if possible (as parallel_for) */
+    const SpatialIndex &spatial_index() const {
+#ifndef ENGINE_PROFILING
+      return state.index(_parallel_for);
+#else
+      return state.index();
+#endif
+    }
+
+    /* calls f(0) ... f(n - 1), in parallel if possible (though never when profiling, as stats aren't atomic) */
+    void parallel_for(std::size_t n, const std::function<void(std::size_t)> &f) {
+#ifndef ENGINE_PROFILING
+      if (_parallel_for) {
+        _parallel_for(n, f);
+        return;
+      }
+#endif
+      for (std::size_t i = 0; i < n; i++) f(i);
+    }
+
+    void emit_foods(Player &player, std::vector<Food> &foods) {
 
       // emit one pellet from each sufficiently large cell
       for (Cell &cell : player.cells) {
@@ -340,17 +1370,17 @@ namespace agario {
         Velocity vel(dir * FOOD_SPEED);
         Food food(loc, vel);
 
-        state.foods.emplace_back(std::move(food));
+        foods.emplace_back(std::move(food));
         cell.increment_mass(-food.mass());
       }
     }
 
-    void maybe_emit_food(Player &player) {
+    void maybe_emit_food(Player &player, std::vector<Food> &foods) {
       if (player.feed_cooldown > 0)
         player.feed_cooldown -= 1;
 
       if (player.action == agario::action::feed && player.feed_cooldown == 0) {
-        emit_foods(player);
+        emit_foods(player, foods);
         player.feed_cooldown = 10;
       }
     }
@@ -405,11 +1435,86 @@ namespace agario {
      * of cells in each player to reflect any collisions.
      */
     void check_player_collisions() {
+      PROFILE_PHASE(_stats, player_collisions);
+      TRACE_SCOPE("player collisions");
       for (auto p1_it = state.players.begin(); p1_it != state.players.end(); ++p1_it)
         for (auto p2_it = std::next(p1_it); p2_it != state.players.end(); ++p2_it)
           check_players_collisions(*p1_it->second, *p2_it->second);
     }
 
+    /**
+     * check_player_collisions for a tiled tick (see set_arena_tiles). A cell
+     * only grows by eating the cells of the players it collides with, so it can
+     * grow to no more than the mass of its group: the players are grouped with
+     * those whose cells are within reach of theirs, and then again as far as
+     * their groups' masses might reach, until no more groups merge. Each tile
+     * then collides (in parallel) the pairs of its groups' players that were
+     * found, in the order that check_player_collisions would, since pairs of
+     * different groups can't reach one another. If the groups are still
+     * merging after collision_rounds, all pairs are checked serially instead.
+     */
+    void check_player_collisions_tiled() {
+      PROFILE_PHASE(_stats, player_collisions);
+      TRACE_SCOPE("player collisions");
+      find_living();
+      index_cells();
+      start_grouping();
+
+      _reach.resize(_cells.size());
+      _player_mass.resize(_living.size());
+      for (std::uint32_t p = 0; p < _living.size(); p++)
+        _group_mass[p] = _player_mass[p] = _living[p]->mass();
+      for (std::uint32_t ordinal = 0; ordinal < _cells.size(); ordinal++)
+        _reach[ordinal] = cell_at(ordinal).radius();
+
+      _pairs.clear();
+      _grown.clear();
+      bool settled = false;
+      for (int round = 0; round < collision_rounds && !settled; round++) {
+        find_pairs(false);
+        settled = true;
+        for (auto &pairs : _tile_pairs) {
+          _pairs.insert(_pairs.end(), pairs.begin(), pairs.end());
+          for (auto &pair : pairs)
+            if (unite(pair.first, pair.second)) settled = false;
+        }
+
+        // the cells of players with others in their group may grow to the group's mass
+        _grown.assign(_cells.size(), false);
+        for (std::uint32_t p = 0; p < _living.size(); p++) {
+          auto group_mass = _group_mass[find_group(p)];
+          if (group_mass == _player_mass[p]) continue;
+          auto reach = radius_conversion(group_mass);
+          auto last = p + 1 < _living.size() ? _first_cell[p + 1] : static_cast<std::uint32_t>(_cells.size());
+          for (auto ordinal = _first_cell[p]; ordinal < last; ordinal++)
+            if (reach > _reach[ordinal]) {
+              _reach[ordinal] = reach;
+              _grown[ordinal] = true;
+              settled = false;
+            }
+        }
+      }
+
+      if (!settled) {
+        _tile_stats.settled_serially += _living.size();
+        check_player_collisions();
+        return;
+      }
+
+      assign_groups();
+      std::sort(_pairs.begin(), _pairs.end());
+      _pairs.erase(std::unique(_pairs.begin(), _pairs.end()), _pairs.end());
+      for (auto &pairs : _tile_pairs) pairs.clear();
+      for (auto &pair : _pairs)
+        _tile_pairs[_owner[find_group(pair.first)]].push_back(pair);
+
+      parallel_for(_tiles.num_tiles(), [&](std::size_t tile) {
+        for (auto &pair : _tile_pairs[tile])
+          check_players_collisions(*_living[pair.first], *_living[pair.second]);
+      });
+      _tile_stats.settled_in_tiles += _living.size();
+    }
+
     /**
      * Checks cell-cell collisions between players `p1` and `p2`
      * and does consumptions/removal of cells that collide
@@ -431,6 +1536,7 @@ namespace agario {
      * section O(n) rather tha O(n^2)
      */
     void eat_others(Player &player, Cell &cell) {
+      PROFILE_COUNT(_stats.cell_tests, player.cells.size());
 
       agario::mass original_mass = player.mass();
 
@@ -447,6 +1553,7 @@ namespace agario {
     }
 
     void recombine_cells(Player &player) {
+      PROFILE_PHASE(_stats, recombination);
       for (auto it = player.cells.begin(); it != player.cells.end(); ++it) {
         if (!it->can_recombine()) continue;
 
@@ -465,8 +1572,10 @@ namespace agario {
     }
 
     void check_virus_collisions(Cell &cell, std::vector<Cell> &created_cells, int create_limit) {
+      PROFILE_PHASE(_stats, virus_collisions);
       for (auto it = state.viruses.begin(); it != state.viruses.end();) {
         Virus &virus = *it;
+        PROFILE_COUNT(_stats.virus_tests, 1);
 
         if (cell.can_eat(virus) && cell.collides_with(virus)) {
           disrupt(cell, virus, created_cells, create_limit);
@@ -513,17 +1622,27 @@ namespace agario {
       cell.reset_recombine_timer();
     }
 
-    float split_speed(agario::mass mass) {
-      return clamp(3 * (std::pow(max_speed(mass), 1.2)), 20.0, 130.0);
+    void record_entity_counts() {
+      _stats.num_players = player_count();
+      _stats.num_cells = 0;
+      for (auto &pair : state.players)
+        _stats.num_cells += pair.second->cells.size();
+      _stats.num_pellets = pellet_count();
+      _stats.num_foods = food_count();
+      _stats.num_viruses = virus_count();
+    }
+
+    agario::distance split_speed(agario::mass mass) {
+      return clamp<agario::distance>(3 * math::pow(max_speed(mass), 1.2), 20, 130);
     }
 
-    float max_speed(agario::mass mass) {
-      return CELL_MAX_SPEED / std::sqrt((float) mass);
+    agario::distance max_speed(agario::mass mass) {
+      return CELL_MAX_SPEED / math::sqrt(agario::distance(mass));
     }
 
     template<typename T>
     T random(T min, T max) {
-      return (max - min) * (static_cast<T>(rand()) / static_cast<T>(RAND_MAX)) + min;
+      return (max - min) * (static_cast<T>(rng()) / static_cast<T>(rng.max())) + min;
     }
 
     template<typename T>
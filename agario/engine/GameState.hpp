@@ -3,9 +3,12 @@
 #include "agario/core/Ball.hpp"
 #include "agario/core/Entities.hpp"
 #include "agario/core/Player.hpp"
+#include "agario/engine/PelletField.hpp"
+#include "agario/engine/SpatialIndex.hpp"
 
+#include <array>
 #include <vector>
-#include <unordered_map>
+#include <map>
 #include <iomanip>
 #include <memory>
 
@@ -14,10 +17,12 @@ namespace agario {
   template<bool renderable>
   class GameState {
   public:
-    using PlayerMap = std::unordered_map<agario::pid, std::shared_ptr<agario::Player<renderable>>>;
+    // ordered by pid, so that players are ticked in the same order in every run of a game
+    using PlayerMap = std::map<agario::pid, std::shared_ptr<agario::Player<renderable>>>;
 
     PlayerMap players;
     std::vector<agario::Pellet<renderable>> pellets;
+    agario::PelletField pellet_field; // procedurally generated pellets (if enabled)
     std::vector<agario::Food<renderable>> foods;
     std::vector<agario::Virus<renderable>> viruses;
 
@@ -30,9 +35,61 @@ namespace agario {
     void clear() {
       players.clear();
       pellets.clear();
+      pellet_field.clear();
       foods.clear();
       viruses.clear();
       ticks = 0;
+      invalidate_index();
+    }
+
+    /* the number of pellets, whether stored or procedurally generated */
+    [[nodiscard]] int pellet_count() const {
+      return static_cast<int>(pellets.size()) + pellet_field.count();
+    }
+
+    /**
+     * Calls `f` with the location of every pellet inside the box [lower, upper],
+     * whether stored or procedurally generated. Observations and bots should
+     * use this rather than `pellets` so that they work in either pellet mode.
+     */
+    template<typename F>
+    void for_each_pellet(const Location &lower, const Location &upper, F &&f) const {
+      for (auto &pellet : pellets)
+        if (lower.x <= pellet.x && pellet.x <= upper.x && lower.y <= pellet.y && pellet.y <= upper.y)
+          f(pellet.location());
+      pellet_field.for_each(lower, upper, f);
+    }
+
+    /**
+     * Spatial queries (nearest, within a radius or within a view) over the
+     * stored pellets, foods, viruses and living players. The index is built on
+     * first use in each tick, and rebuilt if entities have since been added or
+     * removed, so within a tick it holds where everything was when first used.
+     * The engine builds it at the start of each tick in which bots act, so that
+     * all of them decide from the same picture of the arena (in parallel, if
+     * given a `parallel_for`, see SpatialIndex::build).
+     */
+    const SpatialIndex &index(const SpatialIndex::ParallelFor &parallel_for = nullptr) const {
+      if (!_index_valid || _index_tick != ticks || _index_counts != counts()) {
+        _index.build(*this, parallel_for);
+        _index_tick = ticks;
+        _index_counts = counts();
+        _index_valid = true;
+      }
+      return _index;
+    }
+
+    /* makes the next query of `index` rebuild it, e.g. after entities moved outside of a tick */
+    void invalidate_index() { _index_valid = false; }
+
+  private:
+    mutable SpatialIndex _index;
+    mutable bool _index_valid = false;
+    mutable agario::tick _index_tick = 0;
+    mutable std::array<std::size_t, SpatialIndex::num_kinds> _index_counts {};
+
+    [[nodiscard]] std::array<std::size_t, SpatialIndex::num_kinds> counts() const {
+      return { pellets.size(), foods.size(), viruses.size(), players.size() };
     }
   };
 
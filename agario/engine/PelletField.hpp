@@ -0,0 +1,338 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "agario/core/types.hpp"
+#include "agario/core/settings.hpp"
+#include "agario/core/utils.hpp"
+#include "agario/engine/binary.hpp"
+
+namespace agario {
+
+  /**
+   * Procedurally generated pellets, for arenas too large to store every pellet.
+   * The arena is divided into a grid of equally sized regions, each of which
+   * holds a fixed number of pellet "slots". The location of each pellet is a
+   * hash of its (region, slot, generation) so the only state that is stored
+   * is a bitmask of eaten slots and a respawn timer per region, and a byte
+   * per slot counting the times it has been eaten (its generation).
+   * When a region's respawn timer expires, the generation of each eaten slot
+   * is incremented, which re-lays those pellets (at new locations) and un-eats
+   * them, while those that weren't eaten stay where they are.
+   * All queries only visit the regions which overlap the queried area.
+   */
+  class PelletField {
+  public:
+    /* the most pellets a region can hold (bits in the eaten mask) */
+    static constexpr int max_slots = 64;
+
+    PelletField() : _seed(0), _cols(0), _rows(0), _base_slots(0), _extra_slots(0),
+                    _count(0), _capacity(0), _respawn_ticks(PELLET_RESPAWN_TICKS) {}
+
+    /**
+     * Lays out `num_pellets` pellets over a `width` by `height` arena
+     * @param seed determines the locations of all of the pellets
+     * @param respawn_ticks number of ticks after a region's first pellet
+     * is eaten until the region is regenerated
+     */
+    void configure(agario::distance width, agario::distance height, int num_pellets,
+                   std::uint64_t seed, agario::tick respawn_ticks = PELLET_RESPAWN_TICKS) {
+      clear();
+      if (num_pellets <= 0) return;
+
+      // aim for about PELLETS_PER_REGION pellets in each (roughly square) region
+      auto side = std::sqrt(static_cast<float>(width) * static_cast<float>(height)
+                            * PELLETS_PER_REGION / num_pellets);
+      _cols = std::max(1, static_cast<int>(std::lround(width / side)));
+      _rows = std::max(1, static_cast<int>(std::lround(height / side)));
+      while (div_round_up(num_pellets, _cols * _rows) > max_slots) {
+        _cols++;
+        _rows++;
+      }
+
+      _region_width = width / _cols;
+      _region_height = height / _rows;
+      _base_slots = num_pellets / num_regions();
+      _extra_slots = num_pellets % num_regions();
+
+      _seed = seed;
+      _respawn_ticks = respawn_ticks;
+      _count = _capacity = num_pellets;
+      _regions.assign(num_regions(), Region());
+      _generations.assign(num_pellets, 0);
+    }
+
+    /* removes all pellets */
+    void clear() {
+      _regions.clear();
+      _generations.clear();
+      _respawn_queue.clear();
+      _cols = _rows = 0;
+      _count = _capacity = 0;
+    }
+
+    [[nodiscard]] bool empty() const { return _regions.empty(); }
+
+    /* the number of pellets that are currently in the arena */
+    [[nodiscard]] int count() const { return _count; }
+
+    /* the number of pellets when none have been eaten */
+    [[nodiscard]] int capacity() const { return _capacity; }
+
+    [[nodiscard]] int num_regions() const { return _cols * _rows; }
+    [[nodiscard]] agario::distance region_width() const { return _region_width; }
+    [[nodiscard]] agario::distance region_height() const { return _region_height; }
+
+    /* calls `f` with the location of each pellet inside the box [lower, upper] */
+    template<typename F>
+    void for_each(const Location &lower, const Location &upper, F &&f) const {
+      _for_each_region(lower, upper, [&](int region) {
+        auto live = ~_regions[region].eaten;
+        for (int slot = 0; slot < _slots(region); slot++) {
+          if (!(live & _bit(slot))) continue;
+          auto loc = _location(region, slot);
+          if (_inside(loc, lower, upper))
+            f(loc);
+        }
+      });
+    }
+
+    /**
+     * Eats every pellet inside the box [lower, upper] for
+     * which `should_eat` (called with the pellet's location)
+     * returns true, starting the respawn timers of the regions
+     * that they were in.
+     * @param now the current game tick
+     * @return the number of pellets eaten
+     */
+    template<typename Predicate>
+    int eat(const Location &lower, const Location &upper, Predicate &&should_eat, agario::tick now) {
+      int num_eaten = 0;
+      _for_each_region(lower, upper, [&](int region) {
+        auto &r = _regions[region];
+        for (int slot = 0; slot < _slots(region); slot++) {
+          if (r.eaten & _bit(slot)) continue;
+          auto loc = _location(region, slot);
+          if (!_inside(loc, lower, upper) || !should_eat(loc)) continue;
+
+          if (r.eaten == 0) {
+            r.respawn_at = now + _respawn_ticks;
+            _respawn_queue.push_back(region);
+          }
+          r.eaten |= _bit(slot);
+          num_eaten++;
+        }
+      });
+      _count -= num_eaten;
+      return num_eaten;
+    }
+
+    /**
+     * Calls `f(key, location)` with each pellet inside the box [lower, upper],
+     * in the order that `eat` visits them, where `key` identifies its slot
+     * (for eat_slot), and is less than num_regions() * max_slots
+     */
+    template<typename F>
+    void for_each_slot(const Location &lower, const Location &upper, F &&f) const {
+      _for_each_region(lower, upper, [&](int region) {
+        auto live = ~_regions[region].eaten;
+        for (int slot = 0; slot < _slots(region); slot++) {
+          if (!(live & _bit(slot))) continue;
+          auto loc = _location(region, slot);
+          if (_inside(loc, lower, upper))
+            f(static_cast<std::uint32_t>(region * max_slots + slot), loc);
+        }
+      });
+    }
+
+    /* eats the pellet in the slot `key` (from for_each_slot) as `eat` would, if it hasn't been */
+    void eat_slot(std::uint32_t key, agario::tick now) {
+      int region = static_cast<int>(key / max_slots);
+      auto &r = _regions[region];
+      auto bit = _bit(static_cast<int>(key % max_slots));
+      if (r.eaten & bit) return;
+      if (r.eaten == 0) {
+        r.respawn_at = now + _respawn_ticks;
+        _respawn_queue.push_back(region);
+      }
+      r.eaten |= bit;
+      _count--;
+    }
+
+    /* regenerates each region whose respawn timer has expired by tick `now` */
+    void regenerate(agario::tick now) {
+      // all regions have the same respawn delay, so the queue is ordered by respawn time
+      while (!_respawn_queue.empty() && _regions[_respawn_queue.front()].respawn_at <= now) {
+        int region = _respawn_queue.front();
+        auto &r = _regions[region];
+        _count += __builtin_popcountll(r.eaten);
+        for (auto eaten = r.eaten; eaten != 0; eaten &= eaten - 1)
+          _generations[_first_slot(region) + __builtin_ctzll(eaten)]++;
+        r.eaten = 0;
+        _respawn_queue.pop_front();
+      }
+    }
+
+    /**
+     * Finds the pellet nearest to `loc`, searching outwards from the region
+     * containing `loc` so that only nearby regions are visited.
+     * @param nearest set to the location of the nearest pellet, if any
+     * @return whether there are any pellets
+     */
+    bool nearest(const Location &loc, Location &nearest) const {
+      if (_count == 0) return false;
+
+      auto reach = std::max(_region_width, _region_height);
+      auto arena_size = std::max(_region_width * _cols, _region_height * _rows);
+      bool found = false;
+      agario::distance best = agario::distance::max();
+
+      while (true) {
+        Location extent(reach, reach);
+        for_each(loc - extent, loc + extent, [&](const Location &pellet) {
+          auto dist = pellet.distance_to(loc);
+          if (dist < best) {
+            best = dist;
+            nearest = pellet;
+            found = true;
+          }
+        });
+
+        // anything outside of the searched box is farther than `reach`
+        if ((found && best <= reach) || reach > 2 * arena_size)
+          return found;
+        reach *= 2;
+      }
+    }
+
+    /* writes the layout and eaten state of every region (see Engine::save_state) */
+    void save(std::ostream &os) const {
+      binary::write(os, _seed);
+      binary::write(os, _cols);
+      binary::write(os, _rows);
+      binary::write(os, _region_width);
+      binary::write(os, _region_height);
+      binary::write(os, _base_slots);
+      binary::write(os, _extra_slots);
+      binary::write(os, _count);
+      binary::write(os, _capacity);
+      binary::write(os, _respawn_ticks);
+
+      binary::write<std::uint32_t>(os, _regions.size());
+      for (auto &region : _regions) {
+        binary::write(os, region.eaten);
+        binary::write(os, region.respawn_at);
+      }
+      os.write(reinterpret_cast<const char *>(_generations.data()), _generations.size());
+
+      binary::write<std::uint32_t>(os, _respawn_queue.size());
+      for (int region : _respawn_queue)
+        binary::write(os, region);
+    }
+
+    /* restores a pellet field written by `save` */
+    void load(std::istream &is) {
+      _seed = binary::read<std::uint64_t>(is);
+      _cols = binary::read<int>(is);
+      _rows = binary::read<int>(is);
+      _region_width = binary::read<agario::distance>(is);
+      _region_height = binary::read<agario::distance>(is);
+      _base_slots = binary::read<int>(is);
+      _extra_slots = binary::read<int>(is);
+      _count = binary::read<int>(is);
+      _capacity = binary::read<int>(is);
+      _respawn_ticks = binary::read<agario::tick>(is);
+
+      _regions.resize(binary::read<std::uint32_t>(is));
+      for (auto &region : _regions) {
+        region.eaten = binary::read<std::uint64_t>(is);
+        region.respawn_at = binary::read<agario::tick>(is);
+      }
+      _generations.resize(_capacity);
+      if (!is.read(reinterpret_cast<char *>(_generations.data()), _generations.size()))
+        throw binary::FormatException("Unexpected end of data");
+
+      _respawn_queue.resize(binary::read<std::uint32_t>(is));
+      for (auto &region : _respawn_queue)
+        region = binary::read<int>(is);
+    }
+
+  private:
+    struct Region {
+      std::uint64_t eaten = 0; // bit i is set if slot i has been eaten
+      agario::tick respawn_at = 0;
+    };
+
+    std::vector<Region> _regions;
+    std::vector<std::uint8_t> _generations; // of each slot, region by region (wrapping after 256)
+    std::deque<int> _respawn_queue; // regions with eaten pellets
+
+    std::uint64_t _seed;
+    int _cols, _rows;
+    agario::distance _region_width, _region_height;
+    int _base_slots, _extra_slots;
+    int _count, _capacity;
+    agario::tick _respawn_ticks;
+
+    static std::uint64_t _bit(int slot) { return std::uint64_t(1) << slot; }
+
+    /* the number of pellets in `region` (the remainder is spread over the first regions) */
+    int _slots(int region) const { return _base_slots + (region < _extra_slots); }
+
+    /* the index (into _generations) of the first slot of `region` */
+    int _first_slot(int region) const { return region * _base_slots + std::min(region, _extra_slots); }
+
+    /* calls `f` with the index of each region overlapping the box [lower, upper] */
+    template<typename F>
+    void _for_each_region(const Location &lower, const Location &upper, F &&f) const {
+      if (empty()) return;
+      int col_min = _cell(lower.x / _region_width, _cols);
+      int col_max = _cell(upper.x / _region_width, _cols);
+      int row_min = _cell(lower.y / _region_height, _rows);
+      int row_max = _cell(upper.y / _region_height, _rows);
+
+      for (int row = row_min; row <= row_max; row++)
+        for (int col = col_min; col <= col_max; col++)
+          f(row * _cols + col);
+    }
+
+    static int _cell(agario::distance coordinate, int num_cells) {
+      auto cell = clamp<float>(std::floor(static_cast<float>(coordinate)), 0, num_cells - 1);
+      return static_cast<int>(cell);
+    }
+
+    static bool _inside(const Location &loc, const Location &lower, const Location &upper) {
+      return lower.x <= loc.x && loc.x <= upper.x && lower.y <= loc.y && loc.y <= upper.y;
+    }
+
+    /* the location of the pellet in `slot` of `region`, in its current generation */
+    Location _location(int region, int slot) const {
+      auto generation = _generations[_first_slot(region) + slot];
+      auto key = (std::uint64_t(region) << 32) ^ (std::uint64_t(generation) << 6) ^ slot;
+      auto hash = _mix(_seed ^ _mix(key));
+
+      // two 24-bit fractions of the region's width and height
+      constexpr double scale = 1.0 / (1 << 24);
+      double fx = static_cast<double>(hash >> 40) * scale;
+      double fy = static_cast<double>((hash >> 16) & 0xFFFFFF) * scale;
+
+      int col = region % _cols;
+      int row = region / _cols;
+      return Location(_region_width * (col + fx), _region_height * (row + fy));
+    }
+
+    /* SplitMix64 finalizer */
+    static std::uint64_t _mix(std::uint64_t z) {
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+  };
+
+}
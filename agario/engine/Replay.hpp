@@ -0,0 +1,392 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "agario/core/types.hpp"
+#include "agario/engine/Engine.hpp"
+#include "agario/engine/binary.hpp"
+
+/**
+ * Recording games to a compact binary file, and playing them back from any tick.
+ * A replay file consists of
+ *
+ *   header   magic "AGRP", format version, numeric type and engine configuration
+ *   records  either a keyframe (the complete game state, see Engine::save_state)
+ *            or a tick (the elapsed time, and every player's target and action)
+ *   index    the tick and file offset of every keyframe, followed by the
+ *            offset of the index and the magic "AGRI"
+ *
+ * Keyframes are written every `keyframe_interval` ticks, and before the first
+ * tick after players are added or respawned or the game is reset. A tick is
+ * played back by loading the nearest preceding keyframe and re-simulating the
+ * ticks after it with the recorded player actions, so this relies on the engine
+ * being deterministic. Bots are played back as plain players following their
+ * recorded targets. Ticks are numbered from the start of the replay (unlike
+ * Engine::ticks, which restarts when the game is reset).
+ */
+namespace agario {
+
+  class ReplayException : public std::runtime_error {
+    using runtime_error::runtime_error;
+  };
+
+  namespace replay {
+
+    constexpr char magic[4] = { 'A', 'G', 'R', 'P' };
+    constexpr char index_magic[4] = { 'A', 'G', 'R', 'I' };
+    constexpr std::uint32_t version = 2;
+    constexpr int default_keyframe_interval = 300;
+
+    enum record : std::uint8_t { keyframe = 'K', tick = 'T', index = 'I' };
+
+    /* the numeric type the engine was compiled with (replays can only be read with the same) */
+    constexpr std::uint8_t numeric_type =
+#ifdef DETERMINISTIC
+      1;
+#else
+      0;
+#endif
+
+    struct Keyframe {
+      std::uint64_t tick;   // number of ticks recorded before the keyframe
+      std::uint64_t offset; // in the file
+    };
+
+    struct Header {
+      agario::distance arena_width, arena_height;
+      int num_pellets, num_viruses;
+      bool pellet_regen, procedural_pellets;
+      std::uint32_t keyframe_interval;
+    };
+
+    /* the size of a tick record with `num_players`, after its record type and player count */
+    inline std::uint64_t tick_size(std::uint32_t num_players) {
+      auto player_size = sizeof(agario::pid) + 2 * sizeof(agario::distance) + sizeof(std::uint8_t);
+      return sizeof(double) + num_players * player_size;
+    }
+
+  }
+
+  /**
+   * Records the game played by an engine to a replay file, from when it's
+   * constructed until it's closed (or destroyed), by observing the engine.
+   */
+  template<bool renderable>
+  class ReplayRecorder : public EngineObserver {
+  public:
+    ReplayRecorder(Engine<renderable> &engine, const std::string &path,
+                   int keyframe_interval = replay::default_keyframe_interval) :
+      engine(engine), file(path, std::ios::binary), keyframe_interval(keyframe_interval),
+      num_ticks(0), changed(true) {
+      if (!file)
+        throw ReplayException("Could not open replay file: " + path);
+      if (keyframe_interval <= 0)
+        throw ReplayException("Keyframe interval must be positive");
+
+      file.write(replay::magic, sizeof(replay::magic));
+      binary::write(file, replay::version);
+      binary::write(file, replay::numeric_type);
+      binary::write(file, engine.arena_width());
+      binary::write(file, engine.arena_height());
+      binary::write(file, engine.num_pellets());
+      binary::write(file, engine.num_viruses());
+      binary::write<std::uint8_t>(file, engine.pellet_regen());
+      binary::write<std::uint8_t>(file, engine.procedural_pellets());
+      binary::write<std::uint32_t>(file, keyframe_interval);
+
+      engine.set_observer(this);
+    }
+
+    /* stops recording and writes the keyframe index */
+    void close() {
+      if (!file.is_open()) return;
+      engine.set_observer(nullptr);
+
+      std::uint64_t index_offset = file.tellp();
+      binary::write(file, replay::index);
+      binary::write(file, num_ticks);
+      binary::write<std::uint64_t>(file, keyframes.size());
+      for (auto &keyframe : keyframes) {
+        binary::write(file, keyframe.tick);
+        binary::write(file, keyframe.offset);
+      }
+      binary::write(file, index_offset);
+      file.write(replay::index_magic, sizeof(replay::index_magic));
+      file.close();
+    }
+
+    /* the number of ticks recorded so far */
+    [[nodiscard]] std::uint64_t ticks() const { return num_ticks; }
+
+    void before_tick() override {
+      if (changed || num_ticks % keyframe_interval == 0)
+        write_keyframe();
+    }
+
+    void after_tick(const agario::time_delta &elapsed_seconds) override {
+      binary::write(file, replay::tick);
+      binary::write<std::uint32_t>(file, engine.player_count());
+      binary::write(file, elapsed_seconds.count());
+      for (auto &pair : engine.players()) {
+        auto &player = *pair.second;
+        binary::write(file, player.pid());
+        binary::write(file, player.target.x);
+        binary::write(file, player.target.y);
+        binary::write<std::uint8_t>(file, player.action);
+      }
+      num_ticks++;
+    }
+
+    void state_changed() override { changed = true; }
+
+    ~ReplayRecorder() override { close(); }
+
+    ReplayRecorder(const ReplayRecorder &) = delete;
+    ReplayRecorder &operator=(const ReplayRecorder &) = delete;
+
+  private:
+    Engine<renderable> &engine;
+    std::ofstream file;
+    int keyframe_interval;
+
+    std::uint64_t num_ticks;
+    bool changed; // whether the game changed other than by ticking since the last keyframe
+    std::vector<replay::Keyframe> keyframes;
+    std::stringstream buffer;
+
+    void write_keyframe() {
+      keyframes.push_back({ num_ticks, static_cast<std::uint64_t>(file.tellp()) });
+
+      buffer.str(std::string());
+      engine.save_state(buffer);
+      auto state = buffer.str();
+
+      binary::write(file, replay::keyframe);
+      binary::write<std::uint8_t>(file, changed);
+      binary::write(file, num_ticks);
+      binary::write<std::uint64_t>(file, state.size());
+      file.write(state.data(), state.size());
+      changed = false;
+    }
+  };
+
+  /**
+   * Plays back a replay file, rebuilding the game state at any tick
+   */
+  template<bool renderable>
+  class ReplayReader {
+  public:
+    explicit ReplayReader(const std::string &path) :
+      file(open(path)), header(read_header(file, path)),
+      _engine(header.arena_width, header.arena_height, header.num_pellets,
+              header.num_viruses, header.pellet_regen, header.procedural_pellets),
+      records_offset(file.tellg()), num_ticks(0), current(0), loaded(false) {
+      if (!read_index())
+        scan();
+      if (keyframes.empty())
+        throw ReplayException("Replay has no keyframes: " + path);
+    }
+
+    /* the engine which plays back the game */
+    Engine<renderable> &engine() { return _engine; }
+    const GameState<renderable> &state() const { return _engine.get_game_state(); }
+
+    /* the number of ticks in the replay */
+    [[nodiscard]] std::uint64_t ticks() const { return num_ticks; }
+
+    /* the tick that the game has been played back to */
+    [[nodiscard]] std::uint64_t tick() const { return current; }
+
+    const std::vector<replay::Keyframe> &keyframes_index() const { return keyframes; }
+    [[nodiscard]] int keyframe_interval() const { return header.keyframe_interval; }
+
+    /**
+     * Rebuilds the game as it was before tick `tick` (so `seek(ticks())` is the
+     * end of the game) from the nearest keyframe, unless it's quicker to play
+     * forwards from the current tick
+     */
+    void seek(std::uint64_t tick) {
+      if (tick > num_ticks)
+        throw ReplayException("Tick " + std::to_string(tick) + " is past the end of the replay ("
+                              + std::to_string(num_ticks) + " ticks)");
+
+      auto it = std::upper_bound(keyframes.begin(), keyframes.end(), tick,
+                                 [](std::uint64_t t, const replay::Keyframe &k) { return t < k.tick; });
+      auto &keyframe = *std::prev(it);
+
+      if (!loaded || tick < current || keyframe.tick > current) {
+        file.clear();
+        file.seekg(keyframe.offset);
+        current = keyframe.tick;
+        read_keyframe_record();
+      }
+
+      while (current < tick)
+        step();
+    }
+
+    /**
+     * Plays back the next tick
+     * @return false if the end of the replay has been reached
+     */
+    bool step() {
+      if (!loaded) seek(0);
+      if (current == num_ticks) return false;
+
+      while (true) {
+        auto type = binary::read<replay::record>(file);
+        if (type == replay::keyframe) {
+          read_keyframe(false);
+          continue;
+        }
+        if (type != replay::tick)
+          throw ReplayException("Corrupt replay record at tick " + std::to_string(current));
+
+        auto num_players = binary::read<std::uint32_t>(file);
+        agario::time_delta elapsed_seconds(binary::read<double>(file));
+        for (std::uint32_t p = 0; p < num_players; p++) {
+          auto &player = _engine.player(binary::read<agario::pid>(file));
+          player.target.x = binary::read<agario::distance>(file);
+          player.target.y = binary::read<agario::distance>(file);
+          player.action = static_cast<agario::action>(binary::read<std::uint8_t>(file));
+        }
+        _engine.tick(elapsed_seconds);
+        current++;
+        return true;
+      }
+    }
+
+    ReplayReader(const ReplayReader &) = delete;
+    ReplayReader &operator=(const ReplayReader &) = delete;
+
+  private:
+    std::ifstream file;
+    replay::Header header;
+    Engine<renderable> _engine;
+
+    std::uint64_t records_offset;
+    std::uint64_t num_ticks;
+    std::uint64_t current; // the number of ticks played back
+    bool loaded;           // whether the engine holds the game at `current`
+    std::vector<replay::Keyframe> keyframes;
+
+    static std::ifstream open(const std::string &path) {
+      std::ifstream file(path, std::ios::binary);
+      if (!file)
+        throw ReplayException("Could not open replay file: " + path);
+      return file;
+    }
+
+    static replay::Header read_header(std::ifstream &file, const std::string &path) {
+      char magic[sizeof(replay::magic)];
+      if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), replay::magic))
+        throw ReplayException("Not a replay file: " + path);
+      if (binary::read<std::uint32_t>(file) != replay::version)
+        throw ReplayException("Unsupported replay version: " + path);
+      if (binary::read<std::uint8_t>(file) != replay::numeric_type)
+        throw ReplayException("Replay was recorded with a different numeric type "
+                              "(deterministic and floating point engines are incompatible): " + path);
+
+      replay::Header header {};
+      header.arena_width = binary::read<agario::distance>(file);
+      header.arena_height = binary::read<agario::distance>(file);
+      header.num_pellets = binary::read<int>(file);
+      header.num_viruses = binary::read<int>(file);
+      header.pellet_regen = binary::read<std::uint8_t>(file);
+      header.procedural_pellets = binary::read<std::uint8_t>(file);
+      header.keyframe_interval = binary::read<std::uint32_t>(file);
+      return header;
+    }
+
+    /* reads the keyframe index at the end of the file, if there is one */
+    bool read_index() {
+      constexpr auto trailer_size = sizeof(std::uint64_t) + sizeof(replay::index_magic);
+      file.seekg(0, std::ios::end);
+      std::uint64_t size = file.tellg();
+      if (size < records_offset + trailer_size) return false;
+
+      file.seekg(size - trailer_size);
+      auto index_offset = binary::read<std::uint64_t>(file);
+      char magic[sizeof(replay::index_magic)];
+      if (!file.read(magic, sizeof(magic))) return false;
+      if (!std::equal(magic, magic + sizeof(magic), replay::index_magic)) return false;
+
+      file.seekg(index_offset);
+      if (binary::read<replay::record>(file) != replay::index) return false;
+      num_ticks = binary::read<std::uint64_t>(file);
+      keyframes.resize(binary::read<std::uint64_t>(file));
+      for (auto &keyframe : keyframes) {
+        keyframe.tick = binary::read<std::uint64_t>(file);
+        keyframe.offset = binary::read<std::uint64_t>(file);
+      }
+      return true;
+    }
+
+    /* rebuilds the index of a replay which wasn't closed (e.g. the program crashed) */
+    void scan() {
+      file.clear();
+      file.seekg(0, std::ios::end);
+      std::uint64_t size = file.tellg();
+      file.seekg(records_offset);
+
+      // only complete records are indexed
+      try {
+        while (true) {
+          std::uint64_t offset = file.tellg();
+          if (offset >= size) break;
+
+          auto type = binary::read<replay::record>(file);
+          std::uint64_t end;
+          if (type == replay::keyframe) {
+            binary::read<std::uint8_t>(file);
+            auto tick = binary::read<std::uint64_t>(file);
+            end = static_cast<std::uint64_t>(file.tellg()) + sizeof(std::uint64_t) + binary::read<std::uint64_t>(file);
+            if (end > size) break;
+            keyframes.push_back({ tick, offset });
+          } else if (type == replay::tick) {
+            end = static_cast<std::uint64_t>(file.tellg()) + sizeof(std::uint32_t)
+                  + replay::tick_size(binary::read<std::uint32_t>(file));
+            if (end > size) break;
+            num_ticks++;
+          } else break;
+          file.seekg(end);
+        }
+      } catch (const binary::FormatException &) { /* truncated record */ }
+      file.clear();
+    }
+
+    /* reads the keyframe record at the current position, loading the game from it */
+    void read_keyframe_record() {
+      if (binary::read<replay::record>(file) != replay::keyframe)
+        throw ReplayException("Corrupt replay: expected a keyframe");
+      read_keyframe(true);
+    }
+
+    /* reads the rest of a keyframe record, loading the game from it if `load` or
+     * if it was written because the game changed other than by ticking */
+    void read_keyframe(bool load) {
+      bool changed = binary::read<std::uint8_t>(file);
+      auto tick = binary::read<std::uint64_t>(file);
+      auto size = binary::read<std::uint64_t>(file);
+      if (tick != current)
+        throw ReplayException("Corrupt replay: keyframe out of place");
+
+      if (load || changed) {
+        std::string state(size, '\0');
+        if (!file.read(&state[0], size))
+          throw ReplayException("Corrupt replay: truncated keyframe");
+        std::istringstream is(state);
+        _engine.load_state(is);
+        loaded = true;
+      } else {
+        file.seekg(size, std::ios::cur);
+      }
+    }
+  };
+
+}
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "agario/core/types.hpp"
+#include "agario/core/utils.hpp"
+
+namespace agario {
+
+  /**
+   * A uniform grid over the arena, indexing where the pellets, foods, viruses
+   * and players of a GameState were when it was built, so that bots can find
+   * what is near them without scanning every entity in the arena.
+   * The entries of each kind are stored contiguously, sorted by grid cell
+   * (with the offset of each cell's first entry), and all queries visit only
+   * the grid cells which overlap the area searched. It can be built in
+   * parallel, sorting bands of the grid's rows at once, into the same order.
+   */
+  class SpatialIndex {
+  public:
+    enum kind : int { pellets = 0, foods, viruses, players, num_kinds };
+
+    struct Entry {
+      Location location;
+      std::uint32_t id; // index into the state's pellets, foods or viruses, or a player's pid
+    };
+
+    /* calls the given function with each of 0 ... n - 1, returning once all calls have */
+    using ParallelFor = std::function<void(std::size_t, const std::function<void(std::size_t)> &)>;
+
+    /* about this many entries of the most numerous kind share each grid cell */
+    static constexpr int entries_per_cell = 8;
+    static constexpr int max_grid_side = 256;
+
+    // when built in parallel, the most chunks that the entries are split into, and
+    // bands that the rows are, and the fewest entries worth a chunk of their own
+    static constexpr int max_tasks = 64;
+    static constexpr std::size_t min_chunk = 4096;
+
+    /**
+     * Indexes the entities of `state` (dead players, without a location, are
+     * left out), in parallel if given a `parallel_for`, which must call f(0)
+     * ... f(n - 1) (in any order, on any threads) and return once they all have
+     */
+    template<typename GameState>
+    void build(const GameState &state, const ParallelFor &parallel_for = nullptr) {
+      auto most = std::max({ state.pellets.size(), state.foods.size(), state.viruses.size(), state.players.size() });
+      configure(state.arena_width, state.arena_height, static_cast<int>(most));
+
+      _parallel_for = parallel_for;
+      fill(pellets, state.pellets);
+      fill(foods, state.foods);
+      fill(viruses, state.viruses);
+
+      auto &entries = _staged;
+      entries.clear();
+      for (auto &pair : state.players)
+        if (!pair.second->dead())
+          entries.push_back(Entry { pair.second->location(), static_cast<std::uint32_t>(pair.first) });
+      sort(players);
+      _parallel_for = nullptr;
+    }
+
+    [[nodiscard]] std::size_t size(kind k) const { return _grids[k].entries.size(); }
+
+    /* calls `f` with each entry of kind `k` inside the box [lower, upper] */
+    template<typename F>
+    void for_each_in_box(kind k, const Location &lower, const Location &upper, F &&f) const {
+      auto &grid = _grids[k];
+      if (grid.entries.empty()) return;
+      int col_min = col(lower.x), col_max = col(upper.x);
+      int row_min = row(lower.y), row_max = row(upper.y);
+      for (int r = row_min; r <= row_max; r++) {
+        auto begin = grid.starts[r * _cols + col_min];
+        auto end = grid.starts[r * _cols + col_max + 1];
+        for (auto i = begin; i < end; i++) {
+          auto &entry = grid.entries[i];
+          if (lower.x <= entry.location.x && entry.location.x <= upper.x &&
+              lower.y <= entry.location.y && entry.location.y <= upper.y)
+            f(entry);
+        }
+      }
+    }
+
+    /* calls `f` with each entry of kind `k` within `radius` of `center` (inclusive), and its distance */
+    template<typename F>
+    void for_each_within(kind k, const Location &center, agario::distance radius, F &&f) const {
+      Location extent(radius, radius);
+      for_each_in_box(k, center - extent, center + extent, [&](const Entry &entry) {
+        auto dist = entry.location.distance_to(center);
+        if (dist <= radius) f(entry, dist);
+      });
+    }
+
+    /**
+     * The (at most) `count` entries of kind `k` nearest to `center` and no
+     * farther than `max_distance`, nearest first. The search widens outwards
+     * from the grid cell of `center`, so only nearby cells are visited.
+     */
+    std::vector<Entry> nearest(kind k, const Location &center, std::size_t count,
+                               agario::distance max_distance = agario::distance::max()) const {
+      std::vector<std::pair<agario::distance, Entry>> found;
+      if (count == 0 || _grids[k].entries.empty()) return {};
+
+      auto by_distance = [](const std::pair<agario::distance, Entry> &a, const std::pair<agario::distance, Entry> &b) {
+        return a.first < b.first || (a.first == b.first && a.second.id < b.second.id);
+      };
+
+      auto reach = std::max(_cell_width, _cell_height);
+      auto arena_size = std::max(_cell_width * _cols, _cell_height * _rows);
+      while (true) {
+        found.clear();
+        for_each_within(k, center, std::min(reach, max_distance), [&](const Entry &entry, agario::distance dist) {
+          found.emplace_back(dist, entry);
+        });
+
+        // anything outside of the searched circle is farther than `reach`
+        if (found.size() >= count || reach >= max_distance || reach > 2 * arena_size) break;
+        reach *= 2;
+      }
+
+      auto n = std::min(count, found.size());
+      std::partial_sort(found.begin(), found.begin() + n, found.end(), by_distance);
+      std::vector<Entry> nearest;
+      nearest.reserve(n);
+      for (std::size_t i = 0; i < n; i++)
+        nearest.push_back(found[i].second);
+      return nearest;
+    }
+
+    /**
+     * Finds the entry of kind `k` nearest to `center`
+     * @return whether there are any entries of kind `k`
+     */
+    bool nearest(kind k, const Location &center, Entry &nearest) const {
+      if (_grids[k].entries.empty()) return false;
+
+      // as the search above, keeping only the nearest so as not to allocate
+      auto reach = std::max(_cell_width, _cell_height);
+      auto arena_size = std::max(_cell_width * _cols, _cell_height * _rows);
+      bool found = false;
+      agario::distance nearest_distance = 0;
+      while (true) {
+        for_each_within(k, center, reach, [&](const Entry &entry, agario::distance dist) {
+          if (!found || dist < nearest_distance || (dist == nearest_distance && entry.id < nearest.id)) {
+            nearest = entry;
+            nearest_distance = dist;
+            found = true;
+          }
+        });
+        if (found || reach > 2 * arena_size) return found;
+        reach *= 2;
+      }
+    }
+
+  private:
+    struct Grid {
+      std::vector<Entry> entries;        // sorted by grid cell
+      std::vector<std::uint32_t> starts; // of each cell's entries, with the total at the end
+    };
+
+    std::array<Grid, num_kinds> _grids;
+    std::vector<Entry> _staged;          // entries in the order added, before sorting
+    std::vector<std::uint32_t> _cells;   // the grid cell of each staged entry
+
+    // for building in parallel: the staged entries (by index) band by band, and where
+    // each band begins, and each chunk's count of (and then offset into) each band
+    ParallelFor _parallel_for;
+    std::vector<std::uint32_t> _banded;
+    std::vector<std::uint32_t> _band_starts;
+    std::vector<std::uint32_t> _chunk_offsets;
+    std::vector<std::uint8_t> _bands, _row_bands; // the band of each staged entry, and of each row
+
+    int _cols = 1, _rows = 1;
+    agario::distance _cell_width = 1, _cell_height = 1;
+
+    void configure(agario::distance width, agario::distance height, int num_entries) {
+      // roughly square cells, each holding about `entries_per_cell` of the most numerous kind
+      auto side = std::sqrt(static_cast<float>(width) * static_cast<float>(height)
+                            * entries_per_cell / std::max(1, num_entries));
+      _cols = clamp(static_cast<int>(std::lround(width / side)), 1, max_grid_side);
+      _rows = clamp(static_cast<int>(std::lround(height / side)), 1, max_grid_side);
+      _cell_width = width / _cols;
+      _cell_height = height / _rows;
+    }
+
+    int col(agario::distance x) const { return cell(x / _cell_width, _cols); }
+    int row(agario::distance y) const { return cell(y / _cell_height, _rows); }
+
+    static int cell(agario::distance coordinate, int num_cells) {
+      return static_cast<int>(clamp<float>(std::floor(static_cast<float>(coordinate)), 0, num_cells - 1));
+    }
+
+    template<typename Entities>
+    void fill(kind k, const Entities &entities) {
+      _staged.resize(entities.size());
+      for_each_chunk(entities.size(), [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; i++)
+          _staged[i] = Entry { entities[i].location(), static_cast<std::uint32_t>(i) };
+      });
+      sort(k);
+    }
+
+    /* calls f(c, begin, end) with each chunk c of the `n` entries (see num_chunks), in parallel if building so */
+    template<typename F>
+    void for_each_chunk(std::size_t n, F &&f) {
+      auto num_chunks = this->num_chunks(n);
+      run(num_chunks, [&](std::size_t c) { f(c, c * n / num_chunks, (c + 1) * n / num_chunks); });
+    }
+
+    /* the chunks that `n` entries are split into (one, unless building in parallel) */
+    std::size_t num_chunks(std::size_t n) const {
+      if (!_parallel_for) return 1;
+      return clamp<std::size_t>((n + min_chunk - 1) / min_chunk, 1, max_tasks);
+    }
+
+    void run(std::size_t n, const std::function<void(std::size_t)> &f) {
+      if (_parallel_for && n > 1) {
+        _parallel_for(n, f);
+        return;
+      }
+      for (std::size_t i = 0; i < n; i++) f(i);
+    }
+
+    /**
+     * Counting sort of the staged entries into the grid of kind `k`, keeping
+     * their order within each cell. In parallel, each chunk of the entries
+     * counts how many fall in each band of rows, then copies their indices
+     * into the bands (in order), and then each band sorts its own entries.
+     */
+    void sort(kind k) {
+      auto &grid = _grids[k];
+      auto n = _staged.size();
+      auto num_chunks = this->num_chunks(n);
+      auto num_bands = num_chunks == 1 ? 1 : static_cast<std::size_t>(std::min(_rows, max_tasks));
+      grid.starts.resize(_cols * _rows + 1);
+      grid.entries.resize(n);
+      _cells.resize(n);
+
+      _row_bands.resize(_rows);
+      for (int r = 0; r < _rows; r++)
+        _row_bands[r] = static_cast<std::uint8_t>(r * num_bands / _rows);
+      _bands.resize(n);
+
+      _chunk_offsets.assign(num_chunks * num_bands, 0);
+      for_each_chunk(n, [&](std::size_t c, std::size_t begin, std::size_t end) {
+        auto *counts = &_chunk_offsets[c * num_bands];
+        for (auto i = begin; i < end; i++) {
+          auto r = row(_staged[i].location.y);
+          _cells[i] = r * _cols + col(_staged[i].location.x);
+          _bands[i] = _row_bands[r];
+          counts[_bands[i]]++;
+        }
+      });
+
+      _band_starts.resize(num_bands + 1);
+      std::uint32_t offset = 0;
+      for (std::size_t b = 0; b < num_bands; b++) {
+        _band_starts[b] = offset;
+        for (std::size_t c = 0; c < num_chunks; c++) {
+          auto count = _chunk_offsets[c * num_bands + b];
+          _chunk_offsets[c * num_bands + b] = offset;
+          offset += count;
+        }
+      }
+      _band_starts[num_bands] = offset;
+
+      if (num_bands > 1) {
+        _banded.resize(n);
+        for_each_chunk(n, [&](std::size_t c, std::size_t begin, std::size_t end) {
+          auto *next = &_chunk_offsets[c * num_bands];
+          for (auto i = begin; i < end; i++)
+            _banded[next[_bands[i]]++] = static_cast<std::uint32_t>(i);
+        });
+      }
+
+      run(num_bands, [&](std::size_t b) {
+        auto first_cell = first_row(b, num_bands) * _cols;
+        auto last_cell = first_row(b + 1, num_bands) * _cols;
+        auto staged = [&](std::uint32_t j) { return num_bands > 1 ? _banded[j] : j; };
+
+        // each cell's count, then where it begins, then as it's filled, where the next begins
+        std::fill(grid.starts.begin() + first_cell, grid.starts.begin() + last_cell, 0);
+        for (auto j = _band_starts[b]; j < _band_starts[b + 1]; j++)
+          grid.starts[_cells[staged(j)]]++;
+        auto start = _band_starts[b];
+        for (auto c = first_cell; c < last_cell; c++) {
+          auto count = grid.starts[c];
+          grid.starts[c] = start;
+          start += count;
+        }
+        for (auto j = _band_starts[b]; j < _band_starts[b + 1]; j++) {
+          auto i = staged(j);
+          grid.entries[grid.starts[_cells[i]]++] = _staged[i];
+        }
+        for (auto c = last_cell - 1; c > first_cell; c--)
+          grid.starts[c] = grid.starts[c - 1];
+        grid.starts[first_cell] = _band_starts[b];
+      });
+      grid.starts[_cols * _rows] = static_cast<std::uint32_t>(n);
+    }
+
+    /* the first row of band `b` (of `num_bands`), the rows r for which r * num_bands / _rows == b */
+    int first_row(std::size_t b, std::size_t num_bands) const {
+      return static_cast<int>((b * _rows + num_bands - 1) / num_bands);
+    }
+  };
+
+}
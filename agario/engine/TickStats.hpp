@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+
+#include "agario/core/types.hpp"
+
+/**
+ * Per-phase profiling of Engine::tick. When compiled with ENGINE_PROFILING
+ * defined, the engine records how long each phase of the tick takes and how
+ * many collision tests it performs into its TickStats. Otherwise the profiling
+ * macros expand to nothing so that there's no cost at all.
+ */
+#ifdef ENGINE_PROFILING
+#define _PROFILE_CONCAT(a, b) a ## b
+#define _PROFILE_TIMER_NAME(line) _PROFILE_CONCAT(_phase_timer_, line)
+#define PROFILE_TICK(stats) agario::PhaseTimer _PROFILE_TIMER_NAME(__LINE__)((stats).tick_seconds, (stats).ticks)
+#define PROFILE_PHASE(stats, phase) agario::PhaseTimer _PROFILE_TIMER_NAME(__LINE__)((stats).seconds[phase], (stats).calls[phase])
+#define PROFILE_COUNT(counter, n) ((counter) += (n))
+#else
+#define PROFILE_TICK(stats) ((void) 0)
+#define PROFILE_PHASE(stats, phase) ((void) 0)
+#define PROFILE_COUNT(counter, n) ((void) 0)
+#endif
+
+namespace agario {
+
+  /* the phases of a game tick which are timed separately */
+  enum tick_phase {
+    bot_actions = 0,
+    movement,
+    pellet_eating,
+    food_eating,
+    virus_collisions,
+    split_feed,
+    recombination,
+    player_collisions,
+    food_movement,
+    regeneration,
+    num_tick_phases
+  };
+
+  inline const char *phase_name(int phase) {
+    static const char *names[num_tick_phases] = {
+      "bot actions", "movement", "pellet eating", "food eating", "virus collisions",
+      "split/feed", "recombination", "player collisions", "food movement", "regeneration"
+    };
+    return names[phase];
+  }
+
+  /* timing, collision test and entity counts accumulated over game ticks */
+  struct TickStats {
+    static constexpr bool enabled =
+#ifdef ENGINE_PROFILING
+      true;
+#else
+      false;
+#endif
+
+    unsigned long ticks = 0;   // number of ticks profiled
+    double tick_seconds = 0;   // total time spent in those ticks
+
+    // total time spent in, and number of times entering, each phase
+    std::array<double, num_tick_phases> seconds {};
+    std::array<unsigned long, num_tick_phases> calls {};
+
+    // number of pairs of entities tested for collision
+    unsigned long pellet_tests = 0;
+    unsigned long food_tests = 0;
+    unsigned long virus_tests = 0;
+    unsigned long cell_tests = 0;
+
+    // entity counts after the most recent tick
+    int num_players = 0;
+    int num_cells = 0;
+    int num_pellets = 0;
+    int num_foods = 0;
+    int num_viruses = 0;
+
+    /* accumulates the stats of another engine (keeping its entity counts) */
+    TickStats &operator+=(const TickStats &other) {
+      ticks += other.ticks;
+      tick_seconds += other.tick_seconds;
+      for (int p = 0; p < num_tick_phases; p++) {
+        seconds[p] += other.seconds[p];
+        calls[p] += other.calls[p];
+      }
+      pellet_tests += other.pellet_tests;
+      food_tests += other.food_tests;
+      virus_tests += other.virus_tests;
+      cell_tests += other.cell_tests;
+      num_players = other.num_players;
+      num_cells = other.num_cells;
+      num_pellets = other.num_pellets;
+      num_foods = other.num_foods;
+      num_viruses = other.num_viruses;
+      return *this;
+    }
+  };
+
+  /* adds the time from its construction to its destruction to `seconds` */
+  class PhaseTimer {
+    using clock = std::chrono::steady_clock;
+  public:
+    PhaseTimer(double &seconds, unsigned long &calls) : seconds(seconds), start(clock::now()) {
+      calls++;
+    }
+    ~PhaseTimer() {
+      seconds += std::chrono::duration<double>(clock::now() - start).count();
+    }
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+  private:
+    double &seconds;
+    clock::time_point start;
+  };
+
+  /* prints a table of the time spent in each phase, and the collision test counts */
+  inline std::ostream &operator<<(std::ostream &os, const TickStats &stats) {
+    if (!TickStats::enabled)
+      return os << "Tick profiling disabled (compile with ENGINE_PROFILING)" << std::endl;
+
+    auto per_tick = [&](double x) { return stats.ticks == 0 ? 0 : x / stats.ticks; };
+
+    os << std::setw(18) << "Phase" << std::setw(12) << "us/tick" << std::setw(8) << "%" << std::endl;
+    os << std::setfill('=') << std::setw(38) << "" << std::setfill(' ') << std::endl;
+    os << std::fixed << std::setprecision(2);
+    for (int p = 0; p < num_tick_phases; p++) {
+      auto percent = stats.tick_seconds == 0 ? 0 : 100 * stats.seconds[p] / stats.tick_seconds;
+      os << std::setw(18) << phase_name(p)
+         << std::setw(12) << 1e6 * per_tick(stats.seconds[p])
+         << std::setw(8) << percent << std::endl;
+    }
+    os << std::setw(18) << "total" << std::setw(12) << 1e6 * per_tick(stats.tick_seconds) << std::endl;
+
+    os << std::endl << "Collision tests per tick: "
+       << "pellet " << per_tick(stats.pellet_tests) << ", "
+       << "food " << per_tick(stats.food_tests) << ", "
+       << "virus " << per_tick(stats.virus_tests) << ", "
+       << "cell " << per_tick(stats.cell_tests) << std::endl;
+    os << std::defaultfloat;
+    os << "Entities: " << stats.num_players << " players, " << stats.num_cells << " cells, "
+       << stats.num_pellets << " pellets, " << stats.num_foods << " foods, "
+       << stats.num_viruses << " viruses" << std::endl;
+    return os;
+  }
+
+}
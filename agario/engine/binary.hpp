@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+/**
+ * Reading and writing values in a compact binary form, used to save and
+ * load the complete game state (see Engine::save_state and Replay.hpp).
+ * Values are written as their in-memory bytes, so that floating point
+ * (and fixed-point) numbers round trip exactly, which means that files
+ * can only be read back by a build with the same numeric types and
+ * byte order.
+ */
+namespace agario::binary {
+
+  class FormatException : public std::runtime_error {
+    using runtime_error::runtime_error;
+  };
+
+  template<typename T>
+  void write(std::ostream &os, const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be written");
+    os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template<typename T>
+  T read(std::istream &is) {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be read");
+    T value;
+    if (!is.read(reinterpret_cast<char *>(&value), sizeof(T)))
+      throw FormatException("Unexpected end of data");
+    return value;
+  }
+
+  inline void write_string(std::ostream &os, const std::string &s) {
+    write<std::uint32_t>(os, s.size());
+    os.write(s.data(), s.size());
+  }
+
+  inline std::string read_string(std::istream &is) {
+    auto size = read<std::uint32_t>(is);
+    std::string s(size, '\0');
+    if (size > 0 && !is.read(&s[0], size))
+      throw FormatException("Unexpected end of data");
+    return s;
+  }
+
+}
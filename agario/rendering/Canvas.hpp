@@ -7,5 +7,9 @@ public:
   virtual screen_len width() const = 0;
   virtual screen_len height() const = 0;
   virtual float aspect_ratio() const { return (float) width() / height(); }
+
+  /* how many width by height screens the canvas holds, and which one to draw into */
+  virtual int num_tiles() const { return 1; }
+  virtual void use_tile(int tile) { }
   virtual ~Canvas() = default;
 };
\ No newline at end of file
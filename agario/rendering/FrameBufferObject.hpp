@@ -5,6 +5,18 @@
 
 #include "agario/rendering/Canvas.hpp"
 
+#ifdef USE_EGL
+#include "agario/rendering/HeadlessContext.hpp"
+#endif
+
+#include <memory>
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 class FBOException : public std::runtime_error {
   using runtime_error::runtime_error;
 };
@@ -19,33 +31,43 @@ public:
 
   static constexpr GLenum target = GL_RENDERBUFFER;
 
-  FrameBufferObject(screen_len width, screen_len height) :
-    _width(width), _height(height),
-    fbo(0), rbo_depth(0), rbo_color(0),
-    window(nullptr) {
-
-    glfwSetErrorCallback(glfw_error_callback);
-
-    if (!glfwInit())
-      throw FBOException("GLFW initialization failed.");
+  // the number of frames that may be read back asynchronously at once
+  static constexpr std::size_t readback_depth = 3;
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+  /* whether frame buffers may be made headless (i.e. compiled with EGL) */
+  static constexpr bool headless_available =
+#ifdef USE_EGL
+    true;
+#else
+    false;
 #endif
 
-    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
-    window = glfwCreateWindow(_width, _height, "", nullptr, nullptr);
+  /**
+   * @param headless whether to render without a window (and so without a
+   * display server) through the EGL context shared by headless frame buffers,
+   * which requires USE_EGL. Otherwise the frame buffer belongs to a hidden
+   * GLFW window.
+   * @param num_tiles the number of width by height screens to hold, stacked
+   * one above another (see use_tile), so that they're all read back at once
+   */
+  FrameBufferObject(screen_len width, screen_len height, bool headless = false, int num_tiles = 1) :
+    _width(width), _height(height), _num_tiles(num_tiles),
+    fbo(0), rbo_depth(0), rbo_color(0),
+    window(nullptr), readbacks(), first_pending(0), num_pending(0), pbos_created(false) {
 
-    if (window == nullptr) {
-      glfwTerminate();
-      throw FBOException("Off-screen window creation failed");
-    }
+    if (headless)
+      create_headless_context();
+    else
+      create_window();
 
-    glfwHideWindow(window);
-    glfwMakeContextCurrent(window);
+    if (num_tiles < 1)
+      throw FBOException("A frame buffer needs at least one tile");
+
+    GLint max_size;
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &max_size);
+    if (_height * num_tiles > max_size)
+      throw FBOException(std::to_string(num_tiles) + " tiles of height " + std::to_string(_height)
+                         + " exceed the largest frame buffer (" + std::to_string(max_size) + ")");
 
     // Frame Buffer Object
     glGenFramebuffers(1, &fbo);
@@ -54,13 +76,13 @@ public:
     // Color
     glGenRenderbuffers(1, &rbo_color);
     glBindRenderbuffer(GL_RENDERBUFFER, rbo_color);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB565, _width, _height);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB565, _width, _height * _num_tiles);
     glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rbo_color);
 
     // Depth
     glGenRenderbuffers(1, &rbo_depth);
     glBindRenderbuffer(GL_RENDERBUFFER, rbo_depth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, _width, _height);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, _width, _height * _num_tiles);
     glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rbo_depth);
 
     auto fbo_status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
@@ -74,23 +96,107 @@ public:
     if (glstatus != GL_NO_ERROR)
       throw FBOException("GL Error: " + std::to_string(glstatus));
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    if (offscreen()) {
+      // there's no window to render to (or not one big enough), so everything is rendered into (and read from) this
+      glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+      glViewport(0, 0, _width, _height);
+    } else {
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    }
   }
 
   int width() const override { return _width; }
   int height() const override { return _height; }
 
-  void show() const { glfwShowWindow(window); }
-  void hide() const { glfwHideWindow(window); }
+  [[nodiscard]] bool headless() const { return window == nullptr; }
+
+  int num_tiles() const override { return _num_tiles; }
+
+  /* directs drawing to the given tile */
+  void use_tile(int tile) override {
+    glViewport(0, tile * _height, _width, _height);
+  }
+
+  void show() const { if (window != nullptr) glfwShowWindow(window); }
+  void hide() const { if (window != nullptr) glfwHideWindow(window); }
+
+  /* makes this frame buffer's context current on the calling thread */
+  void make_current() const {
+#ifdef USE_EGL
+    if (headless_context) {
+      // the context is shared with the other headless frame buffers
+      headless_context->make_current();
+      glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+      glViewport(0, 0, _width, _height);
+      return;
+    }
+#endif
+    glfwMakeContextCurrent(window);
+  }
+
+  /* the number of bytes in a frame (or tile) */
+  std::size_t frame_size() const { return static_cast<std::size_t>(_width) * _height * 3; }
 
+  /* copies the current frame (every tile, one after another) to `data`, waiting for rendering to finish */
   void copy(void *data) {
-    glReadBuffer(GL_COLOR_ATTACHMENT0);
-    glReadPixels(_width / 2, _height / 2, _width, _height, GL_RGB, GL_UNSIGNED_BYTE, data);
+    flush(); // so that frames arrive in order
+    read_pixels(data);
+  }
+
+  /**
+   * Starts copying the current frame to `data` without waiting for it to be
+   * rendered: the pixels are read into one of a ring of pixel buffer objects,
+   * and only copied to `data` (which must stay valid until then) a frame or
+   * two later, once the GPU is done with them. Frames arrive in the order
+   * that they're queued, and all of them have arrived after `flush`.
+   */
+  void copy_async(void *data) {
+    std::vector<void *> tiles;
+    for (int tile = 0; tile < _num_tiles; tile++)
+      tiles.push_back(static_cast<std::uint8_t *>(data) + tile * frame_size());
+    copy_async(tiles);
+  }
+
+  /* like copy_async, with a destination for each tile (any null ones are skipped) */
+  void copy_async(const std::vector<void *> &tiles) {
+    if (tiles.size() != static_cast<std::size_t>(_num_tiles))
+      throw FBOException("Expected a destination for each of " + std::to_string(_num_tiles) + " tiles");
+
+    if (!pbos_created) create_pbos();
+
+    // take any frames which have arrived, and make room for this one
+    while (num_pending > 0 && ready(readbacks[first_pending]))
+      finish_readback();
+    if (num_pending == readback_depth)
+      finish_readback();
+
+    auto &readback = readbacks[(first_pending + num_pending) % readback_depth];
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    read_pixels(nullptr); // into the bound buffer, at offset zero
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.destinations = tiles;
+    num_pending++;
+  }
+
+  /* whether any frames queued with copy_async are yet to arrive */
+  [[nodiscard]] bool pending() const { return num_pending > 0; }
+
+  /* waits for every frame queued with copy_async to arrive */
+  void flush() {
+    while (num_pending > 0)
+      finish_readback();
   }
 
-  void swap_buffers() const { glfwSwapBuffers(window); }
+  void swap_buffers() const { if (window != nullptr) glfwSwapBuffers(window); }
 
   ~FrameBufferObject() override {
+    make_current(); // another frame buffer's context may be current
+    for (auto &readback : readbacks) {
+      if (readback.fence != nullptr) glDeleteSync(readback.fence);
+      if (pbos_created) glDeleteBuffers(1, &readback.pbo);
+    }
     glDeleteFramebuffers(1, &fbo);
     glDeleteRenderbuffers(1, &rbo_color);
     glDeleteRenderbuffers(1, &rbo_depth);
@@ -99,10 +205,121 @@ public:
 private:
   const screen_len _width;
   const screen_len _height;
+  const int _num_tiles;
 
   GLuint fbo;
   GLuint rbo_depth;
   GLuint rbo_color;
 
   GLFWwindow *window;
+#ifdef USE_EGL
+  std::shared_ptr<HeadlessContext> headless_context;
+#endif
+
+  // a frame being read back into a pixel buffer object, for its tiles to be copied to `destinations`
+  struct Readback {
+    GLuint pbo = 0;
+    GLsync fence = nullptr;
+    std::vector<void *> destinations;
+  };
+
+  // a ring of readbacks, of which `num_pending` from `first_pending` are in flight
+  std::array<Readback, readback_depth> readbacks;
+  std::size_t first_pending;
+  std::size_t num_pending;
+  bool pbos_created;
+
+  /* whether rendering goes into the frame buffer object, rather than the window's own */
+  bool offscreen() const { return headless() || _num_tiles > 1; }
+
+  void create_window() {
+    glfwSetErrorCallback(glfw_error_callback);
+
+    if (!glfwInit())
+      throw FBOException("GLFW initialization failed.");
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(_width, _height, "", nullptr, nullptr);
+
+    if (window == nullptr) {
+      glfwTerminate();
+      throw FBOException("Off-screen window creation failed");
+    }
+
+    glfwHideWindow(window);
+    glfwMakeContextCurrent(window);
+  }
+
+  void create_headless_context() {
+#ifdef USE_EGL
+    try {
+      headless_context = HeadlessContext::shared();
+    } catch (const HeadlessContextException &e) {
+      throw FBOException(e.what());
+    }
+#else
+    throw FBOException("Headless rendering requires compiling with EGL (USE_EGL)");
+#endif
+  }
+
+  void read_pixels(void *data) {
+    glPixelStorei(GL_PACK_ALIGNMENT, 1); // rows are tightly packed, whatever the width
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    if (offscreen())
+      glReadPixels(0, 0, _width, _height * _num_tiles, GL_RGB, GL_UNSIGNED_BYTE, data);
+    else
+      glReadPixels(_width / 2, _height / 2, _width, _height, GL_RGB, GL_UNSIGNED_BYTE, data);
+  }
+
+  void create_pbos() {
+    for (auto &readback : readbacks) {
+      glGenBuffers(1, &readback.pbo);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+      glBufferData(GL_PIXEL_PACK_BUFFER, frame_size() * _num_tiles, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    pbos_created = true;
+  }
+
+  static bool ready(const Readback &readback) {
+    auto status = glClientWaitSync(readback.fence, 0, 0);
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+  }
+
+  /* waits for the oldest pending frame, and copies it to its destination */
+  void finish_readback() {
+    auto &readback = readbacks[first_pending];
+
+    GLenum status;
+    do {
+      status = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    } while (status == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+    if (status == GL_WAIT_FAILED)
+      throw FBOException("Waiting for a frame to be read failed");
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    auto pixels = static_cast<const std::uint8_t *>(
+      glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame_size() * _num_tiles, GL_MAP_READ_BIT));
+    if (pixels == nullptr) {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      throw FBOException("Mapping a frame's pixel buffer failed");
+    }
+    for (std::size_t tile = 0; tile < readback.destinations.size(); tile++)
+      if (readback.destinations[tile] != nullptr)
+        std::memcpy(readback.destinations[tile], pixels + tile * frame_size(), frame_size());
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    first_pending = (first_pending + 1) % readback_depth;
+    num_pending--;
+  }
 };
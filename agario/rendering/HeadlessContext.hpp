@@ -0,0 +1,126 @@
+#pragma once
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+class HeadlessContextException : public std::runtime_error {
+  using runtime_error::runtime_error;
+};
+
+/**
+ * An OpenGL 3.3 core context with no window, display server or GPU needed:
+ * made through EGL on a surfaceless display (e.g. Mesa's llvmpipe software
+ * renderer), so it has no default framebuffer and must render into a frame
+ * buffer object (see FrameBufferObject).
+ */
+class HeadlessContext {
+public:
+
+  HeadlessContext() : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT) {
+    display = surfaceless_display();
+    if (display == EGL_NO_DISPLAY)
+      throw HeadlessContextException("No EGL display available");
+
+    EGLint major, minor;
+    if (!eglInitialize(display, &major, &minor))
+      throw HeadlessContextException("EGL initialization failed: " + error_string());
+
+    if (!has_extension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+      throw HeadlessContextException("EGL display does not support surfaceless contexts");
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+      throw HeadlessContextException("EGL does not support desktop OpenGL: " + error_string());
+
+    // a surfaceless display has no window configs, which eglChooseConfig asks for by default
+    EGLint config_attributes[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_NONE
+    };
+    EGLConfig config;
+    EGLint num_configs = 0;
+    if (!eglChooseConfig(display, config_attributes, &config, 1, &num_configs) || num_configs == 0)
+      throw HeadlessContextException("No EGL config for desktop OpenGL");
+
+    EGLint context_attributes[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 3,
+      EGL_CONTEXT_MINOR_VERSION, 3,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+    if (context == EGL_NO_CONTEXT)
+      throw HeadlessContextException("EGL context creation failed: " + error_string());
+
+    make_current();
+  }
+
+  /**
+   * The context shared by every headless frame buffer in the process, so
+   * that GL objects made while any of them is current (e.g. by entities
+   * created during a tick) are deleted from the context they were made in
+   */
+  static std::shared_ptr<HeadlessContext> shared() {
+    static std::weak_ptr<HeadlessContext> instance;
+    auto context = instance.lock();
+    if (!context) {
+      context = std::make_shared<HeadlessContext>();
+      instance = context;
+    }
+    return context;
+  }
+
+  HeadlessContext(const HeadlessContext &) = delete;
+  HeadlessContext &operator=(const HeadlessContext &) = delete;
+
+  /* makes this the calling thread's current context */
+  void make_current() const {
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+      throw HeadlessContextException("Making EGL context current failed: " + error_string());
+  }
+
+  ~HeadlessContext() {
+    if (context != EGL_NO_CONTEXT) {
+      if (eglGetCurrentContext() == context)
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+      eglDestroyContext(display, context);
+    }
+    // the display is shared by every context in the process, so it isn't terminated
+  }
+
+private:
+  EGLDisplay display;
+  EGLContext context;
+
+  /* Mesa's surfaceless platform if available, or else the default display */
+  static EGLDisplay surfaceless_display() {
+    auto client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (has_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+      auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+      if (get_platform_display != nullptr) {
+        auto display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY) return display;
+      }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+
+  static bool has_extension(const char *extensions, const char *name) {
+    if (extensions == nullptr) return false;
+    auto length = std::strlen(name);
+    for (auto p = extensions; (p = std::strstr(p, name)) != nullptr; p += length)
+      if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+        return true;
+    return false;
+  }
+
+  static std::string error_string() {
+    return "EGL error " + std::to_string(eglGetError());
+  }
+};
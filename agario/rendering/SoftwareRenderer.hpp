@@ -0,0 +1,275 @@
+#pragma once
+
+#include "agario/core/color.hpp"
+#include "agario/core/Entities.hpp"
+#include "agario/core/Player.hpp"
+#include "agario/engine/GameState.hpp"
+#include "agario/rendering/camera.hpp"
+#include "agario/rendering/types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <utility>
+
+namespace agario {
+
+  /**
+   * Renders the same view of the game as Renderer::render_screen (the same
+   * camera, grid and order of drawing) on the CPU, into RGB bytes with the
+   * bottom row first (as read by glReadPixels), and needs no OpenGL at all.
+   * Balls are filled as true circles a row at a time, rather than as polygons,
+   * so pixels on their edges may differ from OpenGL's. Rendering is const, so
+   * any number of threads may render (into different frames) at once.
+   */
+  template<bool renderable>
+  class SoftwareRenderer {
+  public:
+    using Player = agario::Player<renderable>;
+    using GameState = agario::GameState<renderable>;
+
+    SoftwareRenderer(screen_len width, screen_len height,
+                     agario::distance arena_width, agario::distance arena_height) :
+      _width(width), _height(height),
+      arena_width(arena_width), arena_height(arena_height),
+      grid_pattern(pixel(grid_color)) {
+      for (int c = 0; c < agario::color::last; c++)
+        patterns[c] = Pattern(pixel(color_values(static_cast<agario::color>(c))));
+    }
+
+    [[nodiscard]] screen_len width() const { return _width; }
+    [[nodiscard]] screen_len height() const { return _height; }
+
+    /* the number of bytes in a frame */
+    [[nodiscard]] std::size_t frame_size() const {
+      return static_cast<std::size_t>(_width) * _height * 3;
+    }
+
+    /**
+     * renders a single frame of the game from the perspective of the given player
+     * @param pixels frame_size() bytes to render into
+     */
+    void render_screen(const Player &player, const GameState &state, std::uint8_t *pixels) const {
+      View view(player, _width, _height);
+      std::memset(pixels, 255, frame_size()); // white
+
+      draw_grid(view, pixels);
+
+      for (auto &pellet : state.pellets)
+        fill_circle(view, pellet, pixels, patterns[color_of(pellet, location_color(pellet.location()))]);
+
+      if (!state.pellet_field.empty()) {
+        auto radius = static_cast<float>(radius_conversion(PELLET_MASS));
+        Location margin(view.half_width + radius, view.half_height + radius);
+        state.pellet_field.for_each(view.center - margin, view.center + margin, [&](const Location &loc) {
+          fill_circle(view, static_cast<float>(loc.x), static_cast<float>(loc.y), radius,
+                      pixels, patterns[location_color(loc)]);
+        });
+      }
+
+      // foods have no color (nor owner) unless renderable
+      for (auto &food : state.foods)
+        fill_circle(view, food, pixels, patterns[color_of(food, agario::color::blue)]);
+
+      for (auto &pair : state.players)
+        for (auto &cell : pair.second->cells)
+          fill_circle(view, cell, pixels, patterns[color_of(cell, pair.second->color())]);
+
+      for (auto &virus : state.viruses)
+        fill_virus(view, virus, pixels, patterns[color_of(virus, agario::color::green)]);
+    }
+
+  private:
+    const screen_len _width;
+    const screen_len _height;
+
+    agario::distance arena_width;
+    agario::distance arena_height;
+
+    static constexpr float grid_color[3] = { 0.1, 0.1, 0.1 }; // as drawn by Grid
+
+    struct Pixel {
+      std::uint8_t r, g, b;
+    };
+
+    /**
+     * a run of pixels of one color, copied into rows whole so that
+     * spans are filled with a few (vector) stores for every 16 pixels
+     */
+    struct Pattern {
+      static constexpr int num_pixels = 16;
+      std::uint8_t bytes[3 * num_pixels];
+
+      Pattern() = default;
+      explicit Pattern(Pixel p) {
+        for (int i = 0; i < num_pixels; i++) {
+          bytes[3 * i] = p.r;
+          bytes[3 * i + 1] = p.g;
+          bytes[3 * i + 2] = p.b;
+        }
+      }
+    };
+
+    std::array<Pattern, agario::color::last> patterns;
+    Pattern grid_pattern;
+
+    /* where the camera is, and how it maps the arena onto the screen */
+    struct View {
+      View(const Player &player, screen_len width, screen_len height) :
+        center(player.x(), player.y()), x(player.x()), y(player.y()), width(width), height(height) {
+        half_height = view_half_height(camera_z(player.mass()));
+        scale = height / (2 * half_height);
+        half_width = width / (2 * scale);
+      }
+
+      Location center;
+      float x, y;
+      screen_len width, height;
+      float scale; // pixels per unit of distance
+      float half_width, half_height; // of the arena in view
+
+      float screen_x(float world_x) const { return width / 2.0f + (world_x - x) * scale; }
+      float screen_y(float world_y) const { return height / 2.0f + (world_y - y) * scale; }
+
+      bool visible(float world_x, float world_y, float radius) const {
+        return std::abs(world_x - x) - radius <= half_width && std::abs(world_y - y) - radius <= half_height;
+      }
+    };
+
+    static std::uint8_t channel(float value) {
+      return static_cast<std::uint8_t>(std::lround(clamp(value, 0.0f, 1.0f) * 255));
+    }
+
+    static Pixel pixel(const float *rgb) {
+      return { channel(rgb[0]), channel(rgb[1]), channel(rgb[2]) };
+    }
+
+    template<typename B>
+    static agario::color color_of(const B &ball, agario::color otherwise) {
+      if constexpr (renderable) return ball.color;
+      else return otherwise;
+    }
+
+    /* a color for a (non-renderable or procedural) pellet, fixed by where it is */
+    static agario::color location_color(const Location &loc) {
+      auto x = static_cast<std::uint32_t>(static_cast<float>(loc.x) * 64);
+      auto y = static_cast<std::uint32_t>(static_cast<float>(loc.y) * 64);
+      auto hash = (x * 73856093u) ^ (y * 19349663u);
+      return static_cast<agario::color>(hash % agario::color::last);
+    }
+
+    std::uint8_t *row(std::uint8_t *pixels, int y) const {
+      return pixels + static_cast<std::size_t>(y) * _width * 3;
+    }
+
+    /* fills pixels x0 to x1 (inclusive) of a row */
+    static void fill_span(std::uint8_t *row, int x0, int x1, const Pattern &pattern) {
+      auto *p = row + 3 * x0;
+      int n = x1 - x0 + 1;
+      for (; n >= Pattern::num_pixels; n -= Pattern::num_pixels, p += sizeof(pattern.bytes))
+        std::memcpy(p, pattern.bytes, sizeof(pattern.bytes));
+      std::memcpy(p, pattern.bytes, 3 * n);
+    }
+
+    /* the first and last pixel (inclusive) whose centers lie between screen coordinates a and b */
+    static std::pair<int, int> pixels_between(float a, float b, int limit) {
+      int first = std::max(0, static_cast<int>(std::ceil(a - 0.5f)));
+      int last = std::min(limit - 1, static_cast<int>(std::floor(b - 0.5f)));
+      return { first, last };
+    }
+
+    /* one pixel wide lines across the arena, as OpenGL draws GL_LINES */
+    void draw_grid(const View &view, std::uint8_t *pixels) const {
+      auto bottom = view.screen_y(0), top = view.screen_y(static_cast<float>(arena_height));
+      auto left = view.screen_x(0), right = view.screen_x(static_cast<float>(arena_width));
+
+      auto [y0, y1] = pixels_between(bottom, top, _height);
+      auto [x0, x1] = pixels_between(left, right, _width);
+
+      for (int i = 0; i < NUM_GRID_LINES; i++) {
+        float fraction = static_cast<float>(i) / (NUM_GRID_LINES - 1);
+
+        auto column = static_cast<int>(std::floor(left + fraction * (right - left)));
+        if (0 <= column && column < _width)
+          for (int y = y0; y <= y1; y++)
+            std::memcpy(row(pixels, y) + 3 * column, grid_pattern.bytes, 3);
+
+        auto line = static_cast<int>(std::floor(bottom + fraction * (top - bottom)));
+        if (0 <= line && line < _height && x0 <= x1)
+          fill_span(row(pixels, line), x0, x1, grid_pattern);
+      }
+    }
+
+    template<typename B>
+    void fill_circle(const View &view, const B &ball, std::uint8_t *pixels, const Pattern &pattern) const {
+      fill_circle(view, static_cast<float>(ball.x), static_cast<float>(ball.y),
+                  static_cast<float>(ball.radius()), pixels, pattern);
+    }
+
+    /* fills the pixels whose centers lie within the circle, a row (span) at a time */
+    void fill_circle(const View &view, float x, float y, float radius,
+                     std::uint8_t *pixels, const Pattern &pattern) const {
+      if (!view.visible(x, y, radius)) return;
+
+      auto cx = view.screen_x(x), cy = view.screen_y(y);
+      auto r = radius * view.scale;
+      auto r2 = r * r;
+
+      auto [y0, y1] = pixels_between(cy - r, cy + r, _height);
+      for (int py = y0; py <= y1; py++) {
+        auto dy = py + 0.5f - cy;
+        auto half = std::sqrt(std::max(0.0f, r2 - dy * dy));
+        auto [x0, x1] = pixels_between(cx - half, cx + half, _width);
+        if (x0 <= x1) fill_span(row(pixels, py), x0, x1, pattern);
+      }
+    }
+
+    /**
+     * fills a circle with the wavy border of a virus (see virus_vertices),
+     * testing the angle of only those pixels near to the border
+     */
+    template<typename B>
+    void fill_virus(const View &view, const B &virus, std::uint8_t *pixels, const Pattern &pattern) const {
+      constexpr float wave = 1.0f / 15, waves = 15;
+
+      auto x = static_cast<float>(virus.x), y = static_cast<float>(virus.y);
+      auto radius = static_cast<float>(virus.radius());
+      if (!view.visible(x, y, radius * (1 + wave))) return;
+
+      auto cx = view.screen_x(x), cy = view.screen_y(y);
+      auto r = radius * view.scale;
+      auto outer = r * (1 + wave), inner = r * (1 - wave);
+
+      auto [y0, y1] = pixels_between(cy - outer, cy + outer, _height);
+      for (int py = y0; py <= y1; py++) {
+        auto dy = py + 0.5f - cy;
+        auto outer_half = std::sqrt(std::max(0.0f, outer * outer - dy * dy));
+        auto [x0, x1] = pixels_between(cx - outer_half, cx + outer_half, _width);
+
+        // inside the trough of every wave
+        int inner_x0 = x1 + 1, inner_x1 = x1;
+        if (dy * dy < inner * inner) {
+          auto inner_half = std::sqrt(inner * inner - dy * dy);
+          std::tie(inner_x0, inner_x1) = pixels_between(cx - inner_half, cx + inner_half, _width);
+          if (inner_x0 <= inner_x1) fill_span(row(pixels, py), inner_x0, inner_x1, pattern);
+          else inner_x0 = x1 + 1;
+        }
+
+        for (int px = x0; px <= x1; px++) {
+          if (px == inner_x0) {
+            px = inner_x1;
+            continue;
+          }
+          auto dx = px + 0.5f - cx;
+          auto border = r * (1 + wave * std::sin(waves * std::atan2(dy, dx)));
+          if (dx * dx + dy * dy <= border * border)
+            std::memcpy(row(pixels, py) + 3 * px, pattern.bytes, 3);
+        }
+      }
+    }
+  };
+
+}
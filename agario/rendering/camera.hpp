@@ -0,0 +1,30 @@
+#pragma once
+
+#include "agario/core/types.hpp"
+#include "agario/core/utils.hpp"
+
+#include <cmath>
+
+// lines across (and down) the arena drawn by the renderers
+#define NUM_GRID_LINES 11
+
+namespace agario {
+
+  /* the camera's vertical field of view, in degrees */
+  constexpr float field_of_view = 45.0f;
+
+  /**
+   * The distance above the arena from which the game is viewed
+   * when following a player of the given mass (so that bigger
+   * players see more of the arena)
+   */
+  inline float camera_z(agario::mass mass) {
+    return clamp(100 + mass / 10.0, 100.0, 900.0);
+  }
+
+  /* half the height of the arena seen from the given distance above it */
+  inline float view_half_height(float camera_z) {
+    return camera_z * std::tan(field_of_view * static_cast<float>(M_PI) / 360);
+  }
+
+}
@@ -8,6 +8,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <exception>
+#include <stdexcept>
 #include <vector>
 #include <string>
 #include <math.h>
@@ -18,10 +19,13 @@
 #include <core/Player.hpp>
 
 #include "agario/rendering/Canvas.hpp"
+#include "agario/rendering/camera.hpp"
 #include "agario/rendering/shader.hpp"
 #include "agario/core/renderables.hpp"
 
-#define NUM_GRID_LINES 11
+class RenderingException : public std::runtime_error {
+  using runtime_error::runtime_error;
+};
 
 const char* vertex_shader_src =
 #include "shaders/_vertex.glsl"
@@ -31,6 +35,14 @@ const char* fragment_shader_src =
 #include "shaders/_fragment.glsl"
   ;
 
+const char* instanced_vertex_shader_src =
+#include "shaders/_instanced_vertex.glsl"
+  ;
+
+const char* instanced_fragment_shader_src =
+#include "shaders/_instanced_fragment.glsl"
+  ;
+
 namespace agario {
 
   class Renderer {
@@ -42,8 +54,10 @@ namespace agario {
                       agario::distance arena_height) :
       _canvas(std::move(canvas)),
       arena_width(arena_width), arena_height(arena_height),
-      shader(), grid(arena_width, arena_height) {
+      shader(), ball_shader(), grid(arena_width, arena_height), viruses(true),
+      pellet_stamp(Location(0, 0)) {
       shader.compile_shaders(vertex_shader_src, fragment_shader_src);
+      ball_shader.compile_shaders(instanced_vertex_shader_src, instanced_fragment_shader_src);
       shader.use();
     }
 
@@ -76,8 +90,16 @@ namespace agario {
     }
 
     void make_projections(const Player &player) {
-      shader.setMat4("projection_transform", perspective_projection(player));
-      shader.setMat4("view_transform", view_projection(player));
+      auto perspective = perspective_projection(player);
+      auto view = view_projection(player);
+
+      shader.use();
+      shader.setMat4("projection_transform", perspective);
+      shader.setMat4("view_transform", view);
+
+      ball_shader.use();
+      ball_shader.setMat4("projection_transform", perspective);
+      ball_shader.setMat4("view_transform", view);
     }
 
     /**
@@ -87,7 +109,7 @@ namespace agario {
      * @return  z-coordinate for the camera positiooning
      */
     GLfloat camera_z(const Player &player) {
-      return clamp(100 + player.mass() / 10.0, 100.0, 900.0);
+      return agario::camera_z(player.mass());
     }
 
     /**
@@ -97,7 +119,7 @@ namespace agario {
      * @return 4x4 projection matrix
      */
     glm::mat4 perspective_projection(const Player &player) {
-      auto angle = glm::radians(45.0f);
+      auto angle = glm::radians(field_of_view);
       auto znear = 0.1f;
       auto zfar = 1 + camera_z(player);
       return glm::perspective(angle, _canvas->aspect_ratio(), znear, zfar);
@@ -124,26 +146,30 @@ namespace agario {
      * @param state current state of the game
      */
     void render_screen(Player &player, agario::GameState<true> &state) {
-      shader.use();
-
-      make_projections(player);
-
-      glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
-      glClear(GL_COLOR_BUFFER_BIT);
-
-      grid.draw(shader);
-
-      for (auto &pellet : state.pellets)
-        pellet.draw(shader);
-
-      for (auto &food : state.foods)
-        food.draw(shader);
-
-      for (auto &pair : state.players)
-        pair.second->draw(shader);
+      upload_balls({ &player }, state);
+      clear();
+      draw_view(player);
+    }
 
-      for (auto &virus : state.viruses)
-        virus.draw(shader);
+    /**
+     * renders the game from the perspective of each of the given players, into
+     * consecutive tiles of the canvas (see Canvas::use_tile), so that they may
+     * all be read back together. The balls are uploaded to the GPU only once
+     * and then drawn from each player's view.
+     * @param players the players to render the game for, one per tile
+     * @param state current state of the game
+     */
+    void render_screens(const std::vector<Player *> &players, agario::GameState<true> &state) {
+      if (players.size() > static_cast<std::size_t>(_canvas->num_tiles()))
+        throw RenderingException("Can't render " + std::to_string(players.size()) + " screens onto "
+                                 + std::to_string(_canvas->num_tiles()) + " tiles");
+
+      upload_balls(players, state);
+      clear();
+      for (std::size_t i = 0; i < players.size(); i++) {
+        _canvas->use_tile(static_cast<int>(i));
+        draw_view(*players[i]);
+      }
     }
 
     /**
@@ -164,8 +190,86 @@ namespace agario {
     agario::distance arena_width;
     agario::distance arena_height;
 
-    Shader shader;
+    Shader shader;      // for the grid
+    Shader ball_shader; // for the instanced balls
     agario::Grid<NUM_GRID_LINES> grid;
+
+    agario::BallBatch<PELLET_SIDES> pellets;
+    agario::BallBatch<FOOD_SIDES> foods;
+    agario::BallBatch<CELL_SIDES> cells;
+    agario::BallBatch<VIRUS_SIDES> viruses;
+
+    // the size and color of each procedurally generated pellet
+    agario::Pellet<true> pellet_stamp;
+
+    /* clears the whole canvas (every tile of it) to white */
+    void clear() {
+      glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
+      glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    /* collects every ball in view of any of the players into the batches, and uploads them */
+    void upload_balls(const std::vector<Player *> &players, agario::GameState<true> &state) {
+      pellets.clear();
+      for (auto &pellet : state.pellets)
+        pellets.add(pellet);
+      add_procedural_pellets(players, state);
+
+      foods.clear();
+      for (auto &food : state.foods)
+        foods.add(food);
+
+      cells.clear();
+      for (auto &pair : state.players)
+        for (auto &cell : pair.second->cells)
+          cells.add(cell);
+
+      viruses.clear();
+      for (auto &virus : state.viruses)
+        viruses.add(virus);
+
+      pellets.upload();
+      foods.upload();
+      cells.upload();
+      viruses.upload();
+    }
+
+    /* draws the grid and the uploaded balls (in the same order as they overlap) from the player's view */
+    void draw_view(const Player &player) {
+      make_projections(player);
+
+      shader.use();
+      grid.draw(shader);
+
+      // one instanced draw for each kind of ball
+      ball_shader.use();
+      pellets.draw_uploaded();
+      foods.draw_uploaded();
+      cells.draw_uploaded();
+      viruses.draw_uploaded();
+    }
+
+    /* adds the procedurally generated pellets within any of the players' views (each only once) */
+    void add_procedural_pellets(const std::vector<Player *> &players, const agario::GameState<true> &state) {
+      if (state.pellet_field.empty()) return;
+
+      std::vector<std::pair<Location, Location>> views; // added so far, as bottom left and top right corners
+      auto radius = pellet_stamp.radius();
+      for (auto *player : players) {
+        // half the height of the view at z = 0
+        auto half_height = view_half_height(camera_z(*player));
+        auto extent = half_height * std::max(1.0f, _canvas->aspect_ratio());
+
+        Location margin(extent, extent);
+        auto center = player->location();
+        state.pellet_field.for_each(center - margin, center + margin, [&](const Location &loc) {
+          for (auto &[low, high] : views)
+            if (low.x <= loc.x && loc.x <= high.x && low.y <= loc.y && loc.y <= high.y) return;
+          pellets.add(loc.x, loc.y, radius, pellet_stamp.color);
+        });
+        views.emplace_back(center - margin, center + margin);
+      }
+    }
   };
 
 }
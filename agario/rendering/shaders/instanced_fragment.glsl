@@ -0,0 +1,8 @@
+#version 330 core
+
+in vec3 ball_color;
+out vec4 colorF;
+
+void main() {
+    colorF = vec4(ball_color, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 instance_position; // x, y and radius of the ball
+layout (location = 2) in vec3 instance_color;
+
+uniform mat4 projection_transform;
+uniform mat4 view_transform;
+
+out vec3 ball_color;
+
+void main() {
+    vec2 world = instance_position.xy + instance_position.z * position.xy;
+    gl_Position = projection_transform * view_transform * vec4(world, position.z, 1.0f);
+    ball_color = instance_color;
+}
\ No newline at end of file
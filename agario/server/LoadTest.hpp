@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "agario/server/Server.hpp"
+#include "utils/spsc-queue.h"
+
+/**
+ * Load testing of the server over loopback. A server runs in-process while
+ * simulated clients, spread over a few threads, join and play. Clients are
+ * added in rounds, and for each round the latency from the start of each
+ * tick to its snapshot arriving at the client is measured, until the tail
+ * latency exceeds a budget (or the number of connections reaches a limit).
+ */
+namespace agario::server::load_test {
+
+  using clock = std::chrono::steady_clock;
+
+  struct Config {
+    int tick_rate = default_tick_rate;
+    int num_bots = 10;
+    int arena_size = DEFAULT_ARENA_WIDTH;
+    int num_pellets = DEFAULT_NUM_PELLETS;
+    int num_viruses = DEFAULT_NUM_VIRUSES;
+
+    int initial_clients = 50;
+    int clients_per_round = 50;
+    int max_clients = 2000;
+    double round_seconds = 2;
+    double latency_budget_ms = 0; // defaults to one tick
+    int client_threads = 4;
+  };
+
+  struct Round {
+    int clients;
+    std::uint64_t snapshots;     // received by all clients in the round
+    double delivery;             // fraction of the snapshots expected that were received
+    double p50_ms, p99_ms, p999_ms, max_ms;
+    double bytes_per_snapshot;
+    double tick_ms;              // mean time to step the server
+  };
+
+  inline double percentile(std::vector<double> &samples, double p) {
+    if (samples.empty()) return 0;
+    auto index = static_cast<std::size_t>(p * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+  }
+
+  /* raises the limit on open files as far as allowed, returning the new limit */
+  inline rlim_t raise_file_limit() {
+    rlimit limit {};
+    ::getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    ::setrlimit(RLIMIT_NOFILE, &limit);
+    ::getrlimit(RLIMIT_NOFILE, &limit);
+    return limit.rlim_cur;
+  }
+
+  /* when each tick started, looked up by the clients to measure latency */
+  class TickClock {
+  public:
+    void record(std::uint32_t tick, clock::time_point time) {
+      starts[tick % starts.size()].store(time.time_since_epoch().count(), std::memory_order_release);
+    }
+
+    clock::time_point started(std::uint32_t tick) const {
+      return clock::time_point(clock::duration(starts[tick % starts.size()].load(std::memory_order_acquire)));
+    }
+
+  private:
+    std::array<std::atomic<clock::rep>, 1024> starts {};
+  };
+
+  /**
+   * Plays as many clients on one thread: acknowledges each snapshot with
+   * random input, and records how long after the start of its tick it arrived
+   */
+  class ClientThread {
+  public:
+    explicit ClientThread(const TickClock &ticks) :
+      ticks(ticks), added(4096), running(true), _snapshots(0), _bytes(0), rng(std::random_device()()) {
+      epoll = ::epoll_create1(EPOLL_CLOEXEC);
+      thread = std::thread([this]() { loop(); });
+    }
+
+    /* hands a connected socket (which has already joined) over to this thread */
+    void add(int fd) {
+      while (!added.push(std::move(fd))) std::this_thread::yield();
+    }
+
+    /* the latencies (in milliseconds) recorded since last taken */
+    std::vector<double> take_latencies() {
+      std::lock_guard<std::mutex> lg(m);
+      std::vector<double> taken;
+      taken.swap(latencies);
+      return taken;
+    }
+
+    std::uint64_t snapshots() const { return _snapshots; }
+    std::uint64_t bytes() const { return _bytes; }
+
+    ~ClientThread() {
+      running = false;
+      thread.join();
+      for (auto &pair : clients) ::close(pair.first);
+      ::close(epoll);
+    }
+
+  private:
+    const TickClock &ticks;
+    SPSCQueue<int> added;
+    std::atomic<bool> running;
+    std::atomic<std::uint64_t> _snapshots;
+    std::atomic<std::uint64_t> _bytes;
+    std::thread thread;
+    int epoll;
+    std::mt19937 rng;
+
+    std::unordered_map<int, MessageBuffer> clients;
+    std::mutex m;
+    std::vector<double> latencies;
+
+    void loop() {
+      epoll_event events[256];
+      std::vector<double> batch;
+      while (running) {
+        int fd;
+        while (added.pop(fd)) {
+          clients.emplace(fd, MessageBuffer());
+          epoll_event event {};
+          event.events = EPOLLIN | EPOLLET;
+          event.data.fd = fd;
+          ::epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+          read(fd, batch); // anything which arrived before it was watched
+        }
+
+        int n = ::epoll_wait(epoll, events, 256, 10);
+        for (int i = 0; i < n; i++)
+          read(events[i].data.fd, batch);
+
+        if (!batch.empty()) {
+          std::lock_guard<std::mutex> lg(m);
+          latencies.insert(latencies.end(), batch.begin(), batch.end());
+          batch.clear();
+        }
+      }
+    }
+
+    void read(int fd, std::vector<double> &batch) {
+      auto &buffer = clients.at(fd);
+      char data[1 << 16];
+      ssize_t n;
+      while ((n = ::recv(fd, data, sizeof(data), 0)) > 0) {
+        buffer.append(data, n);
+        _bytes += n;
+      }
+
+      Message message;
+      std::uint32_t latest = no_base;
+      while (buffer.next(message)) {
+        if (message.type != message_type::snapshot) continue;
+        auto tick = static_cast<std::uint32_t>(BitReader(message.payload).read_varint());
+
+        auto latency = clock::now() - ticks.started(tick);
+        batch.push_back(std::chrono::duration<double, std::milli>(latency).count());
+        _snapshots++;
+        latest = tick;
+      }
+
+      if (latest != no_base) {
+        std::uniform_int_distribution<std::uint16_t> target;
+        auto input = encode(Input { latest, latest, target(rng), target(rng), agario::action::none });
+        ::send(fd, input.data(), input.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+      }
+    }
+  };
+
+  /**
+   * Runs the load test, writing a line for each round to `os`
+   * @return the results of each round
+   */
+  inline std::vector<Round> run(const Config &config, std::ostream &os) {
+    auto file_limit = raise_file_limit();
+    auto budget = config.latency_budget_ms > 0 ? config.latency_budget_ms : 1000.0 / config.tick_rate;
+
+    Server<false> server(0, config.arena_size, config.arena_size, config.num_pellets,
+                         config.num_viruses, config.num_bots, config.tick_rate);
+    TickClock ticks;
+    std::atomic<bool> running(true);
+    std::atomic<std::uint64_t> steps(0), step_ns(0);
+
+    // the simulation thread, timing each step
+    server.start_network();
+    std::thread simulation([&]() {
+      auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / config.tick_rate));
+      auto next = clock::now();
+      while (running) {
+        auto start = clock::now();
+        ticks.record(static_cast<std::uint32_t>(server.engine().ticks() + 1), start);
+        server.step();
+        step_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+        steps++;
+
+        next += period;
+        if (next < clock::now()) next = clock::now();
+        std::this_thread::sleep_until(next);
+      }
+    });
+
+    std::vector<std::unique_ptr<ClientThread>> threads;
+    for (int i = 0; i < std::max(1, config.client_threads); i++)
+      threads.emplace_back(std::make_unique<ClientThread>(ticks));
+
+    os << std::setw(8) << "clients" << std::setw(12) << "delivered" << std::setw(10) << "p50 ms"
+       << std::setw(10) << "p99 ms" << std::setw(10) << "p99.9 ms" << std::setw(10) << "max ms"
+       << std::setw(12) << "bytes/snap" << std::setw(10) << "tick ms" << std::endl;
+
+    std::vector<Round> rounds;
+    int clients = 0;
+    int target = config.initial_clients;
+    while (target <= config.max_clients) {
+      bool connected = true;
+      for (; clients < target; clients++) {
+        // each client needs a socket on both ends (the server's and its own)
+        if (2 * static_cast<rlim_t>(clients) + 64 > file_limit) {
+          os << "open file limit (" << file_limit << ") reached" << std::endl;
+          connected = false;
+          break;
+        }
+        try {
+          int fd = connect_socket("127.0.0.1", server.port());
+          auto join = encode_join("client " + std::to_string(clients));
+          ::send(fd, join.data(), join.size(), MSG_NOSIGNAL);
+          set_nonblocking(fd);
+          threads[clients % threads.size()]->add(fd);
+        } catch (NetworkException &e) {
+          os << e.what() << std::endl;
+          connected = false;
+          break;
+        }
+      }
+      if (!connected) break;
+
+      // let the new clients join before measuring
+      std::this_thread::sleep_for(std::chrono::duration<double>(config.round_seconds / 4));
+      std::uint64_t snapshots_before = 0, bytes_before = 0;
+      for (auto &thread : threads) {
+        thread->take_latencies();
+        snapshots_before += thread->snapshots();
+        bytes_before += thread->bytes();
+      }
+      auto steps_before = steps.load();
+      auto step_ns_before = step_ns.load();
+
+      std::this_thread::sleep_for(std::chrono::duration<double>(config.round_seconds));
+
+      std::vector<double> latencies;
+      std::uint64_t snapshots = 0, bytes = 0;
+      for (auto &thread : threads) {
+        auto l = thread->take_latencies();
+        latencies.insert(latencies.end(), l.begin(), l.end());
+        snapshots += thread->snapshots();
+        bytes += thread->bytes();
+      }
+      snapshots -= snapshots_before;
+      bytes -= bytes_before;
+      auto round_steps = steps - steps_before;
+
+      Round round {};
+      round.clients = clients;
+      round.snapshots = snapshots;
+      round.delivery = round_steps == 0 ? 0 : static_cast<double>(snapshots) / (round_steps * clients);
+      round.p50_ms = percentile(latencies, 0.5);
+      round.p99_ms = percentile(latencies, 0.99);
+      round.p999_ms = percentile(latencies, 0.999);
+      round.max_ms = latencies.empty() ? 0 : *std::max_element(latencies.begin(), latencies.end());
+      round.bytes_per_snapshot = snapshots == 0 ? 0 : static_cast<double>(bytes) / snapshots;
+      round.tick_ms = round_steps == 0 ? 0 : (step_ns - step_ns_before) / 1e6 / round_steps;
+      rounds.push_back(round);
+
+      os << std::fixed << std::setprecision(2)
+         << std::setw(8) << round.clients << std::setw(11) << 100 * round.delivery << "%"
+         << std::setw(10) << round.p50_ms << std::setw(10) << round.p99_ms << std::setw(10) << round.p999_ms
+         << std::setw(10) << round.max_ms << std::setw(12) << round.bytes_per_snapshot
+         << std::setw(10) << round.tick_ms << std::endl;
+
+      if (round.p99_ms > budget || round.delivery < 0.95) {
+        os << "p99 latency budget (" << budget << " ms) or delivery exceeded" << std::endl;
+        break;
+      }
+      target += config.clients_per_round;
+    }
+
+    running = false;
+    simulation.join();
+    server.stop_network();
+    threads.clear();
+
+    int sustained = 0;
+    for (auto &round : rounds)
+      if (round.p99_ms <= budget && round.delivery >= 0.95)
+        sustained = std::max(sustained, round.clients);
+    os << "max connections within budget: " << sustained << std::endl;
+    return rounds;
+  }
+
+}
@@ -0,0 +1,365 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "agario/server/buffers.hpp"
+#include "agario/server/protocol.hpp"
+#include "utils/spsc-queue.h"
+#include "utils/trace.h"
+
+namespace agario::server {
+
+  /* clients which fall this far behind in receiving are disconnected */
+  constexpr std::size_t max_pending_bytes = 1u << 22u;
+
+  /* clients only send small messages, so anything longer is treated as garbage */
+  constexpr std::uint32_t max_client_message = 1024;
+
+  constexpr std::size_t queue_capacity = 1u << 14u;
+
+  /* a message from a client, decoded by the network thread for the simulation */
+  struct Command {
+    enum kind_t : std::uint8_t { joined, acted, disconnected };
+
+    kind_t kind;
+    std::uint32_t connection;
+    std::string name; // of a joining player
+    Input input;
+  };
+
+  /* bytes for the network thread to send to a client (or a request to drop it) */
+  struct Packet {
+    std::uint32_t connection;
+    std::string bytes;
+    bool close;
+  };
+
+  /**
+   * Event-driven network I/O for the server, using edge-triggered epoll
+   * (so Linux only). A single network thread accepts connections, reads
+   * and decodes the clients' messages and writes out what the simulation
+   * sends them, so that the simulation thread never blocks on a socket.
+   *
+   * The two threads only communicate through a pair of lock-free SPSC
+   * queues: decoded Commands flow from the network to the simulation, and
+   * Packets flow back. Connections take their receive and send buffers from
+   * a pool of slabs as they need them, and each connection's queued packets
+   * are sent with a single writev.
+   *
+   * Without `start`, the simulation thread can instead drive the I/O itself
+   * by calling `poll`, which is how the server is stepped deterministically.
+   */
+  class Reactor {
+  public:
+    /* listens on `port` (0 for any free port, see `port()`) */
+    explicit Reactor(int port) :
+      incoming(queue_capacity), outgoing(queue_capacity),
+      _listener(listen_socket(port, SOMAXCONN)), _running(false), _bytes_sent(0), next_id(first_connection) {
+
+      _epoll = ::epoll_create1(EPOLL_CLOEXEC);
+      _wakeup = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if (_epoll < 0 || _wakeup < 0)
+        throw NetworkException(std::string("epoll: ") + std::strerror(errno));
+      watch(_listener, listener_id, EPOLLIN | EPOLLET);
+      watch(_wakeup, wakeup_id, EPOLLIN | EPOLLET);
+    }
+
+    [[nodiscard]] int port() const { return bound_port(_listener); }
+
+    /* ================ network thread ================ */
+
+    /* starts a network thread which polls until `stop` */
+    void start() {
+      if (_running) return;
+      _running = true;
+      network_thread = std::thread([this]() {
+        TRACE_THREAD_NAME("network");
+        while (_running) poll(100);
+      });
+    }
+
+    void stop() {
+      if (!_running) return;
+      _running = false;
+      wake();
+      network_thread.join();
+    }
+
+    [[nodiscard]] bool running() const { return _running; }
+
+    /**
+     * Handles the I/O that is ready, waiting up to `timeout_ms` for some to be:
+     * accepts connections, decodes received messages into commands, and sends
+     * the packets queued by the simulation
+     */
+    void poll(int timeout_ms) {
+      TRACE_SCOPE("network poll");
+      deliver_commands();
+
+      epoll_event events[256];
+      int n = ::epoll_wait(_epoll, events, 256, timeout_ms);
+      for (int i = 0; i < n; i++) {
+        auto id = events[i].data.u64;
+        if (id == listener_id) {
+          accept_connections();
+        } else if (id == wakeup_id) {
+          std::uint64_t count;
+          while (::read(_wakeup, &count, sizeof(count)) > 0);
+        } else {
+          auto it = connections.find(static_cast<std::uint32_t>(id));
+          if (it == connections.end()) continue;
+          if (events[i].events & EPOLLOUT) dirty.insert(it->first);
+          if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            receive(it->first, it->second);
+        }
+      }
+
+      take_packets();
+      for (auto id : dirty)
+        write_pending(connections.at(id));
+      dirty.clear();
+      close_connections();
+      deliver_commands();
+    }
+
+    /* the number of open connections (network thread only) */
+    [[nodiscard]] std::size_t num_connections() const { return connections.size(); }
+
+    [[nodiscard]] std::uint64_t bytes_sent() const { return _bytes_sent; }
+
+    const SlabPool &pool() const { return _pool; }
+
+    /* ================ simulation thread ================ */
+
+    /* removes the next command from a client into `command` */
+    bool next_command(Command &command) { return incoming.pop(command); }
+
+    /* queues `bytes` to be sent to `connection` */
+    void send(std::uint32_t connection, std::string bytes) {
+      enqueue(Packet { connection, std::move(bytes), false });
+    }
+
+    /* disconnects `connection` */
+    void close(std::uint32_t connection) {
+      enqueue(Packet { connection, std::string(), true });
+    }
+
+    /* hands the queued packets over to the network thread, waking it to send them */
+    void flush() {
+      while (!packet_backlog.empty() && outgoing.push(std::move(packet_backlog.front())))
+        packet_backlog.pop_front();
+      if (_running) wake();
+    }
+
+    ~Reactor() {
+      stop();
+      for (auto &pair : connections)
+        ::close(pair.second.fd);
+      ::close(_listener);
+      ::close(_wakeup);
+      ::close(_epoll);
+    }
+
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+  private:
+    static constexpr std::uint64_t listener_id = 0;
+    static constexpr std::uint64_t wakeup_id = 1;
+    static constexpr std::uint32_t first_connection = 2;
+
+    struct Connection {
+      Connection(int fd, SlabPool &pool) : fd(fd), received(nullptr), pending(pool), closed(false) {}
+
+      int fd;
+      Slab *received;    // partial message (taken from the pool only while there is one)
+      SlabChain pending; // bytes waiting to be sent
+      bool closed;
+    };
+
+    SPSCQueue<Command> incoming;
+    SPSCQueue<Packet> outgoing;
+    std::deque<Command> command_backlog; // network thread's, for when `incoming` is full
+    std::deque<Packet> packet_backlog;   // simulation thread's, for when `outgoing` is full
+
+    int _listener;
+    int _epoll;
+    int _wakeup;
+    std::atomic<bool> _running;
+    std::atomic<std::uint64_t> _bytes_sent;
+    std::thread network_thread;
+
+    SlabPool _pool;
+    std::unordered_map<std::uint32_t, Connection> connections;
+    std::unordered_set<std::uint32_t> dirty; // connections with bytes to send
+    std::uint32_t next_id;
+
+    void watch(int fd, std::uint64_t id, std::uint32_t events) {
+      epoll_event event {};
+      event.events = events;
+      event.data.u64 = id;
+      if (::epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+        throw NetworkException(std::string("epoll_ctl: ") + std::strerror(errno));
+    }
+
+    void wake() {
+      std::uint64_t one = 1;
+      auto written = ::write(_wakeup, &one, sizeof(one));
+      static_cast<void>(written);
+    }
+
+    void enqueue(Packet &&packet) {
+      if (!packet_backlog.empty() || !outgoing.push(std::move(packet)))
+        packet_backlog.emplace_back(std::move(packet));
+    }
+
+    void command(Command &&command) {
+      if (!command_backlog.empty() || !incoming.push(std::move(command)))
+        command_backlog.emplace_back(std::move(command));
+    }
+
+    void deliver_commands() {
+      while (!command_backlog.empty() && incoming.push(std::move(command_backlog.front())))
+        command_backlog.pop_front();
+    }
+
+    void accept_connections() {
+      int fd;
+      while ((fd = ::accept4(_listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        set_nodelay(fd);
+        auto id = next_id++;
+        if (next_id < first_connection) next_id = first_connection;
+        auto &connection = connections.emplace(id, Connection(fd, _pool)).first->second;
+        watch(fd, id, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET);
+        receive(id, connection); // anything the client already sent
+      }
+    }
+
+    /* reads until the socket would block, decoding each complete message */
+    void receive(std::uint32_t id, Connection &connection) {
+      while (!connection.closed) {
+        if (connection.received == nullptr)
+          connection.received = _pool.acquire();
+        auto &slab = *connection.received;
+
+        auto n = ::recv(connection.fd, slab.data + slab.end, slab.space(), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) {
+          connection.closed = true; // closed by the client, or failed
+          break;
+        }
+        slab.end += n;
+        decode(id, connection);
+      }
+
+      // idle connections don't hold on to a buffer
+      if (connection.received != nullptr && connection.received->size() == 0) {
+        _pool.release(connection.received);
+        connection.received = nullptr;
+      }
+    }
+
+    void decode(std::uint32_t id, Connection &connection) {
+      auto &slab = *connection.received;
+      try {
+        std::uint32_t length;
+        while (slab.size() >= sizeof(length)) {
+          std::memcpy(&length, slab.data + slab.begin, sizeof(length));
+          if (length == 0 || length > max_client_message)
+            throw binary::FormatException("Invalid message length");
+          if (slab.size() < sizeof(length) + length) break;
+
+          auto type = static_cast<message_type>(slab.data[slab.begin + sizeof(length)]);
+          std::string payload(slab.data + slab.begin + sizeof(length) + 1, length - 1);
+          slab.begin += sizeof(length) + length;
+
+          if (type == message_type::join) {
+            command(Command { Command::joined, id, decode_join(payload), Input() });
+          } else if (type == message_type::input) {
+            command(Command { Command::acted, id, std::string(), decode_input(payload) });
+          } else {
+            throw binary::FormatException("Unexpected message from client");
+          }
+        }
+      } catch (binary::FormatException &) {
+        connection.closed = true; // the client isn't speaking the protocol
+        return;
+      }
+
+      // move the partial message (if any) to the front to make room for the rest
+      if (slab.begin > 0) {
+        std::memmove(slab.data, slab.data + slab.begin, slab.size());
+        slab.end -= slab.begin;
+        slab.begin = 0;
+      }
+    }
+
+    /* appends the packets from the simulation to their connections' buffers */
+    void take_packets() {
+      Packet packet;
+      while (outgoing.pop(packet)) {
+        auto it = connections.find(packet.connection);
+        if (it == connections.end()) continue; // already disconnected
+        auto &connection = it->second;
+        if (packet.close) {
+          connection.closed = true;
+          continue;
+        }
+        connection.pending.append(packet.bytes.data(), packet.bytes.size());
+        dirty.insert(packet.connection);
+      }
+    }
+
+    /* writes as much of the connection's pending bytes as the socket will take */
+    void write_pending(Connection &connection) {
+      iovec iov[64];
+      while (!connection.closed && !connection.pending.empty()) {
+        int count = connection.pending.gather(iov, 64);
+        auto n = ::writev(connection.fd, iov, count);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break; // until EPOLLOUT
+        if (n < 0) {
+          connection.closed = true;
+          break;
+        }
+        connection.pending.consume(n);
+        _bytes_sent += n;
+      }
+      if (connection.pending.size() > max_pending_bytes)
+        connection.closed = true; // the client isn't keeping up
+    }
+
+    void close_connections() {
+      for (auto it = connections.begin(); it != connections.end();) {
+        auto &connection = it->second;
+        if (!connection.closed) {
+          ++it;
+          continue;
+        }
+        ::epoll_ctl(_epoll, EPOLL_CTL_DEL, connection.fd, nullptr);
+        ::close(connection.fd);
+        if (connection.received != nullptr)
+          _pool.release(connection.received);
+        command(Command { Command::disconnected, it->first, std::string(), Input() });
+        it = connections.erase(it);
+      }
+    }
+  };
+
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "agario/engine/Engine.hpp"
+#include "agario/bots/bots.hpp"
+#include "agario/server/protocol.hpp"
+#include "agario/server/Reactor.hpp"
+#include "agario/server/snapshot.hpp"
+
+namespace agario::server {
+
+  constexpr int default_port = 8080;
+  constexpr int default_tick_rate = 30;
+
+  /**
+   * Hosts a game over TCP. The engine is ticked at a fixed rate, and after
+   * each tick every client is sent the entities in its player's view as a
+   * delta against the last snapshot it acknowledged (see snapshot.hpp).
+   * Clients join with a name, and then send their target and action along
+   * with the latest tick they've received.
+   *
+   * Network I/O is done by a Reactor: on its own thread while the server
+   * is `run`, or inline with each `step` otherwise.
+   */
+  template<bool renderable = false>
+  class Server {
+    using Engine = agario::Engine<renderable>;
+    using Player = agario::Player<renderable>;
+
+  public:
+    /**
+     * @param port the port to listen on (0 for any free port, see `port()`)
+     * @param num_bots the number of bots to add to the game
+     */
+    Server(int port, agario::distance arena_width, agario::distance arena_height,
+           int num_pellets, int num_viruses, int num_bots, int tick_rate = default_tick_rate) :
+      _engine(arena_width, arena_height, num_pellets, num_viruses, true),
+      _tick_rate(tick_rate), reactor(port), _running(false), _num_clients(0) {
+      if (tick_rate <= 0)
+        throw NetworkException("Tick rate must be positive");
+      _engine.reset();
+      add_bots(num_bots);
+    }
+
+    /* the port the server is listening on */
+    [[nodiscard]] int port() const { return reactor.port(); }
+
+    [[nodiscard]] int tick_rate() const { return _tick_rate; }
+
+    /* the number of clients which have joined the game */
+    [[nodiscard]] int num_clients() const { return _num_clients; }
+
+    [[nodiscard]] std::uint64_t bytes_sent() const { return reactor.bytes_sent(); }
+
+    Engine &engine() { return _engine; }
+
+    /**
+     * Performs one tick of the server: handles the messages received from
+     * clients, ticks the game and then sends each client a snapshot of its view
+     */
+    void step() {
+      bool inline_io = !reactor.running();
+      if (inline_io) reactor.poll(0);
+
+      Command command;
+      while (reactor.next_command(command))
+        handle(command);
+
+      for (auto &pair : clients)
+        if (_engine.player(pair.second.pid).dead())
+          _engine.respawn(pair.second.pid);
+
+      _engine.tick(std::chrono::duration<double>(1.0 / _tick_rate));
+      for (auto &pair : clients)
+        _engine.player(pair.second.pid).action = agario::action::none;
+
+      for (auto &pair : clients)
+        send_snapshot(pair.first, pair.second);
+      reactor.flush();
+
+      if (inline_io) reactor.poll(0);
+    }
+
+    /* starts the network thread, after which `step` no longer does I/O itself */
+    void start_network() { reactor.start(); }
+
+    void stop_network() { reactor.stop(); }
+
+    /* steps at the tick rate until `stop` is called (from another thread) */
+    void run() {
+      using clock = std::chrono::steady_clock;
+      auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / _tick_rate));
+
+      start_network();
+      _running = true;
+      auto next = clock::now();
+      while (_running) {
+        step();
+        next += period;
+        auto now = clock::now();
+        if (next < now) next = now; // don't try to catch up after falling behind
+        std::this_thread::sleep_until(next);
+      }
+      stop_network();
+    }
+
+    void stop() { _running = false; }
+
+    Server(const Server &) = delete;
+    Server &operator=(const Server &) = delete;
+
+  private:
+    struct Client {
+      agario::pid pid;
+      std::uint32_t ack = no_base; // the latest tick the client has received
+      std::uint32_t last_input = 0; // sequence number of the latest input applied
+      std::deque<std::pair<std::uint32_t, Snapshot>> history;
+    };
+
+    Engine _engine;
+    const int _tick_rate;
+    Reactor reactor;
+    std::atomic<bool> _running;
+    std::atomic<int> _num_clients; // may be read from other threads while running
+    std::map<std::uint32_t, Client> clients; // by connection
+
+    void add_bots(int num_bots) {
+      using namespace agario::bot;
+      for (int i = 0; i < num_bots; i++) {
+        switch (i % 4) {
+          case 0: _engine.template add_player<HungryBot<renderable>>(); break;
+          case 1: _engine.template add_player<HungryShyBot<renderable>>(); break;
+          case 2: _engine.template add_player<AggressiveBot<renderable>>(); break;
+          default: _engine.template add_player<AggressiveShyBot<renderable>>(); break;
+        }
+      }
+    }
+
+    void handle(const Command &command) {
+      auto it = clients.find(command.connection);
+      switch (command.kind) {
+        case Command::joined: {
+          if (it != clients.end()) break;
+          auto &client = clients[command.connection];
+          client.pid = _engine.template add_player<Player>(command.name);
+          _num_clients++;
+
+          Welcome welcome { client.pid, static_cast<float>(_engine.arena_width()),
+                            static_cast<float>(_engine.arena_height()),
+                            static_cast<std::uint32_t>(_tick_rate) };
+          reactor.send(command.connection, encode(welcome));
+
+          // the newcomer is told about everyone, and everyone else about the newcomer
+          std::vector<PlayerInfo> everyone;
+          for (auto &pair : _engine.players())
+            everyone.push_back(info(*pair.second));
+          reactor.send(command.connection, encode(everyone));
+          broadcast(encode(std::vector<PlayerInfo> { info(_engine.get_player(client.pid)) }), command.connection);
+          break;
+        }
+        case Command::acted: {
+          if (it == clients.end()) break;
+          it->second.ack = command.input.ack;
+          it->second.last_input = command.input.sequence;
+
+          auto &player = _engine.player(it->second.pid);
+          auto width = static_cast<float>(_engine.arena_width());
+          auto height = static_cast<float>(_engine.arena_height());
+          player.target = Location(dequantize(command.input.target_x, width),
+                                   dequantize(command.input.target_y, height));
+          if (command.input.action != agario::action::none)
+            player.action = command.input.action; // kept until the tick performs it, whatever input follows
+          break;
+        }
+        case Command::disconnected:
+          if (it == clients.end()) break;
+          _engine.remove_player(it->second.pid);
+          broadcast(encode_player_left(it->second.pid), it->first);
+          clients.erase(it);
+          _num_clients--;
+          break;
+      }
+    }
+
+    static PlayerInfo info(const Player &player) {
+      return PlayerInfo { player.pid(), player.color(), player.name() };
+    }
+
+    /* sends `bytes` to every client except `except` */
+    void broadcast(const std::string &bytes, std::uint32_t except) {
+      for (auto &pair : clients)
+        if (pair.first != except) reactor.send(pair.first, bytes);
+    }
+
+    void send_snapshot(std::uint32_t connection, Client &client) {
+      auto &player = _engine.get_player(client.pid);
+      auto tick = static_cast<std::uint32_t>(_engine.ticks());
+      auto current = capture(_engine.game_state(), player);
+
+      // snapshots older than the one acknowledged will never be used as a base again
+      while (!client.history.empty() && client.history.front().first < client.ack)
+        client.history.pop_front();
+
+      static const Snapshot empty;
+      const Snapshot *base = &empty;
+      std::uint32_t base_tick = no_base;
+      if (!client.history.empty() && client.history.front().first == client.ack) {
+        base = &client.history.front().second;
+        base_tick = client.ack;
+      }
+
+      BitWriter out;
+      out.write_varint(tick);
+      out.write_varint(base_tick == no_base ? 0 : tick - base_tick);
+      out.write_varint(client.last_input);
+      write_delta(out, *base, current);
+      reactor.send(connection, frame(message_type::snapshot, out.bytes()));
+
+      client.history.emplace_back(tick, std::move(current));
+      if (client.history.size() > snapshot_history)
+        client.history.pop_front();
+    }
+  };
+
+}
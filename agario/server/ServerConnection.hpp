@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "agario/server/protocol.hpp"
+#include "agario/server/snapshot.hpp"
+
+namespace agario::server {
+
+  /**
+   * A client's connection to a Server: joins the game, sends the player's
+   * input and rebuilds the snapshots of the player's view from the deltas
+   * that the server sends back.
+   */
+  class ServerConnection {
+  public:
+    ServerConnection(const std::string &host, int port) :
+      fd(connect_socket(host, port)), _tick(no_base), _welcome() {}
+
+    /**
+     * Asks to join the game as a player named `name`. The server's welcome
+     * (see `welcome()`) arrives ahead of the first snapshot.
+     */
+    void join(const std::string &name) { send(encode_join(name)); }
+
+    /**
+     * Sends the player's target and action, acknowledging the latest snapshot.
+     * The target is clamped to the arena, and sent to within 1/65535 of its size.
+     * @return the input's sequence number (see `last_input`)
+     */
+    std::uint32_t send_input(float target_x, float target_y, agario::action action) {
+      send(encode(Input { _tick, ++_sequence, quantize(target_x, _welcome.arena_width),
+                          quantize(target_y, _welcome.arena_height), action }));
+      return _sequence;
+    }
+
+    /**
+     * Waits up to `timeout_ms` for the next snapshot from the server
+     * @return whether a snapshot was received
+     */
+    bool receive(int timeout_ms = 1000) {
+      Message message;
+      while (next_message(message, timeout_ms)) {
+        if (message.type == message_type::welcome) {
+          _welcome = decode_welcome(message.payload);
+          _joined = true;
+          continue;
+        }
+        if (message.type == message_type::players) {
+          for (auto &player : decode_players(message.payload))
+            _players[player.pid] = player;
+          continue;
+        }
+        if (message.type == message_type::player_left) {
+          _players.erase(decode_player_left(message.payload));
+          continue;
+        }
+        if (message.type != message_type::snapshot)
+          throw NetworkException("Unexpected message from server");
+
+        BitReader in(message.payload);
+        auto tick = static_cast<std::uint32_t>(in.read_varint());
+        auto age = static_cast<std::uint32_t>(in.read_varint());
+        auto base_tick = age == 0 ? no_base : tick - age;
+        auto last_input = static_cast<std::uint32_t>(in.read_varint());
+
+        const Snapshot *base = &empty;
+        if (base_tick != no_base) {
+          base = find(base_tick);
+          if (base == nullptr) {
+            // we no longer have the base, so ask for a complete snapshot
+            _tick = no_base;
+            continue;
+          }
+        }
+
+        auto snapshot = read_delta(in, *base);
+        finish(in);
+        while (!history.empty() && history.front().first < base_tick)
+          history.pop_front(); // the server will no longer send deltas against these
+        history.emplace_back(tick, std::move(snapshot));
+        if (history.size() > snapshot_history)
+          history.pop_front();
+        _tick = tick;
+        _last_input = last_input;
+        return true;
+      }
+      return false;
+    }
+
+    /* the latest snapshot received */
+    const Snapshot &snapshot() const { return history.empty() ? empty : history.back().second; }
+
+    /* the tick of the latest snapshot received (0 before any) */
+    [[nodiscard]] std::uint32_t tick() const { return _tick; }
+
+    /* the sequence number of the latest input the server had applied as of the latest snapshot */
+    [[nodiscard]] std::uint32_t last_input() const { return _last_input; }
+
+    /* whether the server has welcomed us into the game */
+    [[nodiscard]] bool joined() const { return _joined; }
+
+    const Welcome &welcome() const { return _welcome; }
+
+    /* the players in the game, by pid */
+    const std::map<agario::pid, PlayerInfo> &players() const { return _players; }
+
+    [[nodiscard]] std::uint64_t bytes_received() const { return _bytes_received; }
+
+    /* disconnects from the server */
+    void close() {
+      if (fd >= 0) ::close(fd);
+      fd = -1;
+    }
+
+    ~ServerConnection() { close(); }
+
+    ServerConnection(const ServerConnection &) = delete;
+    ServerConnection &operator=(const ServerConnection &) = delete;
+
+  private:
+    int fd;
+    std::uint32_t _tick;
+    std::uint32_t _sequence = 0;
+    std::uint32_t _last_input = 0;
+    Welcome _welcome;
+    bool _joined = false;
+    std::map<agario::pid, PlayerInfo> _players;
+    MessageBuffer received;
+    std::uint64_t _bytes_received = 0;
+
+    const Snapshot empty;
+    std::deque<std::pair<std::uint32_t, Snapshot>> history;
+
+    const Snapshot *find(std::uint32_t tick) const {
+      for (auto &pair : history)
+        if (pair.first == tick) return &pair.second;
+      return nullptr;
+    }
+
+    void send(const std::string &bytes) {
+      std::size_t sent = 0;
+      while (sent < bytes.size()) {
+        auto n = ::send(fd, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0)
+          throw NetworkException("Lost connection to the server");
+        sent += n;
+      }
+    }
+
+    /* the next message from the server, waiting up to `timeout_ms` for it to arrive */
+    bool next_message(Message &message, int timeout_ms) {
+      while (!received.next(message)) {
+        pollfd p { fd, POLLIN, 0 };
+        if (::poll(&p, 1, timeout_ms) <= 0) return false;
+
+        char buffer[1 << 16];
+        auto n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0)
+          throw NetworkException("Lost connection to the server");
+        received.append(buffer, n);
+        _bytes_received += n;
+      }
+      return true;
+    }
+  };
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <sys/uio.h>
+
+namespace agario::server {
+
+  constexpr std::size_t slab_size = 16 * 1024;
+
+  /* a fixed size buffer holding the bytes [begin, end) */
+  struct Slab {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    char data[slab_size];
+
+    [[nodiscard]] std::size_t size() const { return end - begin; }
+    [[nodiscard]] std::size_t space() const { return slab_size - end; }
+  };
+
+  /**
+   * Recycles slabs, so that connections can take buffers as they need
+   * them and give them back when they're emptied, without allocating.
+   * Only to be used from one thread (the network thread).
+   */
+  class SlabPool {
+  public:
+    Slab *acquire() {
+      if (free.empty()) {
+        slabs.emplace_back(std::make_unique<Slab>());
+        return slabs.back().get();
+      }
+      auto *slab = free.back();
+      free.pop_back();
+      slab->begin = slab->end = 0;
+      return slab;
+    }
+
+    void release(Slab *slab) { free.push_back(slab); }
+
+    /* the number of slabs allocated, and of those not in use */
+    [[nodiscard]] std::size_t allocated() const { return slabs.size(); }
+    [[nodiscard]] std::size_t available() const { return free.size(); }
+
+  private:
+    std::vector<std::unique_ptr<Slab>> slabs;
+    std::vector<Slab *> free;
+  };
+
+  /* a queue of bytes stored in a chain of pooled slabs */
+  class SlabChain {
+  public:
+    explicit SlabChain(SlabPool &pool) : pool(&pool), _size(0) {}
+
+    void append(const char *data, std::size_t size) {
+      _size += size;
+      while (size > 0) {
+        if (slabs.empty() || slabs.back()->space() == 0)
+          slabs.push_back(pool->acquire());
+        auto &slab = *slabs.back();
+        auto n = std::min(size, slab.space());
+        std::memcpy(slab.data + slab.end, data, n);
+        slab.end += n;
+        data += n;
+        size -= n;
+      }
+    }
+
+    /* fills `iov` with (up to `max`) pieces of the chain's bytes, returning how many */
+    int gather(iovec *iov, int max) const {
+      int count = 0;
+      for (auto it = slabs.begin(); it != slabs.end() && count < max; ++it) {
+        if ((*it)->size() == 0) continue;
+        iov[count].iov_base = (*it)->data + (*it)->begin;
+        iov[count].iov_len = (*it)->size();
+        count++;
+      }
+      return count;
+    }
+
+    /* drops the first `size` bytes, returning emptied slabs to the pool */
+    void consume(std::size_t size) {
+      _size -= size;
+      while (size > 0) {
+        auto &slab = *slabs.front();
+        auto n = std::min(size, slab.size());
+        slab.begin += n;
+        size -= n;
+        if (slab.size() == 0) {
+          pool->release(slabs.front());
+          slabs.pop_front();
+        }
+      }
+    }
+
+    void clear() { consume(_size); }
+
+    [[nodiscard]] std::size_t size() const { return _size; }
+    [[nodiscard]] bool empty() const { return _size == 0; }
+
+    ~SlabChain() {
+      for (auto *slab : slabs)
+        pool->release(slab);
+    }
+
+    SlabChain(SlabChain &&other) noexcept :
+      pool(other.pool), slabs(std::move(other.slabs)), _size(other._size) {
+      other.slabs.clear();
+      other._size = 0;
+    }
+
+    SlabChain(const SlabChain &) = delete;
+    SlabChain &operator=(const SlabChain &) = delete;
+
+  private:
+    SlabPool *pool;
+    std::deque<Slab *> slabs;
+    std::size_t _size;
+  };
+
+}
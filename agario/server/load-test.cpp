@@ -0,0 +1,54 @@
+#include <iostream>
+
+#include <cxxopts.hpp>
+#include "agario/server/LoadTest.hpp"
+
+cxxopts::Options options() {
+
+  try {
+    cxxopts::Options options("Agar.io Server Load Test", "command line options");
+    options
+      .positional_help("[optional args]")
+      .show_positional_help();
+
+    options.add_options()
+      ("f,frequency", "tick frequency", cxxopts::value<int>()->default_value(std::to_string(agario::server::default_tick_rate)))
+      ("b,bots", "number of bots", cxxopts::value<int>()->default_value("10"))
+      ("c,clients", "initial number of clients", cxxopts::value<int>()->default_value("50"))
+      ("s,step", "clients added each round", cxxopts::value<int>()->default_value("50"))
+      ("m,max", "maximum number of clients", cxxopts::value<int>()->default_value("2000"))
+      ("d,duration", "seconds measured in each round", cxxopts::value<double>()->default_value("2"))
+      ("l,latency", "p99 latency budget in ms (default: one tick)", cxxopts::value<double>()->default_value("0"))
+      ("j,threads", "number of client threads", cxxopts::value<int>()->default_value("4"))
+      ("help", "Print help");
+
+    return options;
+
+  } catch (const cxxopts::OptionException &e) {
+    std::cout << "error parsing options: " << e.what() << std::endl;
+    exit(1);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto opts = options();
+  auto args = opts.parse(argc, argv);
+
+  if (args.count("help")) {
+    std::cout << opts.help() << std::endl;
+    return 0;
+  }
+
+  agario::server::load_test::Config config;
+  config.tick_rate = args["frequency"].as<int>();
+  config.num_bots = args["bots"].as<int>();
+  config.initial_clients = args["clients"].as<int>();
+  config.clients_per_round = args["step"].as<int>();
+  config.max_clients = args["max"].as<int>();
+  config.round_seconds = args["duration"].as<double>();
+  config.latency_budget_ms = args["latency"].as<double>();
+  config.client_threads = args["threads"].as<int>();
+
+  agario::server::load_test::run(config, std::cout);
+  return 0;
+}
@@ -1,10 +1,62 @@
+#include <csignal>
 #include <iostream>
 
+#include <cxxopts.hpp>
+#include "agario/server/Server.hpp"
+
+namespace {
+  agario::server::Server<false> *running_server = nullptr;
+
+  void handle_signal(int) {
+    if (running_server != nullptr) running_server->stop();
+  }
+}
+
+cxxopts::Options options() {
+
+  try {
+    cxxopts::Options options("Agar.io Server", "command line options");
+    options
+      .positional_help("[optional args]")
+      .show_positional_help();
+
+    options.add_options()
+      ("p,port", "Port", cxxopts::value<int>()->default_value(std::to_string(agario::server::default_port)))
+      ("f,frequency", "tick frequency", cxxopts::value<int>()->default_value(std::to_string(agario::server::default_tick_rate)))
+      ("a,arena", "arena size", cxxopts::value<int>()->default_value(std::to_string(DEFAULT_ARENA_WIDTH)))
+      ("pellets", "number of pellets", cxxopts::value<int>()->default_value(std::to_string(DEFAULT_NUM_PELLETS)))
+      ("viruses", "number of viruses", cxxopts::value<int>()->default_value(std::to_string(DEFAULT_NUM_VIRUSES)))
+      ("b,bots", "number of bots", cxxopts::value<int>()->default_value("10"))
+      ("help", "Print help");
+
+    return options;
+
+  } catch (const cxxopts::OptionException &e) {
+    std::cout << "error parsing options: " << e.what() << std::endl;
+    exit(1);
+  }
+}
+
 int main(int argc, char *argv[]) {
-  static_cast<void>(argc);
-  static_cast<void>(argv);
+  auto opts = options();
+  auto args = opts.parse(argc, argv);
+
+  if (args.count("help")) {
+    std::cout << opts.help() << std::endl;
+    return 0;
+  }
+
+  auto arena_size = args["arena"].as<int>();
+  agario::server::Server<false> server(args["port"].as<int>(), arena_size, arena_size,
+                                       args["pellets"].as<int>(), args["viruses"].as<int>(),
+                                       args["bots"].as<int>(), args["frequency"].as<int>());
 
-  std::cout << "Agario server not yet implemented!" << std::endl;
+  running_server = &server;
+  std::signal(SIGINT, handle_signal);
+  std::signal(SIGTERM, handle_signal);
 
+  std::cout << "Serving on port " << server.port() << " at " << server.tick_rate() << " ticks/sec" << std::endl;
+  server.run();
+  std::cout << "Shut down after " << server.engine().ticks() << " ticks" << std::endl;
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,311 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "agario/core/color.hpp"
+#include "agario/core/types.hpp"
+#include "agario/engine/binary.hpp"
+#include "agario/server/wire.hpp"
+
+/**
+ * Messages exchanged between the server and its clients over TCP. Each
+ * message is framed as its length (uint32, counting the type byte and the
+ * payload), its type (uint8) and a payload packed with the BitWriter of
+ * wire.hpp
+ *
+ *   client -> server
+ *     join         name of the player to add to the game
+ *     input        the latest snapshot received, the input's sequence number,
+ *                  and the player's action and target (quantized to 16 bits
+ *                  across the arena)
+ *
+ *   server -> client
+ *     welcome      pid of the client's player, arena size and tick rate
+ *     players      pid, color and name of players which joined the game
+ *                  (all of them, on joining)
+ *     player_left  pid of a player which left the game
+ *     snapshot     tick, how many ticks earlier the snapshot it's a delta
+ *                  against was (0 for none), the sequence number of the last
+ *                  input applied before the tick and the delta (see snapshot.hpp)
+ */
+namespace agario::server {
+
+  class NetworkException : public std::runtime_error {
+    using runtime_error::runtime_error;
+  };
+
+  constexpr std::uint32_t max_message_size = 1u << 24u;
+
+  constexpr std::size_t max_name_length = 64;
+
+  enum message_type : std::uint8_t {
+    join = 1, input = 2, welcome = 3, snapshot = 4, players = 5, player_left = 6
+  };
+
+  /* sent with snapshots which aren't a delta against an earlier snapshot */
+  constexpr std::uint32_t no_base = 0;
+
+  struct Message {
+    message_type type;
+    std::string payload;
+  };
+
+  struct Input {
+    std::uint32_t ack; // tick of the latest snapshot received
+    std::uint32_t sequence; // numbers the client's inputs, from 1
+    std::uint16_t target_x, target_y; // quantized across the arena's width and height
+    agario::action action;
+  };
+
+  struct Welcome {
+    agario::pid pid;
+    float arena_width, arena_height;
+    std::uint32_t tick_rate;
+  };
+
+  struct PlayerInfo {
+    agario::pid pid;
+    agario::color color;
+    std::string name;
+
+    bool operator==(const PlayerInfo &other) const {
+      return pid == other.pid && color == other.color && name == other.name;
+    }
+  };
+
+  /* the bytes to send for a message with `payload` */
+  inline std::string frame(message_type type, const std::string &payload) {
+    std::ostringstream os;
+    binary::write<std::uint32_t>(os, payload.size() + 1);
+    binary::write(os, type);
+    os << payload;
+    return os.str();
+  }
+
+  /* fails on bytes left over after a message was read */
+  inline void finish(const BitReader &in) {
+    if (!in.done())
+      throw binary::FormatException("Unexpected data at the end of message");
+  }
+
+  inline std::string encode_join(const std::string &name) {
+    BitWriter out;
+    out.write_string(name.substr(0, max_name_length));
+    return frame(message_type::join, out.bytes());
+  }
+
+  inline std::string decode_join(const std::string &payload) {
+    BitReader in(payload);
+    auto name = in.read_string(max_name_length);
+    finish(in);
+    return name;
+  }
+
+  /* inputs are 34 bits after the ack and sequence number, which together fit in (at most) 15 bytes */
+  inline std::string encode(const Input &input) {
+    BitWriter out;
+    out.write_varint(input.ack);
+    out.write_varint(input.sequence);
+    out.write(input.action, 2);
+    out.write(input.target_x, 16);
+    out.write(input.target_y, 16);
+    return frame(message_type::input, out.bytes());
+  }
+
+  inline Input decode_input(const std::string &payload) {
+    BitReader in(payload);
+    Input input {};
+    auto ack = in.read_varint();
+    auto sequence = in.read_varint();
+    if (ack > std::numeric_limits<std::uint32_t>::max() || sequence > std::numeric_limits<std::uint32_t>::max())
+      throw binary::FormatException("Invalid tick or sequence number");
+    input.ack = static_cast<std::uint32_t>(ack);
+    input.sequence = static_cast<std::uint32_t>(sequence);
+    auto action = in.read(2);
+    if (action > agario::action::split)
+      throw binary::FormatException("Unknown action");
+    input.action = static_cast<agario::action>(action);
+    input.target_x = static_cast<std::uint16_t>(in.read(16));
+    input.target_y = static_cast<std::uint16_t>(in.read(16));
+    finish(in);
+    return input;
+  }
+
+  inline std::string encode(const Welcome &welcome) {
+    BitWriter out;
+    out.write_varint(welcome.pid);
+    out.write_float(welcome.arena_width);
+    out.write_float(welcome.arena_height);
+    out.write_varint(welcome.tick_rate);
+    return frame(message_type::welcome, out.bytes());
+  }
+
+  inline Welcome decode_welcome(const std::string &payload) {
+    BitReader in(payload);
+    Welcome welcome {};
+    welcome.pid = static_cast<agario::pid>(in.read_varint());
+    welcome.arena_width = in.read_float();
+    welcome.arena_height = in.read_float();
+    welcome.tick_rate = static_cast<std::uint32_t>(in.read_varint());
+    finish(in);
+    return welcome;
+  }
+
+  inline std::string encode(const std::vector<PlayerInfo> &players) {
+    BitWriter out;
+    out.write_varint(players.size());
+    for (auto &player : players) {
+      out.write_varint(player.pid);
+      out.write(player.color, 3);
+      out.write_string(player.name.substr(0, max_name_length));
+    }
+    return frame(message_type::players, out.bytes());
+  }
+
+  inline std::vector<PlayerInfo> decode_players(const std::string &payload) {
+    BitReader in(payload);
+    std::vector<PlayerInfo> players;
+    auto count = in.read_varint();
+    for (std::uint64_t i = 0; i < count; i++) {
+      auto &player = players.emplace_back();
+      auto pid = in.read_varint();
+      auto color = in.read(3);
+      if (pid > std::numeric_limits<agario::pid>::max() || color >= agario::color::last)
+        throw binary::FormatException("Invalid player");
+      player.pid = static_cast<agario::pid>(pid);
+      player.color = static_cast<agario::color>(color);
+      player.name = in.read_string(max_name_length);
+    }
+    finish(in);
+    return players;
+  }
+
+  inline std::string encode_player_left(agario::pid pid) {
+    BitWriter out;
+    out.write_varint(pid);
+    return frame(message_type::player_left, out.bytes());
+  }
+
+  inline agario::pid decode_player_left(const std::string &payload) {
+    BitReader in(payload);
+    auto pid = in.read_varint();
+    finish(in);
+    if (pid > std::numeric_limits<agario::pid>::max())
+      throw binary::FormatException("Invalid pid");
+    return static_cast<agario::pid>(pid);
+  }
+
+  /* accumulates received bytes, splitting them into messages */
+  class MessageBuffer {
+  public:
+    void append(const char *data, std::size_t size) { buffer.append(data, size); }
+
+    /* removes the next complete message from the buffer into `message` */
+    bool next(Message &message) {
+      std::uint32_t length;
+      if (buffer.size() - start < sizeof(length)) return false;
+      std::memcpy(&length, buffer.data() + start, sizeof(length));
+      if (length == 0 || length > max_message_size)
+        throw binary::FormatException("Invalid message length: " + std::to_string(length));
+      if (buffer.size() - start < sizeof(length) + length) return false;
+
+      message.type = static_cast<message_type>(buffer[start + sizeof(length)]);
+      message.payload.assign(buffer, start + sizeof(length) + 1, length - 1);
+      start += sizeof(length) + length;
+
+      // drop consumed bytes once they make up most of the buffer
+      if (start > buffer.size() / 2) {
+        buffer.erase(0, start);
+        start = 0;
+      }
+      return true;
+    }
+
+  private:
+    std::string buffer;
+    std::size_t start = 0;
+  };
+
+  /* ================ sockets ================ */
+
+  inline void set_nonblocking(int fd) {
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+      throw NetworkException(std::string("fcntl: ") + std::strerror(errno));
+  }
+
+  inline void set_nodelay(int fd) {
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+
+  /* a non-blocking socket listening on `port` of all interfaces (0 for any free port) */
+  inline int listen_socket(int port, int backlog = 128) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+      throw NetworkException(std::string("socket: ") + std::strerror(errno));
+
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<std::uint16_t>(port));
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || ::listen(fd, backlog) < 0) {
+      auto error = std::string(std::strerror(errno));
+      ::close(fd);
+      throw NetworkException("Could not listen on port " + std::to_string(port) + ": " + error);
+    }
+    set_nonblocking(fd);
+    return fd;
+  }
+
+  /* the port that socket `fd` is bound to */
+  inline int bound_port(int fd) {
+    sockaddr_in addr {};
+    socklen_t length = sizeof(addr);
+    if (::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &length) < 0)
+      throw NetworkException(std::string("getsockname: ") + std::strerror(errno));
+    return ntohs(addr.sin_port);
+  }
+
+  /* a (blocking) socket connected to `host`:`port` */
+  inline int connect_socket(const std::string &host, int port) {
+    addrinfo hints {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *result = nullptr;
+    if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0)
+      throw NetworkException("Could not resolve " + host);
+
+    int fd = -1;
+    for (auto *info = result; info != nullptr && fd < 0; info = info->ai_next) {
+      fd = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+      if (fd >= 0 && ::connect(fd, info->ai_addr, info->ai_addrlen) < 0) {
+        ::close(fd);
+        fd = -1;
+      }
+    }
+    ::freeaddrinfo(result);
+    if (fd < 0)
+      throw NetworkException("Could not connect to " + host + ":" + std::to_string(port));
+    set_nodelay(fd);
+    return fd;
+  }
+
+}
@@ -0,0 +1,396 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "agario/core/Player.hpp"
+#include "agario/core/utils.hpp"
+#include "agario/engine/GameState.hpp"
+#include "agario/engine/binary.hpp"
+#include "agario/server/wire.hpp"
+
+/**
+ * Interest management and delta compression of the game state sent to
+ * each client of the server.
+ *
+ * A Snapshot is the set of entities within a player's view at one tick,
+ * each identified by its kind and an id which stays the same from tick to
+ * tick for as long as the entity does (a pellet is identified by where it
+ * lies, a player's cell by the player's pid and the cell's index). Rather
+ * than sending whole snapshots, the server sends each client the entities
+ * which have been removed from, added to or changed in its view since the
+ * last snapshot that client acknowledged.
+ *
+ * Positions are captured on the grid of wire.hpp, so that everything in a
+ * view can be sent as 16 bit offsets from a corner of the view.
+ */
+namespace agario::server {
+
+  /* the number of snapshots kept (by the server for each client, and by clients) as bases for deltas */
+  constexpr std::size_t snapshot_history = 32;
+
+  enum entity_kind : std::uint8_t { pellet = 0, virus = 1, food = 2, cell = 3 };
+
+  struct EntityState {
+    entity_kind kind;
+    std::uint64_t id;
+    float x, y; // on the grid (see `snap`)
+    agario::mass mass;
+
+    [[nodiscard]] std::tuple<std::uint8_t, std::uint64_t> key() const { return { kind, id }; }
+
+    bool operator<(const EntityState &other) const { return key() < other.key(); }
+    bool operator==(const EntityState &other) const {
+      return key() == other.key() && x == other.x && y == other.y && mass == other.mass;
+    }
+    bool operator!=(const EntityState &other) const { return !(*this == other); }
+  };
+
+  /* the entities in view, sorted by (kind, id) */
+  using Snapshot = std::vector<EntityState>;
+
+  /* the pid of the player owning an entity of kind `cell` */
+  inline agario::pid cell_owner(const EntityState &entity) {
+    return static_cast<agario::pid>(entity.id >> 32u);
+  }
+
+  /* the id of a pellet at (`x`, `y`) on the grid */
+  inline std::uint64_t pellet_id(std::int32_t x, std::int32_t y) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32u) | static_cast<std::uint32_t>(y);
+  }
+
+  /* the mass of each kind of entity, which isn't sent unless an entity's differs */
+  inline agario::mass default_mass(entity_kind kind) {
+    switch (kind) {
+      case pellet: return PELLET_MASS;
+      case virus: return VIRUS_MASS;
+      case food: return FOOD_MASS;
+      default: return 0;
+    }
+  }
+
+  /* the width (and height) of the region of the arena that `player` can see */
+  template<bool renderable>
+  float view_size(const agario::Player<renderable> &player) {
+    return agario::view_size(player.mass()); // same view size as the environments' observations
+  }
+
+  /**
+   * Captures the entities within `view` (width and height) of `center`.
+   * Every player's cells are included, along with the pellets, viruses and food.
+   */
+  template<bool renderable>
+  Snapshot capture(const GameState<renderable> &state, const Location &center, float view) {
+    Snapshot snapshot;
+    auto half = view / 2;
+    Location extent(half, half);
+
+    auto in_view = [&](const Ball &ball) {
+      return std::abs(static_cast<float>(ball.x - center.x)) <= half &&
+             std::abs(static_cast<float>(ball.y - center.y)) <= half;
+    };
+    auto add = [&](entity_kind kind, std::uint64_t id, const Ball &ball) {
+      snapshot.push_back({ kind, id, snap(static_cast<float>(ball.x)), snap(static_cast<float>(ball.y)), ball.mass() });
+    };
+
+    // pellets don't move, so they're identified by where they lie
+    state.for_each_pellet(center - extent, center + extent, [&](const Location &loc) {
+      auto x = to_grid(static_cast<float>(loc.x)), y = to_grid(static_cast<float>(loc.y));
+      snapshot.push_back({ pellet, pellet_id(x, y), from_grid(x), from_grid(y), PELLET_MASS });
+    });
+
+    for (std::size_t i = 0; i < state.viruses.size(); i++)
+      if (in_view(state.viruses[i])) add(virus, i, state.viruses[i]);
+
+    for (std::size_t i = 0; i < state.foods.size(); i++)
+      if (in_view(state.foods[i])) add(food, i, state.foods[i]);
+
+    for (auto &pair : state.players) {
+      auto &cells = pair.second->cells;
+      for (std::size_t i = 0; i < cells.size(); i++)
+        if (in_view(cells[i]))
+          add(cell, (static_cast<std::uint64_t>(pair.first) << 32u) | i, cells[i]);
+    }
+
+    std::sort(snapshot.begin(), snapshot.end());
+    // two pellets on the same point of the grid are indistinguishable, so only one is sent
+    snapshot.erase(std::unique(snapshot.begin(), snapshot.end(),
+                               [](const EntityState &a, const EntityState &b) { return a.key() == b.key(); }),
+                   snapshot.end());
+    return snapshot;
+  }
+
+  /* captures the entities within view of `player` */
+  template<bool renderable>
+  Snapshot capture(const GameState<renderable> &state, const agario::Player<renderable> &player) {
+    return capture(state, player.location(), view_size(player));
+  }
+
+  /**
+   * The entities of `after`, each moved `alpha` (from 0 to 1) of the way
+   * there from where it was in `before` (if it was in `before` at all)
+   */
+  inline Snapshot interpolate(const Snapshot &before, const Snapshot &after, float alpha) {
+    Snapshot entities(after);
+    auto it = before.begin();
+    for (auto &entity : entities) {
+      it = std::lower_bound(it, before.end(), entity);
+      if (it != before.end() && it->key() == entity.key()) {
+        entity.x = it->x + alpha * (entity.x - it->x);
+        entity.y = it->y + alpha * (entity.y - it->y);
+      }
+    }
+    return entities;
+  }
+
+
+  /* ================ delta encoding ================ */
+
+  /* bits of the mask sent with each changed entity, marking which fields follow */
+  enum field : std::uint8_t { field_x = 1, field_y = 2, field_mass = 4, all_fields = 7 };
+
+  namespace detail {
+
+    constexpr int num_kinds = cell + 1;
+    constexpr std::uint8_t position_fields = field_x | field_y;
+
+    inline void write_id(BitWriter &out, const EntityState &entity) {
+      if (entity.kind == cell) {
+        out.write_varint(cell_owner(entity));
+        out.write_varint(entity.id & 0xffffffffu);
+      } else {
+        out.write_varint(entity.id);
+      }
+    }
+
+    inline std::uint64_t read_id(BitReader &in, entity_kind kind) {
+      if (kind != cell) return in.read_varint();
+      auto pid = in.read_varint();
+      auto index = in.read_varint();
+      if (pid > std::numeric_limits<agario::pid>::max() || index > 0xffffffffu)
+        throw binary::FormatException("Invalid cell id");
+      return (pid << 32u) | index;
+    }
+
+    inline void write_offset(BitWriter &out, float position, std::int64_t origin) {
+      auto offset = to_grid(position) - origin;
+      if (offset < 0 || offset > max_grid_offset)
+        throw std::out_of_range("Entities are too far apart to be sent relative to one origin");
+      out.write(static_cast<std::uint32_t>(offset), 16);
+    }
+
+    /**
+     * The number of entities of each kind in `entities` (which are sorted by
+     * kind): a bit for each kind marking whether there are any, followed by
+     * the counts of those there are
+     */
+    template<typename T, typename Kind>
+    void write_counts(BitWriter &out, const std::vector<T> &entities, Kind kind) {
+      std::size_t counts[num_kinds] = {};
+      for (auto &entity : entities) counts[kind(entity)]++;
+      for (auto count : counts) out.write(count > 0, 1);
+      for (auto count : counts)
+        if (count > 0) out.write_varint(count);
+    }
+
+  }
+
+  /**
+   * Writes the changes from `base` to `current`: the entities which were
+   * removed, followed by the changed fields of each entity which was added
+   * or changed. An empty `base` gives a complete snapshot.
+   *
+   * Entities are grouped by kind, so each group is preceded by its size
+   * rather than each entity by its kind. Positions are sent as 16 bit
+   * offsets on the grid from an origin at the lowest position sent, so all
+   * of the entities sent must lie on the grid within 2^16 points of each
+   * other (as those captured in one view do). Pellets, which never change,
+   * are identified by their positions alone, and masses are only sent for
+   * entities whose mass differs from their kind's default.
+   */
+  inline void write_delta(BitWriter &out, const Snapshot &base, const Snapshot &current) {
+    using namespace detail;
+    std::vector<const EntityState *> removed;
+    std::vector<std::pair<const EntityState *, std::uint8_t>> changed;
+
+    auto b = base.begin();
+    for (auto &entity : current) {
+      while (b != base.end() && *b < entity)
+        removed.push_back(&*b++);
+
+      if (b != base.end() && b->key() == entity.key()) {
+        std::uint8_t mask = (b->x != entity.x ? field_x : 0) |
+                            (b->y != entity.y ? field_y : 0) |
+                            (b->mass != entity.mass ? field_mass : 0);
+        if (mask != 0) changed.emplace_back(&entity, mask);
+        ++b;
+      } else {
+        auto mass = entity.mass != default_mass(entity.kind) ? field_mass : 0;
+        changed.emplace_back(&entity, position_fields | mass);
+      }
+    }
+    for (; b != base.end(); ++b)
+      removed.push_back(&*b);
+
+    // the origin is the lowest position sent, so that every offset is positive
+    auto lowest = std::numeric_limits<std::int64_t>::max();
+    std::int64_t origin_x = lowest, origin_y = lowest;
+    for (auto &pair : changed) {
+      if (pair.second & field_x) origin_x = std::min<std::int64_t>(origin_x, to_grid(pair.first->x));
+      if (pair.second & field_y) origin_y = std::min<std::int64_t>(origin_y, to_grid(pair.first->y));
+    }
+    if (origin_x == lowest) origin_x = 0;
+    if (origin_y == lowest) origin_y = 0;
+    out.write_zigzag(origin_x);
+    out.write_zigzag(origin_y);
+
+    write_counts(out, removed, [](const EntityState *entity) { return entity->kind; });
+    for (auto entity : removed) {
+      if (entity->kind == pellet) {
+        out.write_zigzag(to_grid(entity->x) - origin_x);
+        out.write_zigzag(to_grid(entity->y) - origin_y);
+      } else {
+        write_id(out, *entity);
+      }
+    }
+
+    write_counts(out, changed, [](const std::pair<const EntityState *, std::uint8_t> &pair) {
+      return pair.first->kind;
+    });
+    for (auto &pair : changed) {
+      auto &entity = *pair.first;
+      if (entity.kind != pellet) {
+        write_id(out, entity);
+        out.write(pair.second, 3);
+      }
+      if (pair.second & field_x) write_offset(out, entity.x, origin_x);
+      if (pair.second & field_y) write_offset(out, entity.y, origin_y);
+      if (pair.second & field_mass) out.write_varint(entity.mass);
+    }
+  }
+
+  /* reads a delta written by write_delta, returning the snapshot it was made from */
+  inline Snapshot read_delta(BitReader &in, const Snapshot &base) {
+    using namespace detail;
+    auto read_grid = [&]() -> std::int64_t {
+      auto grid = in.read_zigzag();
+      if (grid < std::numeric_limits<std::int32_t>::min() || grid > std::numeric_limits<std::int32_t>::max())
+        throw binary::FormatException("Position out of range");
+      return grid;
+    };
+    auto origin_x = read_grid();
+    auto origin_y = read_grid();
+
+    auto read_counts = [&](std::uint64_t limit) {
+      std::array<std::uint64_t, num_kinds> counts {};
+      std::uint64_t total = 0;
+      auto present = in.read(num_kinds);
+      for (int kind = 0; kind < num_kinds; kind++) {
+        if ((present & (1u << kind)) == 0) continue;
+        auto &count = counts[kind];
+        count = in.read_varint();
+        if (count == 0)
+          throw binary::FormatException("Empty group of entities");
+        total += count;
+        if (count > limit || total > limit)
+          throw binary::FormatException("Too many entities in delta");
+      }
+      return counts;
+    };
+
+    auto read_position = [&](std::int64_t grid) {
+      if (grid < std::numeric_limits<std::int32_t>::min() || grid > std::numeric_limits<std::int32_t>::max())
+        throw binary::FormatException("Position out of range");
+      return static_cast<std::int32_t>(grid);
+    };
+
+    std::vector<EntityState> removed;
+    auto num_removed = read_counts(base.size());
+    for (int kind = 0; kind < num_kinds; kind++) {
+      for (std::uint64_t i = 0; i < num_removed[kind]; i++) {
+        auto &entity = removed.emplace_back();
+        entity.kind = static_cast<entity_kind>(kind);
+        if (kind == pellet) {
+          auto x = read_position(origin_x + read_grid());
+          auto y = read_position(origin_y + read_grid());
+          entity.id = pellet_id(x, y);
+        } else {
+          entity.id = read_id(in, entity.kind);
+        }
+      }
+    }
+
+    // the counts aren't trusted for allocation, since reading fails at the end of the data anyway
+    std::vector<std::pair<EntityState, std::uint8_t>> changed;
+    auto num_changed = read_counts(std::numeric_limits<std::uint32_t>::max());
+    for (int kind = 0; kind < num_kinds; kind++) {
+      for (std::uint64_t i = 0; i < num_changed[kind]; i++) {
+        auto &pair = changed.emplace_back();
+        auto &entity = pair.first;
+        entity.kind = static_cast<entity_kind>(kind);
+        entity.mass = default_mass(entity.kind);
+        if (kind == pellet) {
+          pair.second = position_fields;
+        } else {
+          entity.id = read_id(in, entity.kind);
+          pair.second = static_cast<std::uint8_t>(in.read(3));
+        }
+        if (pair.second & field_x) entity.x = from_grid(read_position(origin_x + in.read(16)));
+        if (pair.second & field_y) entity.y = from_grid(read_position(origin_y + in.read(16)));
+        if (pair.second & field_mass) {
+          auto mass = in.read_varint();
+          if (mass > std::numeric_limits<agario::mass>::max())
+            throw binary::FormatException("Mass out of range");
+          entity.mass = static_cast<agario::mass>(mass);
+        }
+        if (kind == pellet)
+          entity.id = pellet_id(to_grid(entity.x), to_grid(entity.y));
+      }
+    }
+
+    auto add = [&](Snapshot &snapshot, const std::pair<EntityState, std::uint8_t> &pair) {
+      if ((pair.second & position_fields) != position_fields)
+        throw binary::FormatException("Partial update of an entity not in the base snapshot");
+      snapshot.push_back(pair.first);
+    };
+
+    // merge the (sorted) base, removed and changed entities
+    Snapshot snapshot;
+    snapshot.reserve(base.size() + changed.size());
+    auto r = removed.begin();
+    auto c = changed.begin();
+    for (auto &entity : base) {
+      for (; c != changed.end() && c->first < entity; ++c)
+        add(snapshot, *c);
+
+      if (r != removed.end() && r->key() == entity.key()) {
+        ++r;
+        continue;
+      }
+
+      snapshot.push_back(entity);
+      if (c != changed.end() && c->first.key() == entity.key()) {
+        auto &updated = snapshot.back();
+        if (c->second & field_x) updated.x = c->first.x;
+        if (c->second & field_y) updated.y = c->first.y;
+        if (c->second & field_mass) updated.mass = c->first.mass;
+        ++c;
+      }
+    }
+    for (; c != changed.end(); ++c)
+      add(snapshot, *c);
+
+    if (r != removed.end())
+      throw binary::FormatException("Removed an entity not in the base snapshot");
+    if (!std::is_sorted(snapshot.begin(), snapshot.end()))
+      throw binary::FormatException("Delta entities are out of order");
+    return snapshot;
+  }
+
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "agario/engine/binary.hpp"
+
+/**
+ * Bit-level encoding of the server's messages. Fields are packed into a
+ * stream of bits with no padding between them, least significant bit first,
+ * so that e.g. an action takes two bits and a quantized coordinate sixteen.
+ * Counts, ids and masses are written as varints (seven bits per byte, with
+ * the high bit set on all but the last byte), so that small values, which
+ * are the common case, take a single byte.
+ */
+namespace agario::server {
+
+  /* positions are sent on a grid with this many points per unit of distance */
+  constexpr int grid_resolution = 32;
+
+  /* the widest region (in grid points) whose positions fit in 16 bits */
+  constexpr std::int64_t max_grid_offset = 0xffff;
+
+  inline std::int32_t to_grid(float x) {
+    return static_cast<std::int32_t>(std::lround(x * grid_resolution));
+  }
+
+  inline float from_grid(std::int32_t g) {
+    return static_cast<float>(g) / grid_resolution;
+  }
+
+  /* `x` rounded to the nearest point on the grid */
+  inline float snap(float x) { return from_grid(to_grid(x)); }
+
+  /* `value` in [0, extent] quantized to 16 bits */
+  inline std::uint16_t quantize(float value, float extent) {
+    if (!(extent > 0)) return 0;
+    auto unit = std::clamp(value / extent, 0.0f, 1.0f);
+    return static_cast<std::uint16_t>(std::lround(unit * 0xffff));
+  }
+
+  inline float dequantize(std::uint16_t q, float extent) {
+    return static_cast<float>(q) / 0xffff * extent;
+  }
+
+  class BitWriter {
+  public:
+    /* writes the low `bits` (at most 32) bits of `value` */
+    void write(std::uint32_t value, int bits) {
+      buffer |= (static_cast<std::uint64_t>(value) & ((std::uint64_t(1) << bits) - 1)) << count;
+      count += bits;
+      while (count >= 8) {
+        _bytes.push_back(static_cast<char>(buffer & 0xff));
+        buffer >>= 8u;
+        count -= 8;
+      }
+    }
+
+    void write_varint(std::uint64_t value) {
+      while (value >= 0x80) {
+        write(static_cast<std::uint32_t>(value & 0x7f) | 0x80, 8);
+        value >>= 7u;
+      }
+      write(static_cast<std::uint32_t>(value), 8);
+    }
+
+    /* signed values are zig-zag encoded, so that small negative values stay small */
+    void write_zigzag(std::int64_t value) {
+      write_varint((static_cast<std::uint64_t>(value) << 1u) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+    void write_float(float value) {
+      std::uint32_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      write(bits, 32);
+    }
+
+    void write_string(const std::string &s) {
+      write_varint(s.size());
+      for (char c : s) write(static_cast<std::uint8_t>(c), 8);
+    }
+
+    /* the number of bits written so far */
+    [[nodiscard]] std::size_t bit_size() const { return 8 * _bytes.size() + count; }
+
+    /* the bytes written, with the last byte padded with zeros */
+    std::string bytes() const {
+      auto bytes = _bytes;
+      if (count > 0) bytes.push_back(static_cast<char>(buffer & 0xff));
+      return bytes;
+    }
+
+  private:
+    std::string _bytes;
+    std::uint64_t buffer = 0;
+    int count = 0;
+  };
+
+  /* reads what a BitWriter wrote, throwing binary::FormatException on running out of data */
+  class BitReader {
+  public:
+    BitReader(const char *data, std::size_t size) : data(data), size(size) {}
+    explicit BitReader(const std::string &bytes) : BitReader(bytes.data(), bytes.size()) {}
+    explicit BitReader(std::string &&) = delete; // the bytes must outlive the reader
+
+    std::uint32_t read(int bits) {
+      while (count < bits) {
+        if (position == size)
+          throw binary::FormatException("Unexpected end of message");
+        buffer |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(data[position++])) << count;
+        count += 8;
+      }
+      auto value = static_cast<std::uint32_t>(buffer & ((std::uint64_t(1) << bits) - 1));
+      buffer >>= bits;
+      count -= bits;
+      return value;
+    }
+
+    std::uint64_t read_varint() {
+      std::uint64_t value = 0;
+      for (int shift = 0; shift < 64; shift += 7) {
+        auto byte = read(8);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return value;
+      }
+      throw binary::FormatException("Varint is too long");
+    }
+
+    std::int64_t read_zigzag() {
+      auto value = read_varint();
+      return static_cast<std::int64_t>(value >> 1u) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    float read_float() {
+      auto bits = read(32);
+      float value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+
+    std::string read_string(std::size_t max_length) {
+      auto length = read_varint();
+      if (length > max_length)
+        throw binary::FormatException("String is too long");
+      std::string s(length, '\0');
+      for (auto &c : s) c = static_cast<char>(read(8));
+      return s;
+    }
+
+    /* whether every byte has been read (bar the padding of the last) */
+    [[nodiscard]] bool done() const { return position == size; }
+
+  private:
+    const char *data;
+    std::size_t size;
+    std::size_t position = 0;
+    std::uint64_t buffer = 0;
+    int count = 0;
+  };
+
+}
@@ -1,8 +1,19 @@
 #include <gtest/gtest.h>
 
+#include <agario/test/test-client.hpp>
 #include <agario/test/test-core.hpp>
 #include <agario/test/test-entities.hpp>
 #include <agario/test/test-engine.hpp>
+#include <agario/test/test-fixed-point.hpp>
+#include <agario/test/test-pellet-field.hpp>
+#include <agario/test/test-replay.hpp>
+#include <agario/test/test-server.hpp>
+#include <agario/test/test-software-renderer.hpp>
+#include <agario/test/test-spatial-index.hpp>
+#include <agario/test/test-thread-pool.hpp>
+#include <agario/test/test-tournament.hpp>
+#include <agario/test/test-trace.hpp>
+#include <agario/test/test-wire.hpp>
 
 namespace { }
 
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <agario/client/FixedTimestep.hpp>
+#include <agario/client/SnapshotState.hpp>
+#include <agario/engine/Engine.hpp>
+#include <agario/server/snapshot.hpp>
+#include <agario/test/renderable.hpp>
+
+#include <utils/triple-buffer.h>
+
+namespace {
+
+  TEST(ClientTest, FixedTimestep) {
+    agario::FixedTimestep timestep(agario::time_delta(0.25), 4);
+
+    // leftover time is carried on to the next frame
+    EXPECT_EQ(0, timestep.advance(agario::time_delta(0.125)));
+    EXPECT_FLOAT_EQ(0.5, timestep.alpha());
+    EXPECT_EQ(1, timestep.advance(agario::time_delta(0.25)));
+    EXPECT_FLOAT_EQ(0.5, timestep.alpha());
+    EXPECT_EQ(2, timestep.advance(agario::time_delta(0.375)));
+    EXPECT_FLOAT_EQ(0, timestep.alpha());
+
+    // time too long to catch up on is dropped
+    EXPECT_EQ(4, timestep.advance(agario::time_delta(10)));
+    EXPECT_FLOAT_EQ(0, timestep.alpha());
+    EXPECT_EQ(1, timestep.advance(agario::time_delta(0.25)));
+
+    EXPECT_THROW(agario::FixedTimestep(agario::time_delta(0)), std::invalid_argument);
+  }
+
+  /* the same number of ticks is simulated however the time is divided into frames */
+  TEST(ClientTest, FixedTimestepFrameRate) {
+    for (double frame : { 1.0 / 30, 1.0 / 60, 1.0 / 144, 0.013 }) {
+      agario::FixedTimestep timestep(agario::time_delta(1.0 / 64));
+      int steps = 0, frames = static_cast<int>(2 / frame);
+      for (int i = 0; i < frames; i++)
+        steps += timestep.advance(agario::time_delta(frame));
+      EXPECT_NEAR(frames * frame * 64, steps, 1) << frame;
+    }
+  }
+
+  TEST(ClientTest, Interpolate) {
+    using agario::server::EntityState;
+    agario::server::Snapshot before = {
+      { agario::server::pellet, 1, 10, 10, PELLET_MASS },
+      { agario::server::cell, 5, 100, 200, 50 },
+    };
+    agario::server::Snapshot after = {
+      { agario::server::pellet, 1, 10, 10, PELLET_MASS },
+      { agario::server::cell, 5, 120, 180, 60 },
+      { agario::server::cell, 6, 300, 300, 20 }, // appeared
+    };
+
+    auto between = agario::server::interpolate(before, after, 0.25);
+    ASSERT_EQ(3, between.size());
+    EXPECT_FLOAT_EQ(10, between[0].x);
+    EXPECT_FLOAT_EQ(105, between[1].x);
+    EXPECT_FLOAT_EQ(195, between[1].y);
+    EXPECT_FLOAT_EQ(60, between[1].mass);
+    EXPECT_FLOAT_EQ(300, between[2].x);
+
+    EXPECT_EQ(before[1].x, agario::server::interpolate(before, after, 0)[1].x);
+    EXPECT_EQ(after, agario::server::interpolate(before, after, 1));
+  }
+
+  TEST(ClientTest, SnapshotState) {
+    agario::Engine<renderable> engine(1000, 1000, 100, 5);
+    engine.seed(3);
+    engine.reset();
+    auto pid = engine.add_player<agario::Player<renderable>>("shown");
+    auto other = engine.add_player<agario::Player<renderable>>("elsewhere");
+    engine.tick(agario::time_delta(1.0 / 60));
+
+    auto &player = engine.get_player(pid);
+    auto entities = agario::server::capture(engine.get_game_state(), player.location(), 2000);
+    std::map<agario::pid, agario::server::PlayerInfo> roster = {
+      { pid, { pid, agario::color::purple, "shown" } },
+    };
+
+    agario::SnapshotState<renderable> display(1000, 1000);
+    auto &state = display.show(entities, roster);
+    EXPECT_EQ(engine.get_game_state().pellet_count(), state.pellets.size());
+    EXPECT_EQ(engine.get_game_state().viruses.size(), state.viruses.size());
+    ASSERT_EQ(2, state.players.size());
+    EXPECT_EQ("shown", state.players.at(pid)->name());
+    EXPECT_EQ(agario::color::purple, state.players.at(pid)->color());
+    EXPECT_EQ(player.cells.size(), state.players.at(pid)->cells.size());
+    EXPECT_NEAR(player.x(), state.players.at(pid)->x(), 0.1);
+    EXPECT_EQ("unnamed", state.players.at(other)->name()); // not on the roster
+
+    // players without cells in view are left out
+    auto view = agario::server::capture(engine.get_game_state(), player.location(), 10);
+    display.show(view, roster);
+    EXPECT_EQ(1, state.players.count(pid));
+    EXPECT_EQ(0, state.players.count(other));
+  }
+
+  TEST(ClientTest, TripleBuffer) {
+    TripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.update());
+
+    buffer.back() = 1;
+    buffer.publish();
+    buffer.back() = 2;
+    buffer.publish();
+    ASSERT_TRUE(buffer.update());
+    EXPECT_EQ(2, buffer.front()); // only the newest value is seen
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(2, buffer.front());
+
+    buffer.back() = 3;
+    buffer.publish();
+    ASSERT_TRUE(buffer.update());
+    EXPECT_EQ(3, buffer.front());
+  }
+
+  /* values taken on one thread are whole and in order, as published on another */
+  TEST(ClientTest, TripleBufferThreads) {
+    TripleBuffer<std::vector<int>> buffer;
+    const int n = 20000;
+
+    std::thread producer([&] {
+      for (int i = 1; i <= n; i++) {
+        buffer.back().assign(16, i);
+        buffer.publish();
+      }
+    });
+
+    int last = 0;
+    while (last < n) {
+      if (!buffer.update()) continue;
+      auto &values = buffer.front();
+      ASSERT_EQ(16, values.size());
+      for (int v : values) ASSERT_EQ(values.front(), v);
+      ASSERT_GT(values.front(), last);
+      last = values.front();
+    }
+    producer.join();
+  }
+
+}
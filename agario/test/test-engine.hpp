@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 
 #include <agario/engine/Engine.hpp>
+#include <agario/bots/bots.hpp>
 #include <agario/test/renderable.hpp>
 
 namespace {
@@ -104,6 +105,434 @@ namespace {
     EXPECT_EQ(engine.pellet_regen(), pellet_regen) << "Pellet regeneration can't be set off";
   }
 
+  TEST(Engine, PelletRespawn) {
+    int num_pellets = 2000;
+    agario::Engine<renderable> engine(128, 128, num_pellets, 0);
+    engine.seed(1);
+    engine.reset();
+
+    // a huge cell in the middle of the arena eats many pellets at once
+    auto pid = engine.add_player<agario::Player<renderable>>("glutton");
+    auto &player = engine.player(pid);
+    player.kill();
+    player.add_cell(agario::Location(64, 64), 5000);
+    player.target = agario::Location(64, 64);
+    auto mass = player.mass();
+
+    agario::time_delta dt(0.01);
+    engine.tick(dt);
+    int eaten = player.mass() - mass;
+    ASSERT_GT(eaten, PELLET_RESPAWN_LIMIT * PELLET_RESPAWN_SPREAD);
+
+    // a burst bigger than PELLET_RESPAWN_LIMIT per tick over PELLET_RESPAWN_SPREAD ticks is respawned faster
+    auto budget = [](int backlog) {
+      return std::max(PELLET_RESPAWN_LIMIT, agario::div_round_up(backlog, PELLET_RESPAWN_SPREAD));
+    };
+    int backlog = eaten - budget(eaten);
+    EXPECT_EQ(engine.pellet_count(), num_pellets - backlog) << "Wrong number of pellets respawned in one tick";
+
+    // the rest are respawned over the following ticks
+    player.kill();
+    while (backlog > 0) {
+      engine.tick(dt);
+      backlog -= std::min(backlog, budget(backlog));
+      ASSERT_EQ(engine.pellet_count(), num_pellets - backlog);
+    }
+  }
+
+  /* however fast pellets are eaten, the number waiting to respawn stays bounded */
+  TEST(Engine, PelletRespawnSustained) {
+    int num_pellets = 50000;
+    agario::Engine<renderable> engine(1000, 1000, num_pellets, 0);
+    engine.seed(3);
+    engine.reset();
+
+    // a glutton lands somewhere new each tick, eating far more than PELLET_RESPAWN_LIMIT a tick
+    auto pid = engine.add_player<agario::Player<renderable>>("glutton");
+    auto &player = engine.player(pid);
+    agario::time_delta dt(1.0 / 60);
+    int num_ticks = 300, total_eaten = 0, most_eaten = 0, most_waiting = 0;
+    for (int i = 0; i < num_ticks; i++) {
+      player.kill();
+      player.add_cell(agario::Location(50 + (i * 97) % 900, 50 + (i * 31) % 900), 5000);
+      player.target = player.location();
+      engine.tick(dt);
+      int eaten = player.mass() - 5000;
+      total_eaten += eaten;
+      most_eaten = std::max(most_eaten, eaten);
+      most_waiting = std::max(most_waiting, num_pellets - engine.pellet_count());
+    }
+    ASSERT_GT(total_eaten, 4 * PELLET_RESPAWN_LIMIT * num_ticks);
+
+    // (with more than that waiting, more are respawned each tick than can be eaten)
+    EXPECT_LE(most_waiting, most_eaten * (PELLET_RESPAWN_SPREAD + 1))
+      << "More pellets are waiting to respawn than PELLET_RESPAWN_SPREAD ticks' worth of eating";
+
+    // and once nothing is eating them, they all come back
+    player.kill();
+    for (int i = 0; i < 100; i++)
+      engine.tick(dt);
+    EXPECT_EQ(engine.pellet_count(), num_pellets);
+  }
+
+  TEST(Engine, TickStats) {
+    agario::Engine<renderable> engine;
+    engine.seed(42);
+    engine.reset();
+    for (int i = 0; i < 10; i++)
+      engine.add_player<agario::Player<renderable>>("player");
+
+    int num_ticks = 50;
+    agario::time_delta dt(1.0 / 60);
+    for (int i = 0; i < num_ticks; i++)
+      engine.tick(dt);
+
+    auto &stats = engine.stats();
+    if (agario::TickStats::enabled) {
+      EXPECT_EQ(stats.ticks, num_ticks);
+      EXPECT_GT(stats.tick_seconds, 0);
+      EXPECT_EQ(stats.calls[agario::movement], 10 * num_ticks);
+      EXPECT_EQ(stats.calls[agario::bot_actions], num_ticks / 10); // one decision phase per decision tick
+
+      double phase_seconds = 0;
+      for (auto seconds : stats.seconds)
+        phase_seconds += seconds;
+      EXPECT_LE(phase_seconds, stats.tick_seconds) << "Phases overlap";
+
+      EXPECT_GE(stats.pellet_tests, 10ul * num_ticks * (DEFAULT_NUM_PELLETS - PELLET_RESPAWN_LIMIT));
+      EXPECT_EQ(stats.num_players, 10);
+      EXPECT_EQ(stats.num_pellets, engine.pellet_count());
+    } else {
+      EXPECT_EQ(stats.ticks, 0ul) << "Ticks profiled without ENGINE_PROFILING";
+      EXPECT_EQ(stats.pellet_tests, 0ul);
+    }
+
+    engine.reset_stats();
+    EXPECT_EQ(engine.stats().ticks, 0ul);
+  }
+
+  /* a bot of its own type, which counts its decisions */
+  class CountingBot : public agario::bot::HungryBot<renderable> {
+  public:
+    CountingBot(agario::pid pid, const std::string &name) : HungryBot(pid, name) {}
+    explicit CountingBot(agario::pid pid) : CountingBot(pid, "CountingBot") {}
+    void take_action(const agario::GameState<renderable> &state) override {
+      decisions++;
+      HungryBot::take_action(state);
+    }
+    int decisions = 0;
+  };
+
+  /* adds the same mix of bots to `engine`, returning the pid of the counting bot */
+  agario::pid add_deciding_bots(agario::Engine<renderable> &engine) {
+    using namespace agario::bot;
+    engine.seed(42);
+    engine.reset();
+    for (int i = 0; i < 10; i++) {
+      engine.add_player<HungryBot<renderable>>();
+      engine.add_player<HungryShyBot<renderable>>();
+      engine.add_player<AggressiveBot<renderable>>();
+      engine.add_player<AggressiveShyBot<renderable>>();
+    }
+    engine.add_player<agario::Player<renderable>>("agent");
+    return engine.add_player<CountingBot>();
+  }
+
+  /* deciding bots in parallel batches plays out exactly as deciding them in turn */
+  TEST(Engine, BatchedDecisions) {
+    agario::Engine<renderable> serial, parallel;
+    auto counting = add_deciding_bots(serial);
+    add_deciding_bots(parallel);
+
+    ThreadPool pool(4);
+    parallel.set_thread_pool(&pool, 4);
+
+    int num_ticks = 200;
+    agario::time_delta dt(1.0 / 60);
+    for (int i = 0; i < num_ticks; i++) {
+      serial.tick(dt);
+      parallel.tick(dt);
+    }
+
+    // bots of a type derived from another bot's still make their own decisions
+    auto &bot = dynamic_cast<CountingBot &>(serial.player(counting));
+    EXPECT_GT(bot.decisions, 0);
+    EXPECT_LE(bot.decisions, num_ticks / 10);
+
+    ASSERT_EQ(serial.player_count(), parallel.player_count());
+    for (auto &pair : serial.players()) {
+      auto &player = *pair.second;
+      auto &other = parallel.get_player(pair.first);
+      ASSERT_EQ(player.cells.size(), other.cells.size());
+      ASSERT_EQ(player.target, other.target);
+      ASSERT_EQ(player.mass(), other.mass());
+      if (!player.dead()) {
+        ASSERT_EQ(player.location(), other.location());
+      }
+    }
+  }
+
+  /* a tick with a parallel search plays out exactly as a serial one, down to the order of the pellets */
+  TEST(Engine, ArenaTiles) {
+    auto saved_state = [](const agario::Engine<renderable> &engine) {
+      std::stringstream ss;
+      engine.save_state(ss);
+      return ss.str();
+    };
+    ThreadPool pool(4);
+    for (bool procedural : { false, true }) {
+      for (auto tiles : { std::make_pair(1, 1), std::make_pair(3, 2), std::make_pair(8, 8) }) {
+        agario::Engine<renderable> serial(2000, 2000, 1000, 10, true, procedural);
+        agario::Engine<renderable> tiled(2000, 2000, 1000, 10, true, procedural);
+        std::srand(1); // for the same player colors
+        auto agent = add_deciding_bots(serial) - 1; // added just before the counting bot
+        std::srand(1);
+        add_deciding_bots(tiled);
+        tiled.set_thread_pool(&pool);
+        tiled.set_arena_tiles(tiles.first, tiles.second);
+        ASSERT_TRUE(tiled.tiled());
+
+        // a big cell overlapping a small one, across the middle of the arena, which it eats
+        agario::pid big = 0, small = 0;
+        for (auto *engine : { &serial, &tiled }) {
+          std::srand(2);
+          big = engine->add_player<agario::Player<renderable>>("big");
+          small = engine->add_player<agario::Player<renderable>>("small");
+          for (auto [pid, location, mass] : { std::make_tuple(big, agario::Location(985, 990), 3000),
+                                              std::make_tuple(small, agario::Location(1005, 1010), 30) }) {
+            auto &player = engine->player(pid);
+            player.kill();
+            player.add_cell(location, mass);
+            player.target = location;
+          }
+        }
+
+        agario::time_delta dt(1.0 / 60);
+        for (int i = 0; i < 600; i++) {
+          serial.tick(dt);
+          tiled.tick(dt);
+          if (i % 50 == 0) {
+            // the agent feeds and splits now and then, scattering food and cells
+            for (auto *engine : { &serial, &tiled }) {
+              auto &player = engine->player(agent);
+              player.action = i % 100 == 0 ? agario::action::feed : agario::action::split;
+            }
+          }
+          ASSERT_EQ(saved_state(serial), saved_state(tiled))
+                << "tick " << i << " of " << tiles.first << "x" << tiles.second << (procedural ? ", procedural" : "");
+        }
+
+        // players were eaten too, not just pellets and food
+        EXPECT_TRUE(serial.get_player(small).dead());
+        EXPECT_FALSE(serial.get_player(big).dead());
+      }
+    }
+
+    agario::Engine<renderable> engine;
+    EXPECT_THROW(engine.set_arena_tiles(-1, 2), agario::EngineException);
+    engine.set_arena_tiles(0, 0);
+    EXPECT_FALSE(engine.tiled());
+  }
+
+  /* big cells, each eating many pellets at once, leave the rest in the same order as when ticking serially */
+  TEST(Engine, ArenaTilesPelletOrder) {
+    std::stringstream states[2];
+    for (int tiled : { 0, 1 }) {
+      agario::Engine<renderable> engine(500, 500, 3000, 0, false);
+      engine.seed(5);
+      engine.reset();
+      std::srand(1);
+      if (tiled) engine.set_arena_tiles(2, 2);
+
+      for (int i = 0; i < 4; i++) {
+        auto &player = engine.player(engine.add_player<agario::Player<renderable>>());
+        player.kill();
+        player.add_cell(agario::Location(100 + 100 * i, 100 + 50 * i), 5000);
+        player.target = agario::Location(400 - 100 * i, 450);
+      }
+
+      for (int i = 0; i < 30; i++)
+        engine.tick(agario::time_delta(1.0 / 60));
+      EXPECT_LT(engine.get_game_state().pellets.size(), 2975);
+      engine.save_state(states[tiled]);
+    }
+    EXPECT_EQ(states[0].str(), states[1].str());
+  }
+
+  /* a cell that grows past the reach that collisions were looked for within still eats what it reaches */
+  TEST(Engine, ArenaTilesOutgrown) {
+    std::stringstream states[2];
+    for (int tiled : { 0, 1 }) {
+      agario::Engine<renderable> engine(1000, 1000, 0, 0, false);
+      engine.seed(7);
+      engine.reset();
+      std::srand(1);
+      if (tiled) engine.set_arena_tiles(4, 4);
+
+      // `big` eats `small` then `medium` (in order of pid), which brings `far` within its reach
+      agario::Location center(500, 500);
+      auto big = engine.add_player<agario::Player<renderable>>("big");
+      auto small = engine.add_player<agario::Player<renderable>>("small");
+      auto medium = engine.add_player<agario::Player<renderable>>("medium");
+      auto far = engine.add_player<agario::Player<renderable>>("far");
+      agario::mass masses[] = { 100, 80, 150, 20 };
+      agario::distance offsets[] = { 0, 0, 0, agario::radius_conversion(300) };
+      agario::pid pids[] = { big, small, medium, far };
+      for (int i = 0; i < 4; i++) {
+        auto &player = engine.player(pids[i]);
+        player.kill();
+        player.add_cell(agario::Location(center.x + offsets[i], center.y), masses[i]);
+        player.target = player.location();
+      }
+
+      engine.tick(agario::time_delta(1.0 / 60));
+      EXPECT_TRUE(engine.get_player(far).dead()) << (tiled ? "tiled" : "serial");
+      EXPECT_EQ(350, engine.get_player(big).mass());
+      engine.save_state(states[tiled]);
+    }
+    EXPECT_EQ(states[0].str(), states[1].str());
+  }
+
+  /* what the tiles can't settle alone is settled serially, as a serial tick would */
+  TEST(Engine, ArenaTilesSerialPass) {
+    std::stringstream states[2];
+    for (int tiled : { 0, 1 }) {
+      agario::Engine<renderable> engine(1000, 1000, 0, 0, false);
+      engine.seed(3);
+      engine.reset();
+      std::srand(1);
+      if (tiled) engine.set_arena_tiles(4, 4);
+
+      auto add = [&](agario::Location location, agario::mass mass) -> agario::Player<renderable> & {
+        auto &player = engine.player(engine.add_player<agario::Player<renderable>>());
+        player.kill();
+        player.add_cell(location, mass);
+        player.target = location;
+        return player;
+      };
+
+      // `popper` pops the first virus, moving the last into its place, which
+      // is then the first of the two that `torn` (settled inline) might pop
+      auto &viruses = engine.game_state().viruses;
+      viruses.emplace_back(agario::Location(103, 100));
+      viruses.emplace_back(agario::Location(403, 100));
+      viruses.emplace_back(agario::Location(397, 100));
+      auto &popper = add(agario::Location(100, 100), 200);
+      auto &torn = add(agario::Location(400, 100), 200);
+      popper.target = agario::Location(100, 300); // (moving, so that the cells popped off spread out)
+      torn.target = agario::Location(400, 300);
+
+      // `feeder` emits food which `eater`, after it in order of pid, eats in the same tick
+      auto &feeder = add(agario::Location(600, 600), 100);
+      feeder.target = agario::Location(900, 600);
+      feeder.action = agario::action::feed;
+      auto &eater = add(agario::Location(612, 600), 400);
+
+      // each pair of these cells can only collide once the group before has eaten the next
+      // (were any big enough), so the groups keep on growing until all pairs are checked
+      agario::distance x = 100;
+      for (int i = 0; i < 12; i++) {
+        add(agario::Location(x, 900), 100);
+        x += i == 0 ? agario::distance(3) : agario::radius_conversion((i + 1) * 100) + 0.5;
+      }
+
+      engine.tick(agario::time_delta(1.0 / 60));
+      ASSERT_EQ(1, viruses.size());
+      EXPECT_EQ(agario::Location(403, 100), viruses.front().location()) << "popped the wrong virus";
+      EXPECT_GT(torn.cells.size(), 1);
+      EXPECT_TRUE(engine.foods().empty());
+      EXPECT_GE(eater.mass(), 400 + FOOD_MASS);
+      if (tiled) {
+        EXPECT_GT(engine.tile_stats().settled_in_tiles, 0);
+        EXPECT_GT(engine.tile_stats().settled_serially, 0);
+      }
+
+      for (int i = 0; i < 10; i++)
+        engine.tick(agario::time_delta(1.0 / 60));
+      engine.save_state(states[tiled]);
+    }
+    EXPECT_EQ(states[0].str(), states[1].str());
+  }
+
+  /* staggered, the same number of decisions are spread evenly over the ticks */
+  TEST(Engine, BotScheduleStaggered) {
+    for (bool staggered : { false, true }) {
+      agario::Engine<renderable> engine(1000, 1000, 0, 0);
+      engine.seed(1);
+      engine.reset();
+      std::vector<agario::pid> bots;
+      for (int i = 0; i < 40; i++)
+        bots.push_back(engine.add_player<CountingBot>());
+
+      agario::BotSchedule schedule;
+      schedule.staggered = staggered;
+      engine.set_bot_schedule(schedule);
+      for (int i = 0; i < 100; i++)
+        engine.tick(agario::time_delta(1.0 / 60));
+
+      for (auto pid : bots)
+        EXPECT_EQ(10, dynamic_cast<CountingBot &>(engine.player(pid)).decisions);
+      auto &stats = engine.decision_stats();
+      EXPECT_EQ(100, stats.ticks);
+      EXPECT_DOUBLE_EQ(0.1, stats.rate());
+      EXPECT_DOUBLE_EQ(4, stats.per_tick());
+      EXPECT_EQ(staggered ? 4 : 40, stats.peak_decisions);
+    }
+
+    agario::Engine<renderable> engine;
+    agario::BotSchedule schedule;
+    schedule.distant_period = 15;
+    EXPECT_THROW(engine.set_bot_schedule(schedule), agario::EngineException);
+    schedule.period = 0;
+    EXPECT_THROW(engine.set_bot_schedule(schedule), agario::EngineException);
+  }
+
+  /* a bot which counts its decisions, and stays where it is */
+  class StillBot : public CountingBot {
+  public:
+    StillBot(agario::pid pid, const std::string &name) : CountingBot(pid, name) {}
+    explicit StillBot(agario::pid pid) : StillBot(pid, "StillBot") {}
+    void take_action(const agario::GameState<renderable> &) override {
+      decisions++;
+      target = location();
+    }
+  };
+
+  /* bots out of every agent's view, or with nothing near them, decide less often */
+  TEST(Engine, BotScheduleDistant) {
+    for (bool with_agent : { true, false }) {
+      agario::Engine<renderable> engine(1000, 1000, 0, 0);
+      engine.reset();
+      auto place = [&](agario::pid pid, agario::distance x, agario::distance y) {
+        auto &player = engine.player(pid);
+        player.kill();
+        player.add_cell(agario::Location(x, y), 10);
+        player.target = player.location();
+        return pid;
+      };
+
+      // with an agent, one bot is in its view (of 100 by 100, with a margin of 50)
+      // and one isn't, and without, the lone bot has nothing within 30 of it
+      if (with_agent) place(engine.add_player<agario::Player<renderable>>("agent"), 100, 100);
+      auto near = place(engine.add_player<StillBot>(), 190, 100);
+      auto neighbor = place(engine.add_player<StillBot>(), 210, 110);
+      auto far = place(engine.add_player<StillBot>(), 800, 800);
+
+      agario::BotSchedule schedule;
+      schedule.distant_period = 40;
+      schedule.idle_radius = with_agent ? 0 : 30;
+      engine.set_bot_schedule(schedule);
+      for (int i = 0; i < 80; i++)
+        engine.tick(agario::time_delta(1.0 / 60));
+
+      auto decisions = [&](agario::pid pid) { return dynamic_cast<StillBot &>(engine.player(pid)).decisions; };
+      EXPECT_EQ(8, decisions(near)) << with_agent;
+      EXPECT_EQ(with_agent ? 2 : 8, decisions(neighbor)) << with_agent;
+      EXPECT_EQ(2, decisions(far)) << with_agent;
+      EXPECT_EQ(with_agent ? 12 : 6, engine.decision_stats().deferred);
+    }
+  }
+
   TEST_F(EngineTest, Reset) {
     SetUp();
     agario::time_delta dt(0.1);
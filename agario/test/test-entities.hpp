@@ -5,6 +5,13 @@
 #include <agario/engine/Engine.hpp>
 #include <agario/test/renderable.hpp>
 
+#ifdef DETERMINISTIC
+// fixed-point positions are rounded to multiples of 2^-FIXED_POINT_FRACTION_BITS
+#define EXPECT_POSITION_EQ(val1, val2) EXPECT_NEAR(val1, val2, 1e-5)
+#else
+#define EXPECT_POSITION_EQ(val1, val2) EXPECT_FLOAT_EQ(val1, val2)
+#endif
+
 namespace {
 
   /* =========== Cell =========== */
@@ -48,8 +55,8 @@ namespace {
 
           cell.move(dt);
 
-          EXPECT_FLOAT_EQ(cell.x, dt * dx) << "Did not move to expected x position";
-          EXPECT_FLOAT_EQ(cell.y, dt * dy) << "Did not move to expected y position";
+          EXPECT_POSITION_EQ(cell.x, dt * dx) << "Did not move to expected x position";
+          EXPECT_POSITION_EQ(cell.y, dt * dy) << "Did not move to expected y position";
 
           EXPECT_FLOAT_EQ(cell.location().x, cell.x) << "Location x does not match cell.x";
           EXPECT_FLOAT_EQ(cell.location().y, cell.y) << "Location y does not match cell.y";
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <agario/core/fixed_point.hpp>
+#include <agario/core/math.hpp>
+#include <agario/engine/Engine.hpp>
+#include <agario/bots/bots.hpp>
+#include <agario/test/renderable.hpp>
+
+namespace {
+
+  using fixed = numWrapper<agario::fixed_point<FIXED_POINT_FRACTION_BITS>, agario::_distance>;
+  using fixed_angle = numWrapper<agario::fixed_point<FIXED_POINT_FRACTION_BITS>, agario::_angle>;
+
+  /* =========== Fixed-point arithmetic =========== */
+
+  TEST(FixedPoint, Conversion) {
+    for (float v : {0.0f, 1.0f, -1.0f, 3.25f, -1234.5f, 19999.75f}) {
+      fixed f = v;
+      EXPECT_FLOAT_EQ(static_cast<float>(f), v) << "Exactly representable value not preserved";
+    }
+    fixed i = 42;
+    EXPECT_EQ(i.raw(), 42 * fixed::one) << "Integer conversion incorrect";
+  }
+
+  TEST(FixedPoint, Arithmetic) {
+    for (int i = -10; i < 10; i++) {
+      float a = i * 1.7f + 0.3f;
+      float b = 2.5f - i * 0.9f;
+      fixed fa = a, fb = b;
+
+      EXPECT_NEAR(fa + fb, a + b, 1e-5);
+      EXPECT_NEAR(fa - fb, a - b, 1e-5);
+      EXPECT_NEAR(fa * fb, a * b, 1e-4);
+      EXPECT_NEAR(fa / fb, a / b, 1e-4);
+      EXPECT_NEAR(fa * 3, a * 3, 1e-5);
+      EXPECT_NEAR(2.0 * fb, 2.0 * b, 1e-5);
+      EXPECT_EQ(fa < fb, a < b) << "Bad comparison";
+      EXPECT_EQ(fa > 0, a > 0) << "Bad comparison with constant";
+    }
+  }
+
+  TEST(FixedPoint, DivideByZero) {
+    fixed zero = 0;
+    EXPECT_EQ(fixed(1) / zero, fixed::max());
+    EXPECT_EQ(fixed(-1) / zero, -fixed::max());
+    EXPECT_EQ(zero / zero, zero);
+  }
+
+  /* =========== Deterministic math =========== */
+
+  TEST(FixedPoint, Sqrt) {
+    for (float v = 0; v < 5000; v += 12.34) {
+      fixed f = v;
+      EXPECT_NEAR(agario::math::sqrt(f), std::sqrt(static_cast<float>(f)), 1e-5) << "sqrt(" << v << ")";
+    }
+    EXPECT_EQ(agario::math::sqrt(fixed(16)), fixed(4)) << "sqrt of perfect square not exact";
+  }
+
+  TEST(FixedPoint, Trigonometry) {
+    for (float theta = -20; theta < 20; theta += 0.05) {
+      fixed_angle a = theta;
+      EXPECT_NEAR(agario::math::sin(a), std::sin(static_cast<float>(a)), 1e-4) << "sin(" << theta << ")";
+      EXPECT_NEAR(agario::math::cos(a), std::cos(static_cast<float>(a)), 1e-4) << "cos(" << theta << ")";
+    }
+    for (float x = -100; x < 100; x += 0.37) {
+      fixed f = x;
+      EXPECT_NEAR(agario::math::atan(f), std::atan(static_cast<float>(f)), 1e-4) << "atan(" << x << ")";
+    }
+  }
+
+  TEST(FixedPoint, Pow) {
+    for (float x = 0.05; x < 100; x += 0.77) {
+      fixed f = x;
+      float expected = std::pow(static_cast<float>(f), 1.2f);
+      EXPECT_NEAR(agario::math::pow(f, 1.2), expected, 1e-4 * std::max(1.0f, expected)) << "pow(" << x << ", 1.2)";
+    }
+  }
+
+  /* =========== Reproducibility =========== */
+
+  /* the same seed must produce exactly the same game */
+  TEST(Determinism, SameSeedSameGame) {
+    using HungryBot = agario::bot::HungryBot<renderable>;
+    using AggressiveBot = agario::bot::AggressiveBot<renderable>;
+
+    agario::Engine<renderable> engine1, engine2;
+    agario::Engine<renderable> *engines[] = {&engine1, &engine2};
+
+    for (auto *engine : engines) {
+      engine->seed(1234);
+      engine->reset();
+      for (int i = 0; i < 5; i++) {
+        engine->add_player<HungryBot>();
+        engine->add_player<AggressiveBot>();
+      }
+    }
+
+    agario::time_delta dt(1.0 / 60);
+    for (int t = 0; t < 500; t++) {
+      engine1.tick(dt);
+      engine2.tick(dt);
+    }
+
+    ASSERT_EQ(engine1.pellet_count(), engine2.pellet_count());
+    for (int i = 0; i < engine1.pellet_count(); i++) {
+      ASSERT_EQ(engine1.pellets()[i].x, engine2.pellets()[i].x);
+      ASSERT_EQ(engine1.pellets()[i].y, engine2.pellets()[i].y);
+    }
+
+    for (auto &pair : engine1.players()) {
+      auto &p1 = *pair.second;
+      auto &p2 = engine2.get_player(pair.first);
+      ASSERT_EQ(p1.cells.size(), p2.cells.size());
+      for (unsigned c = 0; c < p1.cells.size(); c++) {
+        ASSERT_EQ(p1.cells[c].x, p2.cells[c].x);
+        ASSERT_EQ(p1.cells[c].y, p2.cells[c].y);
+        ASSERT_EQ(p1.cells[c].mass(), p2.cells[c].mass());
+      }
+    }
+  }
+
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <set>
+
+#include <agario/engine/PelletField.hpp>
+#include <agario/engine/Engine.hpp>
+#include <agario/bots/HungryBot.hpp>
+#include <agario/test/renderable.hpp>
+
+namespace {
+
+  /* counts the pellets of `field` inside the box [lower, upper] */
+  int count_pellets(const agario::PelletField &field,
+                    const agario::Location &lower, const agario::Location &upper) {
+    int count = 0;
+    field.for_each(lower, upper, [&](const agario::Location &) { count++; });
+    return count;
+  }
+
+  TEST(PelletField, Configure) {
+    agario::PelletField field;
+    EXPECT_TRUE(field.empty());
+
+    int num_pellets = 1000;
+    field.configure(500, 300, num_pellets, 42);
+    EXPECT_FALSE(field.empty());
+    EXPECT_EQ(field.count(), num_pellets);
+    EXPECT_EQ(field.capacity(), num_pellets);
+    EXPECT_LE(num_pellets, field.num_regions() * agario::PelletField::max_slots);
+
+    agario::Location lower(0, 0);
+    agario::Location upper(500, 300);
+    EXPECT_EQ(count_pellets(field, lower, upper), num_pellets);
+
+    field.clear();
+    EXPECT_TRUE(field.empty());
+    EXPECT_EQ(field.count(), 0);
+    EXPECT_EQ(count_pellets(field, lower, upper), 0);
+  }
+
+  TEST(PelletField, Reproducible) {
+    agario::PelletField field1, field2, field3;
+    field1.configure(200, 200, 500, 7);
+    field2.configure(200, 200, 500, 7);
+    field3.configure(200, 200, 500, 8);
+
+    agario::Location lower(0, 0);
+    agario::Location upper(200, 200);
+    std::vector<agario::Location> locs1, locs2, locs3;
+    field1.for_each(lower, upper, [&](const agario::Location &loc) { locs1.push_back(loc); });
+    field2.for_each(lower, upper, [&](const agario::Location &loc) { locs2.push_back(loc); });
+    field3.for_each(lower, upper, [&](const agario::Location &loc) { locs3.push_back(loc); });
+
+    EXPECT_EQ(locs1, locs2) << "Same seed should lay out the same pellets";
+    EXPECT_NE(locs1, locs3) << "Different seeds should lay out different pellets";
+  }
+
+  TEST(PelletField, Query) {
+    agario::PelletField field;
+    field.configure(1000, 1000, 10000, 42);
+
+    // a query only returns pellets inside of the box
+    agario::Location lower(100, 200);
+    agario::Location upper(150, 260);
+    int count = 0;
+    field.for_each(lower, upper, [&](const agario::Location &loc) {
+      EXPECT_GE(loc.x, lower.x);
+      EXPECT_LE(loc.x, upper.x);
+      EXPECT_GE(loc.y, lower.y);
+      EXPECT_LE(loc.y, upper.y);
+      count++;
+    });
+
+    // roughly uniform density (expect 10000 * 0.003 = 30)
+    EXPECT_GT(count, 10);
+    EXPECT_LT(count, 60);
+
+    // nearest pellet agrees with a search of the whole field
+    agario::Location center(123, 456);
+    agario::Location nearest;
+    ASSERT_TRUE(field.nearest(center, nearest));
+
+    auto best = agario::distance::max();
+    field.for_each(agario::Location(0, 0), agario::Location(1000, 1000), [&](const agario::Location &loc) {
+      best = std::min(best, loc.distance_to(center));
+    });
+    EXPECT_EQ(nearest.distance_to(center), best);
+  }
+
+  TEST(PelletField, EatAndRegenerate) {
+    agario::PelletField field;
+    int num_pellets = 1000;
+    field.configure(500, 500, num_pellets, 42, 10);
+
+    agario::Location lower(0, 0);
+    agario::Location upper(250, 250);
+    auto quarter = count_pellets(field, lower, upper);
+
+    auto eaten = field.eat(lower, upper, [](const agario::Location &) { return true; }, 0);
+    EXPECT_EQ(eaten, quarter);
+    EXPECT_EQ(field.count(), num_pellets - quarter);
+    EXPECT_EQ(count_pellets(field, lower, upper), 0);
+
+    // eaten pellets stay eaten until the respawn timers expire
+    EXPECT_EQ(field.eat(lower, upper, [](const agario::Location &) { return true; }, 1), 0);
+    field.regenerate(9);
+    EXPECT_EQ(field.count(), num_pellets - quarter);
+
+    field.regenerate(10);
+    EXPECT_EQ(field.count(), num_pellets);
+    agario::Location all(500, 500);
+    EXPECT_EQ(count_pellets(field, agario::Location(0, 0), all), num_pellets);
+  }
+
+  /* only eaten pellets are re-laid, at new locations, and the others stay where they were */
+  TEST(PelletField, RegenerateEatenOnly) {
+    agario::PelletField field;
+    int num_pellets = 1000;
+    field.configure(500, 500, num_pellets, 42, 10);
+
+    agario::Location origin(0, 0), all(500, 500);
+    auto locations = [&] {
+      std::set<std::pair<float, float>> found;
+      field.for_each(origin, all, [&](const agario::Location &loc) { found.emplace(static_cast<float>(loc.x), static_cast<float>(loc.y)); });
+      return found;
+    };
+    auto before = locations();
+
+    std::set<std::pair<float, float>> eaten;
+    int n = 0;
+    field.eat(origin, all, [&](const agario::Location &loc) {
+      if (n++ % 3 != 0) return false;
+      eaten.emplace(static_cast<float>(loc.x), static_cast<float>(loc.y));
+      return true;
+    }, 0);
+    field.regenerate(10);
+    ASSERT_EQ(field.count(), num_pellets);
+
+    auto after = locations();
+    int kept = 0, moved = 0;
+    for (auto &loc : before)
+      (after.count(loc) ? kept : moved)++;
+    EXPECT_EQ(num_pellets - static_cast<int>(eaten.size()), kept);
+    EXPECT_EQ(eaten.size(), moved);
+    for (auto &loc : eaten)
+      EXPECT_EQ(0, after.count(loc));
+  }
+
+  TEST(PelletField, Engine) {
+    int num_pellets = 20000;
+    agario::Engine<renderable> engine(2000, 2000, num_pellets, 0, true, true);
+    engine.seed(42);
+    engine.reset();
+
+    EXPECT_TRUE(engine.procedural_pellets());
+    EXPECT_EQ(engine.pellet_count(), num_pellets);
+    EXPECT_TRUE(engine.pellets().empty()) << "Procedural pellets should not be stored";
+
+    auto pid = engine.add_player<agario::bot::HungryBot<renderable>>();
+    auto &player = engine.player(pid);
+    auto mass = player.mass();
+
+    // tick until the first pellets are eaten (before any could be regenerated)
+    agario::time_delta dt(1.0 / 60);
+    for (int i = 0; i < 1000 && engine.pellet_count() == num_pellets; i++)
+      engine.tick(dt);
+
+    ASSERT_GT(player.mass(), mass) << "Player didn't eat any procedural pellets";
+    EXPECT_EQ(player.mass() - mass, num_pellets - engine.pellet_count())
+      << "Player mass should grow by the number of pellets eaten";
+
+    for (int i = 0; i <= PELLET_RESPAWN_TICKS; i++)
+      engine.tick(dt);
+    EXPECT_GT(engine.pellet_count(), num_pellets - static_cast<int>(player.mass() - mass))
+      << "Eaten pellets were not regenerated";
+  }
+
+}
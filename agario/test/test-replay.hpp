@@ -0,0 +1,136 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <agario/engine/Engine.hpp>
+#include <agario/engine/Replay.hpp>
+#include <agario/bots/bots.hpp>
+#include <agario/test/renderable.hpp>
+
+namespace {
+
+  std::string saved_state(const agario::Engine<renderable> &engine) {
+    std::stringstream ss;
+    engine.save_state(ss);
+    return ss.str();
+  }
+
+  std::string read_file(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  /**
+   * Records a game between bots (respawning one of them part of the way through)
+   * to `path`, returning the saved state of the game before each tick
+   */
+  std::vector<std::string> record_game(const std::string &path, bool procedural_pellets,
+                                       int num_ticks, int keyframe_interval) {
+    agario::Engine<renderable> engine(DEFAULT_ARENA_WIDTH, DEFAULT_ARENA_HEIGHT,
+                                      DEFAULT_NUM_PELLETS, DEFAULT_NUM_VIRUSES, true, procedural_pellets);
+    engine.seed(42);
+    engine.reset();
+    engine.add_player<agario::bot::HungryBot<renderable>>();
+    engine.add_player<agario::bot::HungryShyBot<renderable>>();
+    engine.add_player<agario::bot::AggressiveBot<renderable>>();
+    auto pid = engine.add_player<agario::bot::AggressiveShyBot<renderable>>();
+
+    std::vector<std::string> states;
+    agario::ReplayRecorder<renderable> recorder(engine, path, keyframe_interval);
+    agario::time_delta dt(1.0 / 60);
+    for (int t = 0; t < num_ticks; t++) {
+      if (t == num_ticks / 2 + 1)
+        engine.respawn(pid);
+      states.emplace_back(saved_state(engine));
+      engine.tick(dt);
+    }
+    states.emplace_back(saved_state(engine));
+    EXPECT_EQ(recorder.ticks(), num_ticks);
+    return states;
+  }
+
+  TEST(Replay, SaveLoadState) {
+    agario::Engine<renderable> engine;
+    engine.seed(7);
+    engine.reset();
+    engine.add_player<agario::bot::HungryBot<renderable>>();
+    for (int t = 0; t < 100; t++)
+      engine.tick(agario::time_delta(1.0 / 60));
+
+    auto state = saved_state(engine);
+    agario::Engine<renderable> copy;
+    std::istringstream is(state);
+    copy.load_state(is);
+    EXPECT_EQ(saved_state(copy), state);
+    EXPECT_EQ(copy.ticks(), engine.ticks());
+    EXPECT_EQ(copy.player_count(), engine.player_count());
+    EXPECT_EQ(copy.pellet_count(), engine.pellet_count());
+
+    std::istringstream truncated(state.substr(0, state.size() / 2));
+    EXPECT_THROW(copy.load_state(truncated), agario::binary::FormatException);
+  }
+
+  TEST(Replay, Seek) {
+    for (bool procedural : { false, true }) {
+      auto path = testing::TempDir() + "agario-replay-test.bin";
+      int num_ticks = 300;
+      auto states = record_game(path, procedural, num_ticks, 50);
+
+      agario::ReplayReader<renderable> reader(path);
+      ASSERT_EQ(reader.ticks(), num_ticks);
+      EXPECT_EQ(reader.engine().procedural_pellets(), procedural);
+
+      // periodic keyframes, plus one after the respawn
+      auto &keyframes = reader.keyframes_index();
+      EXPECT_EQ(keyframes.size(), num_ticks / 50 + 1);
+
+      // forwards, backwards, within and across keyframes, and the respawn
+      for (int tick : { 0, 1, 37, 50, 151, 152, 299, 120, 3, 300, 200, 201 }) {
+        reader.seek(tick);
+        EXPECT_EQ(reader.tick(), tick);
+        EXPECT_TRUE(saved_state(reader.engine()) == states[tick])
+          << "Replay diverged at tick " << tick << (procedural ? " (procedural pellets)" : "");
+      }
+
+      reader.seek(290);
+      int steps = 0;
+      while (reader.step()) steps++;
+      EXPECT_EQ(steps, 10);
+      EXPECT_TRUE(saved_state(reader.engine()) == states[num_ticks]);
+
+      EXPECT_THROW(reader.seek(num_ticks + 1), agario::ReplayException);
+      std::remove(path.c_str());
+    }
+  }
+
+  TEST(Replay, Unfinished) {
+    auto path = testing::TempDir() + "agario-replay-unfinished.bin";
+    int num_ticks = 120;
+    auto states = record_game(path, false, num_ticks, 50);
+
+    // lose the index and part of the last tick, as if the recording program crashed
+    auto contents = read_file(path);
+    auto index_size = 1 + 2 * 8 + 2 * 8 * 4 + 8 + 4; // 4 keyframes (with the respawn)
+    std::ofstream(path, std::ios::binary).write(contents.data(), contents.size() - index_size - 5);
+
+    agario::ReplayReader<renderable> reader(path);
+    EXPECT_EQ(reader.ticks(), num_ticks - 1);
+    reader.seek(num_ticks - 1);
+    EXPECT_TRUE(saved_state(reader.engine()) == states[num_ticks - 1]);
+    std::remove(path.c_str());
+  }
+
+  TEST(Replay, InvalidFile) {
+    auto path = testing::TempDir() + "agario-replay-invalid.bin";
+    std::ofstream(path) << "not a replay";
+    EXPECT_THROW(agario::ReplayReader<renderable> reader(path), agario::ReplayException);
+    EXPECT_THROW(agario::ReplayReader<renderable> reader(path + ".missing"), agario::ReplayException);
+    std::remove(path.c_str());
+  }
+
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <agario/client/RemoteGame.hpp>
+#include <agario/server/Server.hpp>
+#include <agario/server/ServerConnection.hpp>
+#include <agario/test/renderable.hpp>
+#include <utils/spsc-queue.h>
+
+namespace {
+
+  using namespace agario::server;
+
+  /* a snapshot of up to `size` random entities, on the grid */
+  Snapshot random_snapshot(std::mt19937 &rng, int size) {
+    std::uniform_int_distribution<int> kind(agario::server::pellet, agario::server::cell);
+    std::uniform_int_distribution<std::uint64_t> id(0, 50);
+    std::uniform_int_distribution<std::int32_t> position(0, 100 * grid_resolution);
+    std::uniform_int_distribution<agario::mass> mass(1, 5000);
+
+    Snapshot snapshot;
+    for (int i = 0; i < size; i++) {
+      auto k = static_cast<entity_kind>(kind(rng));
+      auto x = position(rng), y = position(rng);
+      if (k == agario::server::pellet)
+        snapshot.push_back({ k, pellet_id(x, y), from_grid(x), from_grid(y), PELLET_MASS });
+      else
+        snapshot.push_back({ k, id(rng), from_grid(x), from_grid(y), i % 2 ? mass(rng) : default_mass(k) });
+    }
+    std::sort(snapshot.begin(), snapshot.end());
+    snapshot.erase(std::unique(snapshot.begin(), snapshot.end(),
+                               [](const EntityState &a, const EntityState &b) { return a.key() == b.key(); }),
+                   snapshot.end());
+    return snapshot;
+  }
+
+  TEST(ServerTest, DeltaRoundTrip) {
+    std::mt19937 rng(42);
+    for (int trial = 0; trial < 100; trial++) {
+      auto base = random_snapshot(rng, trial);
+      auto current = random_snapshot(rng, 100 - trial);
+
+      // keep some of the base unchanged, and change only some fields of others
+      for (std::size_t i = 0; i < base.size(); i += 3) {
+        auto entity = base[i];
+        if (i % 2 == 0 && entity.kind != agario::server::pellet) entity.x = snap(entity.x + 1);
+        if (!std::binary_search(current.begin(), current.end(), entity))
+          current.insert(std::lower_bound(current.begin(), current.end(), entity), entity);
+      }
+
+      for (auto *from : { &base, &current }) {
+        BitWriter out;
+        write_delta(out, *from, current);
+        auto bytes = out.bytes();
+        BitReader in(bytes);
+        ASSERT_EQ(current, read_delta(in, *from));
+      }
+
+      BitWriter out;
+      write_delta(out, Snapshot(), current);
+      auto bytes = out.bytes();
+      BitReader in(bytes);
+      ASSERT_EQ(current, read_delta(in, Snapshot()));
+
+      if (!current.empty()) {
+        auto truncated_bytes = bytes.substr(0, bytes.size() - 1);
+        BitReader truncated(truncated_bytes);
+        ASSERT_THROW(read_delta(truncated, Snapshot()), agario::binary::FormatException);
+      }
+    }
+  }
+
+  /* a server and scripted clients over loopback */
+  TEST(ServerTest, Loopback) {
+    Server<renderable> server(0, 1000, 1000, 500, 5, 4);
+    server.engine().seed(42);
+
+    // moves toward a target and acknowledges every snapshot
+    ServerConnection mover("127.0.0.1", server.port());
+    mover.join("mover");
+
+    // never sends input, so never acknowledges a snapshot
+    ServerConnection idle("127.0.0.1", server.port());
+    idle.join("idle");
+
+    auto quitter = std::make_unique<ServerConnection>("127.0.0.1", server.port());
+    quitter->join("quitter");
+
+    std::uint64_t mover_bytes = 0, idle_bytes = 0;
+    for (int step = 0; step < 60; step++) {
+      server.step();
+
+      for (auto *client : { &mover, &idle }) {
+        auto received = client->bytes_received();
+        ASSERT_TRUE(client->receive());
+        ASSERT_TRUE(client->joined());
+        ASSERT_EQ(server.engine().ticks(), client->tick());
+        if (step > 0)
+          (client == &mover ? mover_bytes : idle_bytes) += client->bytes_received() - received;
+        ASSERT_EQ(server.engine().player_count(), client->players().size());
+
+        auto &player = server.engine().get_player(client->welcome().pid);
+        ASSERT_EQ(capture(server.engine().get_game_state(), player), client->snapshot()) << "step " << step;
+        ASSERT_FALSE(client->snapshot().empty());
+      }
+
+      if (step == 10) {
+        ASSERT_EQ(3, server.num_clients());
+        quitter->close();
+      }
+      mover.send_input(900, 900, agario::action::none);
+    }
+    ASSERT_EQ(2, server.num_clients());
+    ASSERT_EQ(4 + 2, server.engine().player_count());
+    ASSERT_EQ("mover", server.engine().get_player(mover.welcome().pid).name());
+    ASSERT_EQ("idle", mover.players().at(idle.welcome().pid).name);
+
+    // deltas are smaller than complete snapshots
+    ASSERT_LT(mover_bytes, idle_bytes);
+    ASSERT_FLOAT_EQ(1000, mover.welcome().arena_width);
+  }
+
+  /* an action is performed even if the input after it (in the same tick) has none */
+  TEST(ServerTest, ActionsKept) {
+    Server<renderable> server(0, 1000, 1000, 0, 0, 0);
+    ServerConnection client("127.0.0.1", server.port());
+    client.join("splitter");
+    server.step();
+    ASSERT_TRUE(client.receive());
+
+    auto &player = server.engine().player(client.welcome().pid);
+    player.cells.front().set_mass(1000);
+    client.send_input(500, 500, agario::action::split);
+    client.send_input(500, 500, agario::action::none);
+    server.step();
+    EXPECT_EQ(2, player.cells.size());
+    EXPECT_EQ(agario::action::none, player.action); // and not performed again
+  }
+
+  /* the local player moves as soon as input is given, and stays close to the server's */
+  TEST(ServerTest, Prediction) {
+    Server<renderable> server(0, 1000, 1000, 5000, 5, 2);
+    agario::RemoteGame<renderable> game("127.0.0.1", server.port(), "predicted");
+    server.step();
+    ASSERT_TRUE(game.wait_for_snapshot());
+    ASSERT_EQ("predicted", game.connection().players().at(game.pid()).name);
+
+    // display at twice the tick rate
+    agario::time_delta dt(0.5 / server.tick_rate());
+    auto spawn = game.player().location();
+    agario::Location target(spawn.x < 500 ? 990 : 10, spawn.y < 500 ? 990 : 10);
+    for (int frame = 0; frame < 60; frame++) {
+      if (server.engine().player(game.pid()).dead()) break;
+
+      auto before = game.player().location();
+      game.update(target, agario::action::none, dt);
+      auto after = game.player().location();
+      ASSERT_GT(before.distance_to(target), after.distance_to(target)) << "frame " << frame;
+
+      if (frame % 2 == 1) {
+        server.step();
+        ASSERT_LE(game.pending_inputs(), 3);
+      }
+    }
+
+    // ahead of the server, by about the inputs it hadn't applied
+    game.update(target, agario::action::none, dt);
+    auto &authoritative = server.engine().get_player(game.pid());
+    ASSERT_LT(game.player().location().distance_to(target), authoritative.location().distance_to(target));
+    ASSERT_LT(game.player().location().distance_to(authoritative.location()), 20);
+    ASSERT_LT(game.prediction_error(), 5);
+
+    // everything else comes from the snapshots
+    auto remote = game.remote_entities();
+    ASSERT_FALSE(remote.empty());
+    for (auto &entity : remote)
+      ASSERT_FALSE(entity.kind == agario::server::cell && cell_owner(entity) == game.pid());
+
+    auto &state = game.state();
+    ASSERT_FALSE(state.pellets.empty());
+    ASSERT_FALSE(state.players.at(game.pid())->dead());
+  }
+
+  TEST(ServerTest, SPSCQueue) {
+    SPSCQueue<int> queue(8);
+    int value;
+    ASSERT_FALSE(queue.pop(value));
+    for (int i = 0; i < 8; i++)
+      ASSERT_TRUE(queue.push(int(i)));
+    ASSERT_FALSE(queue.push(8));
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(0, value);
+    ASSERT_THROW(SPSCQueue<int>(6), std::invalid_argument);
+
+    // values arrive in order across threads
+    SPSCQueue<std::string> strings(64);
+    constexpr int count = 100000;
+    std::thread producer([&]() {
+      for (int i = 0; i < count; i++) {
+        auto s = std::to_string(i);
+        while (!strings.push(std::move(s))) std::this_thread::yield();
+      }
+    });
+    std::string s;
+    for (int i = 0; i < count; i++) {
+      while (!strings.pop(s)) std::this_thread::yield();
+      ASSERT_EQ(std::to_string(i), s);
+    }
+    producer.join();
+  }
+
+  TEST(ServerTest, SlabChain) {
+    SlabPool pool;
+    std::string bytes;
+    for (std::size_t i = 0; i < 3 * slab_size; i++)
+      bytes += static_cast<char>(i * 7);
+    {
+      SlabChain chain(pool);
+      chain.append(bytes.data(), 100);
+      chain.append(bytes.data() + 100, bytes.size() - 100);
+      ASSERT_EQ(bytes.size(), chain.size());
+      ASSERT_EQ(3, pool.allocated());
+
+      chain.consume(slab_size + 10);
+      ASSERT_EQ(1, pool.available()); // the emptied slab went back to the pool
+
+      iovec iov[4];
+      int count = chain.gather(iov, 4);
+      std::string gathered;
+      for (int i = 0; i < count; i++)
+        gathered.append(static_cast<char *>(iov[i].iov_base), iov[i].iov_len);
+      ASSERT_EQ(bytes.substr(slab_size + 10), gathered);
+    }
+    ASSERT_EQ(3, pool.available());
+  }
+
+  /* with the network on its own thread, many clients can play at once */
+  TEST(ServerTest, NetworkThread) {
+    Server<renderable> server(0, 1000, 1000, 200, 5, 2, 100);
+    std::thread thread([&]() { server.run(); });
+
+    std::vector<std::unique_ptr<ServerConnection>> clients;
+    for (int i = 0; i < 50; i++) {
+      clients.emplace_back(std::make_unique<ServerConnection>("127.0.0.1", server.port()));
+      clients.back()->join("client " + std::to_string(i));
+    }
+
+    for (int round = 0; round < 10; round++) {
+      for (auto &client : clients) {
+        ASSERT_TRUE(client->receive(5000));
+        client->send_input(500, 500, agario::action::none);
+      }
+    }
+    for (auto &client : clients) {
+      ASSERT_TRUE(client->joined());
+      ASSERT_FALSE(client->snapshot().empty());
+    }
+
+    clients.resize(25);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (server.num_clients() != 25 && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    server.stop();
+    thread.join();
+    ASSERT_EQ(25, server.num_clients());
+  }
+
+  TEST(ServerTest, InvalidClient) {
+    Server<renderable> server(0, 1000, 1000, 100, 0, 0);
+    int fd = connect_socket("127.0.0.1", server.port());
+    std::string garbage(16, '\xff');
+    ::send(fd, garbage.data(), garbage.size(), MSG_NOSIGNAL);
+
+    server.step();
+    server.step();
+    ASSERT_EQ(0, server.num_clients());
+
+    char c;
+    ASSERT_EQ(0, ::recv(fd, &c, 1, 0)); // disconnected by the server
+    ::close(fd);
+  }
+
+}
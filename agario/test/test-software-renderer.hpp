@@ -0,0 +1,152 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <agario/rendering/SoftwareRenderer.hpp>
+#include <agario/engine/Engine.hpp>
+#include <agario/test/renderable.hpp>
+
+#include <array>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  using Pixel = std::array<std::uint8_t, 3>;
+
+  /* a rendered frame, with screen coordinates from the bottom left */
+  class Frame {
+  public:
+    Frame(int width, int height) : width(width), height(height), data(width * height * 3) {}
+
+    Pixel at(int x, int y) const {
+      auto p = &data[(y * width + x) * 3];
+      return { p[0], p[1], p[2] };
+    }
+
+    int width, height;
+    std::vector<std::uint8_t> data;
+  };
+
+  Pixel color_pixel(agario::color c) {
+    auto values = agario::color_values(c);
+    Pixel p;
+    for (int i = 0; i < 3; i++)
+      p[i] = static_cast<std::uint8_t>(std::lround(values[i] * 255));
+    return p;
+  }
+
+  const Pixel white = { 255, 255, 255 };
+
+  class SoftwareRendererTest : public ::testing::Test {
+  protected:
+    using Player = agario::Player<renderable>;
+
+    SoftwareRendererTest() : state(1000, 1000), frame(192, 128) {
+      player = std::make_shared<Player>(0, "player", agario::color::red);
+      player->add_cell(agario::Location(540, 540), 200);
+      state.players[player->pid()] = player;
+    }
+
+    /* the screen position of a world location */
+    std::pair<int, int> screen(float x, float y) {
+      auto scale = frame.height / (2 * agario::view_half_height(agario::camera_z(player->mass())));
+      return { static_cast<int>(frame.width / 2 + (x - player->x()) * scale),
+               static_cast<int>(frame.height / 2 + (y - player->y()) * scale) };
+    }
+
+    void render() {
+      agario::SoftwareRenderer<renderable> renderer(frame.width, frame.height, 1000, 1000);
+      renderer.render_screen(*player, state, frame.data.data());
+    }
+
+    agario::GameState<renderable> state;
+    std::shared_ptr<Player> player;
+    Frame frame;
+  };
+
+  TEST_F(SoftwareRendererTest, Player) {
+    render();
+
+    // centered on the player, with white around it
+    EXPECT_EQ(color_pixel(agario::color::red), frame.at(frame.width / 2, frame.height / 2));
+    EXPECT_EQ(white, frame.at(2, 2));
+    EXPECT_EQ(white, frame.at(frame.width - 3, frame.height - 3));
+
+    // the grid lines at x = 500 and y = 500 cross the screen left of and below the player
+    auto [x, y] = screen(500, 500);
+    ASSERT_TRUE(0 < x && x < frame.width / 2 && 0 < y && y < frame.height / 2);
+    Pixel grid = { 26, 26, 26 };
+    EXPECT_EQ(grid, frame.at(x, 2));
+    EXPECT_EQ(grid, frame.at(2, y));
+  }
+
+  TEST_F(SoftwareRendererTest, Orientation) {
+    // the arena's y axis points up the screen, whose bottom row comes first
+    state.viruses.emplace_back(agario::Location(570, 580));
+    render();
+
+    auto [x, y] = screen(570 + 3, 580 + 3);
+    EXPECT_GT(x, frame.width / 2);
+    EXPECT_GT(y, frame.height / 2);
+    EXPECT_EQ(color_pixel(agario::color::green), frame.at(x, y));
+
+    // drawn over the player
+    auto [px, py] = screen(570, 580 - 5);
+    EXPECT_EQ(color_pixel(agario::color::green), frame.at(px, py));
+  }
+
+  TEST_F(SoftwareRendererTest, Pellets) {
+    // pellets (big enough to cover a pixel at this size), whether stored or
+    // procedural, are drawn within view and not out of it
+    state.pellets.emplace_back(agario::Location(540, 560));
+    state.pellets.emplace_back(agario::Location(50, 50));
+    state.pellet_field.configure(1000, 1000, 20000, 42);
+    render();
+
+    auto [x, y] = screen(540, 560);
+    EXPECT_NE(white, frame.at(x, y));
+
+    int colored = 0;
+    for (int i = 0; i < frame.width; i++)
+      for (int j = 0; j < frame.height; j++)
+        if (frame.at(i, j) != white) colored++;
+    EXPECT_GT(colored, 10);
+
+    state.pellets.pop_back(); // the one out of view
+    auto before = frame.data;
+    render();
+    EXPECT_EQ(before, frame.data);
+  }
+
+  /* threads may render from one renderer (into their own frames) at once */
+  TEST_F(SoftwareRendererTest, Concurrent) {
+    agario::Engine<renderable> engine(1000, 1000, 500, 10);
+    engine.seed(42);
+    engine.reset();
+    auto pid = engine.add_player<Player>("player");
+    for (int i = 0; i < 10; i++) engine.tick(agario::time_delta(1.0 / 30));
+
+    auto &viewer = engine.get_player(pid);
+    auto &game_state = engine.get_game_state();
+    agario::SoftwareRenderer<renderable> renderer(84, 84, 1000, 1000);
+
+    Frame expected(84, 84);
+    renderer.render_screen(viewer, game_state, expected.data.data());
+
+    std::vector<Frame> frames(4, Frame(84, 84));
+    std::vector<std::thread> threads;
+    for (auto &frame : frames)
+      threads.emplace_back([&] {
+        for (int i = 0; i < 10; i++)
+          renderer.render_screen(viewer, game_state, frame.data.data());
+      });
+    for (auto &thread : threads) thread.join();
+
+    for (auto &frame : frames)
+      EXPECT_EQ(expected.data, frame.data);
+  }
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <agario/engine/Engine.hpp>
+#include <agario/engine/SpatialIndex.hpp>
+#include <agario/bots/HungryBot.hpp>
+#include <agario/test/renderable.hpp>
+
+namespace {
+
+  using agario::SpatialIndex;
+
+  /* a game in progress, with pellets, foods, viruses and players spread over the arena */
+  struct IndexedGame {
+    agario::Engine<renderable> engine;
+
+    IndexedGame() : engine(1000, 1000, 5000, 50) {
+      engine.seed(42);
+      engine.reset();
+      for (int i = 0; i < 30; i++)
+        engine.template add_player<agario::bot::HungryBot<renderable>>();
+      for (int i = 0; i < 100; i++)
+        engine.tick(agario::time_delta(1.0 / 60));
+    }
+
+    const agario::GameState<renderable> &state() { return engine.get_game_state(); }
+  };
+
+  /* the ids of the entries of `kind` within `radius` of `center`, found by checking every entity */
+  std::set<std::uint32_t> brute_within(const agario::GameState<renderable> &state, SpatialIndex::kind kind,
+                                       const agario::Location &center, agario::distance radius) {
+    std::set<std::uint32_t> ids;
+    auto check = [&](const agario::Location &location, std::uint32_t id) {
+      if (location.distance_to(center) <= radius) ids.insert(id);
+    };
+    switch (kind) {
+      case SpatialIndex::pellets:
+        for (std::uint32_t i = 0; i < state.pellets.size(); i++) check(state.pellets[i].location(), i);
+        break;
+      case SpatialIndex::foods:
+        for (std::uint32_t i = 0; i < state.foods.size(); i++) check(state.foods[i].location(), i);
+        break;
+      case SpatialIndex::viruses:
+        for (std::uint32_t i = 0; i < state.viruses.size(); i++) check(state.viruses[i].location(), i);
+        break;
+      default:
+        for (auto &pair : state.players)
+          if (!pair.second->dead()) check(pair.second->location(), pair.first);
+    }
+    return ids;
+  }
+
+  TEST(SpatialIndex, MatchesBruteForce) {
+    IndexedGame game;
+    auto &state = game.state();
+    auto &index = state.index();
+    ASSERT_EQ(state.pellets.size(), index.size(SpatialIndex::pellets));
+    ASSERT_EQ(state.viruses.size(), index.size(SpatialIndex::viruses));
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-50, 1050);
+    std::uniform_real_distribution<float> radius(0, 200);
+    for (int trial = 0; trial < 200; trial++) {
+      agario::Location center(position(rng), position(rng));
+      for (int k = 0; k < SpatialIndex::num_kinds; k++) {
+        auto kind = static_cast<SpatialIndex::kind>(k);
+        agario::distance r = radius(rng);
+
+        std::set<std::uint32_t> within;
+        index.for_each_within(kind, center, r, [&](const SpatialIndex::Entry &entry, agario::distance dist) {
+          ASSERT_LE(dist, r);
+          ASSERT_TRUE(within.insert(entry.id).second) << "visited twice";
+        });
+        ASSERT_EQ(brute_within(state, kind, center, r), within);
+
+        // the k nearest are the closest k of everything, nearest first
+        auto all = brute_within(state, kind, center, agario::distance::max());
+        auto nearest = index.nearest(kind, center, 5);
+        ASSERT_EQ(std::min<std::size_t>(5, all.size()), nearest.size());
+        for (std::size_t i = 1; i < nearest.size(); i++)
+          ASSERT_LE(nearest[i - 1].location.distance_to(center), nearest[i].location.distance_to(center));
+        if (!nearest.empty()) {
+          auto farthest = nearest.back().location.distance_to(center);
+          auto closer = brute_within(state, kind, center, farthest);
+          ASSERT_GE(closer.size(), nearest.size());
+          for (auto &entry : nearest)
+            ASSERT_EQ(1, closer.count(entry.id));
+        }
+      }
+    }
+  }
+
+  TEST(SpatialIndex, View) {
+    IndexedGame game;
+    auto &state = game.state();
+    agario::Location lower(200, 300), upper(450, 400);
+
+    std::vector<agario::Location> expected, found;
+    for (auto &pellet : state.pellets)
+      if (lower.x <= pellet.x && pellet.x <= upper.x && lower.y <= pellet.y && pellet.y <= upper.y)
+        expected.push_back(pellet.location());
+    state.index().for_each_in_box(SpatialIndex::pellets, lower, upper, [&](const SpatialIndex::Entry &entry) {
+      ASSERT_EQ(state.pellets[entry.id].location(), entry.location);
+      found.push_back(entry.location);
+    });
+
+    auto by_position = [](const agario::Location &a, const agario::Location &b) {
+      return a.x < b.x || (a.x == b.x && a.y < b.y);
+    };
+    std::sort(expected.begin(), expected.end(), by_position);
+    std::sort(found.begin(), found.end(), by_position);
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(expected, found);
+  }
+
+  /* the index follows the state as entities are added, removed and ticked */
+  TEST(SpatialIndex, Rebuilds) {
+    IndexedGame game;
+    auto &state = game.engine.game_state();
+    auto pellets = state.index().size(SpatialIndex::pellets);
+
+    state.pellets.pop_back();
+    ASSERT_EQ(pellets - 1, state.index().size(SpatialIndex::pellets));
+
+    auto players = state.index().size(SpatialIndex::players);
+    game.engine.template add_player<agario::bot::HungryBot<renderable>>();
+    ASSERT_EQ(players + 1, state.index().size(SpatialIndex::players));
+
+    // a pellet moved without changing any counts is picked up on the next tick
+    state.pellets.front().x = state.pellets.front().y = 1;
+    game.engine.tick(agario::time_delta(1.0 / 60));
+    agario::Location corner(0, 0);
+    SpatialIndex::Entry nearest;
+    ASSERT_TRUE(state.index().nearest(SpatialIndex::pellets, corner, nearest));
+    ASSERT_LE(nearest.location.distance_to(corner), state.pellets.front().location().distance_to(corner));
+
+    state.clear();
+    ASSERT_EQ(0, state.index().size(SpatialIndex::pellets));
+    ASSERT_FALSE(state.index().nearest(SpatialIndex::players, corner, nearest));
+  }
+
+  /* built in parallel, the index holds the same entries, in the same order, as built serially */
+  TEST(SpatialIndex, Parallel) {
+    IndexedGame game;
+    auto &state = game.state();
+    ThreadPool pool(4);
+    SpatialIndex::ParallelFor pooled = [&](std::size_t n, const std::function<void(std::size_t)> &f) {
+      pool.parallel_for(n, f, 1);
+    };
+    SpatialIndex::ParallelFor backwards = [](std::size_t n, const std::function<void(std::size_t)> &f) {
+      for (auto i = n; i > 0; i--) f(i - 1);
+    };
+
+    auto entries = [&](const SpatialIndex &index, SpatialIndex::kind kind) {
+      std::vector<std::pair<std::uint32_t, agario::Location>> found;
+      agario::Location lower(0, 0), upper(state.arena_width, state.arena_height);
+      index.for_each_in_box(kind, lower, upper, [&](const SpatialIndex::Entry &entry) {
+        found.emplace_back(entry.id, entry.location);
+      });
+      return found;
+    };
+
+    SpatialIndex serial;
+    serial.build(state);
+    ASSERT_GT(serial.size(SpatialIndex::pellets), SpatialIndex::min_chunk); // so they're split between threads
+    for (auto &parallel_for : { pooled, backwards }) {
+      SpatialIndex parallel;
+      parallel.build(state, parallel_for);
+      for (auto kind : { SpatialIndex::pellets, SpatialIndex::foods, SpatialIndex::viruses, SpatialIndex::players }) {
+        ASSERT_EQ(entries(serial, kind), entries(parallel, kind)) << "kind " << kind;
+      }
+    }
+  }
+
+}
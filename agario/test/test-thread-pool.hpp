@@ -0,0 +1,91 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <utils/thread-pool.h>
+
+namespace {
+
+  TEST(ThreadPool, ScheduleAndWait) {
+    ThreadPool pool(4);
+    std::atomic<int> count(0);
+    for (int i = 0; i < 10000; i++)
+      pool.schedule([&count]() { count++; });
+    pool.wait();
+    EXPECT_EQ(10000, count);
+
+    // large callables (which don't fit inline) run too, and are freed
+    auto big = std::make_shared<std::string>(1000, 'x');
+    for (int i = 0; i < 100; i++)
+      pool.schedule([&count, big, padding = std::vector<int>(100, 1)]() {
+        count += padding.front() * static_cast<int>(big->size() / 1000);
+      });
+    pool.wait();
+    EXPECT_EQ(10100, count);
+    EXPECT_EQ(1, big.use_count());
+  }
+
+  /* tasks which schedule more tasks, from the workers' own deques */
+  TEST(ThreadPool, NestedTasks) {
+    ThreadPool pool(3);
+    std::atomic<int> leaves(0);
+    std::function<void(int)> spawn = [&](int depth) {
+      if (depth == 0) {
+        leaves++;
+        return;
+      }
+      pool.schedule([&spawn, depth]() { spawn(depth - 1); });
+      pool.schedule([&spawn, depth]() { spawn(depth - 1); });
+    };
+    spawn(12);
+    pool.wait();
+    EXPECT_EQ(1 << 12, leaves);
+  }
+
+  TEST(ThreadPool, ParallelFor) {
+    for (int threads : { 0, 1, 4 }) {
+      ThreadPool pool(threads);
+      for (std::size_t n : { 0, 1, 7, 1000, 100000 }) {
+        std::vector<std::atomic<int>> visits(n);
+        pool.parallel_for(n, [&](std::size_t i) { visits[i]++; });
+        for (auto &v : visits)
+          ASSERT_EQ(1, v) << n << " indices on " << threads << " threads";
+      }
+
+      // nested loops, as when a parallel game decides its bots in parallel
+      std::atomic<long> sum(0);
+      pool.parallel_for(16, [&](std::size_t i) {
+        pool.parallel_for(100, [&](std::size_t j) { sum += static_cast<long>(i * 100 + j); }, 10);
+      }, 1);
+      EXPECT_EQ(1599L * 1600 / 2, sum);
+    }
+  }
+
+  /* a group only waits on its own tasks */
+  TEST(ThreadPool, TaskGroups) {
+    ThreadPool pool(2);
+    std::atomic<bool> started(false), release(false);
+    pool.schedule([&]() {
+      started = true;
+      while (!release) std::this_thread::yield();
+    });
+    while (!started) std::this_thread::yield();
+
+    std::atomic<int> count(0);
+    {
+      ThreadPool::TaskGroup group(pool);
+      for (int i = 0; i < 100; i++)
+        group.run([&count]() { count++; });
+      group.wait();
+      EXPECT_EQ(100, count);
+    }
+    release = true;
+    pool.wait();
+  }
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <agario/bots/Tournament.hpp>
+#include <agario/bots/HungryBot.hpp>
+#include <agario/bots/HungryShyBot.hpp>
+#include <agario/test/renderable.hpp>
+
+namespace {
+
+  using agario::bot::ScoreStats;
+
+  TEST(Tournament, ScoreStats) {
+    std::vector<double> xs = { 4, 8, 15, 16, 23, 42, 7, 1 };
+    ScoreStats all, first, second;
+    for (std::size_t i = 0; i < xs.size(); i++) {
+      all.add(xs[i]);
+      (i < 3 ? first : second).add(xs[i]);
+    }
+    EXPECT_EQ(8, all.count());
+    EXPECT_DOUBLE_EQ(14.5, all.mean());
+    EXPECT_NEAR(1222.0 / 7, all.variance(), 1e-9);
+    EXPECT_EQ(1, all.min());
+    EXPECT_EQ(42, all.max());
+
+    // merging per-thread statistics is the same as adding everything to one
+    first.merge(second);
+    first.merge(ScoreStats());
+    EXPECT_EQ(all.count(), first.count());
+    EXPECT_DOUBLE_EQ(all.mean(), first.mean());
+    EXPECT_NEAR(all.variance(), first.variance(), 1e-9);
+    EXPECT_EQ(all.min(), first.min());
+    EXPECT_EQ(all.max(), first.max());
+
+    // the interval narrows with more samples of the same spread
+    ScoreStats more = all;
+    more.merge(all);
+    EXPECT_LT(more.confidence(), all.confidence());
+    EXPECT_EQ(0, ScoreStats().confidence());
+  }
+
+  using SmallTournament = agario::bot::Tournament<renderable, agario::bot::HungryBot, agario::bot::HungryShyBot>;
+
+  agario::bot::TournamentConfig small_config() {
+    agario::bot::TournamentConfig config;
+    config.num_games = 4;
+    config.bots_per_kind = 3;
+    config.duration = 0.05;
+    config.tick_freq = 30;
+    config.seed = 42;
+    return config;
+  }
+
+  /* the results depend only on the seed, not on how many threads play the games */
+  TEST(Tournament, Deterministic) {
+    auto config = small_config();
+    SmallTournament serial_tournament(config), parallel_tournament(config);
+
+    ThreadPool serial_pool(0), parallel_pool(2);
+    auto serial = serial_tournament.run(serial_pool);
+    auto parallel = parallel_tournament.run(parallel_pool);
+
+    ASSERT_EQ(config.num_games, serial.games());
+    ASSERT_EQ(config.num_games, parallel.games());
+    ASSERT_EQ(config.num_games * serial_tournament.ticks_per_game(), serial.ticks());
+    ASSERT_EQ(serial.ticks(), parallel.ticks());
+    ASSERT_EQ(2, serial.bots().size());
+    for (auto &pair : serial.bots()) {
+      auto &other = parallel.bots().at(pair.first);
+      EXPECT_EQ(config.num_games, pair.second.average.count());
+      EXPECT_NEAR(pair.second.average.mean(), other.average.mean(), 1e-6);
+      EXPECT_NEAR(pair.second.average.variance(), other.average.variance(), 1e-6);
+      EXPECT_EQ(pair.second.maximum.max(), other.maximum.max());
+      EXPECT_EQ(pair.second.minimum.min(), other.minimum.min());
+    }
+  }
+
+  TEST(Tournament, StreamsResults) {
+    auto config = small_config();
+    SmallTournament tournament(config);
+    ThreadPool pool(2);
+
+    std::stringstream csv, json, progress;
+    agario::bot::ResultWriter csv_writer(csv, agario::bot::ResultWriter::csv);
+    tournament.run(pool, &csv_writer, &progress);
+    agario::bot::ResultWriter json_writer(json, agario::bot::ResultWriter::json);
+    tournament.run(pool, &json_writer);
+
+    auto lines = [](std::stringstream &ss) {
+      std::vector<std::string> lines;
+      for (std::string line; std::getline(ss, line);)
+        lines.push_back(line);
+      return lines;
+    };
+
+    // a header, then a row for each bot of each game
+    auto rows = lines(csv);
+    ASSERT_EQ(1 + config.num_games * 2 * config.bots_per_kind, rows.size());
+    EXPECT_EQ("game,seed,ticks,seconds,bot,index,score", rows.front());
+
+    // a line for each game
+    auto objects = lines(json);
+    ASSERT_EQ(config.num_games, objects.size());
+    for (auto &object : objects) {
+      EXPECT_EQ('{', object.front());
+      EXPECT_NE(std::string::npos, object.find("\"scores\":{"));
+    }
+
+    // the last game done is always reported
+    auto reports = lines(progress);
+    ASSERT_FALSE(reports.empty());
+    EXPECT_EQ(0, reports.back().find("4/4 games"));
+  }
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <utils/trace.h>
+
+namespace {
+
+  /* the number of (non-overlapping) occurrences of `pattern` in `s` */
+  int occurrences(const std::string &s, const std::string &pattern) {
+    int count = 0;
+    for (auto pos = s.find(pattern); pos != std::string::npos; pos = s.find(pattern, pos + pattern.size()))
+      count++;
+    return count;
+  }
+
+  std::string write_trace() {
+    std::stringstream ss;
+    trace::Tracer::instance().write(ss);
+    return ss.str();
+  }
+
+  TEST(Trace, Scopes) {
+    trace::clear();
+    trace::start();
+    {
+      trace::Scope outer("outer");
+      trace::Scope inner("inner");
+    }
+    trace::stop();
+    {
+      trace::Scope ignored("ignored");
+    }
+
+    auto json = write_trace();
+    EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0);
+    EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+
+    EXPECT_EQ(occurrences(json, "\"name\":\"outer\",\"ph\":\"B\""), 1);
+    EXPECT_EQ(occurrences(json, "\"name\":\"outer\",\"ph\":\"E\""), 1);
+    EXPECT_EQ(occurrences(json, "\"name\":\"inner\",\"ph\":\"B\""), 1);
+    EXPECT_EQ(occurrences(json, "\"name\":\"inner\",\"ph\":\"E\""), 1);
+    EXPECT_EQ(occurrences(json, "ignored"), 0) << "Recorded an event while stopped";
+
+    // nested scopes end in the reverse of the order they began
+    auto outer_begin = json.find("\"name\":\"outer\",\"ph\":\"B\"");
+    auto inner_begin = json.find("\"name\":\"inner\",\"ph\":\"B\"");
+    auto inner_end = json.find("\"name\":\"inner\",\"ph\":\"E\"");
+    auto outer_end = json.find("\"name\":\"outer\",\"ph\":\"E\"");
+    EXPECT_LT(outer_begin, inner_begin);
+    EXPECT_LT(inner_begin, inner_end);
+    EXPECT_LT(inner_end, outer_end);
+
+    trace::clear();
+    EXPECT_EQ(occurrences(write_trace(), "\"ph\":\"B\""), 0);
+  }
+
+  TEST(Trace, Threads) {
+    trace::clear();
+    trace::start();
+
+    int num_threads = 4;
+    int num_scopes = 100;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([=]() {
+        trace::set_thread_name("tracer test " + std::to_string(t));
+        for (int i = 0; i < num_scopes; i++)
+          trace::Scope scope("work");
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+    trace::stop();
+
+    auto json = write_trace();
+    EXPECT_EQ(occurrences(json, "\"name\":\"work\",\"ph\":\"B\""), num_threads * num_scopes);
+    EXPECT_EQ(occurrences(json, "\"name\":\"work\",\"ph\":\"E\""), num_threads * num_scopes);
+    for (int t = 0; t < num_threads; t++)
+      EXPECT_EQ(occurrences(json, "\"name\":\"tracer test " + std::to_string(t) + "\""), 1);
+  }
+
+  TEST(Trace, RingBuffer) {
+    trace::clear();
+    trace::start();
+    trace::Scope("first");
+    for (std::size_t i = 0; i < trace::buffer_size; i++)
+      trace::Scope scope("filler");
+    trace::stop();
+
+    // only the most recent events are kept (less the slot the next event would be written into)
+    auto json = write_trace();
+    EXPECT_EQ(occurrences(json, "\"name\":\"first\""), 0);
+    EXPECT_EQ(occurrences(json, "\"name\":\"filler\""), trace::buffer_size - 1);
+    trace::clear();
+  }
+
+  /* snapshots taken while the buffer is being written contain only whole events */
+  TEST(Trace, ConcurrentSnapshot) {
+    static const char *names[] = { "even", "odd" };
+    trace::ThreadBuffer buffer(1, "writer");
+
+    std::atomic<bool> wrapped(false), done(false);
+    std::thread writer([&]() {
+      for (std::uint64_t i = 0; !done.load(std::memory_order_relaxed); i++) {
+        buffer.push(names[i % 2], i % 2 ? 'E' : 'B', i);
+        if (i == trace::buffer_size) wrapped = true;
+      }
+    });
+
+    // snapshots of a full buffer are copied from the slots being overwritten
+    while (!wrapped) std::this_thread::yield();
+    for (int s = 0; s < 200; s++) {
+      auto events = buffer.snapshot();
+      ASSERT_LT(events.size(), trace::buffer_size);
+      for (std::size_t i = 0; i < events.size(); i++) {
+        auto &event = events[i];
+        ASSERT_EQ(event.name, names[event.ns % 2]) << "event " << event.ns;
+        ASSERT_EQ(event.phase, event.ns % 2 ? 'E' : 'B') << "event " << event.ns;
+        if (i > 0) {
+          ASSERT_EQ(event.ns, events[i - 1].ns + 1);
+        }
+      }
+    }
+    done = true;
+    writer.join();
+  }
+
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include <agario/server/protocol.hpp>
+#include <agario/server/snapshot.hpp>
+#include <agario/server/wire.hpp>
+
+namespace {
+
+  using namespace agario::server;
+
+  TEST(WireTest, BitsRoundTrip) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> width(1, 32);
+    std::uniform_int_distribution<int> field(0, 4);
+
+    for (int trial = 0; trial < 200; trial++) {
+      // a random sequence of fields of every kind, remembered to compare against
+      std::vector<std::pair<int, std::uint64_t>> fields;
+      BitWriter out;
+      for (int i = 0; i < 50; i++) {
+        auto kind = field(rng);
+        auto bits = width(rng);
+        std::uint64_t value = rng() >> (rng() % 64);
+        switch (kind) {
+          case 0:
+            value &= (std::uint64_t(1) << bits) - 1;
+            out.write(static_cast<std::uint32_t>(value), bits);
+            value |= static_cast<std::uint64_t>(bits) << 32u;
+            break;
+          case 1: out.write_varint(value); break;
+          case 2: out.write_zigzag(static_cast<std::int64_t>(value) - (1ll << 40)); break;
+          case 3: out.write_float(static_cast<float>(value) / 7); break;
+          default: value %= 1000; out.write_string(std::string(value, 'a' + value % 26)); break;
+        }
+        fields.emplace_back(kind, value);
+      }
+
+      auto bytes = out.bytes();
+      ASSERT_EQ((out.bit_size() + 7) / 8, bytes.size());
+      BitReader in(bytes);
+      for (auto &pair : fields) {
+        auto value = pair.second;
+        switch (pair.first) {
+          case 0: ASSERT_EQ(value & 0xffffffffu, in.read(static_cast<int>(value >> 32u))); break;
+          case 1: ASSERT_EQ(value, in.read_varint()); break;
+          case 2: ASSERT_EQ(static_cast<std::int64_t>(value) - (1ll << 40), in.read_zigzag()); break;
+          case 3: ASSERT_EQ(static_cast<float>(value) / 7, in.read_float()); break;
+          default: ASSERT_EQ(std::string(value, 'a' + value % 26), in.read_string(1000)); break;
+        }
+      }
+      ASSERT_TRUE(in.done());
+      ASSERT_THROW(in.read(8), agario::binary::FormatException);
+    }
+
+    // small values take a single byte
+    BitWriter small;
+    small.write_varint(127);
+    small.write_zigzag(-64);
+    ASSERT_EQ(2, small.bytes().size());
+  }
+
+  TEST(WireTest, Quantization) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(0, 10000);
+    for (int i = 0; i < 1000; i++) {
+      auto x = position(rng);
+      ASSERT_LE(std::abs(snap(x) - x), 0.5f / grid_resolution);
+      ASSERT_EQ(snap(x), snap(snap(x)));
+      ASSERT_LE(std::abs(dequantize(quantize(x, 10000), 10000) - x), 10000.0f / 0xffff);
+    }
+    ASSERT_EQ(0, quantize(-5, 1000));
+    ASSERT_EQ(0xffff, quantize(1005, 1000));
+  }
+
+  TEST(WireTest, MessagesRoundTrip) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::uint32_t> tick;
+    std::uniform_int_distribution<std::uint16_t> target;
+    std::uniform_int_distribution<int> action(agario::action::none, agario::action::split);
+
+    auto payload = [](const std::string &framed) { return framed.substr(5); };
+    for (int i = 0; i < 100; i++) {
+      Input input { tick(rng), tick(rng), target(rng), target(rng), static_cast<agario::action>(action(rng)) };
+      auto encoded = encode(input);
+      ASSERT_LE(encoded.size(), 5 + 15);
+
+      auto decoded = decode_input(payload(encoded));
+      ASSERT_EQ(input.ack, decoded.ack);
+      ASSERT_EQ(input.sequence, decoded.sequence);
+      ASSERT_EQ(input.target_x, decoded.target_x);
+      ASSERT_EQ(input.target_y, decoded.target_y);
+      ASSERT_EQ(input.action, decoded.action);
+    }
+
+    std::vector<PlayerInfo> players {
+      { 1, agario::color::red, "alice" },
+      { 300, agario::color::purple, "" },
+      { 65535, agario::color::blue, std::string(max_name_length, 'z') },
+    };
+    ASSERT_EQ(players, decode_players(payload(encode(players))));
+    ASSERT_EQ(300, decode_player_left(payload(encode_player_left(300))));
+    ASSERT_EQ("bob", decode_join(payload(encode_join("bob"))));
+
+    Welcome welcome { 7, 1000, 2500, 30 };
+    auto decoded = decode_welcome(payload(encode(welcome)));
+    ASSERT_EQ(welcome.pid, decoded.pid);
+    ASSERT_EQ(welcome.arena_height, decoded.arena_height);
+    ASSERT_EQ(welcome.tick_rate, decoded.tick_rate);
+
+    // trailing bytes aren't part of the protocol
+    ASSERT_THROW(decode_join(payload(encode_join("bob")) + "x"), agario::binary::FormatException);
+  }
+
+  /* decoding corrupted messages either works or throws, and never crashes or allocates wildly */
+  TEST(WireTest, Fuzz) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::int32_t> position(0, 300 * grid_resolution);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    Snapshot base, current;
+    for (int i = 0; i < 200; i++) {
+      auto x = position(rng), y = position(rng);
+      base.push_back({ pellet, pellet_id(x, y), from_grid(x), from_grid(y), PELLET_MASS });
+      current.push_back({ cell, static_cast<std::uint64_t>(i), from_grid(x), from_grid(y),
+                          static_cast<agario::mass>(i) });
+    }
+    std::sort(base.begin(), base.end());
+    current.insert(current.end(), base.begin(), base.begin() + 100);
+    std::sort(current.begin(), current.end());
+
+    BitWriter out;
+    write_delta(out, base, current);
+    auto bytes = out.bytes();
+
+    int rejected = 0;
+    auto attempt = [&](auto decode) {
+      try {
+        decode();
+      } catch (agario::binary::FormatException &) {
+        rejected++;
+      }
+    };
+
+    for (int trial = 0; trial < 5000; trial++) {
+      auto corrupted = bytes;
+      for (int i = 0; i < 1 + trial % 4; i++)
+        corrupted[rng() % corrupted.size()] = static_cast<char>(byte(rng));
+      if (trial % 7 == 0) corrupted.resize(rng() % corrupted.size());
+
+      attempt([&]() {
+        BitReader in(corrupted);
+        read_delta(in, base);
+      });
+      attempt([&]() { decode_input(corrupted.substr(0, trial % 12)); });
+      attempt([&]() { decode_players(corrupted); });
+    }
+    ASSERT_GT(rejected, 0);
+  }
+
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <agario/engine/Engine.hpp>
+#include <agario/engine/Replay.hpp>
+#include <agario/bots/ExampleBot.hpp>
+#include <agario/bots/HungryBot.hpp>
+
+#include <bench/bench-utils.hpp>
+
+namespace {
+
+  static void CreateEngine(benchmark::State& state) {
+    for (auto _ : state) {
+      agario::Engine<false> engine;
+      benchmark::DoNotOptimize(engine);
+    }
+  }
+  BENCHMARK(CreateEngine);
+
+  /* resetting the game, which re-spawns every pellet and virus */
+  static void Reset(benchmark::State& state) {
+    int num_pellets = state.range(0);
+    agario::Engine<false> engine(DEFAULT_ARENA_WIDTH, DEFAULT_ARENA_HEIGHT, num_pellets);
+    engine.seed(42);
+
+    for (auto _ : state)
+      engine.reset();
+
+    state.SetItemsProcessed(state.iterations() * num_pellets);
+  }
+  BENCHMARK(Reset)->ArgName("pellets")->RangeMultiplier(4)->Range(256, 16384);
+
+  static void Tick(benchmark::State& state) {
+    using Bot = agario::bot::ExampleBot<false>;
+
+    agario::Engine<false> engine;
+    engine.reset();
+    agario::time_delta dt(1.0 / 60);
+    agario::tick tick_limit = 4 * 3600;
+
+    int num_bots = state.range(0);
+    for (int i = 0; i < num_bots; i++)
+      engine.add_player<Bot>();
+
+    for (auto _ : state) {
+      engine.tick(dt);
+
+      state.PauseTiming();
+      if (engine.ticks() > tick_limit) {
+        engine.reset();
+        for (int i = 0; i < num_bots; i++)
+          engine.add_player<Bot>();
+      }
+      state.ResumeTiming();
+    }
+  }
+  BENCHMARK(Tick)->Arg(0)->Arg(5)->Arg(10)->Arg(20)->Arg(30);
+
+  /* ticks with bots that move around and eat, exercising most of the physics */
+  static void TickHungry(benchmark::State& state) {
+    using Bot = agario::bot::HungryBot<false>;
+
+    agario::Engine<false> engine;
+    engine.seed(42);
+    engine.reset();
+    agario::time_delta dt(1.0 / 60);
+
+    int num_bots = state.range(0);
+    for (int i = 0; i < num_bots; i++)
+      engine.add_player<Bot>();
+
+    for (auto _ : state)
+      engine.tick(dt);
+
+    state.SetLabel(bench::numeric_type());
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(TickHungry)->Arg(10)->Arg(30);
+
+  /**
+   * Ticks a game with the mix of bots used by the environments, sweeping
+   * each of the number of bots, the number of pellets and the arena size
+   * while holding the other two at their defaults
+   */
+  static void TickSweep(benchmark::State& state) {
+    int num_bots = state.range(0);
+    int num_pellets = state.range(1);
+    int arena_size = state.range(2);
+
+    agario::Engine<false> engine(arena_size, arena_size, num_pellets);
+    engine.seed(42);
+    engine.reset();
+    bench::add_bots(engine, num_bots);
+    bench::warm_up(engine, 60);
+
+    agario::time_delta dt(1.0 / 60);
+    for (auto _ : state)
+      engine.tick(dt);
+
+    state.SetLabel(bench::numeric_type());
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(TickSweep)
+    ->ArgNames({"bots", "pellets", "arena"})
+    ->ArgsProduct({{1, 10, 50, 100}, {DEFAULT_NUM_PELLETS}, {DEFAULT_ARENA_WIDTH}})
+    ->ArgsProduct({{10}, {256, 4096, 16384}, {DEFAULT_ARENA_WIDTH}})
+    ->ArgsProduct({{10}, {DEFAULT_NUM_PELLETS}, {250, 1000, 2000}});
+
+  /* one decision tick: indexing the arena and every bot choosing its action from the index */
+  static void BotDecisions(benchmark::State& state) {
+    int num_bots = state.range(0);
+    int num_pellets = state.range(1);
+
+    agario::Engine<false> engine(DEFAULT_ARENA_WIDTH, DEFAULT_ARENA_HEIGHT, num_pellets);
+    engine.seed(42);
+    engine.reset();
+    bench::add_bots(engine, num_bots);
+    bench::warm_up(engine, 60);
+
+    auto &game_state = engine.game_state();
+    for (auto _ : state) {
+      game_state.invalidate_index();
+      for (auto &pair : game_state.players)
+        if (!pair.second->dead())
+          pair.second->take_action(game_state);
+    }
+
+    state.SetLabel(bench::numeric_type());
+    state.SetItemsProcessed(state.iterations() * num_bots);
+  }
+  BENCHMARK(BotDecisions)
+    ->ArgNames({"bots", "pellets"})
+    ->ArgsProduct({{10, 100, 300}, {DEFAULT_NUM_PELLETS, 16384}});
+
+  /* ticks in a huge arena with stored (0) or procedurally generated (1) pellets */
+  static void TickHugeArena(benchmark::State& state) {
+    using Bot = agario::bot::HungryBot<false>;
+
+    bool procedural = state.range(0);
+    int num_pellets = 1000000;
+    agario::Engine<false> engine(20000, 20000, num_pellets, DEFAULT_NUM_VIRUSES, true, procedural);
+    engine.seed(42);
+    engine.reset();
+    agario::time_delta dt(1.0 / 60);
+
+    for (int i = 0; i < 10; i++)
+      engine.add_player<Bot>();
+
+    for (auto _ : state)
+      engine.tick(dt);
+
+    state.SetLabel(procedural ? "procedural" : "stored");
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(TickHugeArena)->Arg(0)->Arg(1);
+
+  /**
+   * ticks of a crowded huge arena, serially (0 threads) or settled by 8x8
+   * tiles on `threads` threads, with the share of players the tiles settled
+   */
+  static void TickTiled(benchmark::State& state) {
+    int num_threads = state.range(0);
+    agario::Engine<false> engine(10000, 10000, 50000);
+    engine.seed(42);
+    engine.reset();
+    bench::add_bots(engine, 300);
+
+    ThreadPool pool(std::max(1, num_threads));
+    if (num_threads > 0) {
+      engine.set_thread_pool(&pool);
+      engine.set_arena_tiles(8, 8);
+    }
+    bench::warm_up(engine, 10);
+
+    agario::time_delta dt(1.0 / 60);
+    engine.reset_tile_stats();
+    for (auto _ : state)
+      engine.tick(dt);
+
+    state.counters["parallel_fraction"] = engine.tile_stats().parallel_fraction();
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(TickTiled)->ArgName("threads")->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond);
+
+  /* ticks with bots deciding all at once (0), staggered (1), or also less often out of the agent's view (2) */
+  static void TickBotSchedule(benchmark::State& state) {
+    agario::Engine<false> engine(5000, 5000, 10000);
+    engine.seed(42);
+    engine.reset();
+    auto agent = engine.add_player<agario::Player<false>>("agent");
+    bench::add_bots(engine, 300);
+
+    agario::BotSchedule schedule;
+    schedule.staggered = state.range(0) > 0;
+    schedule.distant_period = state.range(0) > 1 ? 40 : 0;
+    engine.set_bot_schedule(schedule);
+    engine.set_arena_tiles(4, 4); // so that decisions aren't lost among pellet tests
+    bench::warm_up(engine, 60);
+    engine.reset_decision_stats();
+
+    agario::time_delta dt(1.0 / 60);
+    for (auto _ : state) {
+      if (engine.get_player(agent).dead()) engine.respawn(agent); // bots out of its view only decide less often while it's alive
+      engine.tick(dt);
+    }
+
+    auto &stats = engine.decision_stats();
+    state.counters["decision_rate"] = stats.rate();
+    state.counters["peak_decisions"] = stats.peak_decisions;
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(TickBotSchedule)->ArgName("schedule")->Arg(0)->Arg(1)->Arg(2);
+
+  /* ticks while recording a replay (1) or not (0), to measure the recorder's overhead */
+  static void TickRecorded(benchmark::State& state) {
+    bool record = state.range(0);
+
+    agario::Engine<false> engine;
+    engine.seed(42);
+    engine.reset();
+    bench::add_bots(engine, 30);
+    bench::warm_up(engine, 60);
+
+    // discard the replay so that the disk isn't measured (or filled)
+    std::unique_ptr<agario::ReplayRecorder<false>> recorder;
+    if (record)
+      recorder = std::make_unique<agario::ReplayRecorder<false>>(engine, "/dev/null");
+
+    agario::time_delta dt(1.0 / 60);
+    for (auto _ : state)
+      engine.tick(dt);
+
+    state.SetLabel(record ? "recorded" : "not recorded");
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(TickRecorded)->Arg(0)->Arg(1)->Iterations(3000);
+
+  /* the arithmetic and math functions on agario::distance used by the physics */
+  static void DistanceMath(benchmark::State& state) {
+    agario::distance x = 1.5, y = 2.25;
+    agario::angle theta = 0.3;
+
+    for (auto _ : state) {
+      agario::Location loc(x, y);
+      agario::Velocity vel(theta, loc.norm());
+      x += vel.dx * 0.01;
+      y += vel.dy * 0.01;
+      theta = vel.direction();
+      benchmark::DoNotOptimize(x);
+      benchmark::DoNotOptimize(y);
+    }
+
+    state.SetLabel(bench::numeric_type());
+  }
+  BENCHMARK(DistanceMath);
+
+}
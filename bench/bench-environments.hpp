@@ -0,0 +1,127 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <environment/envs/GridEnvironment.hpp>
+#include <environment/envs/SparseEnvironment.hpp>
+#ifdef INCLUDE_SCREEN_ENV
+#include <environment/envs/ScreenEnvironment.hpp>
+#endif
+
+#include <memory>
+#include <vector>
+
+/* Stepping and resetting the learning environments, as done through the bindings */
+namespace {
+
+  std::vector<agario::env::Action> forward_actions(int num_agents) {
+    return std::vector<agario::env::Action>(num_agents, agario::env::Action(1, 0, agario::action::none));
+  }
+
+  template<typename Environment>
+  void step_environment(benchmark::State& state, Environment &env) {
+    int num_agents = env.num_agents();
+    auto actions = forward_actions(num_agents);
+    int steps = 0;
+
+    for (auto _ : state) {
+      env.take_actions(actions);
+      benchmark::DoNotOptimize(env.step());
+
+      // keep the game from running long enough for every agent to be eaten
+      if (++steps % 500 == 0) {
+        state.PauseTiming();
+        env.reset();
+        state.ResumeTiming();
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * num_agents);
+  }
+
+  static void GridEnvStep(benchmark::State& state) {
+    int num_agents = state.range(0);
+    agario::env::GridEnvironment<int, false> env(num_agents, 4, DEFAULT_ARENA_WIDTH, true,
+                                                 DEFAULT_NUM_PELLETS, DEFAULT_NUM_VIRUSES, 10);
+    env.configure_observation(2, state.range(1), true, true, true, true);
+    env.seed(42);
+    env.reset();
+    step_environment(state, env);
+  }
+  BENCHMARK(GridEnvStep)->ArgNames({"agents", "grid"})->ArgsProduct({{1, 8}, {64, 128}});
+
+  static void GridEnvReset(benchmark::State& state) {
+    agario::env::GridEnvironment<int, false> env(4, 4, DEFAULT_ARENA_WIDTH, true,
+                                                 DEFAULT_NUM_PELLETS, DEFAULT_NUM_VIRUSES, 10);
+    env.configure_observation(2, 128, true, true, true, true);
+    env.seed(42);
+
+    for (auto _ : state)
+      env.reset();
+  }
+  BENCHMARK(GridEnvReset);
+
+  static void SparseEnvStep(benchmark::State& state) {
+    int num_agents = state.range(0);
+    agario::env::SparseEnvironment<false> env(num_agents, 4, DEFAULT_ARENA_WIDTH, true,
+                                              DEFAULT_NUM_PELLETS, DEFAULT_NUM_VIRUSES, 10);
+    env.seed(42);
+    env.reset();
+    step_environment(state, env);
+  }
+  BENCHMARK(SparseEnvStep)->ArgName("agents")->Arg(1)->Arg(8);
+
+  static void SparseEnvReset(benchmark::State& state) {
+    agario::env::SparseEnvironment<false> env(4, 4, DEFAULT_ARENA_WIDTH, true,
+                                              DEFAULT_NUM_PELLETS, DEFAULT_NUM_VIRUSES, 10);
+    env.seed(42);
+
+    for (auto _ : state)
+      env.reset();
+  }
+  BENCHMARK(SparseEnvReset);
+
+#ifdef INCLUDE_SCREEN_ENV
+
+  /**
+   * Steps two OpenGL screen environments in turn (as a vectorized trainer
+   * would), reading each one's observations straight after its step (0), or
+   * only once both have stepped (1), so that the first one's frames are read
+   * back while the second one is stepped and rendered
+   */
+  static void ScreenEnvReadback(benchmark::State& state) {
+    using ScreenEnvironment = agario::env::ScreenEnvironment<true, agario::env::OpenGLScreen>;
+    bool deferred = state.range(0);
+    int num_agents = 4;
+
+    std::vector<std::unique_ptr<ScreenEnvironment>> envs;
+    for (int i = 0; i < 2; i++) {
+      envs.push_back(std::make_unique<ScreenEnvironment>(num_agents, 4, DEFAULT_ARENA_WIDTH, true,
+                                                         DEFAULT_NUM_PELLETS, DEFAULT_NUM_VIRUSES, 10, 1, 256, 256));
+      envs.back()->seed(42);
+      envs.back()->reset();
+    }
+    auto actions = forward_actions(num_agents);
+
+    int steps = 0;
+    for (auto _ : state) {
+      for (auto &env : envs) {
+        env->take_actions(actions);
+        env->step();
+        if (!deferred) benchmark::DoNotOptimize(env->get_observations().front().data());
+      }
+      if (deferred)
+        for (auto &env : envs) benchmark::DoNotOptimize(env->get_observations().front().data());
+
+      if (++steps % 500 == 0) {
+        state.PauseTiming();
+        for (auto &env : envs) env->reset();
+        state.ResumeTiming();
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * 2 * num_agents);
+  }
+  BENCHMARK(ScreenEnvReadback)->ArgName("deferred")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+#endif
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <environment/envs/GridEnvironment.hpp>
+#include <environment/envs/RamEnvironment.hpp>
+#include <environment/envs/SparseEnvironment.hpp>
+#include <agario/rendering/SoftwareRenderer.hpp>
+
+#include <bench/bench-utils.hpp>
+
+/* Capturing a single observation from a game in progress */
+namespace {
+
+  /* a game with the default arena, pellets and viruses, and an extra player to observe */
+  class ObservedGame {
+  public:
+    explicit ObservedGame(int num_bots) {
+      engine.seed(42);
+      engine.reset();
+      bench::add_bots(engine, num_bots);
+      pid = engine.add_player<agario::Player<false>>("observer");
+      bench::warm_up(engine, 60);
+    }
+
+    const agario::Player<false> &player() {
+      if (engine.player(pid).dead()) engine.respawn(pid);
+      return engine.get_player(pid);
+    }
+
+    agario::Engine<false> engine;
+    agario::pid pid;
+  };
+
+  static void GridAddFrame(benchmark::State& state) {
+    ObservedGame game(10);
+    int grid_size = state.range(0);
+    agario::env::GridObservation<int, false> observation(1, grid_size, true, true, true, true);
+
+    auto &player = game.player();
+    auto &game_state = game.engine.get_game_state();
+    for (auto _ : state) {
+      observation.add_frame(player, game_state, 0);
+      benchmark::DoNotOptimize(observation.data());
+    }
+  }
+  BENCHMARK(GridAddFrame)->ArgName("grid")->Arg(32)->Arg(64)->Arg(128)->Arg(256);
+
+  static void RamCapture(benchmark::State& state) {
+    ObservedGame game(10);
+    auto &player = game.player();
+    auto &game_state = game.engine.get_game_state();
+
+    using Observation = agario::env::RamObservation<false, PLAYER_CELL_LIMIT, DEFAULT_NUM_FOODS>;
+    Observation observation(player, game_state, DEFAULT_NUM_PELLETS, DEFAULT_NUM_VIRUSES);
+
+    for (auto _ : state) {
+      observation.capture_ram(player, game_state);
+      benchmark::DoNotOptimize(observation.data());
+    }
+  }
+  BENCHMARK(RamCapture);
+
+  static void SparseCapture(benchmark::State& state) {
+    ObservedGame game(10);
+    auto &player = game.player();
+    auto &game_state = game.engine.get_game_state();
+    agario::env::SparseObservation<false> observation;
+
+    for (auto _ : state) {
+      observation.capture(player, game_state);
+      benchmark::DoNotOptimize(observation.data());
+    }
+  }
+  BENCHMARK(SparseCapture);
+
+  static void SoftwareScreen(benchmark::State& state) {
+    ObservedGame game(10);
+    auto &player = game.player();
+    auto &game_state = game.engine.get_game_state();
+
+    int screen_len = state.range(0);
+    agario::SoftwareRenderer<false> renderer(screen_len, screen_len,
+                                             game.engine.arena_width(), game.engine.arena_height());
+    std::vector<std::uint8_t> pixels(renderer.frame_size());
+
+    for (auto _ : state) {
+      renderer.render_screen(player, game_state, pixels.data());
+      benchmark::DoNotOptimize(pixels.data());
+    }
+  }
+  BENCHMARK(SoftwareScreen)->ArgName("screen")->Arg(84)->Arg(128)->Arg(256);
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <agario/engine/Engine.hpp>
+#include <agario/bots/bots.hpp>
+
+#include <bench/bench-utils.hpp>
+
+#include <vector>
+
+/**
+ * Micro-benchmarks of the individual phases of a game tick, isolated from
+ * the rest of the engine so that a regression can be pinned to a phase.
+ */
+namespace {
+
+  /* a cell testing every pellet for collision (the pellet eating scan) */
+  static void PelletCollisions(benchmark::State& state) {
+    agario::Engine<false> engine(DEFAULT_ARENA_WIDTH, DEFAULT_ARENA_HEIGHT, state.range(0));
+    engine.seed(42);
+    engine.reset();
+    agario::Cell<false> cell(engine.random_location(), agario::Velocity(), 100);
+
+    for (auto _ : state) {
+      int collisions = 0;
+      for (auto &pellet : engine.pellets())
+        collisions += cell.can_eat(pellet) && cell.collides_with(pellet);
+      benchmark::DoNotOptimize(collisions);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(PelletCollisions)->ArgName("pellets")->RangeMultiplier(4)->Range(256, 16384);
+
+  /* every pair of cells testing whether one eats the other (player collisions) */
+  static void CellCollisions(benchmark::State& state) {
+    agario::Engine<false> engine;
+    engine.seed(42);
+
+    int num_cells = state.range(0);
+    std::vector<agario::Cell<false>> cells;
+    for (int i = 0; i < num_cells; i++)
+      cells.emplace_back(engine.random_location(), agario::Velocity(), 10 + 10 * (i % 20));
+
+    for (auto _ : state) {
+      int collisions = 0;
+      for (auto &cell : cells)
+        for (auto &other : cells)
+          collisions += cell.can_eat(other) && cell.collides_with(other);
+      benchmark::DoNotOptimize(collisions);
+    }
+    state.SetItemsProcessed(state.iterations() * num_cells * num_cells);
+  }
+  BENCHMARK(CellCollisions)->ArgName("cells")->RangeMultiplier(4)->Range(16, 1024);
+
+  /* moving cells (the movement phase, without collisions) */
+  static void CellMovement(benchmark::State& state) {
+    agario::Engine<false> engine;
+    engine.seed(42);
+
+    std::vector<agario::Cell<false>> cells;
+    for (int i = 0; i < 100; i++)
+      cells.emplace_back(engine.random_location(), agario::Velocity(agario::angle(i), 50), 100);
+
+    agario::time_delta dt(1.0 / 60);
+    for (auto _ : state) {
+      for (auto &cell : cells) {
+        cell.move(dt.count());
+        cell.splitting_velocity.decelerate(SPLIT_DECELERATION, dt.count());
+      }
+      benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * cells.size());
+  }
+  BENCHMARK(CellMovement);
+
+  /* a single decision of a bot (the bot action phase) in a game with other bots */
+  template<typename Bot>
+  static void BotDecision(benchmark::State& state) {
+    agario::Engine<false> engine;
+    engine.seed(42);
+    engine.reset();
+    bench::add_bots(engine, state.range(0));
+    auto pid = engine.add_player<Bot>();
+    bench::warm_up(engine);
+
+    auto &bot = engine.player(pid);
+    if (bot.dead()) engine.respawn(pid);
+
+    auto &game_state = engine.get_game_state();
+    for (auto _ : state) {
+      bot.take_action(game_state);
+      benchmark::DoNotOptimize(bot.target);
+    }
+  }
+  BENCHMARK_TEMPLATE(BotDecision, agario::bot::HungryBot<false>)->ArgName("bots")->Arg(10)->Arg(100);
+  BENCHMARK_TEMPLATE(BotDecision, agario::bot::HungryShyBot<false>)->ArgName("bots")->Arg(10)->Arg(100);
+  BENCHMARK_TEMPLATE(BotDecision, agario::bot::AggressiveBot<false>)->ArgName("bots")->Arg(10)->Arg(100);
+  BENCHMARK_TEMPLATE(BotDecision, agario::bot::AggressiveShyBot<false>)->ArgName("bots")->Arg(10)->Arg(100);
+
+#ifdef ENGINE_PROFILING
+  /* full ticks, reporting the time spent in each phase (in microseconds per tick) */
+  static void TickPhases(benchmark::State& state) {
+    agario::Engine<false> engine;
+    engine.seed(42);
+    engine.reset();
+    bench::add_bots(engine, state.range(0));
+    bench::warm_up(engine, 60);
+    engine.reset_stats();
+
+    agario::time_delta dt(1.0 / 60);
+    for (auto _ : state)
+      engine.tick(dt);
+
+    auto &stats = engine.stats();
+    for (int phase = 0; phase < agario::num_tick_phases; phase++)
+      state.counters[agario::phase_name(phase)] = 1e6 * stats.seconds[phase] / stats.ticks;
+    state.counters["pellet tests"] = static_cast<double>(stats.pellet_tests) / stats.ticks;
+    state.counters["cell tests"] = static_cast<double>(stats.cell_tests) / stats.ticks;
+  }
+  BENCHMARK(TickPhases)->ArgName("bots")->Arg(10)->Arg(50);
+#endif
+
+}
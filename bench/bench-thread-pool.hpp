@@ -0,0 +1,80 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+
+#include <utils/thread-pool.h>
+
+#include <bench/bench-utils.hpp>
+
+/* The scheduler that bot-compare, parallel bot decisions and environments run on (see utils/thread-pool.h) */
+namespace {
+
+  /* many tiny tasks scheduled from outside of the pool, as bot-compare schedules games */
+  static void PoolSchedule(benchmark::State& state) {
+    ThreadPool pool(state.range(0));
+    std::atomic<int> count(0);
+    int num_tasks = 10000;
+    for (auto _ : state) {
+      for (int i = 0; i < num_tasks; i++)
+        pool.schedule([&count]() { count.fetch_add(1, std::memory_order_relaxed); });
+      pool.wait();
+    }
+    state.SetItemsProcessed(state.iterations() * num_tasks);
+  }
+  BENCHMARK(PoolSchedule)->ArgName("threads")->Arg(1)->Arg(4)->UseRealTime();
+
+  /* tasks which spawn their own subtasks, which stay on the spawning worker's deque unless stolen */
+  static void PoolNested(benchmark::State& state) {
+    ThreadPool pool(state.range(0));
+    std::atomic<int> count(0);
+    int fan_out = 100;
+    for (auto _ : state) {
+      for (int i = 0; i < 100; i++)
+        pool.schedule([&]() {
+          for (int j = 0; j < fan_out; j++)
+            pool.schedule([&count]() { count.fetch_add(1, std::memory_order_relaxed); });
+        });
+      pool.wait();
+    }
+    state.SetItemsProcessed(state.iterations() * 100 * (fan_out + 1));
+  }
+  BENCHMARK(PoolNested)->ArgName("threads")->Arg(1)->Arg(4)->UseRealTime();
+
+  /* a parallel loop over small bodies, like a batch of bot decisions */
+  static void PoolParallelFor(benchmark::State& state) {
+    ThreadPool pool(state.range(0));
+    std::size_t n = 4096;
+    std::vector<float> values(n, 1.0f);
+    for (auto _ : state) {
+      pool.parallel_for(n, [&](std::size_t i) { values[i] = values[i] * 0.5f + 1.0f; });
+      benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+  }
+  BENCHMARK(PoolParallelFor)->ArgName("threads")->Arg(1)->Arg(4)->UseRealTime();
+
+  /* ticks of a game with many bots, deciding them on the pool */
+  static void TickParallelDecisions(benchmark::State& state) {
+    agario::Engine<false> engine;
+    engine.seed(42);
+    engine.reset();
+    bench::add_bots(engine, 100);
+    bench::warm_up(engine, 60);
+
+    std::unique_ptr<ThreadPool> pool;
+    if (state.range(0) > 0) {
+      pool = std::make_unique<ThreadPool>(state.range(0));
+      engine.set_thread_pool(pool.get());
+    }
+
+    agario::time_delta dt(1.0 / 60);
+    for (auto _ : state)
+      engine.tick(dt);
+    engine.set_thread_pool(nullptr);
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(TickParallelDecisions)->ArgName("threads")->Arg(0)->Arg(3)->UseRealTime();
+
+}
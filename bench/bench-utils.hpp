@@ -0,0 +1,40 @@
+#pragma once
+
+#include <agario/engine/Engine.hpp>
+#include <agario/bots/bots.hpp>
+
+namespace bench {
+
+  /* distinguishes results from the floating point and deterministic (fixed-point) builds */
+  inline const char *numeric_type() {
+#ifdef DETERMINISTIC
+    return "fixed-point";
+#else
+    return "float";
+#endif
+  }
+
+  /* adds `num_bots` bots to `engine`, cycling through each kind of bot
+   * (the same mix of bots that the environments add) */
+  template<bool renderable>
+  void add_bots(agario::Engine<renderable> &engine, int num_bots) {
+    using namespace agario::bot;
+    for (int i = 0; i < num_bots; i++) {
+      switch (i % 4) {
+        case 0: engine.template add_player<HungryBot<renderable>>(); break;
+        case 1: engine.template add_player<HungryShyBot<renderable>>(); break;
+        case 2: engine.template add_player<AggressiveBot<renderable>>(); break;
+        case 3: engine.template add_player<AggressiveShyBot<renderable>>(); break;
+      }
+    }
+  }
+
+  /* ticks `engine` enough that entities are spread out and bots have grown */
+  template<bool renderable>
+  void warm_up(agario::Engine<renderable> &engine, int num_ticks = 300) {
+    agario::time_delta dt(1.0 / 60);
+    for (int i = 0; i < num_ticks; i++)
+      engine.tick(dt);
+  }
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <agario/server/snapshot.hpp>
+
+#include <bench/bench-utils.hpp>
+
+/* Encoding the snapshots that the server sends its clients (see agario/server/wire.hpp) */
+namespace {
+
+  /* a game in progress, and views of it `ticks_apart` ticks apart, `view` wide around the center */
+  class SentGame {
+  public:
+    SentGame(float view, int ticks_apart) {
+      engine.seed(42);
+      engine.reset();
+      bench::add_bots(engine, 10);
+      bench::warm_up(engine, 60);
+
+      agario::Location center(engine.arena_width() / 2, engine.arena_height() / 2);
+      base = agario::server::capture(engine.get_game_state(), center, view);
+      bench::warm_up(engine, ticks_apart);
+      current = agario::server::capture(engine.get_game_state(), center, view);
+    }
+
+    agario::Engine<false> engine;
+    agario::server::Snapshot base, current;
+  };
+
+  void report(benchmark::State& state, const agario::server::Snapshot &snapshot, std::size_t bytes) {
+    state.SetItemsProcessed(state.iterations() * snapshot.size());
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.counters["entities"] = snapshot.size();
+    state.counters["bytes/entity"] = snapshot.empty() ? 0 : static_cast<double>(bytes) / snapshot.size();
+  }
+
+  /* a complete snapshot, as sent to clients which haven't acknowledged one yet */
+  static void WireEncodeSnapshot(benchmark::State& state) {
+    SentGame game(state.range(0), 0);
+    agario::server::Snapshot empty;
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+      agario::server::BitWriter out;
+      agario::server::write_delta(out, empty, game.current);
+      bytes = out.bytes().size();
+      benchmark::DoNotOptimize(bytes);
+    }
+    report(state, game.current, bytes);
+  }
+  BENCHMARK(WireEncodeSnapshot)->ArgName("view")->Arg(100)->Arg(300)->Arg(1000);
+
+  /* a delta against a snapshot from a number of ticks earlier */
+  static void WireEncodeDelta(benchmark::State& state) {
+    SentGame game(300, state.range(0));
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+      agario::server::BitWriter out;
+      agario::server::write_delta(out, game.base, game.current);
+      bytes = out.bytes().size();
+      benchmark::DoNotOptimize(bytes);
+    }
+    report(state, game.current, bytes);
+  }
+  BENCHMARK(WireEncodeDelta)->ArgName("ticks")->Arg(1)->Arg(10)->Arg(30);
+
+  static void WireDecodeSnapshot(benchmark::State& state) {
+    SentGame game(state.range(0), 0);
+    agario::server::Snapshot empty;
+    agario::server::BitWriter out;
+    agario::server::write_delta(out, empty, game.current);
+    auto bytes = out.bytes();
+    for (auto _ : state) {
+      agario::server::BitReader in(bytes);
+      auto snapshot = agario::server::read_delta(in, empty);
+      benchmark::DoNotOptimize(snapshot.data());
+    }
+    report(state, game.current, bytes.size());
+  }
+  BENCHMARK(WireDecodeSnapshot)->ArgName("view")->Arg(300)->Arg(1000);
+
+}
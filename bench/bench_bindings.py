@@ -0,0 +1,122 @@
+#!/usr/bin/env python
+"""
+File: bench_bindings
+Date: 2026-10-19
+
+Benchmarks the Python bindings to the environments (`agarle`), including
+the cost of converting observations to NumPy arrays, which the C++
+benchmarks in `agario-bench` don't cover. Results are written in
+Google Benchmark's JSON format so that they can be compared between
+releases with `compare.py`.
+
+    python bench/bench_bindings.py --out bindings.json
+"""
+
+import sys
+import json
+import time
+import argparse
+import platform
+
+import agarle
+
+# (num_agents, ticks_per_step, arena_size, pellet_regen, num_pellets, num_viruses, num_bots)
+ENV_ARGS = (1, 4, 500, True, 1024, 25, 10)
+
+
+def make_grid_env(num_agents=1):
+    args = (num_agents,) + ENV_ARGS[1:]
+    env = agarle.GridEnvironment(*args)
+    env.configure_observation({"num_frames": 2, "grid_size": 128})
+    env.seed(42)
+    env.reset()
+    return env
+
+
+def make_sparse_env(num_agents=1):
+    args = (num_agents,) + ENV_ARGS[1:]
+    env = agarle.SparseEnvironment(*args)
+    env.seed(42)
+    env.reset()
+    return env
+
+
+def time_function(name, f, min_time):
+    """ calls `f` repeatedly for at least `min_time` seconds
+    :return: Google Benchmark style result for `f`
+    """
+    iterations = 0
+    wall_start, cpu_start = time.perf_counter(), time.process_time()
+    while time.perf_counter() - wall_start < min_time:
+        f()
+        iterations += 1
+    wall = time.perf_counter() - wall_start
+    cpu = time.process_time() - cpu_start
+
+    return {
+        "name": name,
+        "run_name": name,
+        "run_type": "iteration",
+        "repetitions": 1,
+        "iterations": iterations,
+        "real_time": 1e9 * wall / iterations,
+        "cpu_time": 1e9 * cpu / iterations,
+        "time_unit": "ns",
+    }
+
+
+def benchmarks():
+    """ yields (name, function to time) for each benchmark """
+    for num_agents in (1, 8):
+        env = make_grid_env(num_agents)
+        actions = [(0.0, 0.0, 0)] * num_agents
+
+        def step(env=env, actions=actions):
+            env.take_actions(actions)
+            env.step()
+        yield f"GridEnv/step/agents:{num_agents}", step
+        yield f"GridEnv/get_state/agents:{num_agents}", env.get_state
+
+        env = make_sparse_env(num_agents)
+
+        def step(env=env, actions=actions):
+            env.take_actions(actions)
+            env.step()
+        yield f"SparseEnv/step/agents:{num_agents}", step
+        yield f"SparseEnv/get_state/agents:{num_agents}", env.get_state
+
+    yield "GridEnv/reset", make_grid_env().reset
+    yield "SparseEnv/reset", make_sparse_env().reset
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark the agarle Python bindings")
+    parser.add_argument("--out", help="file to write JSON results to (default: stdout)")
+    parser.add_argument("--min-time", type=float, default=1.0, help="seconds to run each benchmark")
+    args = parser.parse_args()
+
+    results = []
+    for name, f in benchmarks():
+        result = time_function(name, f, args.min_time)
+        results.append(result)
+        print(f"{name:<32} {result['cpu_time'] / 1e3:>10.1f} us", file=sys.stderr)
+
+    output = {
+        "context": {
+            "date": time.strftime("%Y-%m-%dT%H:%M:%S"),
+            "host_name": platform.node(),
+            "executable": "bench_bindings.py",
+            "python": platform.python_version(),
+        },
+        "benchmarks": results,
+    }
+
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump(output, f, indent=2)
+    else:
+        json.dump(output, sys.stdout, indent=2)
+
+
+if __name__ == "__main__":
+    main()
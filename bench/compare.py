@@ -0,0 +1,119 @@
+#!/usr/bin/env python
+"""
+File: compare
+Date: 2026-10-19
+
+Compares two sets of benchmark results in Google Benchmark's JSON format
+(as written by `agario-bench --benchmark_out=results.json --benchmark_out_format=json`
+or by `bench_bindings.py`) and reports the change in time of each benchmark.
+
+    python bench/compare.py baseline.json contender.json [--threshold 0.1]
+
+Exits with a non-zero status if any benchmark got slower by more than
+the threshold, so that it can be used to catch performance regressions
+between releases.
+"""
+
+import sys
+import json
+import argparse
+
+# conversion of Google Benchmark's time units to nanoseconds
+TIME_UNITS = {"ns": 1, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_times(path, metric):
+    """ reads a benchmark results file
+    :param path: path to the JSON results file
+    :param metric: which time to compare ("cpu_time" or "real_time")
+    :return: dictionary mapping benchmark name to time in nanoseconds
+    """
+    with open(path) as f:
+        results = json.load(f)
+
+    times = {}
+    for benchmark in results["benchmarks"]:
+        if "error_occurred" in benchmark and benchmark["error_occurred"]:
+            continue
+
+        # with --benchmark_repetitions compare the medians of the repetitions
+        if benchmark.get("run_type") == "aggregate":
+            if benchmark.get("aggregate_name") != "median":
+                continue
+            name = benchmark["run_name"]
+        elif "run_name" in benchmark and benchmark.get("repetitions", 1) > 1:
+            continue
+        else:
+            name = benchmark["name"]
+
+        unit = TIME_UNITS[benchmark.get("time_unit", "ns")]
+        times[name] = benchmark[metric] * unit
+    return times
+
+
+def format_time(ns):
+    for unit in ("ns", "us", "ms"):
+        if ns < 1000:
+            return f"{ns:.1f} {unit}"
+        ns /= 1000
+    return f"{ns:.2f} s"
+
+
+def compare(baseline, contender, threshold):
+    """ prints the change in time of each benchmark in both `baseline` and `contender`
+    :return: the names of the benchmarks which got slower by more than `threshold`
+    """
+    names = [name for name in baseline if name in contender]
+    if not names:
+        return []
+
+    width = max(len(name) for name in names)
+    print(f"{'Benchmark':<{width}} {'Baseline':>12} {'Contender':>12} {'Change':>9}")
+    print("=" * (width + 36))
+
+    regressions = []
+    for name in names:
+        before, after = baseline[name], contender[name]
+        change = (after - before) / before if before > 0 else 0
+
+        flag = ""
+        if change > threshold:
+            flag = "  REGRESSION"
+            regressions.append(name)
+        elif change < -threshold:
+            flag = "  improvement"
+
+        print(f"{name:<{width}} {format_time(before):>12} {format_time(after):>12} {100 * change:>+8.1f}%{flag}")
+
+    for name in baseline:
+        if name not in contender:
+            print(f"{name}: missing from contender")
+    for name in contender:
+        if name not in baseline:
+            print(f"{name}: new benchmark")
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two benchmark result files",
+                                     formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument("baseline", help="JSON results of the baseline (e.g. previous release)")
+    parser.add_argument("contender", help="JSON results to compare against the baseline")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="relative slow-down which counts as a regression")
+    parser.add_argument("--metric", choices=("cpu_time", "real_time"), default="cpu_time",
+                        help="which time to compare")
+    args = parser.parse_args()
+
+    baseline = load_times(args.baseline, args.metric)
+    contender = load_times(args.contender, args.metric)
+
+    regressions = compare(baseline, contender, args.threshold)
+    if regressions:
+        print(f"\n{len(regressions)} benchmark(s) regressed by more than {100 * args.threshold:.0f}%")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -5,12 +5,14 @@
 
 #include <tuple>
 #include <iostream>
+#include <cstdint>
 #include <environment/envs/GridEnvironment.hpp>
 #include <environment/envs/RamEnvironment.hpp>
-
-#ifdef INCLUDE_SCREEN_ENV
+#include <environment/envs/SparseEnvironment.hpp>
 #include <environment/envs/ScreenEnvironment.hpp>
-#endif
+#include <environment/dataset/DatasetWriter.hpp>
+#include <environment/dataset/DatasetReader.hpp>
+#include <utils/trace.h>
 
 #include <environment/renderable.hpp>
 
@@ -68,16 +70,168 @@ py::list get_state(const Environment &environment) {
   return obs; // list of numpy arrays
 }
 
+/**
+ * packs the variable-length observations of every agent into one
+ * (num_records, record_length) NumPy array along with an array of
+ * `num_agents + 1` row offsets delimiting each agent's records
+ */
+template <typename Environment>
+py::tuple get_packed_state(const Environment &environment) {
+  using dtype = typename Environment::dtype;
+
+  auto length = environment.packed_length();
+  auto record_length = environment.record_length();
+
+  auto *data = new dtype[length];
+  auto *offsets = new std::int64_t[environment.num_agents() + 1];
+  environment.pack_observations(data, offsets);
+
+  py::capsule cleanup_data(data, [](void *ptr) {
+    delete[] reinterpret_cast<dtype*>(ptr);
+  });
+  py::capsule cleanup_offsets(offsets, [](void *ptr) {
+    delete[] reinterpret_cast<std::int64_t*>(ptr);
+  });
+
+  std::vector<ssize_t> shape = { length / record_length, record_length };
+  std::vector<ssize_t> strides = {
+    static_cast<ssize_t>(record_length * sizeof(dtype)),
+    static_cast<ssize_t>(sizeof(dtype))
+  };
+
+  py::array_t<dtype> records(shape, strides, data, cleanup_data);
+  py::array_t<std::int64_t> row_offsets({ environment.num_agents() + 1 }, offsets, cleanup_offsets);
+  return py::make_tuple(records, row_offsets);
+}
+
+/* sets when an environment's bots decide (see agario::BotSchedule) */
+template <typename Environment>
+void set_bot_schedule(Environment &environment, int period, bool staggered, int distant_period,
+                      float view_margin, float idle_radius) {
+  agario::BotSchedule schedule;
+  schedule.period = period;
+  schedule.staggered = staggered;
+  schedule.distant_period = distant_period;
+  schedule.view_margin = view_margin;
+  schedule.idle_radius = idle_radius;
+  environment.set_bot_schedule(schedule);
+}
+
+/* how often an environment's bots have decided, as a dictionary */
+template <typename Environment>
+py::dict get_decision_stats(const Environment &environment) {
+  auto &stats = environment.decision_stats();
+  py::dict decisions;
+  decisions["ticks"] = stats.ticks;
+  decisions["bot_ticks"] = stats.bot_ticks;
+  decisions["decisions"] = stats.decisions;
+  decisions["deferred"] = stats.deferred;
+  decisions["peak_decisions"] = stats.peak_decisions;
+  decisions["rate"] = stats.rate();
+  decisions["per_tick"] = stats.per_tick();
+  return decisions;
+}
+
+/**
+ * the engine's per-phase tick profile as a dictionary, which
+ * is empty unless compiled with ENGINE_PROFILING
+ */
+template <typename Environment>
+py::dict get_stats(const Environment &environment) {
+  using namespace py::literals;
+  py::dict stats;
+  if (!agario::TickStats::enabled) return stats;
+
+  auto &tick_stats = environment.stats();
+  py::dict phase_seconds;
+  for (int phase = 0; phase < agario::num_tick_phases; phase++)
+    phase_seconds[py::str(agario::phase_name(phase))] = tick_stats.seconds[phase];
+
+  stats["ticks"] = tick_stats.ticks;
+  stats["tick_seconds"] = tick_stats.tick_seconds;
+  stats["phase_seconds"] = phase_seconds;
+  stats["collision_tests"] = py::dict("pellet"_a=tick_stats.pellet_tests,
+                                      "food"_a=tick_stats.food_tests,
+                                      "virus"_a=tick_stats.virus_tests,
+                                      "cell"_a=tick_stats.cell_tests);
+  stats["entities"] = py::dict("players"_a=tick_stats.num_players,
+                               "cells"_a=tick_stats.num_cells,
+                               "pellets"_a=tick_stats.num_pellets,
+                               "foods"_a=tick_stats.num_foods,
+                               "viruses"_a=tick_stats.num_viruses);
+  return stats;
+}
+
+/**
+ * wraps a column of a dataset chunk in a read-only NumPy array of shape
+ * (rows, *row_shape) which shares (rather than copies) the mapped file
+ */
+py::array column_array(agario::env::dataset::DatasetReader &reader, std::size_t chunk, const std::string &name) {
+  auto view = reader.column(chunk, name);
+
+  std::vector<ssize_t> shape = { static_cast<ssize_t>(view.rows) };
+  for (auto dim : view.column->shape)
+    shape.push_back(static_cast<ssize_t>(dim));
+
+  // the capsule keeps the mapping (or decompressed buffer) alive with the array
+  auto *owner = new std::shared_ptr<const void>(view.owner);
+  py::capsule cleanup(owner, [](void *ptr) {
+    delete reinterpret_cast<std::shared_ptr<const void>*>(ptr);
+  });
+
+  py::array array(py::dtype(view.column->typestr), shape, view.data, cleanup);
+  py::detail::array_proxy(array.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+  return array;
+}
+
+/* binds a ScreenEnvironment (with either screen) as `name` */
+template <typename ScreenEnvironment>
+void bind_screen_environment(py::module &module, const char *name) {
+  using namespace py::literals;
+
+  py::class_<ScreenEnvironment>(module, name)
+    .def(py::init<int, int, int, bool, int, int, int, int, screen_len, screen_len>())
+    .def("seed", &ScreenEnvironment::seed)
+    .def("set_num_threads", &ScreenEnvironment::set_num_threads, "num_threads"_a)
+    .def("set_arena_tiles", &ScreenEnvironment::set_arena_tiles, "columns"_a, "rows"_a)
+    .def("set_bot_schedule", &set_bot_schedule<ScreenEnvironment>, "period"_a = 10, "staggered"_a = false,
+         "distant_period"_a = 0, "view_margin"_a = 50, "idle_radius"_a = 0)
+    .def("decision_stats", &get_decision_stats<ScreenEnvironment>)
+    .def("observation_shape", &ScreenEnvironment::observation_shape)
+    .def("dones", &ScreenEnvironment::dones)
+    .def("take_actions", [](ScreenEnvironment &env, const py::list &actions) {
+      env.take_actions(to_action_vector(actions));
+    })
+    .def("reset", &ScreenEnvironment::reset)
+    .def("render", &ScreenEnvironment::render)
+    .def("step", &ScreenEnvironment::step)
+    .def("stats", &get_stats<ScreenEnvironment>)
+    .def("get_state", &get_state<ScreenEnvironment>);
+}
+
 PYBIND11_MODULE(agarle, module) {
   using namespace py::literals;
   module.doc() = "Agar.io Learning Environment";
 
+  /* ================ Tracing ================ */
+  /* timeline of steps and ticks (only recorded if compiled with ENGINE_TRACING) */
+
+  module.def("trace_start", &trace::start);
+  module.def("trace_stop", &trace::stop);
+  module.def("trace_clear", &trace::clear);
+  module.def("trace_flush", &trace::flush, "path"_a);
+
   /* ================ Grid Environment ================ */
   using GridEnvironment = agario::env::GridEnvironment<int, renderable>;
 
   py::class_<GridEnvironment>(module, "GridEnvironment")
     .def(py::init<int, int, int, bool, int, int, int>())
     .def("seed", &GridEnvironment::seed)
+    .def("set_num_threads", &GridEnvironment::set_num_threads, "num_threads"_a)
+    .def("set_arena_tiles", &GridEnvironment::set_arena_tiles, "columns"_a, "rows"_a)
+    .def("set_bot_schedule", &set_bot_schedule<GridEnvironment>, "period"_a = 10, "staggered"_a = false,
+         "distant_period"_a = 0, "view_margin"_a = 50, "idle_radius"_a = 0)
+    .def("decision_stats", &get_decision_stats<GridEnvironment>)
     .def("configure_observation", [](GridEnvironment &env, const py::dict &config) {
 
       int num_frames = config.contains("num_frames")      ? config["num_frames"].cast<int>() : 2;
@@ -97,6 +251,7 @@ PYBIND11_MODULE(agarle, module) {
     .def("reset", &GridEnvironment::reset)
     .def("render", &GridEnvironment::render)
     .def("step", &GridEnvironment::step)
+    .def("stats", &get_stats<GridEnvironment>)
     .def("get_state", &get_state<GridEnvironment>);
 
   
@@ -106,6 +261,11 @@ PYBIND11_MODULE(agarle, module) {
   py::class_<RamEnvironment>(module, "RamEnvironment")
     .def(py::init<int, int, int, bool, int, int, int>())
     .def("seed", &RamEnvironment::seed)
+    .def("set_num_threads", &RamEnvironment::set_num_threads, "num_threads"_a)
+    .def("set_arena_tiles", &RamEnvironment::set_arena_tiles, "columns"_a, "rows"_a)
+    .def("set_bot_schedule", &set_bot_schedule<RamEnvironment>, "period"_a = 10, "staggered"_a = false,
+         "distant_period"_a = 0, "view_margin"_a = 50, "idle_radius"_a = 0)
+    .def("decision_stats", &get_decision_stats<RamEnvironment>)
     .def("observation_shape", &RamEnvironment::observation_shape)
     .def("dones", &RamEnvironment::dones)
     .def("take_actions", [](RamEnvironment &env, const py::list &actions) {
@@ -114,36 +274,90 @@ PYBIND11_MODULE(agarle, module) {
     .def("reset", &RamEnvironment::reset)
     .def("render", &RamEnvironment::render)
     .def("step", &RamEnvironment::step)
+    .def("stats", &get_stats<RamEnvironment>)
     .def("get_state", &get_state<RamEnvironment>);
 
+
+  /* ================ Sparse Environment ================ */
+  using SparseEnvironment = agario::env::SparseEnvironment<renderable>;
+
+  py::class_<SparseEnvironment>(module, "SparseEnvironment")
+    .def(py::init<int, int, int, bool, int, int, int>())
+    .def("seed", &SparseEnvironment::seed)
+    .def("set_num_threads", &SparseEnvironment::set_num_threads, "num_threads"_a)
+    .def("set_arena_tiles", &SparseEnvironment::set_arena_tiles, "columns"_a, "rows"_a)
+    .def("set_bot_schedule", &set_bot_schedule<SparseEnvironment>, "period"_a = 10, "staggered"_a = false,
+         "distant_period"_a = 0, "view_margin"_a = 50, "idle_radius"_a = 0)
+    .def("decision_stats", &get_decision_stats<SparseEnvironment>)
+    .def("record_length", &SparseEnvironment::record_length)
+    .def("dones", &SparseEnvironment::dones)
+    .def("take_actions", [](SparseEnvironment &env, const py::list &actions) {
+      env.take_actions(to_action_vector(actions));
+    })
+    .def("reset", &SparseEnvironment::reset)
+    .def("render", &SparseEnvironment::render)
+    .def("step", &SparseEnvironment::step)
+    .def("stats", &get_stats<SparseEnvironment>)
+    .def("get_state", &get_packed_state<SparseEnvironment>);
+
   
-  /* ================ Screen Environment ================ */
-  /* we only include this conditionally if OpenGL was found available for linking */
+  /* ================ Datasets ================ */
+  /* record trajectories to disk, and map them back for offline learning */
 
-#ifdef INCLUDE_SCREEN_ENV
+  py::class_<agario::env::DatasetWriter<GridEnvironment>>(module, "GridDatasetWriter")
+    .def(py::init<GridEnvironment &, const std::string &, int, bool>(),
+         "environment"_a, "path"_a, "steps_per_chunk"_a=agario::env::dataset::default_steps_per_chunk,
+         "compress"_a=false, py::keep_alive<1, 2>())
+    .def("steps", &agario::env::DatasetWriter<GridEnvironment>::steps)
+    .def("close", &agario::env::DatasetWriter<GridEnvironment>::close);
 
-  // todo: convert ScreenEnvironment to multi-environment
-
-//  using ScreenEnvironment = agario::env::ScreenEnvironment<renderable>;
-//
-//  py::class_<ScreenEnvironment>(module, "ScreenEnvironment")
-//    .def(py::init<int, int, int, bool, int, int, int>())
-//    .def("seed", &ScreenEnvironment::seed)
-//    .def("observation_shape", &ScreenEnvironment::observation_shape)
-//    .def("dones", &ScreenEnvironment::dones)
-//    .def("take_actions", [](ScreenEnvironment &env, const py::list &actions) {
-//      env.take_actions(to_action_vector(actions));
-//    })
-//    .def("reset", &ScreenEnvironment::reset)
-//    .def("render", &ScreenEnvironment::render)
-//    .def("step", &ScreenEnvironment::step)
-//    .def("get_state", &get_state<ScreenEnvironment>);
+  py::class_<agario::env::DatasetWriter<SparseEnvironment>>(module, "SparseDatasetWriter")
+    .def(py::init<SparseEnvironment &, const std::string &, int, bool>(),
+         "environment"_a, "path"_a, "steps_per_chunk"_a=agario::env::dataset::default_steps_per_chunk,
+         "compress"_a=false, py::keep_alive<1, 2>())
+    .def("steps", &agario::env::DatasetWriter<SparseEnvironment>::steps)
+    .def("close", &agario::env::DatasetWriter<SparseEnvironment>::close);
+
+  using DatasetReader = agario::env::dataset::DatasetReader;
+
+  py::class_<DatasetReader>(module, "DatasetReader")
+    .def(py::init<const std::string &>(), "path"_a)
+    .def("num_agents", &DatasetReader::num_agents)
+    .def("num_chunks", &DatasetReader::num_chunks)
+    .def("num_steps", &DatasetReader::num_steps)
+    .def("chunk_steps", &DatasetReader::chunk_steps)
+    .def("columns", [](const DatasetReader &reader) {
+      py::list names;
+      for (auto &column : reader.columns())
+        names.append(column.name);
+      return names;
+    })
+    .def("column", &column_array, "chunk"_a, "name"_a)
+    .def("chunk", [](DatasetReader &reader, std::size_t chunk) {
+      py::dict arrays;
+      for (auto &column : reader.columns())
+        arrays[py::str(column.name)] = column_array(reader, chunk, column.name);
+      return arrays;
+    }, "chunk"_a);
 
+  
+  /* ================ Screen Environment ================ */
+  /* rendered on the CPU, or with OpenGL if it was found available for linking */
+
+  bind_screen_environment<agario::env::ScreenEnvironment<renderable, agario::env::SoftwareScreen>>(
+    module, "ScreenEnvironment");
   module.attr("has_screen_env") = py::bool_(true);
 
+#ifdef INCLUDE_SCREEN_ENV
+
+  // OpenGL renders from renderable game states, however `renderable` was configured
+  bind_screen_environment<agario::env::ScreenEnvironment<true, agario::env::OpenGLScreen>>(
+    module, "OpenGLScreenEnvironment");
+  module.attr("has_opengl_screen_env") = py::bool_(true);
+
 #else
 
-  module.attr("has_screen_env") = py::bool_(false);
+  module.attr("has_opengl_screen_env") = py::bool_(false);
 
 #endif
 
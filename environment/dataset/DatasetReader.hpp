@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "environment/envs/BaseEnvironment.hpp"
+#include "environment/dataset/format.hpp"
+
+namespace agario::env::dataset {
+
+  /* a read-only memory mapping of a whole file */
+  class MappedFile {
+  public:
+    explicit MappedFile(const std::string &path) : _data(nullptr), _size(0) {
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+        throw EnvironmentException("Could not open dataset file: " + path);
+
+      struct stat st {};
+      if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw EnvironmentException("Could not stat dataset file: " + path);
+      }
+
+      _size = static_cast<std::size_t>(st.st_size);
+      if (_size > 0) {
+        void *addr = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+          ::close(fd);
+          throw EnvironmentException("Could not map dataset file: " + path);
+        }
+        _data = static_cast<const char *>(addr);
+      }
+      ::close(fd); // the mapping stays valid after closing
+    }
+
+    [[nodiscard]] const char *data() const { return _data; }
+    [[nodiscard]] std::size_t size() const { return _size; }
+
+    ~MappedFile() {
+      if (_data != nullptr)
+        ::munmap(const_cast<char *>(_data), _size);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+  private:
+    const char *_data;
+    std::size_t _size;
+  };
+
+  /**
+   * The data of one column of a chunk, as `rows` rows of the column's shape.
+   * Uncompressed columns point directly into the mapped chunk file, which
+   * `owner` keeps mapped for as long as the view (or a copy of it) is alive.
+   */
+  struct ColumnView {
+    const Column *column;
+    const void *data;
+    std::uint64_t rows;
+    std::shared_ptr<const void> owner;
+
+    template<typename T>
+    const T *as() const {
+      if (column->item_size() != sizeof(T))
+        throw EnvironmentException("Column " + column->name + " is not of the requested type");
+      return static_cast<const T *>(data);
+    }
+
+    [[nodiscard]] std::size_t size_bytes() const { return rows * column->row_size(); }
+  };
+
+  /**
+   * Reads back the datasets written by DatasetWriter, mapping chunk files
+   * into memory as they are first accessed, so that datasets larger than
+   * memory can be sampled from.
+   */
+  class DatasetReader {
+  public:
+    explicit DatasetReader(const std::string &path) : path(path), _num_steps(0) {
+      std::ifstream index(index_file(path), std::ios::binary);
+      if (!index)
+        throw EnvironmentException("Could not open dataset index: " + index_file(path));
+
+      char m[sizeof(magic)];
+      if (!index.read(m, sizeof(m)) || std::memcmp(m, magic, sizeof(magic)) != 0)
+        throw binary::FormatException("Not a dataset: " + path);
+      if (binary::read<std::uint32_t>(index) != version)
+        throw binary::FormatException("Unsupported dataset version");
+
+      _num_agents = binary::read<std::uint32_t>(index);
+      _steps_per_chunk = binary::read<std::uint32_t>(index);
+      auto num_columns = binary::read<std::uint32_t>(index);
+      for (std::uint32_t i = 0; i < num_columns; i++) {
+        Column column;
+        column.name = binary::read_string(index);
+        column.typestr = binary::read_string(index);
+        auto dims = binary::read<std::uint32_t>(index);
+        for (std::uint32_t d = 0; d < dims; d++)
+          column.shape.push_back(binary::read<std::uint64_t>(index));
+        _columns.push_back(column);
+      }
+
+      // the index ends after the last complete chunk (a partial entry is ignored)
+      while (index.peek() != std::char_traits<char>::eof()) {
+        try {
+          Chunk chunk { binary::read<std::uint64_t>(index), {} };
+          for (std::size_t c = 0; c < _columns.size(); c++) {
+            Extent extent {};
+            extent.offset = binary::read<std::uint64_t>(index);
+            extent.stored_size = binary::read<std::uint64_t>(index);
+            extent.raw_size = binary::read<std::uint64_t>(index);
+            extent.encoding = binary::read<codec>(index);
+            chunk.extents.push_back(extent);
+          }
+          _num_steps += chunk.num_steps;
+          _chunks.push_back(chunk);
+        } catch (binary::FormatException &) {
+          break;
+        }
+      }
+      _files.resize(_chunks.size());
+    }
+
+    [[nodiscard]] int num_agents() const { return _num_agents; }
+    [[nodiscard]] int steps_per_chunk() const { return _steps_per_chunk; }
+    [[nodiscard]] std::size_t num_chunks() const { return _chunks.size(); }
+    [[nodiscard]] std::uint64_t num_steps() const { return _num_steps; }
+    [[nodiscard]] std::uint64_t chunk_steps(std::size_t chunk) const { return _chunks.at(chunk).num_steps; }
+    const std::vector<Column> &columns() const { return _columns; }
+
+    /* the data of the column named `name` in chunk number `chunk` */
+    ColumnView column(std::size_t chunk, const std::string &name) {
+      if (chunk >= _chunks.size())
+        throw EnvironmentException("Chunk " + std::to_string(chunk) + " out of range");
+
+      auto c = column_index(name);
+      auto &column = _columns[c];
+      auto &extent = _chunks[chunk].extents[c];
+      auto file = mapped(chunk);
+      if (extent.offset + extent.stored_size > file->size())
+        throw binary::FormatException("Dataset chunk is truncated: " + chunk_file(path, chunk));
+      if (extent.raw_size % column.row_size() != 0)
+        throw binary::FormatException("Column " + name + " is not a whole number of rows");
+
+      ColumnView view { &column, nullptr, extent.raw_size / column.row_size(), nullptr };
+      const char *stored = file->data() + extent.offset;
+      switch (extent.encoding) {
+        case raw:
+          view.data = stored;
+          view.owner = file;
+          break;
+        case zero_rle: {
+          auto decoded = std::shared_ptr<char>(new char[extent.raw_size], std::default_delete<char[]>());
+          zero_rle_decode(stored, extent.stored_size, decoded.get(), extent.raw_size);
+          view.data = decoded.get();
+          view.owner = decoded;
+          break;
+        }
+        default:
+          throw binary::FormatException("Unknown column encoding");
+      }
+      return view;
+    }
+
+  private:
+    const std::string path;
+    int _num_agents;
+    int _steps_per_chunk;
+    std::uint64_t _num_steps;
+    std::vector<Column> _columns;
+    std::vector<Chunk> _chunks;
+    std::vector<std::weak_ptr<MappedFile>> _files; // mapped while any view of them is alive
+
+    std::size_t column_index(const std::string &name) const {
+      for (std::size_t i = 0; i < _columns.size(); i++)
+        if (_columns[i].name == name) return i;
+      throw EnvironmentException("No column named " + name);
+    }
+
+    std::shared_ptr<MappedFile> mapped(std::size_t chunk) {
+      auto file = _files[chunk].lock();
+      if (file == nullptr) {
+        file = std::make_shared<MappedFile>(chunk_file(path, chunk));
+        _files[chunk] = file;
+      }
+      return file;
+    }
+  };
+
+}
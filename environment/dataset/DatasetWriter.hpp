@@ -0,0 +1,353 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "environment/envs/BaseEnvironment.hpp"
+#include "environment/dataset/format.hpp"
+
+namespace agario::env {
+
+  namespace dataset {
+
+    /* whether an environment's observations are variable-length, packed records */
+    template<typename Environment, typename = void>
+    struct is_packed : std::false_type {};
+
+    template<typename Environment>
+    struct is_packed<Environment, std::void_t<decltype(std::declval<const Environment &>().packed_length())>>
+      : std::true_type {};
+
+    /* a read-write memory mapping of a whole file, which may be grown */
+    class WritableMappedFile {
+    public:
+      /* creates (or truncates) the file at `path`, `size` bytes long */
+      WritableMappedFile(const std::string &path, std::size_t size) : _path(path), _data(nullptr), _size(0) {
+        _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (_fd < 0)
+          throw EnvironmentException("Could not create dataset file: " + path);
+        resize(size);
+      }
+
+      [[nodiscard]] char *data() { return _data; }
+      [[nodiscard]] std::size_t size() const { return _size; }
+
+      /* grows or shrinks the file, after which the mapping may have moved */
+      void resize(std::size_t size) {
+        if (::ftruncate(_fd, static_cast<off_t>(size)) != 0)
+          throw EnvironmentException("Could not resize dataset file: " + _path);
+
+        void *addr = _data == nullptr ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0)
+                                      : ::mremap(_data, _size, size, MREMAP_MAYMOVE);
+        if (addr == MAP_FAILED)
+          throw EnvironmentException("Could not map dataset file: " + _path);
+        _data = static_cast<char *>(addr);
+        _size = size;
+      }
+
+      /* unmaps the file, leaving its first `size` bytes */
+      void close(std::size_t size) {
+        ::munmap(_data, _size);
+        _data = nullptr;
+        bool truncated = ::ftruncate(_fd, static_cast<off_t>(size)) == 0;
+        bool closed = ::close(_fd) == 0;
+        _fd = -1;
+        if (!truncated || !closed)
+          throw EnvironmentException("Failed to write dataset file: " + _path);
+      }
+
+      ~WritableMappedFile() {
+        if (_data != nullptr) ::munmap(_data, _size);
+        if (_fd >= 0) ::close(_fd);
+      }
+
+      WritableMappedFile(const WritableMappedFile &) = delete;
+      WritableMappedFile &operator=(const WritableMappedFile &) = delete;
+
+    private:
+      const std::string _path;
+      int _fd;
+      char *_data;
+      std::size_t _size;
+    };
+
+  }
+
+  /**
+   * Streams the trajectories of an environment into a dataset on disk (see
+   * dataset/format.hpp), so that datasets larger than memory can be generated.
+   * Once attached, each step of the environment appends a row with
+   *
+   *   observations  what the agents observed before the step (their last observation)
+   *   actions       (num_agents, 3) float32 of the dx, dy and action passed to take_actions
+   *   rewards       (num_agents,) float32
+   *   dones         (num_agents,) uint8
+   *   episodes      uint32 number of times the environment has been reset since attaching
+   *
+   * Each chunk's worth of steps is written straight into a memory mapping of
+   * its own file, with every column laid out at its place for a full chunk
+   * (and variable-length records last, growing the file as needed), so that
+   * no steps are buffered on the heap: the kernel writes the mapped pages
+   * back as it sees fit. Once the chunk is full its columns are (optionally)
+   * compressed, one at a time, and packed together, and it is added to the index.
+   */
+  template<typename Environment>
+  class DatasetWriter : public EnvironmentObserver {
+    using dtype = typename Environment::dtype;
+    static constexpr bool packed = dataset::is_packed<Environment>::value;
+
+  public:
+    /**
+     * Attaches to `environment`, creating a dataset in the directory `path`
+     * @param steps_per_chunk the number of steps written to each chunk file
+     * @param compress whether to compress columns (where that makes them smaller)
+     */
+    DatasetWriter(Environment &environment, const std::string &path,
+                  int steps_per_chunk = dataset::default_steps_per_chunk, bool compress = false) :
+      environment(environment), path(path), steps_per_chunk(steps_per_chunk), compress(compress),
+      num_steps(0), num_chunks(0), episode(0) {
+
+      if (steps_per_chunk <= 0)
+        throw EnvironmentException("Steps per chunk must be positive");
+      if (::mkdir(path.c_str(), 0755) != 0 && errno != EEXIST)
+        throw EnvironmentException("Could not create dataset directory: " + path);
+
+      columns = make_columns();
+      lay_out_chunk();
+
+      index.open(dataset::index_file(path), std::ios::binary | std::ios::trunc);
+      if (!index)
+        throw EnvironmentException("Could not create dataset index: " + dataset::index_file(path));
+      dataset::write_header(index, environment.num_agents(), steps_per_chunk, columns);
+      index.flush();
+
+      environment.set_observer(this);
+    }
+
+    /* writes any remaining steps and detaches from the environment */
+    void close() {
+      if (!index.is_open()) return;
+      environment.set_observer(nullptr);
+      if (steps_in_chunk() > 0) {
+        write_chunk();
+      } else if (chunk != nullptr) {
+        chunk.reset(); // began by an unfinished step
+        std::remove(dataset::chunk_file(path, num_chunks).c_str());
+      }
+      index.close();
+    }
+
+    /* the number of steps recorded */
+    [[nodiscard]] std::uint64_t steps() const { return num_steps; }
+
+    const std::vector<dataset::Column> &column_info() const { return columns; }
+
+    void before_step() override {
+      if (chunk == nullptr)
+        chunk = std::make_unique<dataset::WritableMappedFile>(dataset::chunk_file(path, num_chunks), chunk_size);
+      written = written_at_step; // (overwriting any step that began but didn't finish)
+
+      if constexpr (packed) {
+        auto record_base = static_cast<std::int64_t>(written[observations] / columns[observations].row_size());
+        auto records = reserve(observations, environment.packed_length() * sizeof(dtype));
+        environment.pack_observations(reinterpret_cast<dtype *>(records), agent_offsets.data());
+        for (auto &offset : agent_offsets)
+          append(observation_offsets, offset + record_base);
+      } else {
+        for (auto &observation : environment.get_observations())
+          std::memcpy(reserve(observations, observation.length() * sizeof(dtype)),
+                      observation.data(), observation.length() * sizeof(dtype));
+      }
+    }
+
+    void after_step(const std::vector<reward> &rewards) override {
+      auto &actions = environment.actions();
+      auto dones = environment.dones();
+      for (int i = 0; i < environment.num_agents(); i++) {
+        bool acted = i < static_cast<int>(actions.size());
+        append<float>(action_column, acted ? actions[i].dx : 0);
+        append<float>(action_column, acted ? actions[i].dy : 0);
+        append<float>(action_column, acted ? actions[i].a : 0);
+        append<float>(reward_column, rewards[i]);
+        append<std::uint8_t>(done_column, dones[i]);
+      }
+      append<std::uint32_t>(episode_column, episode);
+
+      num_steps++;
+      written_at_step = written;
+      if (steps_in_chunk() == static_cast<std::uint64_t>(steps_per_chunk))
+        write_chunk();
+    }
+
+    void after_reset() override { episode++; }
+
+    ~DatasetWriter() override { close(); }
+
+    DatasetWriter(const DatasetWriter &) = delete;
+    DatasetWriter &operator=(const DatasetWriter &) = delete;
+
+  private:
+    Environment &environment;
+    const std::string path;
+    const int steps_per_chunk;
+    const bool compress;
+
+    std::uint64_t num_steps;
+    std::uint64_t num_chunks;
+    std::uint32_t episode;
+
+    std::vector<dataset::Column> columns;
+    std::ofstream index;
+
+    std::unique_ptr<dataset::WritableMappedFile> chunk; // the chunk being written, if begun
+    std::uint64_t chunk_size;               // of a chunk's file before it is packed (and while records fit)
+    std::vector<std::uint64_t> placement;   // where each column starts in the chunk's file
+    std::vector<std::uint64_t> capacity;    // bytes of each column that fit before the next one
+    std::vector<std::uint64_t> written;     // bytes of each column written so far
+    std::vector<std::uint64_t> written_at_step; // as of the end of the last complete step
+    std::vector<std::int64_t> agent_offsets;    // of each agent's packed observations, reused for each step
+
+    // column indices (the observation offsets column only exists for packed observations)
+    static constexpr int observations = 0;
+    static constexpr int observation_offsets = 1;
+    static constexpr int action_column = packed ? 2 : 1;
+    static constexpr int reward_column = action_column + 1;
+    static constexpr int done_column = action_column + 2;
+    static constexpr int episode_column = action_column + 3;
+
+    std::vector<dataset::Column> make_columns() const {
+      using dataset::typestr;
+      std::vector<dataset::Column> cols;
+      auto agents = static_cast<std::uint64_t>(environment.num_agents());
+
+      if constexpr (packed) {
+        cols.push_back({ "observations", typestr<dtype>(), { static_cast<std::uint64_t>(environment.record_length()) } });
+        cols.push_back({ "observation_offsets", typestr<std::int64_t>(), { agents + 1 } });
+      } else {
+        auto &observations = environment.get_observations();
+        if (observations.empty())
+          throw EnvironmentException("Observations must be configured before recording a dataset");
+
+        std::vector<std::uint64_t> shape = { agents };
+        std::apply([&](auto... dims) { (shape.push_back(dims), ...); }, observations.front().shape());
+        cols.push_back({ "observations", typestr<dtype>(), shape });
+      }
+      cols.push_back({ "actions", typestr<float>(), { agents, 3 } });
+      cols.push_back({ "rewards", typestr<float>(), { agents } });
+      cols.push_back({ "dones", typestr<std::uint8_t>(), { agents } });
+      cols.push_back({ "episodes", typestr<std::uint32_t>(), { } });
+      return cols;
+    }
+
+    static std::uint64_t aligned(std::uint64_t offset) {
+      return (offset + dataset::alignment - 1) / dataset::alignment * dataset::alignment;
+    }
+
+    /* the columns in the order they are placed in a chunk's file (packed records last, as they may grow) */
+    [[nodiscard]] std::vector<int> file_order() const {
+      std::vector<int> order;
+      for (int c = packed ? 1 : 0; c < static_cast<int>(columns.size()); c++)
+        order.push_back(c);
+      if (packed) order.push_back(observations);
+      return order;
+    }
+
+    /**
+     * Places each column of the next chunk, with room for a full chunk of the
+     * columns with one row per step. Records are given room for as many as the
+     * last chunk grew to hold (or one per step, at first).
+     */
+    void lay_out_chunk() {
+      auto record_room = packed && !capacity.empty() ? capacity[observations] : 0;
+      placement.assign(columns.size(), 0);
+      capacity.assign(columns.size(), 0);
+      written.assign(columns.size(), 0);
+      written_at_step = written;
+      agent_offsets.resize(environment.num_agents() + 1);
+
+      std::uint64_t end = 0;
+      for (int c : file_order()) {
+        placement[c] = aligned(end);
+        capacity[c] = std::max<std::uint64_t>(columns[c].row_size() * steps_per_chunk,
+                                              c == observations ? record_room : 0);
+        end = placement[c] + capacity[c];
+      }
+      chunk_size = end;
+    }
+
+    [[nodiscard]] std::uint64_t steps_in_chunk() const {
+      return written_at_step[episode_column] / sizeof(std::uint32_t);
+    }
+
+    /* where to write the next `size` bytes of column `c` (growing the file for records) */
+    char *reserve(int c, std::size_t size) {
+      if (written[c] + size > capacity[c]) {
+        if (!packed || c != observations)
+          throw EnvironmentException("Dataset column " + columns[c].name + " overflowed its chunk");
+        capacity[c] = std::max(2 * capacity[c], written[c] + size);
+        chunk->resize(placement[c] + capacity[c]);
+      }
+      auto at = chunk->data() + placement[c] + written[c];
+      written[c] += size;
+      return at;
+    }
+
+    template<typename T>
+    void append(int c, T value) {
+      std::memcpy(reserve(c, sizeof(T)), &value, sizeof(T));
+    }
+
+    /**
+     * Finishes the chunk being written, packing its columns together from
+     * where they were placed (compressing them, if enabled), and adds it to
+     * the index. Columns only ever move towards the start of the file, as each
+     * is stored in no more than the room it was given.
+     */
+    void write_chunk() {
+      auto data = chunk->data();
+      dataset::Chunk entry { steps_in_chunk(), std::vector<dataset::Extent>(columns.size()) };
+      std::uint64_t end = 0;
+      for (int c : file_order()) {
+        auto raw_size = written_at_step[c];
+        auto offset = aligned(end);
+        std::memset(data + end, 0, offset - end);
+
+        dataset::Extent extent { offset, raw_size, raw_size, dataset::raw };
+        if (compress && raw_size <= UINT32_MAX) {
+          auto encoded = dataset::zero_rle_encode(data + placement[c], raw_size);
+          if (encoded.size() < raw_size) {
+            extent.stored_size = encoded.size();
+            extent.encoding = dataset::zero_rle;
+            std::memcpy(data + offset, encoded.data(), encoded.size());
+          }
+        }
+        if (extent.encoding == dataset::raw && offset != placement[c])
+          std::memmove(data + offset, data + placement[c], raw_size);
+
+        entry.extents[c] = extent;
+        end = offset + extent.stored_size;
+      }
+      chunk->close(end);
+      chunk.reset();
+
+      // the chunk is only added to the index once its file is complete
+      dataset::write_chunk(index, entry);
+      index.flush();
+      num_chunks++;
+      lay_out_chunk();
+    }
+  };
+
+}
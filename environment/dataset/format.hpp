@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <agario/engine/binary.hpp>
+#include "environment/envs/BaseEnvironment.hpp"
+
+/**
+ * On-disk format of the trajectory datasets written by DatasetWriter and read by
+ * DatasetReader. A dataset is a directory holding an index and numbered chunk files
+ *
+ *   index.bin          magic "AGDS", version, number of agents, steps per chunk and a
+ *                      description of each column, followed by one entry per chunk
+ *                      which is appended once the chunk has been written
+ *   chunk-000000.bin   the data of each column for a range of steps, one after the
+ *                      other (each aligned to 64 bytes so that it can be memory mapped)
+ *
+ * Each column is an array of rows of a fixed shape and type. For most columns there is
+ * one row per step, but the rows of variable-length observations (SparseEnvironment)
+ * are entity records, delimited by the "observation_offsets" column. Columns may be
+ * stored compressed, with a run-length encoding of zero bytes which suits the mostly
+ * empty grid observations well and costs little to decode.
+ */
+namespace agario::env::dataset {
+
+  constexpr char magic[4] = { 'A', 'G', 'D', 'S' };
+  constexpr std::uint32_t version = 1;
+  constexpr std::size_t alignment = 64;
+  constexpr int default_steps_per_chunk = 1024;
+
+  enum codec : std::uint8_t { raw = 0, zero_rle = 1 };
+
+  /* describes the rows of a column */
+  struct Column {
+    std::string name;
+    std::string typestr;              // NumPy array interface type string, e.g. "<f4"
+    std::vector<std::uint64_t> shape; // of each row
+
+    [[nodiscard]] std::size_t item_size() const { return std::stoul(typestr.substr(2)); }
+
+    [[nodiscard]] std::size_t row_size() const {
+      std::size_t size = item_size();
+      for (auto dim : shape) size *= dim;
+      return size;
+    }
+  };
+
+  /* where a column of a chunk is stored in the chunk file */
+  struct Extent {
+    std::uint64_t offset;      // in the chunk file
+    std::uint64_t stored_size; // in the file (compressed size if compressed)
+    std::uint64_t raw_size;
+    codec encoding;
+  };
+
+  struct Chunk {
+    std::uint64_t num_steps;
+    std::vector<Extent> extents; // one for each column
+  };
+
+  /* the NumPy type string for T */
+  template<typename T>
+  std::string typestr() {
+    static_assert(std::is_arithmetic<T>::value, "Columns must be of an arithmetic type");
+    char kind = std::is_floating_point<T>::value ? 'f' : (std::is_signed<T>::value ? 'i' : 'u');
+    return std::string(sizeof(T) == 1 ? "|" : "<") + kind + std::to_string(sizeof(T));
+  }
+
+  inline std::string chunk_file(const std::string &path, std::size_t chunk) {
+    auto number = std::to_string(chunk);
+    return path + "/chunk-" + std::string(6 - std::min<std::size_t>(6, number.size()), '0') + number + ".bin";
+  }
+
+  inline std::string index_file(const std::string &path) { return path + "/index.bin"; }
+
+  inline void write_header(std::ostream &os, int num_agents, int steps_per_chunk,
+                           const std::vector<Column> &columns) {
+    os.write(magic, sizeof(magic));
+    binary::write(os, version);
+    binary::write<std::uint32_t>(os, num_agents);
+    binary::write<std::uint32_t>(os, steps_per_chunk);
+    binary::write<std::uint32_t>(os, columns.size());
+    for (auto &column : columns) {
+      binary::write_string(os, column.name);
+      binary::write_string(os, column.typestr);
+      binary::write<std::uint32_t>(os, column.shape.size());
+      for (auto dim : column.shape)
+        binary::write(os, dim);
+    }
+  }
+
+  inline void write_chunk(std::ostream &os, const Chunk &chunk) {
+    binary::write(os, chunk.num_steps);
+    for (auto &extent : chunk.extents) {
+      binary::write(os, extent.offset);
+      binary::write(os, extent.stored_size);
+      binary::write(os, extent.raw_size);
+      binary::write(os, extent.encoding);
+    }
+  }
+
+  /* ================ zero run-length encoding ================ */
+
+  /* runs of zeros shorter than this are left in with the literal bytes around them */
+  constexpr std::size_t min_zero_run = 8;
+
+  /**
+   * Encodes `data` as a sequence of (literal count, literal bytes, zero count)
+   * tokens, with the counts as 32 bit integers
+   */
+  inline std::vector<char> zero_rle_encode(const char *data, std::size_t size) {
+    std::vector<char> encoded;
+    auto put_count = [&](std::size_t count) {
+      auto n = static_cast<std::uint32_t>(count);
+      encoded.insert(encoded.end(), reinterpret_cast<char *>(&n), reinterpret_cast<char *>(&n) + sizeof(n));
+    };
+
+    std::size_t i = 0;
+    while (i < size) {
+      // literals extend up to the next sufficiently long run of zeros
+      std::size_t end = i, zeros = 0;
+      while (end < size) {
+        if (data[end] != 0) {
+          end++;
+          continue;
+        }
+        auto run_end = end;
+        while (run_end < size && data[run_end] == 0) run_end++;
+        if (run_end - end >= min_zero_run || run_end == size) {
+          zeros = run_end - end;
+          break;
+        }
+        end = run_end;
+      }
+
+      put_count(end - i);
+      encoded.insert(encoded.end(), data + i, data + end);
+      put_count(zeros);
+      i = end + zeros;
+    }
+    return encoded;
+  }
+
+  /* decodes `size` bytes of zero_rle_encode output into `out` of `out_size` bytes */
+  inline void zero_rle_decode(const char *data, std::size_t size, char *out, std::size_t out_size) {
+    auto get_count = [&](std::size_t &pos) {
+      std::uint32_t n;
+      if (pos + sizeof(n) > size)
+        throw binary::FormatException("Truncated compressed column");
+      std::memcpy(&n, data + pos, sizeof(n));
+      pos += sizeof(n);
+      return static_cast<std::size_t>(n);
+    };
+
+    std::size_t pos = 0, written = 0;
+    while (pos < size) {
+      auto literals = get_count(pos);
+      if (pos + literals > size || written + literals > out_size)
+        throw binary::FormatException("Corrupt compressed column");
+      std::memcpy(out + written, data + pos, literals);
+      pos += literals;
+      written += literals;
+
+      auto zeros = get_count(pos);
+      if (written + zeros > out_size)
+        throw binary::FormatException("Corrupt compressed column");
+      std::memset(out + written, 0, zeros);
+      written += zeros;
+    }
+    if (written != out_size)
+      throw binary::FormatException("Compressed column has the wrong size");
+  }
+
+}
@@ -7,6 +7,7 @@
 #include <agario/bots/bots.hpp>
 #include "agario/engine/GameState.hpp"
 
+#include <memory>
 #include <tuple>
 
 // 30 frames per second: the default amount of time between frames of the game
@@ -29,6 +30,18 @@ namespace agario {
 
     typedef double reward;
 
+    /**
+     * Is notified around each step and after each reset of an
+     * environment (e.g. by a DatasetWriter, see dataset/DatasetWriter.hpp)
+     */
+    class EnvironmentObserver {
+    public:
+      virtual void before_step() {}
+      virtual void after_step(const std::vector<reward> &/* rewards */) {}
+      virtual void after_reset() {}
+      virtual ~EnvironmentObserver() = default;
+    };
+
     template<bool renderable>
     class BaseEnvironment {
       using Player = agario::Player<renderable>;
@@ -41,7 +54,7 @@ namespace agario {
         dones_(num_agents),
         engine_(arena_size, arena_size, num_pellets, num_viruses, pellet_regen),
         ticks_per_step_(ticks_per_step), num_bots_(num_bots),
-        step_dt_(DEFAULT_DT) {
+        step_dt_(DEFAULT_DT), observer_(nullptr) {
 
         pids_.reserve(num_agents);
         reset();
@@ -56,14 +69,16 @@ namespace agario {
        * and after the step
        */
       std::vector<reward> step() {
+        TRACE_SCOPE("env step");
+        if (observer_) observer_->before_step();
         this->_step_hook(); // allow subclass to set itself up for the step
 
         auto before = masses<float>();
 
         for (int tick = 0; tick < ticks_per_step(); tick++) {
           engine_.tick(step_dt_);
-          for (int agent = 0; agent < num_agents(); agent++)
-              this->_partial_observation(agent, tick);
+          TRACE_SCOPE("observe");
+          this->_observe(tick);
         }
 
         // reward = mass after - mass before
@@ -71,6 +86,7 @@ namespace agario {
         for (int i = 0; i < num_agents(); ++i)
           rewards[i] -= before[i];
 
+        if (observer_) observer_->after_step(rewards);
         return rewards;
       }
 
@@ -94,8 +110,12 @@ namespace agario {
 
         for (int i = 0; i < num_agents(); i++)
           take_action(pids_[i], actions[i]);
+        actions_ = actions;
       }
 
+      /* the actions most recently passed to take_actions */
+      [[nodiscard]] const std::vector<Action> &actions() const { return actions_; }
+
       /* set the action for a given player `pid` */
       void take_action(agario::pid pid, const Action &action) {
         take_action(pid, action.dx, action.dy, action.a);
@@ -126,6 +146,7 @@ namespace agario {
 
       /* resets the environment by resetting the game engine. */
       void reset() {
+        TRACE_SCOPE("env reset");
         engine_.reset();
 
         pids_.clear();
@@ -144,8 +165,9 @@ namespace agario {
         // with the newly reset state so that a call to `get_state` directly
         // after `reset` will return a state representing the fresh beginning
         for (int frame_index = 0; frame_index < ticks_per_step(); frame_index++)
-          for (int agent_index = 0; agent_index < num_agents(); agent_index++)
-            this->_partial_observation(agent_index, frame_index);
+          this->_observe(frame_index);
+
+        if (observer_) observer_->after_reset();
       }
 
       [[nodiscard]] std::vector<bool> dones() const { return dones_; }
@@ -155,6 +177,36 @@ namespace agario {
 
       void seed (int s) { engine_.seed(s); }
 
+      /* the engine's tick profile (only recorded if compiled with ENGINE_PROFILING) */
+      const TickStats &stats() const { return engine_.stats(); }
+
+      /* sets (or clears, with nullptr) the observer notified of each step and reset */
+      void set_observer(EnvironmentObserver *observer) { observer_ = observer; }
+
+      /**
+       * Spreads bot decisions and the agents' observations over `num_threads`
+       * threads, including the stepping thread (so 1 means no extra threads).
+       * Steps play out the same however many threads there are.
+       */
+      void set_num_threads(int num_threads) {
+        engine_.set_thread_pool(nullptr);
+        pool_ = num_threads > 1 ? std::make_unique<ThreadPool>(num_threads - 1) : nullptr;
+        engine_.set_thread_pool(pool_.get());
+      }
+
+      /**
+       * Splits the arena into `columns` by `rows` tiles, which settle the
+       * players they own on the threads of set_num_threads (see
+       * Engine::set_arena_tiles). Pass zeros to tick serially again.
+       */
+      void set_arena_tiles(int columns, int rows) { engine_.set_arena_tiles(columns, rows); }
+
+      /* sets when the bots decide (see agario::BotSchedule) */
+      void set_bot_schedule(const agario::BotSchedule &schedule) { engine_.set_bot_schedule(schedule); }
+
+      /* how often the bots have decided, over every step since the environment was created */
+      const agario::BotDecisionStats &decision_stats() const { return engine_.decision_stats(); }
+
     protected:
       Engine <renderable> engine_;
       std::vector<agario::pid> pids_;
@@ -165,6 +217,10 @@ namespace agario {
       const int num_bots_;
       const agario::time_delta step_dt_;
 
+      std::vector<Action> actions_;
+      EnvironmentObserver *observer_;
+      std::unique_ptr<ThreadPool> pool_;
+
       /* allows subclass to do something special at the beginning of each step */
       virtual void _step_hook() {};
 
@@ -172,6 +228,22 @@ namespace agario {
        * intermediate frames between the start and end of a "step" */
       virtual void _partial_observation(int agent_index, int tick_index) {};
 
+      /* observes every agent after the given tick of a step, with _partial_observation
+       * (on several threads, if allowed); override to observe all agents at once */
+      virtual void _observe(int tick_index) {
+        if (pool_ && this->_parallel_observations()) {
+          pool_->parallel_for(num_agents(), [&](std::size_t agent) {
+            this->_partial_observation(static_cast<int>(agent), tick_index);
+          });
+        } else {
+          for (int agent = 0; agent < num_agents(); agent++)
+            this->_partial_observation(agent, tick_index);
+        }
+      }
+
+      /* whether _partial_observation may be called for different agents at once */
+      virtual bool _parallel_observations() const { return true; }
+
     private:
       /* adds the specified number of bots to the game */
       void add_bots() {
@@ -89,7 +89,7 @@ namespace agario::env {
 
         if (config_.observe_pellets) {
           channel++;
-          _store_entities<Pellet>(game_state.pellets, player, channel);
+          _store_pellets(game_state, player, channel);
         }
 
         if (config_.observe_viruses) {
@@ -207,6 +207,23 @@ namespace agario::env {
         }
       }
 
+      /* stores the pellets within view of `player` in the data array at the given `channel` */
+      void _store_pellets(const GameState &game_state, const Player &player, int channel) {
+        float view_size = _view_size(player);
+
+        // one grid square of margin since grid coordinates are truncated towards zero
+        float extent = view_size / 2 + view_size / config_.grid_size;
+        Location margin(extent, extent);
+
+        int grid_x, grid_y;
+        auto origin = player.location();
+        game_state.for_each_pellet(origin - margin, origin + margin, [&](const Location &loc) {
+          _world_to_grid(player, loc, view_size, grid_x, grid_y);
+          if (_inside_grid(grid_x, grid_y))
+            data_[_index(channel, grid_x, grid_y)] = PELLET_MASS;
+        });
+      }
+
       /* marks out-of-bounds locations on the given `channel` */
       void _mark_out_of_bounds(const Player &player, int channel,
                                agario::distance arena_width, agario::distance arena_height) {
@@ -226,7 +243,7 @@ namespace agario::env {
       /* determines what the view size should be, based on the player's mass */
       float _view_size(const Player &player) const {
         // todo: make this "consistent" with the renderer's view (somewhat tough)
-        return agario::clamp<float>(2 * player.mass(), 100, 300);
+        return agario::view_size(player.mass());
       }
 
       /* converts world-coordinates to grid-coordinates */
@@ -69,7 +69,7 @@ namespace agario {
             index = _store_player(*pair.second, index);
         }
 
-        index = _store_entities<Pellet>(game_state.pellets, index, num_pellets);
+        index = _store_pellets(game_state, index, num_pellets);
         index = _store_entities< Virus>(game_state.viruses, index, num_viruses);
         index = _store_entities<  Food>(game_state.foods,   index,   num_foods);
       }
@@ -137,6 +137,22 @@ namespace agario {
         return start_index + cell_count;
       }
 
+      /* stores the locations of (up to `n` of) the pellets in the data array */
+      int _store_pellets(const GameState &game_state, int start_index, int n) {
+        Location lower(0, 0);
+        Location upper(game_state.arena_width, game_state.arena_height);
+
+        int num_stored = 0;
+        game_state.for_each_pellet(lower, upper, [&](const Location &loc) {
+          if (num_stored == n) return;
+          auto index = start_index + 2 * num_stored;
+          _data[index + 0] = loc.x;
+          _data[index + 1] = loc.y;
+          num_stored++;
+        });
+        return start_index + 2 * n;
+      }
+
       /* store the given entities in the data array at layer */
       template<typename U>
       int _store_entities(const std::vector<U> &entities, int start_index, int n) {
@@ -8,108 +8,269 @@
 #include "agario/engine/GameState.hpp"
 
 #include "agario/rendering/types.hpp"
+#include "agario/rendering/SoftwareRenderer.hpp"
+
+#ifdef INCLUDE_SCREEN_ENV
 #include "agario/rendering/FrameBufferObject.hpp"
 #include "agario/rendering/renderer.hpp"
+#endif
 
 #include "environment/envs/BaseEnvironment.hpp"
 
-#define PIXEL_LEN 3
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <tuple>
+#include <vector>
 
-// todo: needs to be converted over to multi-environment
+#define PIXEL_LEN 3
 
 namespace agario::env {
 
+    /* the last `num_frames` frames of the screen seen by one agent in a step */
     class ScreenObservation {
     public:
+      using dtype = std::uint8_t;
+      using Shape = std::tuple<int, int, int, int>;
+      using Strides = std::tuple<ssize_t, ssize_t, ssize_t, ssize_t>;
+
       explicit ScreenObservation(int num_frames, screen_len width, screen_len height) :
-        _num_frames(num_frames), _width(width), _height(height) {
-        _frame_data = new std::uint8_t[size()];
+        _num_frames(num_frames), _width(width), _height(height),
+        _frame_data(new dtype[length()]) {
+        clear();
       }
 
-      [[nodiscard]] const std::uint8_t *frame_data() const { return _frame_data; }
+      ScreenObservation(ScreenObservation &&) noexcept = default;
+      ScreenObservation(const ScreenObservation &) = delete;
+      ScreenObservation &operator=(const ScreenObservation &) = delete;
 
-      [[nodiscard]] std::size_t size() const {
-        return _num_frames * _width * _height * PIXEL_LEN;
+      [[nodiscard]] const dtype *data() const { return _frame_data.get(); }
+
+      /* full length of data array */
+      [[nodiscard]] int length() const {
+        return _num_frames * frame_length();
       }
 
       void clear() {
-        std::fill(_frame_data, _frame_data + size(), 0);
+        std::fill(_frame_data.get(), _frame_data.get() + length(), 0);
       }
 
-      std::uint8_t *frame_data(int frame_index) {
+      dtype *frame_data(int frame_index) {
         if (frame_index >= _num_frames)
-          throw FBOException("Frame index " + std::to_string(frame_index) + " out of bounds");
+          throw EnvironmentException("Frame index " + std::to_string(frame_index) + " out of bounds");
 
-        auto data_index = frame_index * _width * _height * PIXEL_LEN;
-        return &_frame_data[data_index];
+        return &_frame_data[frame_index * frame_length()];
       }
 
+      /* the length of each frame's data */
+      [[nodiscard]] int frame_length() const { return _width * _height * PIXEL_LEN; }
+
       [[nodiscard]] int num_frames() const { return _num_frames; }
 
-      [[nodiscard]] std::vector<int> shape() const {
-        return {_num_frames, _width, _height, PIXEL_LEN};
+      /* frames of rows of pixels (bottom row first, as read from OpenGL) */
+      [[nodiscard]] Shape shape() const {
+        return { _num_frames, _height, _width, PIXEL_LEN };
       }
 
-      [[nodiscard]] std::vector<ssize_t> strides() const {
+      [[nodiscard]] Strides strides() const {
         return {
-          _width * _height * PIXEL_LEN * dtype_size,
-                   _height * PIXEL_LEN * dtype_size,
+          _height * _width * PIXEL_LEN * dtype_size,
+                    _width * PIXEL_LEN * dtype_size,
                              PIXEL_LEN * dtype_size,
                                          dtype_size
         };
       }
 
-      ~ScreenObservation() { delete[] _frame_data; }
-
     private:
       int _num_frames;
-      const int _width;
-      const int _height;
-      static constexpr ssize_t dtype_size = sizeof(std::uint8_t);
-      std::uint8_t *_frame_data;
+      int _width;
+      int _height;
+      static constexpr ssize_t dtype_size = sizeof(dtype);
+      std::unique_ptr<dtype[]> _frame_data;
     };
 
+    /**
+     * Renders each agent's screen on the CPU (see agario::SoftwareRenderer),
+     * needing no OpenGL. Agents may be rendered on different threads at once.
+     */
     template<bool renderable>
-    class ScreenEnvironment : public BaseEnvironment<renderable> {
-      using GameState = GameState<renderable>;
-      using Player = Player<renderable>;
-      using Cell = Cell<renderable>;
-      using Pellet = Pellet<renderable>;
-      using Virus = Virus<renderable>;
-      using Food = Food<renderable>;
+    class SoftwareScreen {
+    public:
+      static constexpr bool parallel = true;
+      static constexpr bool batched = false;
+
+      SoftwareScreen(int /* num_agents */, screen_len width, screen_len height,
+                     agario::distance arena_width, agario::distance arena_height) :
+        renderer(width, height, arena_width, arena_height) {}
+
+      /* renders the player's screen into `data` (or begins to, until finish is called) */
+      void render(agario::Player<renderable> &player, agario::GameState<renderable> &state, std::uint8_t *data) {
+        renderer.render_screen(player, state, data);
+      }
+
+      /* waits for every screen rendered so far to arrive */
+      void finish() {}
+
+    private:
+      agario::SoftwareRenderer<renderable> renderer;
+    };
+
+#ifdef INCLUDE_SCREEN_ENV
+
+    /**
+     * Renders each agent's screen with OpenGL (see agario::Renderer). Rendering
+     * is headless (needing neither a display server nor a GPU) when compiled
+     * with EGL, and through a hidden window otherwise. Every agent's screen
+     * is drawn into its own tile of one frame buffer, and all of them are read
+     * back together, so that a tick costs one upload and one readback however
+     * many agents there are.
+     */
+    template<bool renderable>
+    class OpenGLScreen {
+      static_assert(renderable, "OpenGL renders the screen from renderable game states");
+
+    public:
+      static constexpr bool parallel = false; // every agent is rendered by the one GL context
+      static constexpr bool batched = true;
+
+      OpenGLScreen(int num_agents, screen_len width, screen_len height,
+                   agario::distance arena_width, agario::distance arena_height) :
+        frame_buffer(std::make_shared<FrameBufferObject>(width, height, FrameBufferObject::headless_available,
+                                                         num_agents)),
+        renderer(frame_buffer, arena_width, arena_height),
+        tiles(num_agents, nullptr) {}
+
+      void render(agario::Player<renderable> &player, agario::GameState<renderable> &state, std::uint8_t *data) {
+        render({ &player }, state, { data });
+      }
+
+      /* renders each player's screen into the corresponding frame (of at most num_agents) */
+      void render(const std::vector<agario::Player<renderable> *> &players, agario::GameState<renderable> &state,
+                  const std::vector<std::uint8_t *> &frames) {
+        frame_buffer->make_current(); // in case another environment rendered since
+        renderer.render_screens(players, state);
+
+        std::fill(tiles.begin(), tiles.end(), nullptr);
+        std::copy(frames.begin(), frames.end(), tiles.begin());
+        frame_buffer->copy_async(tiles); // arrives while the next frames (or steps) are rendered
+      }
 
+      /* waits for every screen rendered so far to arrive */
+      void finish() {
+        if (!frame_buffer->pending()) return;
+        frame_buffer->make_current(); // in case another environment rendered since
+        frame_buffer->flush();
+      }
+
+    private:
+      std::shared_ptr<FrameBufferObject> frame_buffer;
+      agario::Renderer renderer;
+      std::vector<void *> tiles; // where to copy each tile of the frame buffer
+    };
+
+#endif
+
+    /**
+     * Observations of the game screen as rendered for each agent, by
+     * a SoftwareScreen or (if compiled with OpenGL) an OpenGLScreen
+     */
+    template<bool renderable, template<bool> class Screen = SoftwareScreen>
+    class ScreenEnvironment : public BaseEnvironment<renderable> {
     public:
       using Super = BaseEnvironment<renderable>;
+      using dtype = ScreenObservation::dtype;
+      using Observation = ScreenObservation;
 
-      explicit ScreenEnvironment(int frames_per_step, int arena_size, bool pellet_regen,
+      explicit ScreenEnvironment(int num_agents, int ticks_per_step, int arena_size, bool pellet_regen,
                                  int num_pellets, int num_viruses, int num_bots,
-                                 screen_len screen_width, screen_len screen_height) :
-        Super(frames_per_step, arena_size, pellet_regen, num_pellets, num_viruses, num_bots),
-        _observation(frames_per_step, screen_width, screen_height),
-        frame_buffer(std::make_shared<FrameBufferObject>(screen_width, screen_height)),
-        renderer(frame_buffer, this->engine_.arena_width(), this->engine_.arena_height()) {}
+                                 int num_frames, screen_len screen_width, screen_len screen_height) :
+        Super(num_agents, ticks_per_step, arena_size, pellet_regen, num_pellets, num_viruses, num_bots),
+        screen(num_agents, screen_width, screen_height, this->engine_.arena_width(), this->engine_.arena_height()),
+        _screen_width(screen_width), _screen_height(screen_height) {
 
-      [[nodiscard]] const ScreenObservation &get_state() const { return _observation; }
-      [[nodiscard]] screen_len screen_width() const { return frame_buffer->width(); }
-      [[nodiscard]] screen_len screen_height() const { return frame_buffer->height(); }
+        if (num_frames < 1 || num_frames > ticks_per_step)
+          throw EnvironmentException("Number of frames (" + std::to_string(num_frames)
+                                     + ") must be between 1 and the ticks per step");
+
+        for (int i = 0; i < num_agents; i++)
+          observations.emplace_back(num_frames, screen_width, screen_height);
+        frames_pending.assign(num_agents, false);
+      }
+
+      /* the shape of the observation object(s) */
+      [[nodiscard]] ScreenObservation::Shape observation_shape() const {
+        return observations.front().shape();
+      }
+
+      /* the observations, once any of their frames still being read back have arrived */
+      [[nodiscard]] const std::vector<Observation> &get_observations() const {
+        finish_frames();
+        return observations;
+      }
+
+      [[nodiscard]] screen_len screen_width() const { return _screen_width; }
+      [[nodiscard]] screen_len screen_height() const { return _screen_height; }
 
     private:
+      std::vector<Observation> observations;
+      mutable Screen<renderable> screen; // finished when the observations are read
+      screen_len _screen_width;
+      screen_len _screen_height;
 
-      ScreenObservation _observation;
-      std::shared_ptr<FrameBufferObject> frame_buffer;
-      agario::Renderer renderer;
+      std::vector<agario::Player<renderable> *> batch_players;
+      std::vector<std::uint8_t *> batch_frames;
+      mutable std::vector<std::uint8_t> frames_pending; // whether each agent has frames yet to arrive
 
-      // stores current frame into buffer containing the next observation
-      void _partial_observation(Player &player, int frame_index) override {
-        renderer.render_screen(player, this->engine_.game_state());
-        void *data = _observation.frame_data(frame_index);
-        frame_buffer->copy(data);
+      void finish_frames() const {
+        screen.finish();
+        frames_pending.assign(this->num_agents(), false);
       }
 
-    };
+      /* the frame of the agent's observation to render after the given tick (if any, and if it's alive) */
+      std::uint8_t *frame_to_render(int agent_index, int tick_index) {
+        assert(agent_index < this->num_agents());
+        assert(tick_index < this->ticks_per_step());
 
-} // namespace agario:env
+        auto &observation = observations[agent_index];
+        int frame_index = tick_index - (this->ticks_per_step() - observation.num_frames());
+        if (frame_index < 0) return nullptr;
 
+        auto *data = observation.frame_data(frame_index);
+        if (this->engine_.player(this->pids_[agent_index]).dead()) {
+          if (frames_pending[agent_index]) finish_frames(); // so that they don't arrive over the zeros
+          std::fill(data, data + observation.frame_length(), 0);
+          return nullptr;
+        }
+        return data;
+      }
 
+      // renders the agent's screen into its observation, for the last `num_frames` ticks of the step
+      void _partial_observation(int agent_index, int tick_index) override {
+        if (auto *data = frame_to_render(agent_index, tick_index))
+          screen.render(this->engine_.player(this->pids_[agent_index]), this->engine_.game_state(), data);
+      }
+
+      // renders every living agent's screen at once, if the screen can
+      void _observe(int tick_index) override {
+        if constexpr (Screen<renderable>::batched) {
+          batch_players.clear();
+          batch_frames.clear();
+          for (int agent = 0; agent < this->num_agents(); agent++) {
+            if (auto *data = frame_to_render(agent, tick_index)) {
+              batch_players.push_back(&this->engine_.player(this->pids_[agent]));
+              batch_frames.push_back(data);
+              frames_pending[agent] = true;
+            }
+          }
+          if (!batch_players.empty())
+            screen.render(batch_players, this->engine_.game_state(), batch_frames);
+        } else {
+          Super::_observe(tick_index);
+        }
+      }
 
+      [[nodiscard]] bool _parallel_observations() const override { return Screen<renderable>::parallel; }
 
+    };
+
+} // namespace agario:env
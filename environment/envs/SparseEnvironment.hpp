@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cassert>
+
+#include <agario/engine/Engine.hpp>
+#include <agario/core/types.hpp>
+#include <agario/core/Entities.hpp>
+#include <agario/core/Ball.hpp>
+#include <agario/bots/bots.hpp>
+#include <agario/engine/GameState.hpp>
+
+#include "environment/envs/BaseEnvironment.hpp"
+
+#include <tuple>
+#include <vector>
+
+// (entity type, relative x, relative y, mass, velocity x, velocity y)
+#define SPARSE_RECORD_LEN 6
+
+namespace agario::env {
+
+    /**
+     * A variable-length observation which lists only the entities
+     * that are within view of the agent. Each entity is stored as
+     * a fixed-size record of SPARSE_RECORD_LEN values such that
+     * the observation is a (num_entities, SPARSE_RECORD_LEN) array.
+     * Compared to the GridObservation, the size of this observation
+     * depends only on how crowded the agent's view is, not on the
+     * size of the arena or on the grid resolution.
+     */
+    template<bool renderable>
+    class SparseObservation {
+      using GameState = GameState<renderable>;
+      using Player = Player<renderable>;
+      using Cell = Cell<renderable>;
+      using Pellet = Pellet<renderable>;
+      using Virus = Virus<renderable>;
+      using Food = Food<renderable>;
+
+    public:
+      using dtype = float;
+      using Shape = std::tuple<int, int>;
+      using Strides = std::tuple<ssize_t, ssize_t>;
+
+      /* the value stored in the "entity type" field of each record */
+      enum entity_type { pellet = 0, virus = 1, food = 2, cell = 3, other = 4 };
+
+      SparseObservation() = default;
+
+      /* captures every entity within view of `player` */
+      void capture(const Player &player, const GameState &game_state) {
+        clear_data();
+
+        auto view = _view_size(player) / 2;
+        auto origin = player.location();
+
+        _store_pellets(game_state, origin, view);
+        _store_entities(game_state.viruses, origin, view, virus);
+        _store_entities(game_state.foods, origin, view, food);
+        _store_entities(player.cells, origin, view, cell);
+
+        for (auto &pair : game_state.players) {
+          auto &other_player = *pair.second;
+          if (other_player == player) continue;
+          _store_entities(other_player.cells, origin, view, other);
+        }
+      }
+
+      /* empties the observation without releasing its memory */
+      void clear_data() { _data.clear(); }
+
+      /* data buffer, mulit-dim array shape and sizes */
+      [[nodiscard]] const dtype *data() const { return _data.data(); }
+      [[nodiscard]] Shape shape() const { return { num_entities(), SPARSE_RECORD_LEN }; }
+      [[nodiscard]] Strides strides() const {
+        auto dtype_size = static_cast<ssize_t>(sizeof(dtype));
+        return { SPARSE_RECORD_LEN * dtype_size, dtype_size };
+      }
+
+      /* full length of data array */
+      [[nodiscard]] int length() const { return static_cast<int>(_data.size()); }
+
+      /* the number of entity records in the observation */
+      [[nodiscard]] int num_entities() const { return length() / SPARSE_RECORD_LEN; }
+
+    private:
+      std::vector<dtype> _data;
+
+      /* appends a record for each pellet which is within `view` of `origin` */
+      void _store_pellets(const GameState &game_state, const Location &origin, float view) {
+        Location extent(view, view);
+        game_state.for_each_pellet(origin - extent, origin + extent, [&](const Location &loc) {
+          _data.push_back(pellet);
+          _data.push_back(loc.x - origin.x);
+          _data.push_back(loc.y - origin.y);
+          _data.push_back(PELLET_MASS);
+          _data.push_back(0); // pellets don't move
+          _data.push_back(0);
+        });
+      }
+
+      /* appends a record for each of `entities` which is within `view` of `origin` */
+      template<typename U>
+      void _store_entities(const std::vector<U> &entities, const Location &origin,
+                           float view, entity_type type) {
+        for (auto &entity : entities) {
+          float dx = entity.x - origin.x;
+          float dy = entity.y - origin.y;
+          if (std::abs(dx) > view || std::abs(dy) > view) continue;
+
+          _data.push_back(type);
+          _data.push_back(dx);
+          _data.push_back(dy);
+          _data.push_back(entity.mass());
+          _store_velocity(entity);
+        }
+      }
+
+      void _store_velocity(const MovingBall &ball) {
+        _data.push_back(ball.velocity.dx);
+        _data.push_back(ball.velocity.dy);
+      }
+
+      /* determines what the view size should be, based on the player's mass */
+      float _view_size(const Player &player) const {
+        // same view size as the GridObservation
+        return agario::view_size(player.mass());
+      }
+    };
+
+
+    template<bool renderable>
+    class SparseEnvironment : public BaseEnvironment<renderable> {
+      using Player = agario::Player<renderable>;
+      using Super = BaseEnvironment<renderable>;
+
+    public:
+      using Observation = SparseObservation<renderable>;
+      using dtype = typename Observation::dtype;
+
+      explicit SparseEnvironment(int num_agents, int ticks_per_step, int arena_size, bool pellet_regen,
+                                 int num_pellets, int num_viruses, int num_bots) :
+        Super(num_agents, ticks_per_step, arena_size, pellet_regen,
+              num_pellets, num_viruses, num_bots),
+        observations(num_agents) { }
+
+      /* the number of values in each entity record */
+      [[nodiscard]] int record_length() const { return SPARSE_RECORD_LEN; }
+
+      /**
+       * Returns the current state of the world without advancing through time
+       * @return A SparseObservation for each agent, listing the entities
+       * within that agent's view
+       */
+      const std::vector<Observation> &get_observations() const { return observations; }
+
+      /**
+       * Packs the observations of all agents into a single flat buffer in
+       * compressed sparse row format: the records of agent `i` are rows
+       * offsets[i] through offsets[i + 1] of the (offsets.back(), record_length())
+       * array that is written to `data`
+       * @param data buffer of at least `packed_length()` values to fill
+       * @param offsets buffer of at least `num_agents() + 1` row offsets to fill
+       */
+      template<typename Index>
+      void pack_observations(dtype *data, Index *offsets) const {
+        offsets[0] = 0;
+        for (int i = 0; i < this->num_agents(); i++) {
+          auto &observation = observations[i];
+          std::copy(observation.data(), observation.data() + observation.length(), data);
+          data += observation.length();
+          offsets[i + 1] = offsets[i] + observation.num_entities();
+        }
+      }
+
+      /* the total number of values in all of the agents' observations */
+      [[nodiscard]] int packed_length() const {
+        int length = 0;
+        for (auto &observation : observations)
+          length += observation.length();
+        return length;
+      }
+
+      /* since we reuse the observation's data buffer for each step,
+       * we need to have the data cleared at the beginning of each step */
+      void _step_hook() override {
+        for (auto &observation : observations)
+          observation.clear_data();
+      }
+
+      /* captures the entities in view after the final tick of the step */
+      void _partial_observation(int agent_index, int tick_index) override {
+        assert(agent_index < this->num_agents());
+        assert(tick_index < this->ticks_per_step());
+
+        if (tick_index != this->ticks_per_step() - 1)
+          return;
+
+        auto &player = this->engine_.player(this->pids_[agent_index]);
+        Observation &observation = observations[agent_index];
+        if (player.dead()) {
+          observation.clear_data();
+          return;
+        }
+
+        observation.capture(player, this->engine_.game_state());
+      }
+
+    private:
+      std::vector<Observation> observations;
+    };
+
+} // namespace agario::env
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include <environment/envs/GridEnvironment.hpp>
+#include <environment/envs/SparseEnvironment.hpp>
+#include <environment/dataset/DatasetWriter.hpp>
+#include <environment/dataset/DatasetReader.hpp>
+
+#include <environment/renderable.hpp>
+
+using namespace agario::env;
+
+namespace {
+
+  void remove_dataset(const std::string &path, std::size_t num_chunks) {
+    for (std::size_t chunk = 0; chunk <= num_chunks; chunk++)
+      std::remove(dataset::chunk_file(path, chunk).c_str());
+    std::remove(dataset::index_file(path).c_str());
+    ::rmdir(path.c_str());
+  }
+
+  std::vector<Action> varied_actions(int num_agents, int step) {
+    std::vector<Action> actions;
+    for (int i = 0; i < num_agents; i++)
+      actions.emplace_back((step % 7) / 7.0, -(i % 3) / 3.0, static_cast<agario::action>(step % 3));
+    return actions;
+  }
+
+  TEST(DatasetTest, ZeroRunLength) {
+    std::vector<char> data(1000, 0);
+    for (int i = 0; i < 1000; i += 97) data[i] = static_cast<char>(i);
+    data[500] = data[502] = 1; // short run of zeros left as literals
+    data.back() = 0;
+
+    for (std::size_t size : { 0ul, 1ul, 7ul, 100ul, 1000ul }) {
+      auto encoded = dataset::zero_rle_encode(data.data(), size);
+      std::vector<char> decoded(size, 'x');
+      dataset::zero_rle_decode(encoded.data(), encoded.size(), decoded.data(), size);
+      ASSERT_EQ(std::vector<char>(data.begin(), data.begin() + size), decoded) << "size " << size;
+    }
+
+    auto encoded = dataset::zero_rle_encode(data.data(), data.size());
+    ASSERT_LT(encoded.size(), data.size() / 4);
+    std::vector<char> decoded(data.size() - 1);
+    EXPECT_THROW(dataset::zero_rle_decode(encoded.data(), encoded.size(), decoded.data(), decoded.size()),
+                 agario::binary::FormatException);
+  }
+
+  /* records grid observations over several chunks, and reads them back */
+  TEST(DatasetTest, GridRoundTrip) {
+    using GridEnvironment = agario::env::GridEnvironment<int, renderable>;
+    int num_agents = 2, num_steps = 25, steps_per_chunk = 10;
+
+    for (bool compress : { false, true }) {
+      auto path = testing::TempDir() + "agario-dataset-grid";
+      GridEnvironment env(num_agents, 2, 1000, true, 500, 10, 5);
+      env.configure_observation(2, 32, true, true, true, true);
+      env.reset();
+
+      std::vector<std::vector<int>> observations;
+      std::vector<reward> rewards;
+      std::vector<std::uint32_t> episodes;
+      {
+        DatasetWriter<GridEnvironment> writer(env, path, steps_per_chunk, compress);
+        for (int step = 0; step < num_steps; step++) {
+          if (step == 12) env.reset();
+          for (auto &observation : env.get_observations())
+            observations.emplace_back(observation.data(), observation.data() + observation.length());
+          episodes.push_back(step < 12 ? 0 : 1);
+
+          env.take_actions(varied_actions(num_agents, step));
+          auto r = env.step();
+          rewards.insert(rewards.end(), r.begin(), r.end());
+        }
+        ASSERT_EQ(num_steps, writer.steps());
+      }
+      env.step(); // no longer recorded
+
+      dataset::DatasetReader reader(path);
+      ASSERT_EQ(num_agents, reader.num_agents());
+      ASSERT_EQ(3, reader.num_chunks());
+      ASSERT_EQ(num_steps, reader.num_steps());
+      ASSERT_EQ(5, reader.chunk_steps(2));
+
+      int step = 0;
+      for (std::size_t chunk = 0; chunk < reader.num_chunks(); chunk++) {
+        auto obs = reader.column(chunk, "observations");
+        auto actions = reader.column(chunk, "actions");
+        auto rews = reader.column(chunk, "rewards");
+        auto dones = reader.column(chunk, "dones");
+        auto eps = reader.column(chunk, "episodes");
+        ASSERT_EQ(reader.chunk_steps(chunk), obs.rows);
+        ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(obs.data) % alignof(int));
+
+        auto row_length = obs.column->row_size() / sizeof(int) / num_agents;
+        for (std::uint64_t row = 0; row < obs.rows; row++, step++) {
+          auto expected_actions = varied_actions(num_agents, step);
+          ASSERT_EQ(episodes[step], eps.as<std::uint32_t>()[row]);
+          for (int agent = 0; agent < num_agents; agent++) {
+            auto &expected = observations[step * num_agents + agent];
+            ASSERT_EQ(expected.size(), row_length);
+            auto data = obs.as<int>() + (row * num_agents + agent) * row_length;
+            ASSERT_EQ(expected, std::vector<int>(data, data + row_length)) << "step " << step;
+
+            auto action = actions.as<float>() + (row * num_agents + agent) * 3;
+            ASSERT_FLOAT_EQ(expected_actions[agent].dx, action[0]);
+            ASSERT_FLOAT_EQ(expected_actions[agent].dy, action[1]);
+            ASSERT_FLOAT_EQ(expected_actions[agent].a, action[2]);
+            ASSERT_FLOAT_EQ(rewards[step * num_agents + agent], rews.as<float>()[row * num_agents + agent]);
+            ASSERT_EQ(0, dones.as<std::uint8_t>()[row * num_agents + agent]);
+          }
+        }
+      }
+      ASSERT_THROW(reader.column(0, "missing"), EnvironmentException);
+      ASSERT_THROW(reader.column(3, "rewards"), EnvironmentException);
+
+      // the last (half full) chunk is packed into a file half the size
+      struct stat full {}, last {};
+      ASSERT_EQ(0, ::stat(dataset::chunk_file(path, 0).c_str(), &full));
+      ASSERT_EQ(0, ::stat(dataset::chunk_file(path, 2).c_str(), &last));
+      if (!compress) EXPECT_NEAR(full.st_size / 2, last.st_size, dataset::alignment * 5);
+      remove_dataset(path, reader.num_chunks());
+    }
+  }
+
+  /* variable-length observations are stored as records delimited by offsets */
+  TEST(DatasetTest, SparseOffsets) {
+    using SparseEnvironment = agario::env::SparseEnvironment<renderable>;
+    int num_agents = 3, num_steps = 8;
+
+    for (bool compress : { false, true }) {
+      auto path = testing::TempDir() + "agario-dataset-sparse";
+
+      SparseEnvironment env(num_agents, 2, 1000, true, 500, 10, 5);
+      env.reset();
+
+      std::vector<std::vector<float>> observations;
+      {
+        DatasetWriter<SparseEnvironment> writer(env, path, 3, compress);
+        for (int step = 0; step < num_steps; step++) {
+          for (auto &observation : env.get_observations())
+            observations.emplace_back(observation.data(), observation.data() + observation.length());
+          env.take_actions(varied_actions(num_agents, step));
+          env.step();
+        }
+      }
+
+      dataset::DatasetReader reader(path);
+      ASSERT_EQ(3, reader.num_chunks());
+      ASSERT_EQ(num_steps, reader.num_steps());
+
+      int step = 0;
+      for (std::size_t chunk = 0; chunk < reader.num_chunks(); chunk++) {
+        auto records = reader.column(chunk, "observations");
+        auto offsets = reader.column(chunk, "observation_offsets");
+        ASSERT_EQ(reader.chunk_steps(chunk), offsets.rows);
+        ASSERT_EQ(env.record_length(), records.column->shape[0]);
+
+        auto offset = offsets.as<std::int64_t>();
+        for (std::uint64_t row = 0; row < offsets.rows; row++, step++) {
+          for (int agent = 0; agent < num_agents; agent++) {
+            auto begin = offset[row * (num_agents + 1) + agent];
+            auto end = offset[row * (num_agents + 1) + agent + 1];
+            auto data = records.as<float>();
+            std::vector<float> recorded(data + begin * env.record_length(), data + end * env.record_length());
+            ASSERT_EQ(observations[step * num_agents + agent], recorded) << "step " << step;
+          }
+        }
+        ASSERT_EQ(records.rows, offset[offsets.rows * (num_agents + 1) - 1]);
+      }
+      remove_dataset(path, reader.num_chunks());
+    }
+  }
+
+}
@@ -175,4 +175,58 @@ namespace {
     }
   }
 
+
+  /* stepping with bots, observations and arena tiles spread over threads gives the same observations */
+  TEST(GridEnvTest, Threads) {
+    GridEnvironment serial(8, 4, 500, true, 1000, 10, 20), threaded(8, 4, 500, true, 1000, 10, 20);
+    for (auto *env : { &serial, &threaded }) {
+      env->configure_observation(2, 64, true, true, true, true);
+      env->seed(42);
+      env->reset();
+    }
+    threaded.set_num_threads(4);
+    threaded.set_arena_tiles(2, 2);
+
+    std::vector<Action> actions;
+    for (int i = 0; i < serial.num_agents(); i++)
+      actions.emplace_back(i % 2 ? 1.0 : -0.5, 0.5, agario::action::none);
+
+    for (int step = 0; step < 20; step++) {
+      serial.take_actions(actions);
+      threaded.take_actions(actions);
+      ASSERT_EQ(serial.step(), threaded.step());
+
+      auto &expected = serial.get_observations();
+      auto &observed = threaded.get_observations();
+      for (int agent = 0; agent < serial.num_agents(); agent++) {
+        auto length = expected[agent].length();
+        ASSERT_EQ(length, observed[agent].length());
+        ASSERT_TRUE(std::equal(expected[agent].data(), expected[agent].data() + length, observed[agent].data()));
+      }
+    }
+  }
+
+
+  /* staggered, a tenth of the bots decide on each tick, however the agents act */
+  TEST(GridEnvTest, BotSchedule) {
+    GridEnvironment env(2, 4, 1000, true, 1000, 10, 30);
+    env.configure_observation(1, 32, true, true, true, true);
+    agario::BotSchedule schedule;
+    schedule.staggered = true;
+    env.set_bot_schedule(schedule);
+    env.seed(3);
+    env.reset();
+
+    std::vector<Action> actions(env.num_agents(), Action(0.5, 0.5, agario::action::none));
+    for (int step = 0; step < 25; step++) {
+      env.take_actions(actions);
+      env.step();
+    }
+
+    auto &stats = env.decision_stats();
+    EXPECT_EQ(100, stats.ticks);
+    EXPECT_NEAR(0.1, stats.rate(), 0.01);
+    EXPECT_LE(stats.peak_decisions, 3);
+  }
+
 }
@@ -2,6 +2,9 @@
 
 #include <environment/test/grid-env-test.hpp>
 #include <environment/test/ram-env-test.hpp>
+#include <environment/test/sparse-env-test.hpp>
+#include <environment/test/dataset-test.hpp>
+#include <environment/test/screen-env-test.hpp>
 
 namespace { }
 
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <environment/envs/ScreenEnvironment.hpp>
+#include <environment/renderable.hpp>
+
+namespace {
+
+  using agario::env::SoftwareScreen;
+
+  template<typename Environment>
+  void test_observations() {
+    int num_agents = 2, ticks_per_step = 4, num_frames = 2;
+    Environment env(num_agents, ticks_per_step, 1000, true, 1000, 25, 5, num_frames, 96, 64);
+    env.seed(42);
+    env.reset();
+
+    ASSERT_EQ(std::make_tuple(num_frames, 64, 96, 3), env.observation_shape());
+
+    for (int step = 0; step < 5; step++) {
+      env.take_actions({{0.5, 0.5, agario::action::none}, {-0.5, 0.25, agario::action::none}});
+      env.step();
+
+      auto &observations = env.get_observations();
+      ASSERT_EQ(num_agents, observations.size());
+      for (auto &observation : observations) {
+        auto begin = observation.data(), end = begin + observation.length();
+
+        // the background, and something drawn on it, in every frame
+        auto frame_length = observation.frame_length();
+        for (int frame = 0; frame < num_frames; frame++) {
+          auto frame_begin = begin + frame * frame_length;
+          auto white = std::count(frame_begin, frame_begin + frame_length, 255);
+          EXPECT_GT(white, frame_length / 2);
+          EXPECT_LT(white, frame_length);
+        }
+        EXPECT_FALSE(std::all_of(begin, end, [](std::uint8_t p) { return p == 0; }));
+      }
+
+      // the agents are in different places, so see different screens
+      auto length = observations[0].length();
+      EXPECT_FALSE(std::equal(observations[0].data(), observations[0].data() + length, observations[1].data()));
+    }
+  }
+
+  TEST(ScreenEnvTest, SoftwareObservations) {
+    test_observations<agario::env::ScreenEnvironment<renderable, SoftwareScreen>>();
+  }
+
+  /* agents' screens are rendered the same however many threads render them */
+  TEST(ScreenEnvTest, SoftwareThreads) {
+    using ScreenEnvironment = agario::env::ScreenEnvironment<renderable, SoftwareScreen>;
+    int num_agents = 4;
+    std::vector<agario::env::Action> actions;
+    for (int i = 0; i < num_agents; i++)
+      actions.emplace_back(i % 2 ? 1 : -1, i / 2 ? 1 : -1, agario::action::none);
+
+    std::srand(3); // the same colors
+    ScreenEnvironment serial(num_agents, 4, 1000, true, 1000, 25, 10, 2, 84, 84);
+    std::srand(3);
+    ScreenEnvironment parallel(num_agents, 4, 1000, true, 1000, 25, 10, 2, 84, 84);
+    parallel.set_num_threads(3);
+
+    for (auto *env : { &serial, &parallel }) {
+      std::srand(5);
+      env->seed(7);
+      env->reset();
+    }
+
+    for (int step = 0; step < 5; step++) {
+      serial.take_actions(actions);
+      parallel.take_actions(actions);
+      serial.step();
+      parallel.step();
+      for (int agent = 0; agent < num_agents; agent++) {
+        auto &expected = serial.get_observations()[agent], &observation = parallel.get_observations()[agent];
+        ASSERT_TRUE(std::equal(expected.data(), expected.data() + expected.length(), observation.data()));
+      }
+    }
+  }
+
+#ifdef INCLUDE_SCREEN_ENV
+
+  /* which pixels of an observation are the (white) background */
+  std::vector<bool> background(const agario::env::ScreenObservation &observation) {
+    std::vector<bool> mask;
+    auto data = observation.data();
+    for (int i = 0; i < observation.length(); i += 3)
+      mask.push_back(data[i] == 255 && data[i + 1] == 255 && data[i + 2] == 255);
+    return mask;
+  }
+
+  using agario::env::OpenGLScreen;
+  using OpenGLScreenEnvironment = agario::env::ScreenEnvironment<true, OpenGLScreen>;
+
+  TEST(ScreenEnvTest, OpenGLObservations) {
+    test_observations<OpenGLScreenEnvironment>();
+  }
+
+  /* environments rendering in turn don't draw over each other's screens */
+  TEST(ScreenEnvTest, OpenGLInterleaved) {
+    int num_steps = 3;
+
+    // colors are random, but the same seed puts everything in the same place
+    std::vector<std::vector<bool>> expected;
+    {
+      OpenGLScreenEnvironment alone(1, 2, 1000, true, 1000, 25, 0, 1, 64, 64);
+      alone.seed(7);
+      alone.reset();
+      for (int step = 0; step < num_steps; step++) {
+        alone.step();
+        expected.push_back(background(alone.get_observations().front()));
+      }
+    }
+
+    OpenGLScreenEnvironment env1(1, 2, 1000, true, 1000, 25, 0, 1, 64, 64);
+    OpenGLScreenEnvironment env2(1, 2, 1000, true, 1000, 25, 0, 1, 80, 48);
+    env1.seed(7);
+    env1.reset();
+    env2.reset();
+
+    for (int step = 0; step < num_steps; step++) {
+      env1.step();
+      env2.step(); // while env1's frames may still be in flight
+      ASSERT_EQ(expected[step], background(env1.get_observations().front()));
+    }
+  }
+
+  /* an agent's screen rendered before it died doesn't arrive over the zeros it observes once dead */
+  TEST(ScreenEnvTest, OpenGLDeadAfterPending) {
+    struct Environment : OpenGLScreenEnvironment {
+      using OpenGLScreenEnvironment::OpenGLScreenEnvironment;
+      void kill(int agent) { this->engine_.player(this->pids_[agent]).cells.clear(); }
+    };
+
+    Environment env(2, 2, 1000, true, 1000, 25, 0, 1, 64, 64);
+    env.reset();
+    env.step(); // not read, so its frames may still be in flight
+    env.kill(0);
+    env.step();
+
+    auto &dead = env.get_observations()[0];
+    EXPECT_TRUE(std::all_of(dead.data(), dead.data() + dead.length(), [](std::uint8_t p) { return p == 0; }));
+    auto &alive = env.get_observations()[1];
+    EXPECT_FALSE(std::all_of(alive.data(), alive.data() + alive.length(), [](std::uint8_t p) { return p == 0; }));
+  }
+
+  /* renders one agent's screen at a time, into a frame buffer with a single tile */
+  template<bool renderable>
+  class SingleTileScreen : public OpenGLScreen<renderable> {
+  public:
+    static constexpr bool batched = false;
+
+    SingleTileScreen(int num_agents, screen_len width, screen_len height,
+                     agario::distance arena_width, agario::distance arena_height) :
+      OpenGLScreen<renderable>(1, width, height, arena_width, arena_height) {}
+  };
+
+  /* rendering every agent into tiles of one frame buffer draws what rendering each alone does */
+  TEST(ScreenEnvTest, OpenGLBatched) {
+    int num_agents = 3;
+    OpenGLScreenEnvironment batched(num_agents, 3, 1000, true, 1000, 25, 10, 2, 96, 64);
+    agario::env::ScreenEnvironment<true, SingleTileScreen> single(num_agents, 3, 1000, true, 1000, 25, 10, 2, 96, 64);
+    for (auto *env : std::initializer_list<agario::env::BaseEnvironment<true> *>{ &batched, &single }) {
+      env->seed(13);
+      env->reset();
+    }
+
+    std::vector<agario::env::Action> actions;
+    for (int i = 0; i < num_agents; i++)
+      actions.emplace_back(i % 2 ? 1 : -1, i - 1, agario::action::none);
+
+    for (int step = 0; step < 4; step++) {
+      batched.take_actions(actions);
+      single.take_actions(actions);
+      batched.step();
+      single.step();
+      for (int agent = 0; agent < num_agents; agent++)
+        ASSERT_EQ(background(single.get_observations()[agent]), background(batched.get_observations()[agent]))
+          << "step " << step << " agent " << agent;
+    }
+  }
+
+  /* the software renderer draws (nearly) the same pixels as OpenGL */
+  TEST(ScreenEnvTest, SoftwareMatchesOpenGL) {
+    OpenGLScreenEnvironment opengl(2, 2, 1000, false, 1000, 25, 10, 1, 128, 128);
+    agario::env::ScreenEnvironment<true, SoftwareScreen> software(2, 2, 1000, false, 1000, 25, 10, 1, 128, 128);
+    for (auto *env : std::initializer_list<agario::env::BaseEnvironment<true> *>{ &opengl, &software }) {
+      env->seed(11);
+      env->reset();
+    }
+
+    for (int step = 0; step < 5; step++) {
+      opengl.step();
+      software.step();
+      for (int agent = 0; agent < 2; agent++) {
+        auto expected = background(opengl.get_observations()[agent]);
+        auto mask = background(software.get_observations()[agent]);
+
+        int same = 0;
+        for (std::size_t i = 0; i < mask.size(); i++)
+          same += mask[i] == expected[i];
+        EXPECT_GT(same, 0.98 * mask.size()) << "step " << step << " agent " << agent;
+      }
+    }
+  }
+
+#endif
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <environment/envs/SparseEnvironment.hpp>
+
+#include <environment/renderable.hpp>
+
+using namespace agario::env;
+
+namespace {
+
+  using SparseEnvironment = agario::env::SparseEnvironment<renderable>;
+  using SparseObservation = SparseEnvironment::Observation;
+
+  std::vector<Action> null_actions(int num_agents) {
+    std::vector<Action> actions;
+    for (int i = 0; i < num_agents; i++)
+      actions.emplace_back(0.0, 0.0, agario::action::none);
+    return actions;
+  }
+
+  TEST(SparseEnvTest, ObservationShape) {
+    SparseEnvironment env(4, 4, 1000, true, 1000, 25, 10);
+    env.reset();
+
+    for (auto &observation : env.get_observations()) {
+      int rows, cols;
+      std::tie(rows, cols) = observation.shape();
+
+      ASSERT_EQ(cols, env.record_length()) << "wrong record length";
+      ASSERT_EQ(rows * cols, observation.length()) << "length does not match shape";
+
+      // the agent should always see (at least) its own cell
+      ASSERT_GE(rows, 1) << "agent does not observe its own cell";
+    }
+  }
+
+  /* every record must be within the agent's view and have a valid type */
+  TEST(SparseEnvTest, RecordsInView) {
+    SparseEnvironment env(2, 2, 1000, true, 1000, 25, 10);
+    env.reset();
+
+    for (int step = 0; step < 10; step++) {
+      env.take_actions(null_actions(env.num_agents()));
+      env.step();
+
+      for (auto &observation : env.get_observations()) {
+        const float *data = observation.data();
+        int own_cells = 0;
+        for (int i = 0; i < observation.num_entities(); i++) {
+          const float *record = data + i * env.record_length();
+          ASSERT_GE(record[0], SparseObservation::pellet);
+          ASSERT_LE(record[0], SparseObservation::other);
+          ASSERT_LE(std::abs(record[1]), 150) << "entity outside of view";
+          ASSERT_LE(std::abs(record[2]), 150) << "entity outside of view";
+          ASSERT_GT(record[3], 0) << "entity without mass";
+          own_cells += record[0] == SparseObservation::cell;
+        }
+        ASSERT_GE(own_cells, 1) << "agent's own cells missing";
+      }
+    }
+  }
+
+  /* packed buffer must contain each agent's records in order */
+  TEST(SparseEnvTest, PackObservations) {
+    SparseEnvironment env(3, 2, 1000, true, 1000, 25, 10);
+    env.reset();
+    env.take_actions(null_actions(env.num_agents()));
+    env.step();
+
+    std::vector<float> data(env.packed_length());
+    std::vector<long> offsets(env.num_agents() + 1);
+    env.pack_observations(data.data(), offsets.data());
+
+    auto &observations = env.get_observations();
+    ASSERT_EQ(offsets.front(), 0);
+    ASSERT_EQ(offsets.back() * env.record_length(), env.packed_length());
+
+    for (int i = 0; i < env.num_agents(); i++) {
+      auto &observation = observations[i];
+      ASSERT_EQ(offsets[i + 1] - offsets[i], observation.num_entities());
+
+      auto *begin = data.data() + offsets[i] * env.record_length();
+      ASSERT_TRUE(std::equal(observation.data(), observation.data() + observation.length(), begin));
+    }
+  }
+
+}
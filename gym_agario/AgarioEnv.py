@@ -7,8 +7,8 @@ This file wraps the Agar.io Learning Environment (agarle)
 in an OpenAI gym interface. The interface offers three different
 kinds of observation types:
 
-1. screen   - rendering of the agar.io game screen
-              (only available if agarle was compiled with OpenGL)
+1. screen   - rendering of the agar.io game screen, on the CPU or
+              (with "screen_backend": "opengl", if agarle was compiled with OpenGL) by OpenGL
 
 2. grid     - an image-like grid with channels for pellets, cells, viruses, boundaries, etc.
               I recommend this one the most since it produces fixed-size image-like data
@@ -18,6 +18,11 @@ kinds of observation types:
 3. ram      - raw positions and velocities of every entity in a fixed-size vector
               I haven't tried this one, but I'm guessing that this is harder than "grid".
 
+4. sparse   - variable-length list of the entities within the agent's view, one row
+              (entity type, relative x, relative y, mass, velocity x, velocity y) per entity.
+              Useful for set-based or transformer policies in very large arenas where
+              most of a grid observation would be empty.
+
 
 This gym supports multiple agents in the same game. By default, there will
 only be a single agent, and the gym will conform to the typical gym interface.
@@ -69,7 +74,7 @@ class AgarioEnv(gym.Env):
     def __init__(self, obs_type='grid', **kwargs):
         super(AgarioEnv, self).__init__()
 
-        if obs_type not in ("ram", "screen", "grid"):
+        if obs_type not in ("ram", "screen", "grid", "sparse"):
             raise ValueError(obs_type)
 
         self._env, self.observation_space = self._make_environment(obs_type, kwargs)
@@ -91,7 +96,9 @@ class AgarioEnv(gym.Env):
             observation (object) : the next state of the world.
             reward (float) : reward gained during the time step
             episode_over (bool) : whether the game is over or not
-            info (dict) : diagnostic information (currently empty)
+            info (dict) : diagnostic information: the number of steps taken and, if
+                agarle was compiled with ENGINE_PROFILING, the engine's per-phase
+                tick profile under "engine"
         """
         assert self.steps is not None, "Cannot call step() before calling reset()"
 
@@ -137,7 +144,12 @@ class AgarioEnv(gym.Env):
             dones = dones[0]
 
         self.steps += 1
-        return observations, rewards, dones, {'steps': self.steps}
+        info = {'steps': self.steps, 'bot_decisions': self._env.decision_stats()}
+
+        stats = self._env.stats()
+        if stats:
+            info['engine'] = stats
+        return observations, rewards, dones, info
 
     def reset(self):
         """ resets the environment
@@ -156,7 +168,13 @@ class AgarioEnv(gym.Env):
         representing the current state of the game
         :return: An observation object
         """
-        states = self._env.get_state()
+        if self.obs_type == "sparse":
+            # all agents' records come packed in one array, with row offsets
+            # delimiting each agent's entities. Slicing makes views, not copies
+            records, offsets = self._env.get_state()
+            states = [records[offsets[i]:offsets[i + 1]] for i in range(self.num_agents)]
+        else:
+            states = self._env.get_state()
         assert len(states) == self.num_agents
 
         if self.obs_type in ("grid", ):
@@ -171,13 +189,13 @@ class AgarioEnv(gym.Env):
 
     def _make_environment(self, obs_type, kwargs):
         """ Instantiates and configures the underlying Agar.io environment (C++ implementation)
-        :param obs_type: the observation type one of "ram", "screen", or "grid"
+        :param obs_type: the observation type one of "ram", "screen", "grid", or "sparse"
         :param kwargs: environment configuration parameters
         :return: tuple of
                     1) the environment object
                     2) observation space
         """
-        assert obs_type in ("ram", "screen", "grid")
+        assert obs_type in ("ram", "screen", "grid", "sparse")
 
         args = self._get_env_args(kwargs)
 
@@ -209,27 +227,48 @@ class AgarioEnv(gym.Env):
             shape = env.observation_shape()
             observation_space = spaces.Box(-np.inf, np.inf, shape)
 
+        elif obs_type == "sparse":
+            env = agarle.SparseEnvironment(*args)
+            # observations have a variable number of rows, so the
+            # space describes a single entity record
+            shape = (env.record_length(), )
+            observation_space = spaces.Box(-np.inf, np.inf, shape)
+
         elif obs_type == "screen":
-            if not agarle.has_screen_env:
-                raise ValueError("agarle was not compiled to include ScreenEnvironment")
+            backend = kwargs.get("screen_backend", "software")
+            if backend not in ("software", "opengl"):
+                raise ValueError(backend)
+            if backend == "opengl" and not agarle.has_opengl_screen_env:
+                raise ValueError("agarle was not compiled with OpenGL to include OpenGLScreenEnvironment")
 
             # the screen environment requires the additional
-            # arguments of screen width and height. We don't use
+            # arguments of number of frames, screen width and height. We don't use
             # the "configure_observation" design here because it would
             # introduce some ugly work-arounds and layers of indirection
             # in the underlying C++ code
 
+            num_frames = kwargs.get("num_frames", 2)
             screen_len = kwargs.get("screen_len", 256)
-            args += (screen_len, screen_len)
-            env = agarle.ScreenEnvironment(*args)
+            args += (num_frames, screen_len, screen_len)
+            if backend == "opengl":
+                env = agarle.OpenGLScreenEnvironment(*args)
+            else:
+                env = agarle.ScreenEnvironment(*args)
 
-            # todo: use env.observation_shape() ?
-            shape = 4, screen_len, screen_len, 3
+            shape = env.observation_shape()
             observation_space = spaces.Box(low=0, high=255, shape=shape, dtype=np.uint8)
 
         else:
             raise ValueError(obs_type)
 
+        # bot decisions and observations can be spread over threads
+        # (although OpenGL renders screens on the stepping thread only)
+        env.set_num_threads(kwargs.get("num_threads", 1))
+        env.set_arena_tiles(*kwargs.get("arena_tiles", (0, 0)))
+
+        # e.g. {"staggered": True, "distant_period": 40} (see set_bot_schedule)
+        env.set_bot_schedule(**kwargs.get("bot_schedule", {}))
+
         return env, observation_space
 
     def _get_env_args(self, kwargs):
@@ -16,9 +16,10 @@ register(id='agario-grid-v0',
          entry_point='gym_agario.AgarioEnv:AgarioEnv',
          kwargs={'obs_type': 'grid'})
 
+register(id='agario-sparse-v0',
+         entry_point='gym_agario.AgarioEnv:AgarioEnv',
+         kwargs={'obs_type': 'sparse'})
 
-if agarle.has_screen_env:
-    # only register the screen environment if its available
-    register(id='agario-screen-v0',
-             entry_point='gym_agario.AgarioEnv:AgarioEnv',
-             kwargs={'obs_type': 'screen'})
\ No newline at end of file
+register(id='agario-screen-v0',
+         entry_point='gym_agario.AgarioEnv:AgarioEnv',
+         kwargs={'obs_type': 'screen'})
\ No newline at end of file
@@ -0,0 +1,94 @@
+/**
+ * File: spsc-queue.h
+ * ------------------
+ * This file defines SPSCQueue, a bounded lock-free queue for passing values
+ * from exactly one producer thread to exactly one consumer thread, such as
+ * between the server's network thread and its simulation thread.
+ *
+ * The producer only writes `tail` and the consumer only writes `head`, so
+ * neither ever waits on the other: push fails when the queue is full and
+ * pop fails when it is empty. Each side also caches the other's index,
+ * only re-reading it (and so taking the cache miss) when the cached value
+ * says the queue is full (or empty).
+ */
+
+#ifndef _spsc_queue_
+#define _spsc_queue_
+
+#include <atomic>    // for atomic
+#include <cstddef>   // for size_t
+#include <stdexcept> // for invalid_argument
+#include <utility>   // for move
+#include <vector>    // for vector
+
+template<typename T>
+class SPSCQueue {
+public:
+
+  /**
+   * Constructs an empty queue
+   * @param capacity : The maximum number of values in the queue at once,
+   * which must be a power of two
+   */
+  explicit SPSCQueue(std::size_t capacity) :
+    slots(capacity), mask(capacity - 1), head(0), tail(0), cached_head(0), cached_tail(0) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+      throw std::invalid_argument("SPSCQueue capacity must be a power of two");
+  }
+
+  /**
+   * Adds `value` to the back of the queue (producer thread only)
+   * @return false, leaving `value` alone, if the queue is full
+   */
+  bool push(T &&value) {
+    auto t = tail.load(std::memory_order_relaxed);
+    if (t - cached_head == slots.size()) {
+      cached_head = head.load(std::memory_order_acquire);
+      if (t - cached_head == slots.size()) return false;
+    }
+    slots[t & mask] = std::move(value);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Removes the value at the front of the queue into `value` (consumer thread only)
+   * @return false if the queue is empty
+   */
+  bool pop(T &value) {
+    auto h = head.load(std::memory_order_relaxed);
+    if (h == cached_tail) {
+      cached_tail = tail.load(std::memory_order_acquire);
+      if (h == cached_tail) return false;
+    }
+    value = std::move(slots[h & mask]);
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  /* the number of values in the queue (only exact when called from one of its threads) */
+  std::size_t size() const {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+
+  std::size_t capacity() const { return slots.size(); }
+
+  SPSCQueue(const SPSCQueue &) = delete;
+  SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+private:
+  static constexpr std::size_t cache_line = 64;
+
+  std::vector<T> slots;
+  const std::size_t mask;
+
+  // kept on separate cache lines so that the two threads don't contend on them
+  alignas(cache_line) std::atomic<std::size_t> head; // written by the consumer
+  alignas(cache_line) std::atomic<std::size_t> tail; // written by the producer
+  alignas(cache_line) std::size_t cached_head;       // producer's copy of head
+  alignas(cache_line) std::size_t cached_tail;       // consumer's copy of tail
+};
+
+#endif
@@ -1,22 +1,43 @@
 /**
  * File: thread-pool.h
  * -------------------
- * This file defines the ThreadPool class, which creates
- * a pool of threads to execute
+ * This file defines the ThreadPool class, a work-stealing scheduler which
+ * runs tasks on a fixed set of worker threads.
+ *
+ * Each worker owns a Chase-Lev deque of tasks: it pushes and pops tasks at
+ * the bottom of its own deque without locking, and workers which run out of
+ * tasks steal from the top of the others' deques. Tasks scheduled from
+ * outside of the pool go through a shared queue, which workers drain when
+ * their own deques are empty. There is no dispatcher thread: workers find
+ * their own work, and sleep only when there is none to be found anywhere.
+ *
+ * Tasks are stored by value in a small fixed-size buffer, so scheduling a
+ * small, trivially copyable callable (such as a lambda capturing a few
+ * pointers and indices) doesn't allocate. Larger callables go on the heap.
+ * Tasks must not throw.
  */
 
 #ifndef _thread_pool_
 #define _thread_pool_
 
-#include <cstddef>     // for size_t
-#include <functional>  // for the function template used in the schedule signature
-#include <thread>      // for thread
-#include <vector>      // for vector
-#include <map>         // for map
-#include <queue>       // for queue
-#include "semaphore.h" // for semaphore
-#include <mutex>
-#include "condition_variable"
+#include <algorithm>          // for max
+#include <atomic>             // for atomic
+#include <chrono>             // for microseconds
+#include <condition_variable> // for condition_variable
+#include <cstddef>            // for size_t, max_align_t
+#include <cstdint>            // for int64_t, uintptr_t
+#include <cstring>            // for memcpy
+#include <deque>              // for deque
+#include <memory>             // for unique_ptr
+#include <mutex>              // for mutex
+#include <new>                // for placement new, launder
+#include <string>             // for to_string
+#include <thread>             // for thread
+#include <type_traits>        // for decay_t, is_trivially_copyable
+#include <utility>            // for forward
+#include <vector>             // for vector
+
+#include "trace.h"
 
 class ThreadPool {
 public:
@@ -25,27 +46,111 @@ public:
    * Constructs a ThreadPool of size `num_threads` threads
    * @param num_threads : The number of threads in this thread pool
    */
-  explicit ThreadPool(size_t num_threads);
+  explicit ThreadPool(size_t num_threads) {
+    for (size_t i = 0; i < num_threads; i++)
+      workers.emplace_back(std::make_unique<Worker>());
+    for (size_t i = 0; i < num_threads; i++)
+      workers[i]->thread = std::thread([this, i]() { work(i); });
+  }
+
+  /**
+   * Schedules the provided thunk (which is something that can be invoked as a
+   * zero-argument function without a return value) to be executed by one of
+   * the ThreadPool's threads. Thunks scheduled from a worker go on that
+   * worker's own deque, and are run (or stolen) most recent first.
+   */
+  template<typename F>
+  void schedule(F &&thunk) {
+    submit(make_task(std::forward<F>(thunk), nullptr));
+  }
+
+  /**
+   * Blocks until all tasks in the thread pool have been executed,
+   * running tasks on the calling thread in the meantime.
+   */
+  void wait() {
+    TRACE_SCOPE("pool wait");
+    help_until([this]() { return outstanding.load(std::memory_order_acquire) == 0; });
+  }
+
+  /**
+   * A set of tasks which can be waited on together, while the
+   * rest of the pool's tasks carry on
+   */
+  class TaskGroup {
+  public:
+    explicit TaskGroup(ThreadPool &pool) : pool(pool), pending(0) {}
+
+    /* schedules `thunk` as part of this group */
+    template<typename F>
+    void run(F &&thunk) {
+      pending.fetch_add(1, std::memory_order_relaxed);
+      pool.submit(pool.make_task(std::forward<F>(thunk), &pending));
+    }
+
+    /**
+     * Blocks until every task of the group has run, running tasks on the calling
+     * thread in the meantime (which may be any of the pool's tasks, not just the group's)
+     */
+    void wait() {
+      pool.help_until([this]() { return pending.load(std::memory_order_acquire) == 0; });
+    }
+
+    ~TaskGroup() { wait(); }
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+  private:
+    ThreadPool &pool;
+    std::atomic<size_t> pending;
+  };
 
   /**
-   * Schedules the provided thunk (which is something that can
-   * be invoked as a zero-argument function without a return value)
-   * to be executed by one of the ThreadPool's threads as soon as
-   * all previously scheduled thunks have been handled.
-   * @param thunk : A function with no parameters and no return value
-   * that will be scheduled for execution by a worker thread
+   * Calls f(i) for each i in [0, n) on the pool (including the calling thread),
+   * returning once all of the calls have. The range is split in half
+   * recursively, each half becoming a task for idle workers to steal, down to
+   * ranges of `grain` indices (by default, several ranges for each thread).
    */
-  void schedule(const std::function<void(void)>& thunk);
+  template<typename F>
+  void parallel_for(size_t n, F &&f, size_t grain = 0) {
+    if (grain == 0) grain = std::max<size_t>(1, n / (8 * (workers.size() + 1)));
+    if (n <= grain || workers.empty()) {
+      for (size_t i = 0; i < n; i++) f(i);
+      return;
+    }
+
+    TaskGroup group(*this);
+    Loop<std::remove_reference_t<F>> loop { &group, &f, grain };
+    loop.run(0, n);
+    group.wait();
+  }
+
+  /* the number of worker threads */
+  [[nodiscard]] size_t size() const { return workers.size(); }
 
   /**
-   * Blocks until all tasks in the thread pool have been executed.
+   * The index of the worker running the calling thread, or size() for a thread
+   * outside of the pool (e.g. one helping in wait), for keeping per-thread state
    */
-  void wait();
+  [[nodiscard]] size_t thread_index() const {
+    auto &c = current();
+    return c.pool == this ? c.index : workers.size();
+  }
 
   /**
-   * waits for all scheduled tasks to complete and then joins all worker / dispatcher threads
+   * waits for all scheduled tasks to complete and then joins all worker threads
    */
-  ~ThreadPool();
+  ~ThreadPool() {
+    wait();
+    {
+      std::lock_guard<std::mutex> lg(sleep_mutex);
+      stopping = true;
+    }
+    sleep_cv.notify_all();
+    for (auto &worker : workers)
+      worker->thread.join();
+  }
 
   /**
    * ThreadPools are the type of thing that shouldn't be cloneable, since it's
@@ -60,48 +165,288 @@ public:
   ThreadPool &operator=(const ThreadPool &rhs) = delete;
 
 private:
-  std::thread dispatcher;                    // dispatcher thread handle
-  std::vector<std::thread> workers;  // worker thread handles
-  size_t num_threads;                 // number of worker threads
 
-  // For indicating when all threads should exit
-  bool should_exit;
+  /* a type-erased thunk, stored inline if it is small and trivially copyable */
+  struct Task {
+    static constexpr size_t capacity = 32;
+
+    void (*run)(Task &) = nullptr;
+    std::atomic<size_t> *pending = nullptr; // of the group the task belongs to, if any
+    alignas(std::max_align_t) unsigned char storage[capacity];
+  };
+  static_assert(std::is_trivially_copyable<Task>::value, "tasks are copied between threads word by word");
 
-  // Queue of scheduled functions
-  std::queue<std::function<void(void)>> queue;
-  std::mutex m;
+  /**
+   * A Chase-Lev work-stealing deque of tasks with a fixed capacity. The owning
+   * worker pushes and pops at the bottom, and other threads steal from the top.
+   * Tasks are copied in and out of the slots a word at a time through (relaxed)
+   * atomics, so a thief which loses the race for a slot can safely discard it.
+   */
+  class WorkDeque {
+  public:
+    static constexpr std::int64_t capacity = 1024;
 
-  typedef size_t id_t; // Type for storing Worker IDs
+    /* adds `task` at the bottom (owner only), failing if the deque is full */
+    bool push(const Task &task) {
+      auto b = bottom.load(std::memory_order_relaxed);
+      auto t = top.load(std::memory_order_acquire);
+      if (b - t >= capacity) return false;
+      store(b, task);
+      bottom.store(b + 1, std::memory_order_release);
+      return true;
+    }
 
-  std::vector<bool> free_workers; // which workers are free
-  std::vector<std::shared_ptr<semaphore>> worker_go;
-  std::vector<std::function<void(void)>> worker_funcs;
+    /* takes the task at the bottom (owner only) */
+    bool pop(Task &task) {
+      auto b = bottom.load(std::memory_order_relaxed) - 1;
+      bottom.store(b, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      auto t = top.load(std::memory_order_relaxed);
 
-  std::condition_variable_any can_dispatch;
-  std::condition_variable_any all_complete;
+      if (t > b) { // empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+      }
+      load(b, task);
+      if (t == b) {
+        // the last task, which a thief may be taking at the same time
+        bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+      }
+      return true;
+    }
 
-  /**
-   * Private Method: dispatcher
-   * --------------------------
-   * This method will continuously wait until there is something in the
-   * thunk queue and then dispatch that thunk to be executed by a worker
-   */
-  void dispatch();
+    /* takes the task at the top (any thread) */
+    bool steal(Task &task) {
+      auto t = top.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      auto b = bottom.load(std::memory_order_acquire);
+      if (t >= b) return false;
+      load(t, task);
+      return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
 
-  bool try_dispatch();
+  private:
+    static constexpr size_t words = sizeof(Task) / sizeof(std::uintptr_t);
+    static_assert(sizeof(Task) % sizeof(std::uintptr_t) == 0, "tasks are a whole number of words");
 
-  /**
-   * Private Method: worker
-   * ---------------------
-   * This method first waits until signaled by the workerSignalLock associated
-   * with the ID, then it will retrieve the function to execute from the queue
-   * and execute the funciton. This method will also indicate that it is available
-   * after it has completed it's assigned task and notify the condition_variable_any
-   * cv that it has finished.
-   * This method is meant to be executed as a thread routine.
-   * @param workerID : The ID of the worker that is
-   */
-  void worker(id_t workerID);
+    struct Slot {
+      std::atomic<std::uintptr_t> word[words];
+    };
+
+    std::unique_ptr<Slot[]> slots { new Slot[capacity] };
+    alignas(64) std::atomic<std::int64_t> top { 0 };
+    alignas(64) std::atomic<std::int64_t> bottom { 0 };
+
+    void store(std::int64_t i, const Task &task) {
+      std::uintptr_t w[words];
+      std::memcpy(w, &task, sizeof(Task));
+      auto &slot = slots[i & (capacity - 1)];
+      for (size_t k = 0; k < words; k++)
+        slot.word[k].store(w[k], std::memory_order_relaxed);
+    }
+
+    void load(std::int64_t i, Task &task) const {
+      std::uintptr_t w[words];
+      auto &slot = slots[i & (capacity - 1)];
+      for (size_t k = 0; k < words; k++)
+        w[k] = slot.word[k].load(std::memory_order_relaxed);
+      std::memcpy(&task, w, sizeof(Task));
+    }
+  };
+
+  struct Worker {
+    WorkDeque deque;
+    std::thread thread;
+  };
+
+  /* the range of a parallel_for that is left to split, or to run */
+  template<typename F>
+  struct Loop {
+    TaskGroup *group;
+    F *f;
+    size_t grain;
+
+    void run(size_t begin, size_t end) const {
+      while (end - begin > grain) {
+        auto mid = begin + (end - begin) / 2;
+        auto self = this;
+        group->run([self, mid, end]() { self->run(mid, end); });
+        end = mid;
+      }
+      for (auto i = begin; i < end; i++) (*f)(i);
+    }
+  };
+
+  static constexpr size_t no_worker = static_cast<size_t>(-1);
+
+  /* the pool and index of the worker running on this thread, if any */
+  struct Current {
+    ThreadPool *pool = nullptr;
+    size_t index = no_worker;
+  };
+  static Current &current() {
+    static thread_local Current c;
+    return c;
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers;
+
+  // tasks scheduled from outside of the pool
+  std::mutex injected_mutex;
+  std::deque<Task> injected;
+  std::atomic<size_t> num_injected { 0 };
+
+  std::atomic<size_t> outstanding { 0 }; // tasks scheduled but not yet finished
+
+  // sleeping: workers sleep until the epoch changes, which it does whenever a task is added
+  std::mutex sleep_mutex;
+  std::condition_variable sleep_cv; // for sleeping workers
+  std::condition_variable done_cv;  // for threads waiting on tasks to finish
+  std::atomic<std::uint64_t> epoch { 0 };
+  std::atomic<size_t> sleepers { 0 };
+  bool stopping = false;
+
+  template<typename F>
+  Task make_task(F &&f, std::atomic<size_t> *pending) {
+    using Fn = std::decay_t<F>;
+    Task task;
+    task.pending = pending;
+    if constexpr (sizeof(Fn) <= Task::capacity && alignof(Fn) <= alignof(std::max_align_t)
+                  && std::is_trivially_copyable<Fn>::value) {
+      new (task.storage) Fn(std::forward<F>(f));
+      task.run = [](Task &t) { (*std::launder(reinterpret_cast<Fn *>(t.storage)))(); };
+    } else {
+      auto *fn = new Fn(std::forward<F>(f));
+      std::memcpy(task.storage, &fn, sizeof(fn));
+      task.run = [](Task &t) {
+        Fn *fn;
+        std::memcpy(&fn, t.storage, sizeof(fn));
+        std::unique_ptr<Fn> owned(fn);
+        (*owned)();
+      };
+    }
+    return task;
+  }
+
+  void submit(const Task &task) {
+    outstanding.fetch_add(1, std::memory_order_relaxed);
+    auto &c = current();
+    if (c.pool == this) {
+      Task t = task;
+      if (!workers[c.index]->deque.push(t)) {
+        execute(t); // this worker has plenty queued already
+        return;
+      }
+    } else {
+      std::lock_guard<std::mutex> lg(injected_mutex);
+      injected.push_back(task);
+      num_injected.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    epoch.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_seq_cst) > 0) {
+      { std::lock_guard<std::mutex> lg(sleep_mutex); }
+      sleep_cv.notify_one();
+    }
+  }
+
+  /* finds a task for worker `self` (or for a thread outside of the pool, with no_worker) */
+  bool find(Task &task, size_t self) {
+    if (self != no_worker && workers[self]->deque.pop(task))
+      return true;
+
+    if (num_injected.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lg(injected_mutex);
+      if (!injected.empty()) {
+        task = injected.front();
+        injected.pop_front();
+        num_injected.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+
+    // steal, starting from a different victim each time to spread out the thieves
+    static thread_local size_t victim = 0;
+    auto n = workers.size();
+    for (size_t i = 0; i < n; i++) {
+      auto v = (victim + i) % n;
+      if (v != self && workers[v]->deque.steal(task)) {
+        victim = v;
+        return true;
+      }
+    }
+    victim++;
+    return false;
+  }
+
+  void execute(Task &task) {
+    {
+      TRACE_SCOPE("task");
+      task.run(task);
+    }
+    bool done = false;
+    if (task.pending != nullptr && task.pending->fetch_sub(1, std::memory_order_acq_rel) == 1)
+      done = true;
+    if (outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      done = true;
+    if (done) {
+      { std::lock_guard<std::mutex> lg(sleep_mutex); }
+      done_cv.notify_all();
+    }
+  }
+
+  /* runs tasks on the calling thread until `finished` returns true */
+  template<typename Predicate>
+  void help_until(Predicate &&finished) {
+    auto &c = current();
+    auto self = c.pool == this ? c.index : no_worker;
+    int idle = 0;
+    Task task;
+    while (!finished()) {
+      if (find(task, self)) {
+        execute(task);
+        idle = 0;
+      } else if (++idle < 64) {
+        std::this_thread::yield();
+      } else {
+        // the remaining tasks are running elsewhere (or haven't been made yet)
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        done_cv.wait_for(lock, std::chrono::microseconds(100), finished);
+      }
+    }
+  }
+
+  void work(size_t index) {
+    TRACE_THREAD_NAME("worker " + std::to_string(index));
+    current() = Current { this, index };
+
+    Task task;
+    while (true) {
+      bool found = find(task, index);
+      for (int spin = 0; !found && spin < 64; spin++) {
+        std::this_thread::yield();
+        found = find(task, index);
+      }
+      if (found) {
+        execute(task);
+        continue;
+      }
+
+      // sleep until a task is added (checking once more, in case one was added before reading the epoch)
+      auto seen = epoch.load(std::memory_order_seq_cst);
+      if (find(task, index)) {
+        execute(task);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex);
+      sleepers.fetch_add(1, std::memory_order_seq_cst);
+      sleep_cv.wait(lock, [&]() { return stopping || epoch.load(std::memory_order_seq_cst) != seen; });
+      sleepers.fetch_sub(1, std::memory_order_seq_cst);
+      if (stopping) return;
+    }
+  }
 };
 
 #endif
@@ -0,0 +1,292 @@
+/**
+ * File: trace.h
+ * -------------
+ * This file defines a timeline tracer which records when scopes of code
+ * (game ticks, environment steps, thread pool tasks, ...) begin and end on
+ * each thread, and writes them out in the Chrome trace event format so that
+ * they can be viewed in chrome://tracing or https://ui.perfetto.dev
+ *
+ * Each thread records into its own fixed size ring buffer (overwriting its
+ * oldest events once full, and keeping one fewer than its size) so recording
+ * an event takes no locks. Recording is off until trace::start() is called,
+ * or if the AGARIO_TRACE environment variable is set to a file path, in which
+ * case recording starts right away and the trace is written to that file when
+ * the program exits.
+ *
+ * The TRACE_ macros used to instrument the engine, environments and thread
+ * pool expand to nothing unless compiled with ENGINE_TRACING defined.
+ */
+
+#ifndef _trace_
+#define _trace_
+
+#include <algorithm> // for min, max
+#include <atomic>    // for atomic
+#include <chrono>    // for steady_clock
+#include <cstdint>   // for uint64_t
+#include <cstdlib>   // for getenv
+#include <fstream>   // for ofstream
+#include <memory>    // for unique_ptr
+#include <mutex>     // for mutex
+#include <ostream>   // for ostream
+#include <string>    // for string
+#include <vector>    // for vector
+#include <unistd.h>  // for getpid
+
+#ifdef ENGINE_TRACING
+#define _TRACE_CONCAT(a, b) a ## b
+#define _TRACE_SCOPE_NAME(line) _TRACE_CONCAT(_trace_scope_, line)
+#define TRACE_SCOPE(name) trace::Scope _TRACE_SCOPE_NAME(__LINE__)(name)
+#define TRACE_THREAD_NAME(name) trace::set_thread_name(name)
+#else
+#define TRACE_SCOPE(name) ((void) 0)
+#define TRACE_THREAD_NAME(name) ((void) 0)
+#endif
+
+namespace trace {
+
+  /* the number of events kept for each thread */
+  constexpr std::size_t buffer_size = 1 << 16;
+
+  struct Event {
+    const char *name;  // must be a string literal (it isn't copied)
+    std::uint64_t ns;  // nanoseconds since the tracer was created
+    char phase;        // 'B' (begin) or 'E' (end)
+  };
+
+  /**
+   * Ring buffer of the events recorded by a single thread. Only the owning
+   * thread writes events, and it publishes each one by incrementing `head`,
+   * so that a reader can copy out the events without stopping the writer.
+   * The writer may be filling the slot after the newest event at any time,
+   * so that slot (which, once the buffer is full, holds the oldest event)
+   * is never read.
+   */
+  class ThreadBuffer {
+  public:
+    ThreadBuffer(int tid, std::string name) :
+      tid(tid), name(std::move(name)), slots(buffer_size), head(0), tail(0) {}
+
+    void push(const char *event_name, char phase, std::uint64_t ns) {
+      auto h = head.load(std::memory_order_relaxed);
+      // a reader that sees any of the slot's new fields also sees head >= h (see snapshot)
+      std::atomic_thread_fence(std::memory_order_release);
+      auto &slot = slots[h % buffer_size];
+      slot.name.store(event_name, std::memory_order_relaxed);
+      slot.ns.store(ns, std::memory_order_relaxed);
+      slot.phase.store(phase, std::memory_order_relaxed);
+      head.store(h + 1, std::memory_order_release);
+    }
+
+    /* copies out the events which are still in the buffer, oldest first */
+    std::vector<Event> snapshot() const {
+      auto end = head.load(std::memory_order_acquire);
+      auto begin = first(end + 1);
+
+      std::vector<Event> copy;
+      copy.reserve(end - begin);
+      for (auto i = begin; i < end; i++) {
+        auto &slot = slots[i % buffer_size];
+        copy.push_back(Event { slot.name.load(std::memory_order_relaxed),
+                               slot.ns.load(std::memory_order_relaxed),
+                               slot.phase.load(std::memory_order_relaxed) });
+      }
+
+      // drop any events that the writer overwrote (or was overwriting) while they were being copied
+      std::atomic_thread_fence(std::memory_order_acquire);
+      auto overwritten = first(head.load(std::memory_order_relaxed) + 1);
+      if (overwritten > begin)
+        copy.erase(copy.begin(), copy.begin() + std::min(overwritten - begin, end - begin));
+      return copy;
+    }
+
+    /* discards all events recorded so far */
+    void clear() { tail.store(head.load(std::memory_order_acquire)); }
+
+    const int tid;
+    std::string name;
+
+  private:
+    /* an Event, whose fields may be read while they're being written */
+    struct Slot {
+      std::atomic<const char *> name { nullptr };
+      std::atomic<std::uint64_t> ns { 0 };
+      std::atomic<char> phase { 0 };
+    };
+
+    std::vector<Slot> slots;
+    std::atomic<std::uint64_t> head; // total number of events ever recorded
+    std::atomic<std::uint64_t> tail; // events before this were cleared
+
+    /* the first event kept when the newest (or the one being written) is `end` - 1 */
+    std::uint64_t first(std::uint64_t end) const {
+      auto oldest = end > buffer_size ? end - buffer_size : 0;
+      return std::max<std::uint64_t>(oldest, tail.load());
+    }
+  };
+
+  class Tracer {
+    using clock = std::chrono::steady_clock;
+  public:
+    static Tracer &instance() {
+      static Tracer tracer;
+      return tracer;
+    }
+
+    [[nodiscard]] bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+    void start() { _enabled.store(true); }
+    void stop() { _enabled.store(false); }
+
+    void record(const char *name, char phase) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - _epoch).count();
+      buffer().push(name, phase, static_cast<std::uint64_t>(ns));
+    }
+
+    /* the calling thread's buffer, which is created on its first event */
+    ThreadBuffer &buffer() {
+      auto &local = this_thread();
+      if (local.buffer == nullptr) {
+        std::lock_guard<std::mutex> lg(m);
+        int tid = static_cast<int>(_buffers.size()) + 1;
+        auto name = local.name.empty() ? "thread " + std::to_string(tid) : local.name;
+        _buffers.emplace_back(std::make_unique<ThreadBuffer>(tid, name));
+        local.buffer = _buffers.back().get();
+      }
+      return *local.buffer;
+    }
+
+    /* names the calling thread in the trace (without creating its buffer) */
+    void set_thread_name(const std::string &name) {
+      auto &local = this_thread();
+      local.name = name;
+      if (local.buffer != nullptr) {
+        std::lock_guard<std::mutex> lg(m);
+        local.buffer->name = name;
+      }
+    }
+
+    /* discards all events recorded so far, on all threads */
+    void clear() {
+      std::lock_guard<std::mutex> lg(m);
+      for (auto &b : _buffers)
+        b->clear();
+    }
+
+    /* writes all recorded events as a Chrome trace (JSON) */
+    void write(std::ostream &os) {
+      std::lock_guard<std::mutex> lg(m);
+      auto pid = ::getpid();
+      bool first = true;
+      auto separate = [&]() {
+        os << (first ? "\n" : ",\n");
+        first = false;
+      };
+
+      os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+      for (auto &b : _buffers) {
+        separate();
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << b->tid
+           << ",\"args\":{\"name\":\"" << escape(b->name) << "\"}}";
+
+        for (auto &event : b->snapshot()) {
+          separate();
+          // timestamps are in microseconds
+          os << "{\"name\":\"" << escape(event.name) << "\",\"ph\":\"" << event.phase
+             << "\",\"ts\":" << event.ns / 1000 << "." << pad(event.ns % 1000)
+             << ",\"pid\":" << pid << ",\"tid\":" << b->tid << "}";
+        }
+      }
+      os << "\n]}\n";
+    }
+
+    /* writes the trace to the file at `path` */
+    bool flush(const std::string &path) {
+      std::ofstream file(path);
+      if (!file) return false;
+      write(file);
+      return static_cast<bool>(file);
+    }
+
+    /* sets a file to which the trace is written when the program exits */
+    void flush_on_exit(const std::string &path) {
+      std::lock_guard<std::mutex> lg(m);
+      _exit_path = path;
+    }
+
+    ~Tracer() {
+      if (!_exit_path.empty())
+        flush(_exit_path);
+    }
+
+    Tracer(const Tracer &) = delete;
+    Tracer &operator=(const Tracer &) = delete;
+
+  private:
+    Tracer() : _epoch(clock::now()), _enabled(false) {
+      if (auto path = std::getenv("AGARIO_TRACE")) {
+        _exit_path = path;
+        _enabled = true;
+      }
+    }
+
+    clock::time_point _epoch;
+    std::atomic<bool> _enabled;
+    std::string _exit_path;
+
+    std::mutex m; // guards the list of buffers and their names
+    std::vector<std::unique_ptr<ThreadBuffer>> _buffers;
+
+    struct ThreadState {
+      ThreadBuffer *buffer = nullptr;
+      std::string name;
+    };
+
+    static ThreadState &this_thread() {
+      thread_local ThreadState state;
+      return state;
+    }
+
+    static std::string escape(const std::string &s) {
+      std::string escaped;
+      for (char c : s) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+      }
+      return escaped;
+    }
+
+    static std::string pad(std::uint64_t ns) {
+      auto digits = std::to_string(ns);
+      return std::string(3 - digits.size(), '0') + digits;
+    }
+  };
+
+  inline void start() { Tracer::instance().start(); }
+  inline void stop() { Tracer::instance().stop(); }
+  inline bool enabled() { return Tracer::instance().enabled(); }
+  inline void clear() { Tracer::instance().clear(); }
+  inline bool flush(const std::string &path) { return Tracer::instance().flush(path); }
+  inline void flush_on_exit(const std::string &path) { Tracer::instance().flush_on_exit(path); }
+  inline void set_thread_name(const std::string &name) { Tracer::instance().set_thread_name(name); }
+
+  /* records a begin event when constructed and an end event when destroyed */
+  class Scope {
+  public:
+    explicit Scope(const char *name) : name(enabled() ? name : nullptr) {
+      if (this->name != nullptr)
+        Tracer::instance().record(this->name, 'B');
+    }
+    ~Scope() {
+      if (name != nullptr)
+        Tracer::instance().record(name, 'E');
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    const char *name; // null if the tracer wasn't recording when the scope began
+  };
+
+}
+
+#endif
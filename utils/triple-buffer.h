@@ -0,0 +1,71 @@
+/**
+ * File: triple-buffer.h
+ * ---------------------
+ * This file defines TripleBuffer, for handing the latest of a stream of
+ * values (such as game states) from exactly one producer thread to exactly
+ * one consumer thread, where the consumer only ever wants the newest value
+ * and may skip any that it was too slow to see.
+ *
+ * Of the three slots, the producer writes one (the back), the consumer
+ * reads another (the front) and the third holds the value most recently
+ * published. Publishing swaps the back slot with that one, and taking the
+ * newest value swaps it with the front slot, each with a single atomic
+ * exchange, so neither thread ever waits on the other.
+ */
+
+#ifndef _triple_buffer_
+#define _triple_buffer_
+
+#include <atomic>  // for atomic
+#include <cstdint> // for uint8_t
+
+template<typename T>
+class TripleBuffer {
+public:
+
+  TripleBuffer() : back_index(0), front_index(1), middle(2) {}
+
+  /**
+   * The slot to write the next value into (producer thread only), which
+   * may still hold a value published some time before
+   */
+  T &back() { return slots[back_index]; }
+
+  /* makes the value written into `back` the newest (producer thread only) */
+  void publish() {
+    auto previous = middle.exchange(back_index | fresh, std::memory_order_acq_rel);
+    back_index = previous & index_mask;
+  }
+
+  /**
+   * Moves the newest value (if one has been published since) to the front
+   * (consumer thread only)
+   * @return whether there was a newer value
+   */
+  bool update() {
+    if (!(middle.load(std::memory_order_relaxed) & fresh)) return false;
+    auto previous = middle.exchange(front_index, std::memory_order_acq_rel);
+    front_index = previous & index_mask;
+    return true;
+  }
+
+  /**
+   * The value taken by the last `update` (consumer thread only), which the
+   * consumer may modify or move from until it next updates
+   */
+  T &front() { return slots[front_index]; }
+
+  TripleBuffer(const TripleBuffer &) = delete;
+  TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+private:
+  static constexpr std::uint8_t index_mask = 3;
+  static constexpr std::uint8_t fresh = 4; // set in `middle` when it holds a value not yet taken
+
+  T slots[3];
+  std::uint8_t back_index;          // the producer's
+  std::uint8_t front_index;         // the consumer's
+  std::atomic<std::uint8_t> middle; // the index of the newest value, and whether it's fresh
+};
+
+#endif